@@ -0,0 +1,289 @@
+// Host benchmark: old if/startsWith command chain vs. COMMAND_TABLE perfect hash
+//
+// Build and run on the PC (no Arduino headers needed):
+//   g++ -std=gnu++11 -O2 -Isrc scripts/bench_dispatch.cpp src/CommandTable.cpp -o bench_dispatch
+//   ./bench_dispatch            # per-command dispatch time, old vs. new
+//
+// After adding a command that collides (static_assert in CommandTable.h), find a new
+// CommandHash::SEED with the check disabled:
+//   g++ -std=gnu++11 -O2 -DCOMMAND_TABLE_SEED_SEARCH -Isrc scripts/bench_dispatch.cpp src/CommandTable.cpp -o bench_dispatch
+//   ./bench_dispatch --seed
+//
+// The old chain is reproduced entry by entry in its original order, including
+// the trim + toUpperCase copies processCommand made before comparing. Both
+// dispatchers must resolve every sample line to the same CommandId; the
+// benchmark exits non-zero otherwise. Commands added after the chain was
+// retired are timed on the new dispatcher only.
+
+#include "CommandTable.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// ============================================================================
+// Old dispatch (processCommand before the command table)
+// ============================================================================
+
+enum MatchKind {
+    EQ,          // upper == "X"
+    PREFIX,      // upper.startsWith("X")
+    EQ_OR_ARGS,  // upper == "X" || upper.startsWith("X ")
+    WIFI_JOIN    // startsWith("WIFI ") except the WIFI STATUS/START/STOP/SCAN prefixes
+};
+
+struct ChainEntry {
+    MatchKind kind;
+    const char* pattern;
+    CommandId id;
+};
+
+const ChainEntry OLD_CHAIN[] = {
+    { EQ, "*IDN?", CMD_IDN },
+    { EQ, "HELP", CMD_HELP },
+    { EQ, "?", CMD_HELP_SHORT },
+    { EQ, "INFO", CMD_INFO },
+    { EQ, "STATUS", CMD_STATUS },
+    { EQ, "SEND", CMD_SEND },
+    { EQ, "READ", CMD_READ },
+    { EQ, "CLEAR", CMD_CLEAR },
+    { PREFIX, "DELAY ", CMD_DELAY },
+    { EQ, "CLEAR ERROR", CMD_CLEAR_ERROR },
+    { EQ, "CLEAR_ERROR", CMD_CLEAR_ERROR_ALT },
+    { EQ, "RESUME", CMD_RESUME },
+    { EQ, "RPM", CMD_RPM },
+    { EQ_OR_ARGS, "RPM STATS", CMD_RPM_STATS },
+    { PREFIX, "RPM SET", CMD_RPM_SET },
+    { EQ_OR_ARGS, "PID", CMD_PID },
+    { EQ_OR_ARGS, "FAN", CMD_FAN },
+    { EQ_OR_ARGS, "STEP", CMD_STEP },
+    { EQ_OR_ARGS, "SWEEP", CMD_SWEEP },
+    { EQ_OR_ARGS, "FAULT", CMD_FAULT },
+    { PREFIX, "RPM EVENT", CMD_RPM_EVENT },
+    { PREFIX, "RPM COUNTER", CMD_RPM_COUNTER },
+    { EQ, "RPM LATENCY", CMD_RPM_LATENCY },
+    { EQ, "RPM LATENCY RESET", CMD_RPM_LATENCY },
+    { EQ_OR_ARGS, "RPM DUTY", CMD_RPM_DUTY },
+    { EQ_OR_ARGS, "RPM FILTER", CMD_RPM_FILTER },
+    { PREFIX, "RPM TIMEOUT", CMD_RPM_TIMEOUT },
+    { PREFIX, "RPM AVG", CMD_RPM_AVG },
+    { PREFIX, "RAMP ", CMD_RAMP },
+    { EQ_OR_ARGS, "FOLLOW", CMD_FOLLOW },
+    { EQ_OR_ARGS, "DITHER", CMD_DITHER },
+    { EQ, "MOTOR STOP", CMD_MOTOR_STOP },
+    { EQ, "MOTOR STATUS", CMD_MOTOR_STATUS },
+    { EQ, "SAVE", CMD_SAVE },
+    { EQ, "LOAD", CMD_LOAD },
+    { EQ, "RESET", CMD_RESET },
+    { PREFIX, "SET ", CMD_SET },
+    { WIFI_JOIN, "WIFI ", CMD_WIFI },
+    { EQ, "IP", CMD_IP },
+    { EQ, "WIFI STATUS", CMD_WIFI_STATUS },
+    { EQ, "WIFI START", CMD_WIFI_START },
+    { EQ, "WIFI STOP", CMD_WIFI_STOP },
+    { EQ, "WIFI SCAN", CMD_WIFI_SCAN },
+    { EQ, "WEB STATUS", CMD_WEB_STATUS },
+    { PREFIX, "UART1 MODE ", CMD_UART1_MODE },
+    { PREFIX, "UART1 CONFIG ", CMD_UART1_CONFIG },
+    { PREFIX, "UART1 PWM ", CMD_UART1_PWM },
+    { EQ_OR_ARGS, "UART1 COMPL", CMD_UART1_COMPL },
+    { EQ, "UART1 STATUS", CMD_UART1_STATUS },
+    { EQ, "UART1 SWITCH RESET", CMD_UART1_SWITCH },
+    { PREFIX, "UART1 WRITE ", CMD_UART1_WRITE },
+    { PREFIX, "UART2 CONFIG ", CMD_UART2_CONFIG },
+    { EQ, "UART2 STATUS", CMD_UART2_STATUS },
+    { PREFIX, "UART2 WRITE ", CMD_UART2_WRITE },
+    { PREFIX, "BUZZER BEEP ", CMD_BUZZER_BEEP },
+    { PREFIX, "BUZZER ", CMD_BUZZER },
+    { PREFIX, "LED_PWM FADE ", CMD_LED_PWM_FADE },
+    { PREFIX, "LEDPWM FADE ", CMD_LEDPWM_FADE },
+    { PREFIX, "LED_PWM ", CMD_LED_PWM },
+    { PREFIX, "LEDPWM ", CMD_LEDPWM },
+    { PREFIX, "RELAY ", CMD_RELAY },
+    { PREFIX, "GPIO ", CMD_GPIO },
+    { EQ, "KEYS STATUS", CMD_KEYS_STATUS },
+    { EQ, "KEYS", CMD_KEYS },
+    { PREFIX, "KEYS CONFIG ", CMD_KEYS_CONFIG },
+    { PREFIX, "KEYS MODE ", CMD_KEYS_MODE },
+    { EQ, "PERIPHERAL STATUS", CMD_PERIPHERAL_STATUS },
+    { EQ, "PERIPHERALS", CMD_PERIPHERALS },
+    { EQ, "PERIPHERAL STATS", CMD_PERIPHERAL_STATS },
+    { EQ, "PERIPHERAL SAVE", CMD_PERIPHERAL_SAVE },
+    { EQ, "PERIPHERAL LOAD", CMD_PERIPHERAL_LOAD },
+    { EQ, "PERIPHERAL RESET", CMD_PERIPHERAL_RESET },
+    { EQ_OR_ARGS, "TRACE", CMD_TRACE },
+};
+
+bool startsWith(const std::string& s, const char* prefix) {
+    return s.compare(0, strlen(prefix), prefix) == 0;
+}
+
+CommandId oldDispatch(const std::string& cmd) {
+    // String trimmed = cmd; trimmed.trim();
+    size_t first = cmd.find_first_not_of(" \t\r\n");
+    if (first == std::string::npos) {
+        return CMD_NONE;
+    }
+    size_t last = cmd.find_last_not_of(" \t\r\n");
+    std::string trimmed = cmd.substr(first, last - first + 1);
+
+    // String upper = trimmed; upper.toUpperCase();
+    std::string upper = trimmed;
+    for (size_t i = 0; i < upper.size(); i++) {
+        upper[i] = (char)toupper((unsigned char)upper[i]);
+    }
+
+    for (const ChainEntry& e : OLD_CHAIN) {
+        switch (e.kind) {
+            case EQ:
+                if (upper == e.pattern) return e.id;
+                break;
+            case PREFIX:
+                if (startsWith(upper, e.pattern)) return e.id;
+                break;
+            case EQ_OR_ARGS:
+                if (upper == e.pattern || startsWith(upper, (std::string(e.pattern) + " ").c_str())) return e.id;
+                break;
+            case WIFI_JOIN:
+                if (startsWith(upper, "WIFI ") && !startsWith(upper, "WIFI STATUS") &&
+                    !startsWith(upper, "WIFI START") && !startsWith(upper, "WIFI STOP") &&
+                    !startsWith(upper, "WIFI SCAN")) {
+                    return e.id;
+                }
+                break;
+        }
+    }
+    return CMD_NONE;
+}
+
+// ============================================================================
+// New dispatch
+// ============================================================================
+
+CommandId newDispatch(const std::string& cmd) {
+    CommandMatch match;
+    return findCommand(cmd.c_str(), match) ? match.id : CMD_NONE;
+}
+
+// ============================================================================
+// Benchmark
+// ============================================================================
+
+// One representative line per command, in table order
+const char* SAMPLES[CMD_COUNT] = {
+    "*idn?", "help", "?", "info", "status", "send", "read", "clear",
+    "DELAY 10", "clear error", "CLEAR_ERROR", "resume",
+    "rpm", "rpm stats 32", "rpm set 1200", "rpm event on 4 500", "rpm counter on 20000",
+    "rpm latency reset", "rpm duty on", "rpm filter 4 20 30", "rpm timeout 3 500", "rpm avg 16 100",
+    "pid gains 0.1 0.5 0", "fan 2 pwm 25000 40", "step 60 0 2000", "sweep status", "fault limit 5000 300 500",
+    "ramp freq 1000 500", "follow on 2", "dither on 20000",
+    "motor stop", "motor status", "save", "load", "reset",
+    "set pwm 25000 37.5",
+    "WIFI MyNetwork secret123", "ip", "wifi status", "wifi start", "wifi stop", "wifi scan", "web status",
+    "uart1 mode pwm", "uart1 config 115200 8 N 1", "uart1 pwm 25000 50 on", "uart1 compl on 200",
+    "uart1 status", "uart1 switch reset", "UART1 WRITE Hello World",
+    "uart2 config 9600", "uart2 status", "UART2 WRITE ping",
+    "buzzer beep 2000 100", "buzzer on", "led_pwm fade 255 1000", "ledpwm fade 0 500",
+    "led_pwm 5000 128", "ledpwm 128", "relay on", "gpio high",
+    "keys", "keys status", "keys config 50 1000", "keys mode duty",
+    "peripherals", "peripheral status", "peripheral stats", "peripheral save", "peripheral load",
+    "peripheral reset", "trace dump 32", "executor reset", "begin", "commit", "abort",
+};
+
+template <typename F>
+double timeNs(F dispatch, const std::string& line, int iterations) {
+    volatile unsigned sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = sink + dispatch(line);
+    }
+    auto end = std::chrono::steady_clock::now();
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(end - start).count() / iterations;
+}
+
+int runBenchmark() {
+    const int iterations = 200000;
+    double oldTotal = 0.0, newTotal = 0.0, oldWorst = 0.0, newWorst = 0.0;
+    int mismatches = 0;
+    uint32_t compared = 0;
+
+    printf("%-28s %10s %10s %8s\n", "command", "old ns", "new ns", "speedup");
+    for (uint32_t i = 0; i < CMD_COUNT; i++) {
+        std::string line = SAMPLES[i];
+        CommandId oldId = oldDispatch(line);
+        CommandId newId = newDispatch(line);
+        bool inOldChain = (oldId != CMD_NONE);
+        if ((inOldChain && oldId != (CommandId)i) || newId != (CommandId)i) {
+            printf("MISMATCH %-28s expected %u, old %u, new %u\n", SAMPLES[i], i, oldId, newId);
+            mismatches++;
+            continue;
+        }
+
+        if (!inOldChain) {
+            double newNs = timeNs(newDispatch, line, iterations);
+            newWorst = std::max(newWorst, newNs);
+            printf("%-28s %10s %10.1f %8s\n", SAMPLES[i], "-", newNs, "-");
+            continue;
+        }
+
+        compared++;
+        double oldNs = timeNs(oldDispatch, line, iterations);
+        double newNs = timeNs(newDispatch, line, iterations);
+        oldTotal += oldNs;
+        newTotal += newNs;
+        oldWorst = std::max(oldWorst, oldNs);
+        newWorst = std::max(newWorst, newNs);
+        printf("%-28s %10.1f %10.1f %7.1fx\n", SAMPLES[i], oldNs, newNs, oldNs / newNs);
+    }
+
+    // Unknown commands walk the whole old chain
+    std::string unknown = "frobnicate 1 2 3";
+    double oldMiss = timeNs(oldDispatch, unknown, iterations);
+    double newMiss = timeNs(newDispatch, unknown, iterations);
+    printf("%-28s %10.1f %10.1f %7.1fx\n", "(unknown command)", oldMiss, newMiss, oldMiss / newMiss);
+
+    printf("\n%u commands, %u-slot table, seed 0x%08X\n", (unsigned)CMD_COUNT,
+           (unsigned)CommandHash::SLOT_COUNT, (unsigned)CommandHash::SEED);
+    printf("mean  old %.1f ns, new %.1f ns (%u commands in both)\n", oldTotal / compared, newTotal / compared,
+           (unsigned)compared);
+    printf("worst old %.1f ns, new %.1f ns\n", oldWorst, newWorst);
+    return mismatches == 0 ? 0 : 1;
+}
+
+int findSeed() {
+    std::vector<bool> used(CommandHash::SLOT_COUNT);
+    uint32_t state = 0x12345678u;
+    for (uint32_t attempt = 0; attempt < 10000000u; attempt++) {
+        state = state * 1664525u + 1013904223u;  // LCG
+        uint32_t seed = state | 1u;
+        std::fill(used.begin(), used.end(), false);
+        bool ok = true;
+        for (uint32_t i = 0; i < CMD_COUNT && ok; i++) {
+            uint32_t s = CommandHash::slot(CommandHash::HASHES[i], seed);
+            ok = !used[s];
+            used[s] = true;
+        }
+        if (ok) {
+            printf("static constexpr uint32_t SEED = 0x%08Xu;  // %u attempts\n", (unsigned)seed, attempt + 1);
+            return 0;
+        }
+    }
+    printf("No seed found: increase CommandHash::SLOT_BITS\n");
+    return 1;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1 && strcmp(argv[1], "--seed") == 0) {
+        return findSeed();
+    }
+    return runBenchmark();
+}
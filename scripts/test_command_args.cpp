@@ -0,0 +1,226 @@
+// Host test: CommandArgs tokenizer, number parsers and error columns
+//
+// Build and run on the PC (no Arduino headers needed):
+//   g++ -std=gnu++11 -O2 -Isrc scripts/test_command_args.cpp src/CommandArgs.cpp -o test_command_args
+//   ./test_command_args         # exits non-zero if any case fails
+//
+// Arguments are parsed the way CommandParser does: the view starts after the
+// command keywords and error columns count from the start of the whole line,
+// so a column here is the 1-based position a user sees in the typed command.
+
+#include "CommandArgs.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+int failures = 0;
+int checks = 0;
+
+#define CHECK(cond, ...)                                   \
+    do {                                                   \
+        checks++;                                          \
+        if (!(cond)) {                                     \
+            failures++;                                    \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);    \
+            printf(__VA_ARGS__);                           \
+            printf("\n");                                  \
+        }                                                  \
+    } while (0)
+
+// Arguments of `line` starting after the first `skip` characters
+CommandArgs argsOf(const char* line, size_t skip) {
+    return CommandArgs(line + skip, line);
+}
+
+void expectInt(const char* token, int32_t min, int32_t max, int32_t expected) {
+    CommandArgs args(token);
+    int32_t v = 12345;
+    bool ok = args.getInt(0, min, max, v);
+    CHECK(ok && v == expected, "getInt(\"%s\") = %d (ok %d), expected %d", token, v, ok, expected);
+}
+
+void expectUInt(const char* token, uint32_t min, uint32_t max, uint32_t expected) {
+    CommandArgs args(token);
+    uint32_t v = 12345;
+    bool ok = args.getUInt(0, min, max, v);
+    CHECK(ok && v == expected, "getUInt(\"%s\") = %u (ok %d), expected %u", token, v, ok, expected);
+}
+
+void expectFloat(const char* token, float expected) {
+    CommandArgs args(token);
+    float v = 12345.0f;
+    bool ok = args.getFloat(0, -1e30f, 1e30f, v);
+    float tolerance = std::fabs(expected) * 1e-6f;
+    CHECK(ok && std::fabs(v - expected) <= tolerance, "getFloat(\"%s\") = %g (ok %d), expected %g",
+          token, v, ok, expected);
+}
+
+// Integer parse of argument `arg` must fail with `error` at `column`, leaving out unchanged
+void expectIntError(const char* line, size_t skip, uint8_t arg, int32_t min, int32_t max,
+                    CommandArgs::Error error, uint16_t column) {
+    CommandArgs args = argsOf(line, skip);
+    int32_t v = 777;
+    bool ok = args.getInt(arg, min, max, v);
+    CHECK(!ok && v == 777 && args.error() == error && args.errorArg() == arg && args.errorColumn() == column,
+          "\"%s\" arg %u: ok %d, error %d col %u, expected error %d col %u", line, arg, ok,
+          (int)args.error(), args.errorColumn(), (int)error, column);
+}
+
+void expectFloatError(const char* line, size_t skip, uint8_t arg, float min, float max,
+                      CommandArgs::Error error, uint16_t column) {
+    CommandArgs args = argsOf(line, skip);
+    float v = 777.0f;
+    bool ok = args.getFloat(arg, min, max, v);
+    CHECK(!ok && v == 777.0f && args.error() == error && args.errorArg() == arg && args.errorColumn() == column,
+          "\"%s\" arg %u: ok %d, error %d col %u, expected error %d col %u", line, arg, ok,
+          (int)args.error(), args.errorColumn(), (int)error, column);
+}
+
+void testTokens() {
+    CommandArgs empty("   \t ");
+    CHECK(empty.empty() && empty.count() == 0, "blank line has %u tokens", empty.count());
+    CHECK(!empty.has(0) && strcmp(empty.text(0), "") == 0 && empty.length(0) == 0, "missing token not empty");
+
+    const char* line = "UART1 WRITE  Hello,  World \t\r\n";
+    CommandArgs args = argsOf(line, 11);
+    CHECK(args.count() == 2, "count %u, expected 2", args.count());
+    CHECK(args.length(0) == 6 && strncmp(args.text(0), "Hello,", 6) == 0, "token 0 wrong");
+    CHECK(args.restLength(0) == 13 && strncmp(args.rest(0), "Hello,  World", 13) == 0,
+          "rest keeps inner spacing, drops trailing: length %u", (unsigned)args.restLength(0));
+
+    char buf[8];
+    CHECK(args.copyRest(0, buf, sizeof(buf)) == 7 && strcmp(buf, "Hello, ") == 0, "copyRest truncation: \"%s\"", buf);
+    CHECK(args.copy(1, buf, sizeof(buf)) == 5 && strcmp(buf, "World") == 0, "copy: \"%s\"", buf);
+    CHECK(args.copy(5, buf, sizeof(buf)) == 0 && buf[0] == '\0', "copy of missing token not empty");
+    CHECK(args.copy(0, buf, 0) == 0, "copy into size 0");
+
+    CommandArgs kw("on OFF Pwm");
+    CHECK(kw.is(0, "ON") && kw.is(1, "off") && kw.is(2, "PWM"), "keywords are case-insensitive");
+    CHECK(!kw.is(2, "PW") && !kw.is(2, "PWMX") && !kw.is(3, "PWM"), "prefix/suffix/missing keyword matched");
+
+    CommandArgs many("1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18");
+    CHECK(many.count() == CommandArgs::MAX_TOKENS, "token limit: %u", many.count());
+
+    CommandArgs null(nullptr);
+    CHECK(null.empty(), "null text has tokens");
+}
+
+void testNumbers() {
+    expectInt("0", -10, 10, 0);
+    expectInt("-0", -10, 10, 0);
+    expectInt("+7", -10, 10, 7);
+    expectInt("-10", -10, 10, -10);
+    expectInt("0x1F", 0, 100, 31);
+    expectInt("0XfF", 0, 1000, 255);
+    expectInt("-0x10", -100, 0, -16);
+    expectInt("2147483647", 0, 2147483647, 2147483647);
+    expectInt("-2147483648", -2147483647 - 1, 0, -2147483647 - 1);
+    expectInt("007", 0, 10, 7);
+    expectUInt("4294967295", 0, 4294967295u, 4294967295u);
+    expectUInt("0xFFFFFFFF", 0, 4294967295u, 4294967295u);
+    expectUInt("25000", 10, 500000, 25000);
+
+    expectFloat("0", 0.0f);
+    expectFloat("-1.5", -1.5f);
+    expectFloat("+.25", 0.25f);
+    expectFloat("5.", 5.0f);
+    expectFloat("37.5", 37.5f);
+    expectFloat("1e3", 1000.0f);
+    expectFloat("2.5E-2", 0.025f);
+    expectFloat("1e+2", 100.0f);
+    expectFloat("0.000123", 0.000123f);
+    expectFloat("123456789012345678901234", 1.23456789e23f);  // More digits than the mantissa keeps
+    expectFloat("1e-50", 0.0f);                               // Underflow rounds to zero
+
+    // Out of range, including values beyond 32 bits that must not wrap
+    CommandArgs big("99999999999999999999 4294967296 -1");
+    uint32_t u = 5;
+    CHECK(!big.getUInt(0, 0, 4294967295u, u) && big.error() == CommandArgs::ARG_RANGE && u == 5,
+          "20-digit integer accepted");
+    CHECK(!big.getUInt(1, 0, 4294967295u, u) && big.error() == CommandArgs::ARG_RANGE, "2^32 accepted");
+    CHECK(!big.getUInt(2, 0, 10, u) && big.error() == CommandArgs::ARG_RANGE, "-1 accepted as unsigned");
+    CommandArgs huge("1e1000");
+    float f = 5.0f;
+    CHECK(!huge.getFloat(0, -1e30f, 1e30f, f) && huge.error() == CommandArgs::ARG_RANGE && f == 5.0f,
+          "1e1000 accepted");
+
+    // A later success clears the previous error
+    CommandArgs mixed("x 3");
+    int32_t v = 0;
+    CHECK(!mixed.getInt(0, 0, 9, v) && mixed.getInt(1, 0, 9, v) && v == 3 && mixed.error() == CommandArgs::ARG_OK,
+          "error not cleared by a later success");
+}
+
+void testErrorColumns() {
+    //                  1234567890123456789
+    const char* freq = "SET PWM_FREQ 25k";
+    expectIntError(freq, 13, 0, 10, 500000, CommandArgs::ARG_SYNTAX, 16);    // 'k'
+    expectIntError(freq, 13, 1, 10, 500000, CommandArgs::ARG_MISSING, 0);
+
+    const char* duty = "SET PWM_DUTY  12.5.1";
+    expectFloatError(duty, 13, 0, 0.0f, 100.0f, CommandArgs::ARG_SYNTAX, 19);  // Second '.'
+    expectFloatError("SET PWM_DUTY 150", 13, 0, 0.0f, 100.0f, CommandArgs::ARG_RANGE, 14);
+    expectFloatError("SET PWM_DUTY .", 13, 0, 0.0f, 100.0f, CommandArgs::ARG_SYNTAX, 15);
+    expectFloatError("SET PWM_DUTY 1e", 13, 0, 0.0f, 100.0f, CommandArgs::ARG_SYNTAX, 16);
+    expectFloatError("SET PWM_DUTY 1e+", 13, 0, 0.0f, 100.0f, CommandArgs::ARG_SYNTAX, 17);
+    expectFloatError("SET PWM_DUTY inf", 13, 0, 0.0f, 100.0f, CommandArgs::ARG_SYNTAX, 14);
+    expectFloatError("SET PWM_DUTY -", 13, 0, -1.0f, 100.0f, CommandArgs::ARG_SYNTAX, 15);
+
+    const char* fan = "FAN 2 PWM 25000 x50";
+    expectIntError(fan, 4, 3, 0, 100, CommandArgs::ARG_SYNTAX, 17);          // 'x' of the 4th argument
+    expectIntError(fan, 4, 2, 10, 20000, CommandArgs::ARG_RANGE, 11);        // Range points at the token
+    expectIntError("RPM AVG 0x", 8, 0, 0, 100, CommandArgs::ARG_SYNTAX, 11);
+    expectIntError("RPM AVG 0xG", 8, 0, 0, 100, CommandArgs::ARG_SYNTAX, 11);
+    expectIntError("RPM AVG +", 8, 0, 0, 100, CommandArgs::ARG_SYNTAX, 10);
+    expectIntError("RPM AVG 1.5", 8, 0, 0, 100, CommandArgs::ARG_SYNTAX, 10);
+
+    // Without a line start, columns count from the argument text
+    expectIntError("  7 8z", 0, 1, 0, 100, CommandArgs::ARG_SYNTAX, 6);
+}
+
+void testErrorText() {
+    CommandArgs args = argsOf("SET PWM_FREQ 25k", 13);
+    uint32_t v;
+    args.getUInt(0, 10, 500000, v);
+    CHECK(strcmp(args.errorText(), "argument 1 \"25k\": not a number at column 16") == 0, "text: %s",
+          args.errorText());
+
+    args.getUInt(1, 10, 500000, v);
+    CHECK(strcmp(args.errorText(), "argument 2 missing") == 0, "text: %s", args.errorText());
+
+    CommandArgs range = argsOf("FAN 1 PWM 9", 4);
+    range.getUInt(2, 10, 500000, v);
+    CHECK(strcmp(range.errorText(), "argument 3 \"9\" at column 11: must be 10 to 500000") == 0, "text: %s",
+          range.errorText());
+
+    float f;
+    CommandArgs duty = argsOf("SET PWM_DUTY 100.5", 13);
+    duty.getFloat(0, 0.0f, 100.0f, f);
+    CHECK(strcmp(duty.errorText(), "argument 1 \"100.5\" at column 14: must be 0 to 100") == 0, "text: %s",
+          duty.errorText());
+
+    // Long tokens are clipped to 16 characters and fit the message buffer
+    int32_t i;
+    CommandArgs longTok("abcdefghijklmnopqrstuvwxyz");
+    longTok.getInt(0, 0, 1, i);
+    CHECK(strcmp(longTok.errorText(), "argument 1 \"abcdefghijklmnop\": not a number at column 1") == 0,
+          "text: %s", longTok.errorText());
+
+    CommandArgs ok("1");
+    CHECK(strcmp(ok.errorText(), "no error") == 0, "text: %s", ok.errorText());
+}
+
+}  // namespace
+
+int main() {
+    testTokens();
+    testNumbers();
+    testErrorColumns();
+    testErrorText();
+
+    printf("%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -25,6 +25,7 @@ import time
 import sys
 import threading
 import os
+import struct
 from typing import List, Optional, Tuple
 
 # ==================== 配置常數 ====================
@@ -37,6 +38,16 @@ HID_PACKET_SIZE = 64  # HID 資料封包大小（不含 Report ID）
 PROTOCOL_0xA1_HEADER_SIZE = 3  # 0xA1 協定標頭大小（0xA1 + length + 0x00）
 MAX_COMMAND_LENGTH = HID_PACKET_SIZE - PROTOCOL_0xA1_HEADER_SIZE  # 61 bytes
 
+# 二進位協定（0xA0 請求 / 0xA2 回應，見 PROTOCOL.md）
+BINARY_REQUEST = 0xA0
+BINARY_RESPONSE = 0xA2
+OP_SET_PWM = 0x10
+OP_READ_MEASUREMENTS = 0x20
+OP_READ_STATUS = 0x21
+OP_BATCH_GET = 0x30
+BINARY_STATUS_NAMES = {0: 'OK', 1: 'BAD_OPCODE', 2: 'BAD_LENGTH', 3: 'OUT_OF_RANGE',
+                       4: 'WRONG_MODE', 5: 'BUSY', 6: 'TRUNCATED', 7: 'FAULT'}
+
 # 超時設定
 DEFAULT_RESPONSE_TIMEOUT = 2.0  # 等待回應的預設超時（秒）
 SEND_COMMAND_DELAY = 0.5  # 發送命令後的等待時間（秒）
@@ -202,6 +213,95 @@ def decode_response_0xA1(data: List[int]) -> Optional[str]:
         # 解碼失敗、索引錯誤或類型錯誤
         return None
 
+def binary_transaction(device: hid.HidDevice, opcode: int, payload: bytes, seq: int,
+                       timeout: float = DEFAULT_RESPONSE_TIMEOUT) -> Optional[Tuple[int, bytes, float]]:
+    """
+    發送一個 0xA0 請求並等待序號相同的 0xA2 回應
+
+    返回: (status, payload, 往返時間 ms)，逾時返回 None
+    """
+    packet = bytes([BINARY_REQUEST, opcode, seq & 0xFF, (seq >> 8) & 0xFF, len(payload)]) + payload
+    packet += bytes(HID_PACKET_SIZE - len(packet))
+
+    with response_lock:
+        received_responses.clear()
+
+    output_report = device.find_output_reports()[0]
+    output_report.set_raw_data([0] + list(packet))
+    start = time.perf_counter()
+    output_report.send()
+
+    while (time.perf_counter() - start) < timeout:
+        with response_lock:
+            while received_responses:
+                data = received_responses.pop(0)
+                if data[0] == BINARY_RESPONSE and data[1] == opcode and (data[2] | (data[3] << 8)) == seq:
+                    elapsed_ms = (time.perf_counter() - start) * 1000.0
+                    return data[4], bytes(data[6:6 + data[5]]), elapsed_ms
+        time.sleep(0.0005)
+
+    return None
+
+def binary_mode(args: List[str]) -> None:
+    """二進位協定測試（status / measure / pwm <Hz> <duty%> / get <id...>）"""
+    if not args:
+        print("✗ 請提供 status、measure、pwm 或 get")
+        return
+
+    op = args[0].lower()
+    if op == 'status':
+        opcode, payload = OP_READ_STATUS, b''
+    elif op == 'measure':
+        opcode, payload = OP_READ_MEASUREMENTS, b''
+    elif op == 'pwm' and len(args) >= 3:
+        opcode = OP_SET_PWM
+        payload = struct.pack('<IHBB', int(args[1]), int(round(float(args[2]) * 100)), 0x03, 0)
+    elif op == 'get' and len(args) >= 2:
+        opcode, payload = OP_BATCH_GET, bytes(int(h, 16) for h in args[1:])
+    else:
+        print(f"✗ 未知的二進位命令: {' '.join(args)}")
+        return
+
+    device = find_device()
+    if not device:
+        print("找不到設備！")
+        return
+
+    device.open()
+    try:
+        device.set_raw_data_handler(data_handler)
+        result = binary_transaction(device, opcode, payload, seq=1)
+        if result is None:
+            print("未收到 0xA2 回應")
+            return
+
+        status, data, elapsed_ms = result
+        print(f"狀態: {BINARY_STATUS_NAMES.get(status, status)}  往返: {elapsed_ms:.2f} ms")
+
+        if status != 0 and status != 6:
+            return
+        if opcode == OP_READ_STATUS:
+            uptime, heap, trips, mode, fault, flags, poles = struct.unpack('<IIIBBBB', data)
+            print(f"  uptime={uptime} ms heap={heap} trips={trips} mode={mode} fault={fault} "
+                  f"flags=0x{flags:02X} pole_pairs={poles}")
+        elif opcode == OP_READ_MEASUREMENTS:
+            rpm, freq, period, tseq, age, pwm_freq, duty, signal, method = struct.unpack('<IIIIIIHBB', data)
+            print(f"  rpm={rpm / 64:.2f} freq={freq / 1024:.3f} Hz period={period / 16:.1f} ticks "
+                  f"seq={tseq} age={age} us")
+            print(f"  pwm={pwm_freq} Hz duty={duty / 100:.2f}% signal={signal} method={method}")
+        elif opcode == OP_SET_PWM:
+            freq, actual, duty, enabled, _ = struct.unpack('<IIHBB', data)
+            print(f"  freq={freq} Hz actual={actual / 1000:.3f} Hz duty={duty / 100:.2f}% enabled={enabled}")
+        else:
+            i = 0
+            while i + 2 <= len(data):
+                field, size = data[i], data[i + 1]
+                value = int.from_bytes(data[i + 2:i + 2 + size], 'little') if size else None
+                print(f"  0x{field:02X}: {value}")
+                i += 2 + size
+    finally:
+        device.close()
+
 def send_command(device: hid.HidDevice, command: str, use_0xA1_protocol: bool = False) -> bool:
     """發送命令到 HID 設備（自動加上 \\n）"""
     global received_responses
@@ -506,6 +606,7 @@ def main() -> None:
         print(f"  {sys.argv[0]} interactive          - 互動模式（支援命令和資料，簡單協定）")
         print(f"  {sys.argv[0]} interactive-0xa1     - 互動模式（0xA1 協定）")
         print(f"  {sys.argv[0]} receive              - 接收資料模式")
+        print(f"  {sys.argv[0]} binary <op> [args]   - 二進位協定 (status | measure | pwm <Hz> <duty%> | get <id...>)")
         print()
         print("範例:")
         print(f"  {sys.argv[0]} cmd *IDN?            - 發送識別命令（SCPI，會有 HID 回應）")
@@ -605,6 +706,12 @@ def main() -> None:
     elif command == 'receive':
         receive_data()
 
+    elif command == 'binary':
+        try:
+            binary_mode(sys.argv[2:])
+        except ValueError as e:
+            print(f"✗ 無效的參數: {e}")
+
     else:
         print(f"✗ 未知命令: {command}")
 
@@ -0,0 +1,280 @@
+// Host test: PeriodHistory outlier rejection, resync and statistics windows
+//
+// Build and run on the PC (no Arduino headers needed):
+//   g++ -std=gnu++11 -O2 -Isrc scripts/test_period_history.cpp src/CaptureRing.cpp -o test_period_history
+//   ./test_period_history       # exits non-zero if any case fails
+//
+// Edges are fed as the capture consumer does, as 64-bit tick timestamps in
+// order. Each case starts from a steady 10000-tick tach (8 kHz input at the
+// 80 MHz capture clock) with ±20 % tolerance, so the reference band is
+// 8000-12000 ticks, then injects one disturbance and checks what was kept.
+
+#include "CaptureRing.h"
+
+#include <cstdio>
+
+namespace {
+
+const uint32_t PERIOD = 10000;
+const uint32_t TOLERANCE_PCT = 20;
+
+int failures = 0;
+int checks = 0;
+
+#define CHECK(cond, ...)                                   \
+    do {                                                   \
+        checks++;                                          \
+        if (!(cond)) {                                     \
+            failures++;                                    \
+            printf("FAIL %s:%d: ", __FILE__, __LINE__);    \
+            printf(__VA_ARGS__);                           \
+            printf("\n");                                  \
+        }                                                  \
+    } while (0)
+
+// History with tolerance set and `periods` steady periods recorded; t is the newest edge
+void steady(PeriodHistory& h, uint64_t& t, uint32_t periods, uint32_t tolerancePct = TOLERANCE_PCT) {
+    h.reset();
+    h.resetOutlierStats();
+    h.setOutlierTolerance(tolerancePct);
+    t = 1000;
+    h.addEdge(t);
+    for (uint32_t i = 0; i < periods; i++) {
+        t += PERIOD;
+        h.addEdge(t);
+    }
+}
+
+CaptureStats stats(const PeriodHistory& h, uint32_t maxEdges = 0, uint64_t windowTicks = 0) {
+    CaptureStats s;
+    h.computeStats(maxEdges, windowTicks, s);
+    return s;
+}
+
+void testWarmUp() {
+    // Fewer than OUTLIER_WINDOW periods: no reference yet, everything is kept
+    PeriodHistory h;
+    h.setOutlierTolerance(TOLERANCE_PCT);
+    CHECK(!h.addEdge(0), "first edge recorded a period");
+    CHECK(h.addEdge(10000) && h.addEdge(13000) && h.addEdge(40000), "warm-up period rejected");
+    CHECK(h.size() == 3 && stats(h).minTicks == 3000 && stats(h).maxTicks == 27000,
+          "warm-up kept %u periods, min %u max %u", h.size(), stats(h).minTicks, stats(h).maxTicks);
+    OutlierStats o = h.getOutlierStats();
+    CHECK(o.shortRejects == 0 && o.longRejects == 0 && o.resyncs == 0, "warm-up counted outliers");
+
+    CHECK(!h.addEdge(40000), "zero-length period recorded");
+    CHECK(h.size() == 3, "zero-length period changed size");
+}
+
+void testGlitch() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 8);
+
+    // Noise edge 3000 ticks into a period: held as suspect, dropped by the next edge
+    CHECK(!h.addEdge(t + 3000), "glitch edge recorded a period");
+    t += PERIOD;
+    CHECK(h.addEdge(t), "edge after glitch not recorded");
+
+    CaptureStats s = stats(h);
+    CHECK(h.size() == 9 && s.minTicks == PERIOD && s.maxTicks == PERIOD,
+          "glitch leaked: %u periods, min %u max %u", h.size(), s.minTicks, s.maxTicks);
+    CHECK(h.getOutlierStats().shortRejects == 1, "shortRejects %u", h.getOutlierStats().shortRejects);
+    CHECK(h.getLastEdge() == t, "last edge not the real edge");
+}
+
+void testEarlyEdge() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 8);
+
+    // One edge 5000 early (phase jump): the period before it is off, the one after fits
+    uint64_t early = t + 5000;
+    CHECK(!h.addEdge(early), "early edge recorded a period");
+    CHECK(h.addEdge(early + PERIOD), "period after the early edge not recorded");
+    CHECK(h.getOutlierStats().shortRejects == 0 && h.getOutlierStats().resyncs == 0,
+          "early edge counted as glitch/resync");
+    CHECK(stats(h, 1).meanTicks == PERIOD, "newest period %u, expected %u", stats(h, 1).meanTicks, PERIOD);
+}
+
+void testHalfPeriod() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 8);
+
+    // Isolated glitches never add up to a resync
+    for (int i = 0; i < 5; i++) {
+        h.addEdge(t + 4000);
+        t += PERIOD;
+        h.addEdge(t);
+        t += PERIOD;
+        h.addEdge(t);
+    }
+    CHECK(h.getOutlierStats().shortRejects == 5 && h.getOutlierStats().resyncs == 0,
+          "isolated glitches: shortRejects %u resyncs %u", h.getOutlierStats().shortRejects,
+          h.getOutlierStats().resyncs);
+
+    // Step to half the period: every other edge fits the old median, so each
+    // new edge first looks like a glitch. OUTLIER_RESYNC of them in a row resync.
+    h.resetOutlierStats();
+    const uint32_t half = PERIOD / 2;
+    for (uint32_t i = 0; i < 2 * PeriodHistory::OUTLIER_RESYNC; i++) {
+        t += half;
+        h.addEdge(t);
+    }
+    OutlierStats o = h.getOutlierStats();
+    CHECK(o.shortRejects == PeriodHistory::OUTLIER_RESYNC - 1 && o.resyncs == 1 && stats(h, 1).meanTicks == half,
+          "half period: shortRejects %u resyncs %u, newest %u", o.shortRejects, o.resyncs, stats(h, 1).meanTicks);
+    for (int i = 0; i < 8; i++) {
+        t += half;
+        h.addEdge(t);
+    }
+    CHECK(stats(h, 8).minTicks == half && stats(h, 8).maxTicks == half, "half period not tracked");
+}
+
+void testMissedEdge() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 8);
+
+    // One edge missing: a double period is skipped, the edge stays as reference
+    t += 2 * PERIOD;
+    CHECK(!h.addEdge(t), "double period recorded");
+    t += PERIOD;
+    CHECK(h.addEdge(t), "period after the missed edge not recorded");
+
+    CaptureStats s = stats(h);
+    CHECK(h.size() == 9 && s.maxTicks == PERIOD, "missed edge leaked: %u periods, max %u", h.size(), s.maxTicks);
+    CHECK(h.getOutlierStats().longRejects == 1, "longRejects %u", h.getOutlierStats().longRejects);
+}
+
+void testSpeedUp() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 8);
+
+    // Real step to 7000 ticks: first short edge is a suspect, the second confirms it
+    const uint32_t fast = 7000;
+    t += fast;
+    CHECK(!h.addEdge(t), "first fast edge recorded");
+    t += fast;
+    CHECK(h.addEdge(t), "confirming fast edge not recorded");
+    CHECK(h.getOutlierStats().resyncs == 1 && h.size() == 1 && stats(h).meanTicks == fast,
+          "speed-up: resyncs %u, %u periods, mean %u", h.getOutlierStats().resyncs, h.size(), stats(h).meanTicks);
+
+    // The restarted median follows the new speed: a glitch is now judged against 7000
+    for (int i = 0; i < 6; i++) {
+        t += fast;
+        h.addEdge(t);
+    }
+    CHECK(!h.addEdge(t + 1500), "glitch at new speed recorded");
+    t += fast;
+    CHECK(h.addEdge(t) && stats(h).minTicks == fast && h.getOutlierStats().shortRejects == 1,
+          "glitch at new speed leaked: min %u", stats(h).minTicks);
+}
+
+void testSlowDown() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 8);
+
+    // Real step to 15000 ticks: OUTLIER_RESYNC long periods in a row restart the median
+    const uint32_t slow = 15000;
+    for (uint32_t i = 1; i < PeriodHistory::OUTLIER_RESYNC; i++) {
+        t += slow;
+        CHECK(!h.addEdge(t), "long period %u recorded before resync", i);
+    }
+    t += slow;
+    CHECK(h.addEdge(t), "resync period not recorded");
+    OutlierStats o = h.getOutlierStats();
+    CHECK(o.longRejects == PeriodHistory::OUTLIER_RESYNC - 1 && o.resyncs == 1 && h.size() == 1 &&
+          stats(h).meanTicks == slow,
+          "slow-down: longRejects %u resyncs %u, %u periods, mean %u", o.longRejects, o.resyncs, h.size(),
+          stats(h).meanTicks);
+
+    // A single long period in between resets the run
+    steady(h, t, 8);
+    t += slow;
+    h.addEdge(t);
+    t += PERIOD;
+    h.addEdge(t);
+    t += slow;
+    h.addEdge(t);
+    t += slow;
+    CHECK(!h.addEdge(t) && h.getOutlierStats().resyncs == 0, "interrupted long run resynced");
+}
+
+void testDisabled() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 8, 0);
+    h.addEdge(t + 3000);
+    h.addEdge(t + PERIOD);
+    CaptureStats s = stats(h);
+    CHECK(h.size() == 10 && s.minTicks == 3000 && s.maxTicks == PERIOD,
+          "tolerance 0 filtered: %u periods, min %u", h.size(), s.minTicks);
+    CHECK(h.getOutlierStats().shortRejects == 0, "tolerance 0 counted outliers");
+}
+
+void testStatsWindow() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, 10, 0);
+    t += 2 * PERIOD;
+    h.addEdge(t);  // Newest period 20000
+
+    CaptureStats all = stats(h);
+    CHECK(all.count == 11 && all.spanTicks == 12 * (uint64_t)PERIOD && all.medianTicks == PERIOD &&
+          all.meanTicks == 12 * PERIOD / 11 && all.maxTicks == 2 * PERIOD,
+          "all: count %u span %llu mean %u median %u", all.count, (unsigned long long)all.spanTicks,
+          all.meanTicks, all.medianTicks);
+
+    CaptureStats last = stats(h, 3);
+    CHECK(last.count == 3 && last.spanTicks == 4 * (uint64_t)PERIOD, "maxEdges 3: count %u", last.count);
+
+    // Periods whose opening edge lies within 35000 ticks of the newest edge
+    CaptureStats win = stats(h, 0, 35000);
+    CHECK(win.count == 2 && win.spanTicks == 3 * (uint64_t)PERIOD, "window: count %u", win.count);
+
+    // The newest period is always used, even if longer than the window
+    CaptureStats tiny = stats(h, 0, 1);
+    CHECK(tiny.count == 1 && tiny.meanTicks == 2 * PERIOD, "tiny window: count %u", tiny.count);
+
+    PeriodHistory empty;
+    CaptureStats none;
+    CHECK(!empty.computeStats(0, 0, none) && none.count == 0, "empty history has stats");
+}
+
+void testWrapAndSaturation() {
+    PeriodHistory h;
+    uint64_t t;
+    steady(h, t, PeriodHistory::HISTORY_SIZE + 50, 0);
+    CHECK(h.size() == PeriodHistory::HISTORY_SIZE, "size %u after wrap", h.size());
+    CHECK(stats(h).spanTicks == (uint64_t)PERIOD * PeriodHistory::HISTORY_SIZE, "span after wrap");
+
+    // Periods beyond 32 bits (sub-0.02 Hz input) saturate instead of wrapping
+    t += 0x100000000ULL + 5;
+    h.addEdge(t);
+    CHECK(stats(h, 1).maxTicks == UINT32_MAX, "long period %u not saturated", stats(h, 1).maxTicks);
+
+    h.reset();
+    CHECK(h.size() == 0 && !h.hasLastEdge(), "reset kept state");
+}
+
+}  // namespace
+
+int main() {
+    testWarmUp();
+    testGlitch();
+    testEarlyEdge();
+    testHalfPeriod();
+    testMissedEdge();
+    testSpeedUp();
+    testSlowDown();
+    testDisabled();
+    testStatsWindow();
+    testWrapAndSaturation();
+
+    printf("%d checks, %d failures\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+// Host test: PWMSolver against an exhaustive search of every prescaler × period pair
+//
+// Build and run on the PC (no Arduino headers needed):
+//   g++ -std=gnu++11 -O2 -Isrc scripts/test_pwm_solver.cpp src/PWMSolver.cpp -o test_pwm_solver
+//   ./test_pwm_solver           # exits non-zero on the first few mismatches
+//
+// The reference marks every tick count prescaler × period reachable within the
+// register limits, then walks outward from clock / f to the nearest reachable
+// counts. For each requested frequency the solver must match that residual,
+// pick the smallest prescaler that reaches it, keep a preferred prescaler that
+// is just as good, and report errorPpm consistent with its pair.
+
+#include "PWMSolver.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+const uint32_t CLOCK_HZ = PWMSolver::TIMER_CLK_HZ;
+const uint32_t MAX_TICKS = PWMSolver::MAX_PRESCALER * PWMSolver::MAX_PERIOD;
+
+int failures = 0;
+
+#define CHECK(cond, ...)                                   \
+    do {                                                   \
+        if (!(cond)) {                                     \
+            if (failures++ < 20) {                         \
+                printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+                printf(__VA_ARGS__);                       \
+                printf("\n");                              \
+            }                                              \
+        }                                                  \
+    } while (0)
+
+std::vector<bool> reachable;  // reachable[n]: n = prescaler × period for some legal pair
+
+void buildReachable() {
+    reachable.assign(MAX_TICKS + 1, false);
+    for (uint32_t p = PWMSolver::MIN_PRESCALER; p <= PWMSolver::MAX_PRESCALER; p++) {
+        for (uint32_t q = PWMSolver::MIN_PERIOD; q <= PWMSolver::MAX_PERIOD; q++) {
+            reachable[p * q] = true;
+        }
+    }
+}
+
+uint64_t residual(uint32_t frequency, uint64_t ticks) {
+    uint64_t produced = ticks * frequency;
+    return produced > CLOCK_HZ ? produced - CLOCK_HZ : CLOCK_HZ - produced;
+}
+
+// Minimum residual over all legal pairs, and the reachable counts achieving it
+uint64_t bruteForce(uint32_t frequency, std::vector<uint32_t>& bestTicks) {
+    bestTicks.clear();
+    uint32_t n = CLOCK_HZ / frequency;
+    uint32_t lo = n, hi = n + 1;
+    while (lo > 0 && !reachable[lo]) lo--;
+    while (hi <= MAX_TICKS && !reachable[hi]) hi++;
+
+    uint64_t best = UINT64_MAX;
+    uint32_t candidates[2] = { lo, hi };
+    for (uint32_t c : candidates) {
+        if (c == 0 || c > MAX_TICKS) continue;
+        uint64_t r = residual(frequency, c);
+        if (r < best) {
+            best = r;
+            bestTicks.clear();
+        }
+        if (r == best) bestTicks.push_back(c);
+    }
+    return best;
+}
+
+// True if the prescaler reaches one of the optimal tick counts with a legal period
+bool prescalerReaches(uint32_t prescaler, const std::vector<uint32_t>& bestTicks) {
+    for (uint32_t t : bestTicks) {
+        if (t % prescaler == 0) {
+            uint32_t q = t / prescaler;
+            if (q >= PWMSolver::MIN_PERIOD && q <= PWMSolver::MAX_PERIOD) return true;
+        }
+    }
+    return false;
+}
+
+void checkFrequency(uint32_t frequency, uint32_t preferred) {
+    std::vector<uint32_t> bestTicks;
+    uint64_t best = bruteForce(frequency, bestTicks);
+
+    PWMSolution sol;
+    bool ok = PWMSolver::solve(CLOCK_HZ, frequency, preferred, sol);
+    CHECK(ok, "f=%u: solve failed", frequency);
+    if (!ok) return;
+
+    CHECK(sol.prescaler >= PWMSolver::MIN_PRESCALER && sol.prescaler <= PWMSolver::MAX_PRESCALER &&
+          sol.period >= PWMSolver::MIN_PERIOD && sol.period <= PWMSolver::MAX_PERIOD,
+          "f=%u: pair %u x %u out of range", frequency, sol.prescaler, sol.period);
+
+    uint64_t r = residual(frequency, (uint64_t)sol.prescaler * sol.period);
+    CHECK(r == best, "f=%u pref=%u: residual %llu, brute force %llu (%u x %u)", frequency, preferred,
+          (unsigned long long)r, (unsigned long long)best, sol.prescaler, sol.period);
+
+    // Tie-break: the preferred prescaler if it is optimal, else the smallest optimal one
+    uint32_t expected = 0;
+    if (preferred >= PWMSolver::MIN_PRESCALER && preferred <= PWMSolver::MAX_PRESCALER &&
+        prescalerReaches(preferred, bestTicks)) {
+        expected = preferred;
+    } else {
+        for (uint32_t p = PWMSolver::MIN_PRESCALER; p <= PWMSolver::MAX_PRESCALER && !expected; p++) {
+            if (prescalerReaches(p, bestTicks)) expected = p;
+        }
+    }
+    CHECK(sol.prescaler == expected, "f=%u pref=%u: prescaler %u, expected %u", frequency, preferred,
+          sol.prescaler, expected);
+
+    double ticks = (double)sol.prescaler * sol.period;
+    double ppm = ((double)CLOCK_HZ - ticks * frequency) / (ticks * frequency) * 1e6;
+    CHECK(std::fabs(ppm - sol.errorPpm) <= 1.0, "f=%u: errorPpm %d, expected %.1f", frequency,
+          (int)sol.errorPpm, ppm);
+}
+
+void checkFixedPrescaler(uint32_t frequency, uint32_t prescaler) {
+    // Best period for this prescaler alone
+    uint64_t best = UINT64_MAX;
+    uint32_t bestQ = 0;
+    uint32_t center = CLOCK_HZ / (frequency * prescaler);
+    uint32_t from = center > 2 ? center - 2 : 0;
+    for (uint32_t q = from; q <= center + 2; q++) {
+        uint64_t r = residual(frequency, (uint64_t)prescaler * q);
+        if (r < best) {
+            best = r;
+            bestQ = q;
+        }
+    }
+
+    PWMSolution sol;
+    bool ok = PWMSolver::solveForPrescaler(CLOCK_HZ, frequency, prescaler, sol);
+    bool legal = bestQ >= PWMSolver::MIN_PERIOD && bestQ <= PWMSolver::MAX_PERIOD;
+    CHECK(ok == legal, "f=%u p=%u: solveForPrescaler %d, best period %u", frequency, prescaler, ok, bestQ);
+    if (ok && legal) {
+        CHECK(residual(frequency, (uint64_t)prescaler * sol.period) == best,
+              "f=%u p=%u: period %u, expected %u", frequency, prescaler, sol.period, bestQ);
+    }
+}
+
+}  // namespace
+
+int main() {
+    buildReachable();
+
+    PWMSolution sol;
+    CHECK(!PWMSolver::solve(CLOCK_HZ, 0, 0, sol), "f=0 accepted");
+    CHECK(!PWMSolver::solve(CLOCK_HZ, 4, 0, sol), "f=4 Hz accepted (below clock / (256 x 65535))");
+    CHECK(!PWMSolver::solve(CLOCK_HZ, CLOCK_HZ, 0, sol), "f=clock accepted (period < 2)");
+    CHECK(!PWMSolver::solveForPrescaler(CLOCK_HZ, 1000, 0, sol), "prescaler 0 accepted");
+    CHECK(!PWMSolver::solveForPrescaler(CLOCK_HZ, 1000, 257, sol), "prescaler 257 accepted");
+
+    uint32_t checked = 0;
+
+    // Every frequency where the prescaler search runs, plus the first O(1) ones
+    for (uint32_t f = 5; f <= 2000; f++, checked++) {
+        checkFrequency(f, 0);
+    }
+
+    // Pseudo-random sweep up to the 500 kHz command limit, with random preferences
+    uint32_t state = 0x2545F491u;
+    for (int i = 0; i < 50000; i++, checked++) {
+        state = state * 1664525u + 1013904223u;  // LCG
+        uint32_t f = 10 + (state >> 8) % 499991;
+        state = state * 1664525u + 1013904223u;
+        uint32_t preferred = (state >> 24) + 1;  // 1-256
+        checkFrequency(f, (i & 1) ? preferred : 0);
+        checkFixedPrescaler(f, preferred);
+    }
+
+    // Preferred prescaler kept on exact ties: 1 kHz is 80000 ticks = 2 × 40000 = 4 × 20000
+    CHECK(PWMSolver::solve(CLOCK_HZ, 1000, 4, sol) && sol.prescaler == 4 && sol.period == 20000,
+          "1 kHz pref 4: got %u x %u", sol.prescaler, sol.period);
+    CHECK(PWMSolver::solve(CLOCK_HZ, 1000, 0, sol) && sol.prescaler == 2 && sol.period == 40000,
+          "1 kHz: got %u x %u", sol.prescaler, sol.period);
+
+    printf("%u frequencies checked, %d failures\n", checked, failures);
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+#include "CommandParser.h"
+#include "HIDProtocol.h"
+#include "PeripheralManager.h"
+#include "WebServer.h"
+#include <cstring>
+
+// External references (defined in main.cpp)
+extern PeripheralManager peripheralManager;
+extern WebServerManager webServerManager;
+
+using namespace HIDBinary;
+
+namespace {
+
+inline uint16_t toCenti(float percent) {
+    return (uint16_t)(percent * 100.0f + 0.5f);
+}
+
+uint8_t faultCode(UART1Mux& uart1) {
+    return uart1.isFaultLatched() ? uart1.getFaultStatus().code : 0;
+}
+
+// Fixed-size little-endian value of one BATCH_GET field; 0 if the ID is unknown
+uint8_t readField(UART1Mux& uart1, uint8_t id, const TachSnapshot& tach, uint8_t* out) {
+    uint32_t value = 0;
+    uint8_t size = 4;
+
+    switch (id) {
+        case FIELD_PWM_FREQUENCY: value = uart1.getPWMFrequency(); break;
+        case FIELD_PWM_DUTY:      value = toCenti(uart1.getPWMDuty()); size = 2; break;
+        case FIELD_PWM_ENABLED:   value = uart1.isPWMEnabled() ? 1 : 0; size = 1; break;
+        case FIELD_RPM_Q6:        value = tach.rpmQ6; break;
+        case FIELD_FREQ_Q10:      value = tach.freqQ10; break;
+        case FIELD_PERIOD_Q4:     value = tach.periodQ4; break;
+        case FIELD_TACH_SEQ:      value = tach.seq; break;
+        case FIELD_POLE_PAIRS:    value = uart1.getPolePairs(); size = 1; break;
+        case FIELD_UART1_MODE:    value = (uint8_t)uart1.getMode(); size = 1; break;
+        case FIELD_FAULT_CODE:    value = faultCode(uart1); size = 1; break;
+        case FIELD_UPTIME_MS:     value = millis(); break;
+        case FIELD_FREE_HEAP:     value = ESP.getFreeHeap(); break;
+        default:                  return 0;
+    }
+
+    // ESP32-S3 is little-endian, same as the wire format
+    memcpy(out, &value, size);
+    return size;
+}
+
+}  // namespace
+
+// ============================================================================
+// HID Binary Requests (0xA0 → 0xA2)
+// ============================================================================
+
+bool CommandParser::processBinary(const uint8_t* request, uint8_t* reply) {
+    // [0xA0][opcode][seq_lo][seq_hi][length][payload...]
+    uint8_t opcode = request[1];
+    uint16_t seq = (uint16_t)(request[2] | (request[3] << 8));
+    uint8_t length = request[4];
+    const uint8_t* payload = request + REQUEST_HEADER_SIZE;
+
+    auto& uart1 = peripheralManager.getUART1();
+    uint8_t status = STATUS_OK;
+
+    switch (opcode) {
+        case OP_SET_PWM: {
+            SetPWMRequest set;
+            if (length != sizeof(set)) {
+                status = STATUS_BAD_LENGTH;
+                break;
+            }
+            memcpy(&set, payload, sizeof(set));
+
+            bool setFreq = (set.mask & SET_FREQUENCY) != 0;
+            bool setDuty = (set.mask & SET_DUTY) != 0;
+            if ((setFreq && (set.frequencyHz < 10 || set.frequencyHz > 500000 ||
+                             set.frequencyHz > uart1.getMaxFrequency())) ||
+                (setDuty && set.dutyCenti > 10000)) {
+                status = STATUS_OUT_OF_RANGE;
+                break;
+            }
+            if (uart1.getMode() != UART1Mux::MODE_PWM_RPM) {
+                status = STATUS_WRONG_MODE;
+                break;
+            }
+            if (set.mask != 0 && uart1.isFaultLatched()) {
+                status = STATUS_FAULT;  // Output is forced safe until FAULT CLEAR
+                break;
+            }
+
+            // Both together use the same single-period update as SET PWM_FREQ_DUTY
+            float duty = set.dutyCenti / 100.0f;
+            bool ok = true;
+            if (setFreq && setDuty) {
+                ok = uart1.setPWMFrequencyAndDuty(set.frequencyHz, duty);
+            } else if (setFreq) {
+                ok = uart1.setPWMFrequency(set.frequencyHz);
+            } else if (setDuty) {
+                ok = uart1.setPWMDuty(duty);
+            }
+            if (!ok) {
+                status = STATUS_OUT_OF_RANGE;
+                break;
+            }
+
+            PWMReply out;
+            out.frequencyHz = uart1.getPWMFrequency();
+            out.actualFrequencyMHz = (uint32_t)(uart1.getPWMActualFrequency() * 1000.0f + 0.5f);
+            out.dutyCenti = toCenti(uart1.getPWMDuty());
+            out.enabled = uart1.isPWMEnabled() ? 1 : 0;
+            out.reserved = 0;
+            HIDProtocol::encodeBinaryResponse(reply, opcode, seq, STATUS_OK, &out, sizeof(out));
+
+            if (set.mask != 0 && webServerManager.isRunning()) {
+                webServerManager.broadcastStatus();
+            }
+            return true;
+        }
+
+        case OP_READ_MEASUREMENTS: {
+            TachSnapshot tach = uart1.getTachSnapshot();
+            Measurements out;
+            out.rpmQ6 = tach.rpmQ6;
+            out.freqQ10 = tach.freqQ10;
+            out.periodQ4 = tach.periodQ4;
+            out.tachSeq = tach.seq;
+            out.ageUs = tach.timestampUs ? (uint32_t)(esp_timer_get_time() - tach.timestampUs) : 0;
+            out.pwmFrequencyHz = uart1.getPWMFrequency();
+            out.pwmDutyCenti = toCenti(uart1.getPWMDuty());
+            out.hasSignal = uart1.hasRPMSignal() ? 1 : 0;
+            out.rpmMethod = (uint8_t)uart1.getRPMMethod();
+            HIDProtocol::encodeBinaryResponse(reply, opcode, seq, STATUS_OK, &out, sizeof(out));
+            return true;
+        }
+
+        case OP_READ_STATUS: {
+            StatusReply out;
+            out.uptimeMs = millis();
+            out.freeHeap = ESP.getFreeHeap();
+            out.faultTrips = uart1.getFaultStatus().tripCount;
+            out.uart1Mode = (uint8_t)uart1.getMode();
+            out.faultCode = faultCode(uart1);
+            out.flags = (uart1.isPWMEnabled() ? STATUS_FLAG_PWM_ENABLED : 0) |
+                        (uart1.isFaultArmed() ? STATUS_FLAG_FAULT_ARMED : 0) |
+                        (uart1.isFaultLatched() ? STATUS_FLAG_FAULT_LATCHED : 0) |
+                        (uart1.isRamping() ? STATUS_FLAG_RAMPING : 0) |
+                        (uart1.isFollowing() ? STATUS_FLAG_FOLLOWING : 0) |
+                        (uart1.isDutyDither() ? STATUS_FLAG_DITHER : 0);
+            out.polePairs = (uint8_t)uart1.getPolePairs();
+            HIDProtocol::encodeBinaryResponse(reply, opcode, seq, STATUS_OK, &out, sizeof(out));
+            return true;
+        }
+
+        case OP_BATCH_GET: {
+            // Reply: [id][len][value] per requested field, in request order
+            uint8_t out[MAX_RESPONSE_PAYLOAD];
+            uint8_t used = 0;
+            TachSnapshot tach = uart1.getTachSnapshot();  // One snapshot for all tach fields
+
+            for (uint8_t i = 0; i < length; i++) {
+                uint8_t value[4];
+                uint8_t size = readField(uart1, payload[i], tach, value);
+                if (used + 2 + size > MAX_RESPONSE_PAYLOAD) {
+                    status = STATUS_TRUNCATED;
+                    break;
+                }
+                out[used++] = payload[i];
+                out[used++] = size;
+                memcpy(out + used, value, size);
+                used += size;
+            }
+            HIDProtocol::encodeBinaryResponse(reply, opcode, seq, status, out, used);
+            return true;
+        }
+
+        default:
+            status = STATUS_BAD_OPCODE;
+            break;
+    }
+
+    HIDProtocol::encodeBinaryResponse(reply, opcode, seq, status, nullptr, 0);
+    return false;
+}
@@ -0,0 +1,196 @@
+#include "CaptureRing.h"
+#include <algorithm>
+
+// ============================================================================
+// CaptureRing (consumer side)
+// ============================================================================
+
+uint32_t CaptureRing::pop(uint64_t* out, uint32_t maxCount) {
+    if (out == nullptr || maxCount == 0) {
+        return 0;
+    }
+
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    uint32_t h = head.load(std::memory_order_acquire);
+    uint32_t n = h - t;
+    if (n > maxCount) {
+        n = maxCount;
+    }
+
+    for (uint32_t i = 0; i < n; i++) {
+        out[i] = buffer[(t + i) & MASK];
+    }
+
+    // Release the slots only after they have been copied out
+    tail.store(t + n, std::memory_order_release);
+    return n;
+}
+
+// ============================================================================
+// PeriodHistory
+// ============================================================================
+
+bool PeriodHistory::addEdge(uint64_t timestamp) {
+    if (!hasEdge) {
+        lastEdge = timestamp;
+        hasEdge = true;
+        return false;
+    }
+
+    uint64_t delta = timestamp - lastEdge;
+    if (delta == 0) {
+        return false;
+    }
+    if (outlierPct == 0 || count < OUTLIER_WINDOW) {
+        hasSuspect = false;
+        longRun = 0;
+        shortRun = 0;
+        return recordPeriod(timestamp, delta);
+    }
+
+    uint64_t median = recentMedian();
+    uint64_t lo = median * (100 - outlierPct) / 100;
+    uint64_t hi = median * (100 + outlierPct) / 100;
+
+    if (hasSuspect) {
+        uint64_t fromSuspect = timestamp - suspectEdge;
+        hasSuspect = false;
+        if (delta >= lo && delta <= hi) {
+            // Fits from the previous good edge: the suspect was a glitch (a noise
+            // edge splits one period into two short ones, so this is tested first).
+            // Every edge in between looking like one means the speed really rose
+            // to about half the period.
+            if (++shortRun < OUTLIER_RESYNC) {
+                outliers.shortRejects++;
+                longRun = 0;
+                return recordPeriod(timestamp, delta);
+            }
+            outliers.resyncs++;
+            restartMedian();
+            lastEdge = suspectEdge;
+            return recordPeriod(timestamp, fromSuspect);
+        }
+        if (fromSuspect < lo) {
+            // Two short periods in a row: the suspect edge was real
+            outliers.resyncs++;
+            restartMedian();
+            lastEdge = suspectEdge;
+            return recordPeriod(timestamp, fromSuspect);
+        }
+        if (fromSuspect <= hi) {
+            // Only the period before the suspect was off: keep the suspect
+            lastEdge = suspectEdge;
+            longRun = 0;
+            shortRun = 0;
+            return recordPeriod(timestamp, fromSuspect);
+        }
+        // Still out of range: judge from the suspect edge as a long period
+        lastEdge = suspectEdge;
+        delta = fromSuspect;
+    }
+
+    if (delta < lo) {
+        suspectEdge = timestamp;
+        hasSuspect = true;
+        return false;
+    }
+
+    if (delta > hi) {
+        if (++longRun < OUTLIER_RESYNC) {
+            outliers.longRejects++;
+            lastEdge = timestamp;  // Real edge, unusable period
+            return false;
+        }
+        outliers.resyncs++;
+        restartMedian();
+    }
+    longRun = 0;
+    shortRun = 0;
+    return recordPeriod(timestamp, delta);
+}
+
+bool PeriodHistory::recordPeriod(uint64_t timestamp, uint64_t delta) {
+    lastEdge = timestamp;
+    periods[next] = (delta > UINT32_MAX) ? UINT32_MAX : (uint32_t)delta;
+    edgeTimes[next] = timestamp;
+    next = (next + 1) % HISTORY_SIZE;
+    if (count < HISTORY_SIZE) {
+        count++;
+    }
+    return true;
+}
+
+uint32_t PeriodHistory::recentMedian() const {
+    uint32_t window[OUTLIER_WINDOW];
+    for (uint32_t i = 0; i < OUTLIER_WINDOW; i++) {
+        uint32_t p = periods[(next + HISTORY_SIZE - 1 - i) % HISTORY_SIZE];
+        uint32_t j = i;
+        while (j > 0 && window[j - 1] > p) {
+            window[j] = window[j - 1];
+            j--;
+        }
+        window[j] = p;
+    }
+    return window[OUTLIER_WINDOW / 2];
+}
+
+void PeriodHistory::restartMedian() {
+    // Periods from before the speed change would outvote the new ones
+    next = 0;
+    count = 0;
+    longRun = 0;
+    shortRun = 0;
+}
+
+void PeriodHistory::reset() {
+    next = 0;
+    count = 0;
+    lastEdge = 0;
+    hasEdge = false;
+    hasSuspect = false;
+    longRun = 0;
+    shortRun = 0;
+}
+
+bool PeriodHistory::computeStats(uint32_t maxEdges, uint64_t windowTicks, CaptureStats& out) const {
+    out = CaptureStats();
+    if (count == 0) {
+        return false;
+    }
+
+    uint32_t limit = (maxEdges == 0 || maxEdges > count) ? count : maxEdges;
+    uint32_t newest = (next + HISTORY_SIZE - 1) % HISTORY_SIZE;
+    uint64_t newestTime = edgeTimes[newest];
+
+    uint32_t sorted[HISTORY_SIZE];
+    uint32_t used = 0;
+    uint64_t span = 0;
+    uint32_t minP = UINT32_MAX;
+    uint32_t maxP = 0;
+
+    for (uint32_t i = 0; i < limit; i++) {
+        uint32_t idx = (newest + HISTORY_SIZE - i) % HISTORY_SIZE;
+
+        // Window limit applies to the edge that opened this period
+        uint64_t start = edgeTimes[idx] - periods[idx];
+        if (windowTicks > 0 && used > 0 && (newestTime - start) > windowTicks) {
+            break;
+        }
+
+        uint32_t p = periods[idx];
+        sorted[used++] = p;
+        span += p;
+        if (p < minP) minP = p;
+        if (p > maxP) maxP = p;
+    }
+
+    std::nth_element(sorted, sorted + used / 2, sorted + used);
+
+    out.count = used;
+    out.spanTicks = span;
+    out.meanTicks = (uint32_t)(span / used);
+    out.medianTicks = sorted[used / 2];
+    out.minTicks = minP;
+    out.maxTicks = maxP;
+    return true;
+}
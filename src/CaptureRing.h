@@ -0,0 +1,207 @@
+#ifndef CAPTURE_RING_H
+#define CAPTURE_RING_H
+
+#include <stdint.h>
+#include <atomic>
+
+/**
+ * @brief Lock-free single-producer/single-consumer ring of capture timestamps
+ *
+ * The MCPWM capture ISR is the only producer and pushes one 64-bit extended
+ * timestamp (capture timer ticks) per edge. A single consumer task drains the
+ * ring with pop(). No locks are taken on either side: the producer publishes
+ * with a release store of head, the consumer frees slots with a release store
+ * of tail.
+ *
+ * When the ring is full the newest edge is dropped and counted, so a slow
+ * consumer never corrupts entries that are being read.
+ */
+class CaptureRing {
+public:
+    static constexpr uint32_t CAPACITY = 256;  // Must be a power of two
+    static constexpr uint32_t MASK = CAPACITY - 1;
+
+    /**
+     * @brief Push a timestamp (producer / ISR side only)
+     * @param timestamp Extended capture timestamp in timer ticks
+     * @return false if the ring was full and the edge was dropped
+     */
+    __attribute__((always_inline)) inline bool push(uint64_t timestamp) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if ((h - t) >= CAPACITY) {
+            overflows.store(overflows.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+            return false;
+        }
+        buffer[h & MASK] = timestamp;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Period from the previous edge to a new capture (producer / ISR side)
+     *
+     * Extends the 32-bit capture counter to the 64-bit timeline: the unsigned
+     * difference to the previous edge is the elapsed time across one counter
+     * wrap. Whole extra wraps (periods over 2^32 ticks, 53.7 s at 80 MHz) are
+     * invisible to it and come from the esp_timer time between the edges
+     * instead, which is accurate to far better than the ±2^31-tick margin.
+     * @param lastTicks Extended timestamp of the previous edge
+     * @param capture Raw 32-bit capture value of the new edge
+     * @param elapsedUs esp_timer time since the previous edge
+     * @param ticksPerUs Capture clock in ticks per microsecond
+     * @return Period in ticks; above UINT32_MAX when extra wraps were added
+     */
+    __attribute__((always_inline)) static inline uint64_t extendPeriod(uint64_t lastTicks, uint32_t capture,
+                                                                       int64_t elapsedUs, uint32_t ticksPerUs) {
+        uint64_t period = (uint32_t)(capture - (uint32_t)lastTicks);
+        uint64_t elapsedTicks = (uint64_t)elapsedUs * ticksPerUs;
+        if (elapsedTicks > period + (1ULL << 31)) {
+            period += ((elapsedTicks - period + (1ULL << 31)) >> 32) << 32;
+        }
+        return period;
+    }
+
+    /**
+     * @brief Pop up to maxCount timestamps (consumer side only)
+     * @param out Destination buffer
+     * @param maxCount Capacity of destination buffer
+     * @return Number of timestamps copied (oldest first)
+     */
+    uint32_t pop(uint64_t* out, uint32_t maxCount);
+
+    /**
+     * @brief Number of timestamps waiting to be consumed
+     */
+    uint32_t available() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Discard all pending timestamps (consumer side only)
+     */
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    /**
+     * @brief Get number of edges dropped because the ring was full
+     */
+    uint32_t getOverflowCount() const { return overflows.load(std::memory_order_relaxed); }
+
+private:
+    uint64_t buffer[CAPACITY];
+    std::atomic<uint32_t> head{0};       // Written by producer only
+    std::atomic<uint32_t> tail{0};       // Written by consumer only
+    std::atomic<uint32_t> overflows{0};  // Written by producer only
+};
+
+/**
+ * @brief Statistics over a set of capture periods (all values in timer ticks)
+ */
+struct CaptureStats {
+    uint32_t count = 0;        ///< Number of periods used
+    uint64_t spanTicks = 0;    ///< Sum of all periods (first edge to last edge)
+    uint32_t meanTicks = 0;    ///< Average period (spanTicks / count)
+    uint32_t medianTicks = 0;  ///< Median period
+    uint32_t minTicks = 0;     ///< Shortest period
+    uint32_t maxTicks = 0;     ///< Longest period
+};
+
+/**
+ * @brief Outlier rejection counters of a PeriodHistory
+ */
+struct OutlierStats {
+    uint32_t shortRejects = 0;  ///< Edges dropped as glitches (period too short)
+    uint32_t longRejects = 0;   ///< Periods skipped as too long (missed edge)
+    uint32_t resyncs = 0;       ///< Median restarted after a real speed change
+};
+
+/**
+ * @brief Consumer-side history of recent periods derived from the capture ring
+ *
+ * Keeps the last HISTORY_SIZE periods together with the timestamp of the edge
+ * that closed each period, so statistics can be taken over the last N edges
+ * or over a time window ending at the newest edge.
+ *
+ * Optional outlier rejection compares each new period with the median of the
+ * last OUTLIER_WINDOW accepted periods:
+ * - Too short: the edge is held as suspect. If the next edge fits the median
+ *   measured from the previous good edge, the suspect was a glitch and is
+ *   dropped; if the next period is short again, the speed really rose and
+ *   the median restarts. OUTLIER_RESYNC glitches in a row also restart it
+ *   (speed near half the period makes every other edge look like one).
+ * - Too long: the edge is kept as reference but the period is skipped (missed
+ *   edge). OUTLIER_RESYNC long periods in a row restart the median.
+ */
+class PeriodHistory {
+public:
+    static constexpr uint32_t HISTORY_SIZE = 128;
+    static constexpr uint32_t OUTLIER_WINDOW = 5;  // Periods in the reference median
+    static constexpr uint32_t OUTLIER_RESYNC = 3;  // Consecutive long periods / glitches accepted as real
+
+    /**
+     * @brief Feed the next edge timestamp (in order)
+     * @return true if a new period was recorded
+     */
+    bool addEdge(uint64_t timestamp);
+
+    /**
+     * @brief Forget all periods and the previous edge
+     */
+    void reset();
+
+    /**
+     * @brief Compute statistics over the newest periods
+     * @param maxEdges Use at most this many periods (0 = all available)
+     * @param windowTicks Only use periods ending within this many ticks of the
+     *                    newest edge (0 = no time limit). At least one period
+     *                    is always used when available.
+     * @param out Result
+     * @return true if at least one period was available
+     */
+    bool computeStats(uint32_t maxEdges, uint64_t windowTicks, CaptureStats& out) const;
+
+    /**
+     * @brief Number of periods currently stored
+     */
+    uint32_t size() const { return count; }
+
+    /**
+     * @brief Timestamp of the newest edge (valid when hasLastEdge())
+     */
+    uint64_t getLastEdge() const { return lastEdge; }
+
+    bool hasLastEdge() const { return hasEdge; }
+
+    /**
+     * @brief Outlier tolerance around the recent median (0 = off, else 5-90 %)
+     */
+    void setOutlierTolerance(uint32_t percent) { outlierPct = percent; }
+    uint32_t getOutlierTolerance() const { return outlierPct; }
+
+    OutlierStats getOutlierStats() const { return outliers; }
+    void resetOutlierStats() { outliers = OutlierStats(); }
+
+private:
+    bool recordPeriod(uint64_t timestamp, uint64_t delta);
+    uint32_t recentMedian() const;
+    void restartMedian();
+
+    uint32_t periods[HISTORY_SIZE];
+    uint64_t edgeTimes[HISTORY_SIZE];
+    uint32_t next = 0;    // Next write index
+    uint32_t count = 0;   // Valid entries
+    uint64_t lastEdge = 0;
+    bool hasEdge = false;
+
+    uint32_t outlierPct = 0;
+    uint64_t suspectEdge = 0;   // Short-period edge awaiting confirmation
+    bool hasSuspect = false;
+    uint32_t longRun = 0;       // Consecutive long periods
+    uint32_t shortRun = 0;      // Consecutive glitches
+    OutlierStats outliers;
+};
+
+#endif // CAPTURE_RING_H
@@ -0,0 +1,323 @@
+#include "CommandArgs.h"
+#include <stdio.h>
+
+namespace {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+inline char upper(char c) {
+    return (c >= 'a' && c <= 'z') ? (char)(c - 'a' + 'A') : c;
+}
+
+int hexValue(char c) {
+    if (isDigit(c)) return c - '0';
+    c = upper(c);
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// Largest magnitude tracked while parsing; anything above is out of range for 32-bit targets
+constexpr int64_t INT_PARSE_LIMIT = (int64_t)1 << 40;
+
+}  // namespace
+
+CommandArgs::CommandArgs(const char* text, const char* lineStart) {
+    if (text == nullptr) {
+        text = "";
+    }
+    line = (lineStart != nullptr) ? lineStart : text;
+
+    const char* p = text;
+    end = p;
+    while (*p != '\0') {
+        while (isSpace(*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+        const char* start = p;
+        while (*p != '\0' && !isSpace(*p)) {
+            p++;
+        }
+        end = p;
+        if (tokenCount < MAX_TOKENS) {
+            size_t len = p - start;
+            offsets[tokenCount] = (uint16_t)(start - line);
+            lengths[tokenCount] = (uint8_t)(len > 255 ? 255 : len);
+            tokenCount++;
+        }
+    }
+    message[0] = '\0';
+}
+
+// ============================================================================
+// Tokens
+// ============================================================================
+
+bool CommandArgs::is(uint8_t i, const char* keyword) const {
+    if (i >= tokenCount) {
+        return false;
+    }
+    const char* t = line + offsets[i];
+    uint8_t len = lengths[i];
+    for (uint8_t k = 0; k < len; k++) {
+        if (keyword[k] == '\0' || upper(t[k]) != upper(keyword[k])) {
+            return false;
+        }
+    }
+    return keyword[len] == '\0';
+}
+
+const char* CommandArgs::text(uint8_t i) const {
+    return (i < tokenCount) ? line + offsets[i] : "";
+}
+
+uint8_t CommandArgs::length(uint8_t i) const {
+    return (i < tokenCount) ? lengths[i] : 0;
+}
+
+const char* CommandArgs::rest(uint8_t i) const {
+    return (i < tokenCount) ? line + offsets[i] : "";
+}
+
+size_t CommandArgs::restLength(uint8_t i) const {
+    return (i < tokenCount) ? (size_t)(end - (line + offsets[i])) : 0;
+}
+
+size_t CommandArgs::copy(uint8_t i, char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+    size_t n = length(i);
+    if (n > size - 1) {
+        n = size - 1;
+    }
+    const char* t = text(i);
+    for (size_t k = 0; k < n; k++) {
+        out[k] = t[k];
+    }
+    out[n] = '\0';
+    return n;
+}
+
+size_t CommandArgs::copyRest(uint8_t i, char* out, size_t size) const {
+    if (size == 0) {
+        return 0;
+    }
+    size_t n = restLength(i);
+    if (n > size - 1) {
+        n = size - 1;
+    }
+    const char* t = rest(i);
+    for (size_t k = 0; k < n; k++) {
+        out[k] = t[k];
+    }
+    out[n] = '\0';
+    return n;
+}
+
+// ============================================================================
+// Numbers
+// ============================================================================
+
+bool CommandArgs::fail(Error error, uint8_t i, size_t charOffset) {
+    lastError = error;
+    errorIndex = i;
+    errorCol = (i < tokenCount) ? (uint16_t)(offsets[i] + charOffset + 1) : 0;
+    return false;
+}
+
+bool CommandArgs::parseInteger(uint8_t i, int64_t& value) {
+    if (i >= tokenCount) {
+        return fail(ARG_MISSING, i, 0);
+    }
+    const char* t = line + offsets[i];
+    uint8_t len = lengths[i];
+    uint8_t k = 0;
+
+    bool negative = false;
+    if (t[k] == '+' || t[k] == '-') {
+        negative = (t[k] == '-');
+        k++;
+    }
+
+    uint32_t base = 10;
+    if (k + 1 < len && t[k] == '0' && upper(t[k + 1]) == 'X') {
+        base = 16;
+        k += 2;
+    }
+    if (k == len) {
+        return fail(ARG_SYNTAX, i, k);
+    }
+
+    int64_t v = 0;
+    for (; k < len; k++) {
+        int digit = (base == 16) ? hexValue(t[k]) : (isDigit(t[k]) ? t[k] - '0' : -1);
+        if (digit < 0) {
+            return fail(ARG_SYNTAX, i, k);
+        }
+        if (v < INT_PARSE_LIMIT) {
+            v = v * base + digit;
+        }
+    }
+    value = negative ? -v : v;
+    return true;
+}
+
+bool CommandArgs::getInt(uint8_t i, int32_t min, int32_t max, int32_t& out) {
+    int64_t v;
+    errorIsFloat = false;
+    errorMin = min;
+    errorMax = max;
+    if (!parseInteger(i, v)) {
+        return false;
+    }
+    if (v < min || v > max) {
+        return fail(ARG_RANGE, i, 0);
+    }
+    out = (int32_t)v;
+    lastError = ARG_OK;
+    return true;
+}
+
+bool CommandArgs::getUInt(uint8_t i, uint32_t min, uint32_t max, uint32_t& out) {
+    int64_t v;
+    errorIsFloat = false;
+    errorMin = min;
+    errorMax = max;
+    if (!parseInteger(i, v)) {
+        return false;
+    }
+    if (v < (int64_t)min || v > (int64_t)max) {
+        return fail(ARG_RANGE, i, 0);
+    }
+    out = (uint32_t)v;
+    lastError = ARG_OK;
+    return true;
+}
+
+bool CommandArgs::getFloat(uint8_t i, float min, float max, float& out) {
+    errorIsFloat = true;
+    errorMin = min;
+    errorMax = max;
+    if (i >= tokenCount) {
+        return fail(ARG_MISSING, i, 0);
+    }
+    const char* t = line + offsets[i];
+    uint8_t len = lengths[i];
+    uint8_t k = 0;
+
+    bool negative = false;
+    if (t[k] == '+' || t[k] == '-') {
+        negative = (t[k] == '-');
+        k++;
+    }
+
+    // Up to 19 significant digits in an integer mantissa, the rest only move the exponent
+    uint64_t mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool any = false;
+    for (; k < len && isDigit(t[k]); k++) {
+        any = true;
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (t[k] - '0');
+            if (mantissa != 0) digits++;
+        } else {
+            exponent++;
+        }
+    }
+    if (k < len && t[k] == '.') {
+        for (k++; k < len && isDigit(t[k]); k++) {
+            any = true;
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (t[k] - '0');
+                if (mantissa != 0) digits++;
+                exponent--;
+            }
+        }
+    }
+    if (!any) {
+        return fail(ARG_SYNTAX, i, k);
+    }
+    if (k < len && upper(t[k]) == 'E') {
+        k++;
+        bool expNegative = false;
+        if (k < len && (t[k] == '+' || t[k] == '-')) {
+            expNegative = (t[k] == '-');
+            k++;
+        }
+        if (k == len || !isDigit(t[k])) {
+            return fail(ARG_SYNTAX, i, k);
+        }
+        int e = 0;
+        for (; k < len && isDigit(t[k]); k++) {
+            if (e < 1000) e = e * 10 + (t[k] - '0');
+        }
+        exponent += expNegative ? -e : e;
+    }
+    if (k != len) {
+        return fail(ARG_SYNTAX, i, k);
+    }
+
+    double v = (double)mantissa;
+    if (mantissa != 0) {
+        for (; exponent > 0; exponent--) {
+            v *= 10.0;
+            if (v > 1e39) break;  // Beyond any float range check
+        }
+        for (; exponent < 0; exponent++) {
+            v /= 10.0;
+            if (v < 1e-46) { v = 0.0; break; }
+        }
+    }
+    if (negative) {
+        v = -v;
+    }
+    if (v < min || v > max) {
+        return fail(ARG_RANGE, i, 0);
+    }
+    out = (float)v;
+    lastError = ARG_OK;
+    return true;
+}
+
+// ============================================================================
+// Errors
+// ============================================================================
+
+const char* CommandArgs::errorText() const {
+    unsigned arg = errorIndex + 1u;
+    int len = (errorIndex < tokenCount) ? lengths[errorIndex] : 0;
+    const char* tok = text(errorIndex);
+
+    switch (lastError) {
+        case ARG_OK:
+            snprintf(message, sizeof(message), "no error");
+            break;
+        case ARG_MISSING:
+            snprintf(message, sizeof(message), "argument %u missing", arg);
+            break;
+        case ARG_SYNTAX:
+            snprintf(message, sizeof(message), "argument %u \"%.*s\": not a number at column %u",
+                     arg, len > 16 ? 16 : len, tok, errorCol);
+            break;
+        case ARG_RANGE:
+            if (errorIsFloat) {
+                snprintf(message, sizeof(message), "argument %u \"%.*s\" at column %u: must be %g to %g",
+                         arg, len > 16 ? 16 : len, tok, errorCol, errorMin, errorMax);
+            } else {
+                snprintf(message, sizeof(message), "argument %u \"%.*s\" at column %u: must be %.0f to %.0f",
+                         arg, len > 16 ? 16 : len, tok, errorCol, errorMin, errorMax);
+            }
+            break;
+    }
+    return message;
+}
@@ -0,0 +1,109 @@
+#ifndef COMMAND_ARGS_H
+#define COMMAND_ARGS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Zero-allocation view of a command's argument tokens
+ *
+ * Tokens are (offset, length) spans into the caller's line, which is never
+ * copied or modified, so a command costs no heap allocation. Keywords are
+ * compared case-insensitively instead of upper-casing a copy, and numbers
+ * are parsed in place with range checks. A failed parse records which
+ * argument failed, why, and its column in the original line.
+ *
+ * Like CommandTable, this has no Arduino dependency and builds on the host.
+ */
+class CommandArgs {
+public:
+    static constexpr uint8_t MAX_TOKENS = 16;
+
+    enum Error : uint8_t {
+        ARG_OK = 0,
+        ARG_MISSING,        ///< Argument not given
+        ARG_SYNTAX,         ///< Not a number (column points at the offending character)
+        ARG_RANGE           ///< Valid number outside [min, max]
+    };
+
+    /**
+     * @param text First argument character (leading spaces allowed)
+     * @param line Start of the whole command line; error columns count from here
+     */
+    explicit CommandArgs(const char* text = "", const char* line = nullptr);
+
+    uint8_t count() const { return tokenCount; }
+    bool empty() const { return tokenCount == 0; }
+    bool has(uint8_t i) const { return i < tokenCount; }
+
+    /**
+     * @brief Case-insensitive keyword compare (false if the token is missing)
+     */
+    bool is(uint8_t i, const char* keyword) const;
+
+    /**
+     * @brief Token start ("" if missing); not NUL-terminated, see length()
+     */
+    const char* text(uint8_t i) const;
+    uint8_t length(uint8_t i) const;
+
+    /**
+     * @brief Raw text from token i to the end of the line (trailing spaces removed)
+     *
+     * For free text such as UART payloads or Wi-Fi passwords, which keep
+     * their spacing and case.
+     */
+    const char* rest(uint8_t i) const;
+    size_t restLength(uint8_t i) const;
+
+    /**
+     * @brief Copy a token / the rest of the line as a C string (truncated to size - 1)
+     * @return Characters copied
+     */
+    size_t copy(uint8_t i, char* out, size_t size) const;
+    size_t copyRest(uint8_t i, char* out, size_t size) const;
+
+    /**
+     * @brief Range-checked number parsers
+     *
+     * Integers accept an optional sign and 0x hex; floats accept sign,
+     * fraction and exponent. The whole token must be consumed.
+     * @return false with error()/errorText() set; out is unchanged
+     */
+    bool getInt(uint8_t i, int32_t min, int32_t max, int32_t& out);
+    bool getUInt(uint8_t i, uint32_t min, uint32_t max, uint32_t& out);
+    bool getFloat(uint8_t i, float min, float max, float& out);
+
+    Error error() const { return lastError; }
+    uint8_t errorArg() const { return errorIndex; }
+
+    /**
+     * @brief 1-based column of the error in the command line (0 if not applicable)
+     */
+    uint16_t errorColumn() const { return errorCol; }
+
+    /**
+     * @brief Last error as text, e.g. `argument 2 "25k": not a number at column 17`
+     */
+    const char* errorText() const;
+
+private:
+    const char* line;
+    const char* end;               // Last non-space character + 1
+    uint8_t tokenCount = 0;
+    uint16_t offsets[MAX_TOKENS];  // From line
+    uint8_t lengths[MAX_TOKENS];
+
+    Error lastError = ARG_OK;
+    uint8_t errorIndex = 0;
+    uint16_t errorCol = 0;
+    bool errorIsFloat = false;
+    double errorMin = 0.0;
+    double errorMax = 0.0;
+    mutable char message[80];
+
+    bool fail(Error error, uint8_t i, size_t charOffset);
+    bool parseInteger(uint8_t i, int64_t& value);
+};
+
+#endif // COMMAND_ARGS_H
@@ -0,0 +1,210 @@
+#include "CommandExecutor.h"
+#include "CommandTable.h"
+#include "HIDProtocol.h"
+#include "esp_timer.h"
+#include <cstring>
+
+// Global command executor (all transports post here)
+CommandExecutor commandExecutor;
+
+bool CommandExecutor::begin(CommandParser& commandParser) {
+    if (task) {
+        return true;
+    }
+    parser = &commandParser;
+
+    BaseType_t ok = xTaskCreatePinnedToCore(taskEntry, "Cmd_Exec", TASK_STACK, this,
+                                            TASK_PRIORITY, &task, TASK_CORE);
+    if (ok != pdPASS) {
+        Serial.println("[EXEC] Task create failed, commands run in the caller's task");
+        task = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Posting side (any task)
+// ============================================================================
+
+bool CommandExecutor::execute(const char* line, ICommandResponse* response, CommandSource source) {
+    if (line == nullptr || parser == nullptr) {
+        return false;
+    }
+
+    // Not started yet, or a command running on the executor posts another one
+    if (task == nullptr || xTaskGetCurrentTaskHandle() == task) {
+        return parser->processCommand(line, response, source);
+    }
+
+    // Unknown commands and argument errors are reported by processCommand on the executor.
+    // A ';' batch is always one normal record, whatever its first command is.
+    CommandMatch match;
+    uint8_t flags = (strchr(line, ';') == nullptr && findCommand(line, match))
+                        ? getCommandSpec(match.id).flags : 0;
+
+    if (flags & CMD_FLAG_INLINE) {
+        // Bypasses the batch/transaction state the executor task is using
+        inlined.fetch_add(1, std::memory_order_relaxed);
+        return parser->processInline(line, response, source);
+    }
+
+    CommandRecord record;
+    record.line = line;
+    record.frame = nullptr;
+    record.reply = nullptr;
+    record.response = response;
+    record.source = source;
+    record.urgent = (flags & CMD_FLAG_URGENT) != 0;
+
+    if (!post(record)) {
+        response->println("❌ 命令佇列已滿，請稍後重試");
+        return false;
+    }
+    return record.result;
+}
+
+bool CommandExecutor::executeBinary(const uint8_t* request, uint8_t* reply) {
+    if (request == nullptr || reply == nullptr || parser == nullptr) {
+        return false;
+    }
+
+    if (task == nullptr || xTaskGetCurrentTaskHandle() == task) {
+        return parser->processBinary(request, reply);
+    }
+
+    CommandRecord record;
+    record.line = nullptr;
+    record.frame = request;
+    record.reply = reply;
+    record.response = nullptr;
+    record.source = CMD_SOURCE_HID;
+    record.urgent = false;
+
+    if (!post(record)) {
+        uint16_t seq = (uint16_t)(request[2] | (request[3] << 8));
+        HIDProtocol::encodeBinaryResponse(reply, request[1], seq, HIDBinary::STATUS_BUSY, nullptr, 0);
+        return false;
+    }
+    return record.result;
+}
+
+// Push a filled-in record, wake the executor and wait until it has run.
+// Returns false (nothing run) if the lane was full.
+bool CommandExecutor::post(CommandRecord& record) {
+    StaticSemaphore_t doneBuffer;
+    record.result = false;
+    record.postedUs = esp_timer_get_time();
+    record.done = xSemaphoreCreateBinaryStatic(&doneBuffer);
+
+    CommandMailbox& lane = record.urgent ? urgentLane : normalLane;
+    if (!lane.push(&record)) {
+        rejected.fetch_add(1, std::memory_order_relaxed);
+        vSemaphoreDelete(record.done);
+        return false;
+    }
+    posted.fetch_add(1, std::memory_order_relaxed);
+    if (record.urgent) {
+        urgentPosted.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    xTaskNotifyGive(task);
+    xSemaphoreTake(record.done, portMAX_DELAY);
+    vSemaphoreDelete(record.done);
+    return true;
+}
+
+// ============================================================================
+// Executor task
+// ============================================================================
+
+void CommandExecutor::taskEntry(void* arg) {
+    static_cast<CommandExecutor*>(arg)->run();
+}
+
+void CommandExecutor::run() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        uint32_t depth = urgentLane.depth() + normalLane.depth();
+        if (depth > maxDepth) {
+            maxDepth = depth;
+        }
+
+        // Urgent lane is re-checked before every normal record
+        while (true) {
+            CommandRecord* record = urgentLane.pop();
+            if (record == nullptr) {
+                record = normalLane.pop();
+            }
+            if (record == nullptr) {
+                break;
+            }
+            runRecord(record);
+        }
+    }
+}
+
+void CommandExecutor::runRecord(CommandRecord* record) {
+    int64_t startUs = esp_timer_get_time();
+    if (record->line != nullptr) {
+        record->result = parser->processCommand(record->line, record->response, record->source);
+    } else {
+        record->result = parser->processBinary(record->frame, record->reply);
+    }
+    int64_t endUs = esp_timer_get_time();
+
+    uint32_t queueUs = (uint32_t)(startUs - record->postedUs);
+    uint32_t execUs = (uint32_t)(endUs - startUs);
+    executed++;
+    queueLastUs = queueUs;
+    queueSumUs += queueUs;
+    if (queueUs > queueMaxUs) {
+        queueMaxUs = queueUs;
+    }
+    execLastUs = execUs;
+    execSumUs += execUs;
+    if (execUs > execMaxUs) {
+        execMaxUs = execUs;
+    }
+
+    // The record belongs to the poster; it may be gone once done is given
+    xSemaphoreGive(record->done);
+}
+
+// ============================================================================
+// Statistics
+// ============================================================================
+
+CommandExecutor::Stats CommandExecutor::getStats() const {
+    Stats s;
+    s.posted = posted.load(std::memory_order_relaxed);
+    s.urgent = urgentPosted.load(std::memory_order_relaxed);
+    s.inlined = inlined.load(std::memory_order_relaxed);
+    s.rejected = rejected.load(std::memory_order_relaxed);
+    s.executed = executed;
+    s.maxDepth = maxDepth;
+    s.queueLastUs = queueLastUs;
+    s.queueAvgUs = executed ? (uint32_t)(queueSumUs / executed) : 0;
+    s.queueMaxUs = queueMaxUs;
+    s.execLastUs = execLastUs;
+    s.execAvgUs = executed ? (uint32_t)(execSumUs / executed) : 0;
+    s.execMaxUs = execMaxUs;
+    return s;
+}
+
+void CommandExecutor::resetStats() {
+    // EXECUTOR RESET itself runs on the executor task, the only writer of these
+    posted.store(0, std::memory_order_relaxed);
+    urgentPosted.store(0, std::memory_order_relaxed);
+    inlined.store(0, std::memory_order_relaxed);
+    rejected.store(0, std::memory_order_relaxed);
+    executed = 0;
+    maxDepth = 0;
+    queueLastUs = 0;
+    queueMaxUs = 0;
+    queueSumUs = 0;
+    execLastUs = 0;
+    execMaxUs = 0;
+    execSumUs = 0;
+}
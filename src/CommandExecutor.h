@@ -0,0 +1,134 @@
+#ifndef COMMAND_EXECUTOR_H
+#define COMMAND_EXECUTOR_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "CommandParser.h"
+#include "CommandMailbox.h"
+
+/**
+ * @brief Single task that runs every text command, whatever the transport
+ *
+ * hidTask, cdcTask, bleTask and the WebSocket handler used to call
+ * CommandParser::processCommand() concurrently, so two transports could
+ * reconfigure the same peripheral at once. Now they post a CommandRecord
+ * and the executor task runs the commands one at a time.
+ *
+ * Two lock-free mailboxes give two priorities: commands flagged
+ * CMD_FLAG_URGENT (MOTOR STOP, FAULT) go to the urgent lane, which is
+ * drained before every normal record, so a stop never waits behind
+ * queued bulk traffic. A command that is already running is not
+ * interrupted.
+ *
+ * execute() is synchronous: the caller's record lives on its stack and the
+ * caller sleeps on a binary semaphore until the command has finished, so
+ * the output goes to the originating ICommandResponse exactly as before.
+ * Commands flagged CMD_FLAG_INLINE (DELAY) touch no shared state and run
+ * in the caller's task so they do not hold up other transports. They go
+ * through CommandParser::processInline(), which skips the batch and
+ * transaction state, and the parser keeps no per-command members (the
+ * source is passed to the handlers), so they can overlap any executor
+ * command.
+ *
+ * Usage:
+ *   commandExecutor.begin(parser);
+ *   commandExecutor.execute(line, cdc_response, CMD_SOURCE_CDC);
+ */
+class CommandExecutor {
+public:
+    static constexpr uint32_t TASK_STACK = 8192;
+    static constexpr UBaseType_t TASK_PRIORITY = 2;  // Same as HID_Task
+    static constexpr BaseType_t TASK_CORE = 1;
+
+    /**
+     * @brief Queueing and execution statistics (times in µs)
+     */
+    struct Stats {
+        uint32_t posted;         ///< Records posted to the mailboxes
+        uint32_t urgent;         ///< ... of which on the urgent lane
+        uint32_t inlined;        ///< Commands run in the caller's task
+        uint32_t rejected;       ///< Mailbox full, command refused
+        uint32_t executed;       ///< Records run by the executor task
+        uint32_t maxDepth;       ///< Most records waiting at once (both lanes)
+        uint32_t queueLastUs;    ///< Post → start of execution
+        uint32_t queueAvgUs;
+        uint32_t queueMaxUs;
+        uint32_t execLastUs;     ///< Start → end of execution
+        uint32_t execAvgUs;
+        uint32_t execMaxUs;
+    };
+
+    CommandExecutor() = default;
+
+    /**
+     * @brief Create the executor task
+     * @param parser Parser the commands are run on
+     * @return true if successful
+     */
+    bool begin(CommandParser& parser);
+
+    bool isRunning() const { return task != nullptr; }
+
+    /**
+     * @brief Run one command line on the executor task and wait for it
+     *
+     * Falls back to running the command directly before begin() and when
+     * called from the executor task itself.
+     *
+     * @return CommandParser::processCommand() result; false if the mailbox was full
+     */
+    bool execute(const char* line, ICommandResponse* response, CommandSource source);
+
+    /**
+     * @brief Run one HID binary request (0xA0 frame) on the executor task and wait for it
+     *
+     * Binary requests share the normal lane with text commands, so they are
+     * serialized with every other transport. The reply frame is always
+     * written; a full mailbox gives a STATUS_BUSY reply.
+     *
+     * @param request 64-byte request frame
+     * @param reply 64-byte buffer for the 0xA2 reply frame
+     * @return CommandParser::processBinary() result; false if the mailbox was full
+     */
+    bool executeBinary(const uint8_t* request, uint8_t* reply);
+
+    Stats getStats() const;
+
+    /**
+     * @brief Clear the statistics (counters and latencies)
+     */
+    void resetStats();
+
+private:
+    static void taskEntry(void* arg);
+    void run();
+    void runRecord(CommandRecord* record);
+    bool post(CommandRecord& record);
+
+    CommandParser* parser = nullptr;
+    TaskHandle_t task = nullptr;
+    CommandMailbox urgentLane;
+    CommandMailbox normalLane;
+
+    // Written by posting tasks
+    std::atomic<uint32_t> posted{0};
+    std::atomic<uint32_t> urgentPosted{0};
+    std::atomic<uint32_t> inlined{0};
+    std::atomic<uint32_t> rejected{0};
+
+    // Written by the executor task only
+    uint32_t executed = 0;
+    uint32_t maxDepth = 0;
+    uint32_t queueLastUs = 0;
+    uint32_t queueMaxUs = 0;
+    uint64_t queueSumUs = 0;
+    uint32_t execLastUs = 0;
+    uint32_t execMaxUs = 0;
+    uint64_t execSumUs = 0;
+};
+
+extern CommandExecutor commandExecutor;
+
+#endif // COMMAND_EXECUTOR_H
@@ -0,0 +1,112 @@
+#ifndef COMMAND_MAILBOX_H
+#define COMMAND_MAILBOX_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "CommandParser.h"
+
+/**
+ * @brief One command posted to the CommandExecutor
+ *
+ * Fixed-size and owned by the posting task (usually on its stack). The
+ * poster blocks on `done` until the executor has run the command, so the
+ * line and the response object stay valid for the whole execution and
+ * nothing is copied or allocated.
+ */
+struct CommandRecord {
+    const char* line;              ///< NUL-terminated command line (nullptr for a binary request)
+    const uint8_t* frame;          ///< 64-byte HID binary request when line is nullptr
+    uint8_t* reply;                ///< 64-byte buffer for the binary reply
+    ICommandResponse* response;    ///< Where the output goes (originating transport)
+    CommandSource source;
+    bool urgent;                   ///< Posted on the urgent lane
+    bool result;                   ///< processCommand() / processBinary() return value
+    int64_t postedUs;              ///< esp_timer time when posted
+    SemaphoreHandle_t done;        ///< Given by the executor when finished
+};
+
+/**
+ * @brief Lock-free bounded multi-producer/single-consumer ring of CommandRecord*
+ *
+ * Any number of transport tasks push, the executor task is the only
+ * consumer. Each slot carries a sequence number (Vyukov bounded queue):
+ * a producer claims a position with a CAS on enqueuePos, writes the
+ * pointer and publishes it with a release store of the slot sequence;
+ * the consumer frees the slot by advancing the sequence by CAPACITY.
+ * No locks are taken, so a low-priority poster can never block a
+ * higher-priority one.
+ */
+class CommandMailbox {
+public:
+    static constexpr uint32_t CAPACITY = 8;  // Must be a power of two
+    static constexpr uint32_t MASK = CAPACITY - 1;
+
+    CommandMailbox() {
+        for (uint32_t i = 0; i < CAPACITY; i++) {
+            slots[i].seq.store(i, std::memory_order_relaxed);
+            slots[i].record = nullptr;
+        }
+    }
+
+    /**
+     * @brief Post a record (any task)
+     * @return false if the ring is full
+     */
+    bool push(CommandRecord* record) {
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+        while (true) {
+            Slot& slot = slots[pos & MASK];
+            uint32_t seq = slot.seq.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(seq - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = record;
+                    slot.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+                // pos reloaded by the failed CAS
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Take the oldest record (consumer / executor task only)
+     * @return nullptr if empty
+     */
+    CommandRecord* pop() {
+        Slot& slot = slots[dequeuePos & MASK];
+        uint32_t seq = slot.seq.load(std::memory_order_acquire);
+        if ((int32_t)(seq - (dequeuePos + 1)) < 0) {
+            return nullptr;
+        }
+        CommandRecord* record = slot.record;
+        slot.seq.store(dequeuePos + CAPACITY, std::memory_order_release);
+        dequeuePos++;
+        return record;
+    }
+
+    /**
+     * @brief Records claimed but not yet taken (consumer side only)
+     */
+    uint32_t depth() const {
+        return enqueuePos.load(std::memory_order_relaxed) - dequeuePos;
+    }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        CommandRecord* record;
+    };
+
+    Slot slots[CAPACITY];
+    std::atomic<uint32_t> enqueuePos{0};  // Claimed by producers with CAS
+    uint32_t dequeuePos = 0;              // Consumer only
+};
+
+#endif // COMMAND_MAILBOX_H
@@ -1,14 +1,17 @@
 #include "CommandParser.h"
+#include "CommandExecutor.h"
 #include "CustomHID.h"
 #include "HIDProtocol.h"
 // #include "MotorControl.h"  // DEPRECATED: Motor control merged to UART1Mux
 // #include "MotorSettings.h"  // DEPRECATED: Motor control merged to UART1Mux
 #include "PeripheralManager.h"
+#include "TraceRing.h"
 #include "StatusLED.h"
 #include "WiFiManager.h"
 #include "WebServer.h"
 #include "freertos/FreeRTOS.h"
 #include "soc/mcpwm_struct.h"  // For direct MCPWM register access
+#include "driver/gpio.h"    // Input level when no duty edges arrive
 #include "freertos/semphr.h"
 #include "freertos/queue.h"
 #include <BLEDevice.h>
@@ -39,429 +42,503 @@ extern WiFiManager wifiManager;
 extern WiFiSettingsManager wifiSettingsManager;
 extern WebServerManager webServerManager;
 
+static_assert(CMD_SRC_CDC == (1 << CMD_SOURCE_CDC) && CMD_SRC_HID == (1 << CMD_SOURCE_HID) &&
+              CMD_SRC_BLE == (1 << CMD_SOURCE_BLE) && CMD_SRC_WEBSOCKET == (1 << CMD_SOURCE_WEBSOCKET),
+              "CMD_SRC_* masks must follow CommandSource");
+
+// 命令處理函式 (與 COMMAND_TABLE 同順序)
+const CommandParser::CommandHandler CommandParser::HANDLERS[CMD_COUNT] = {
+#define COMMAND_HANDLER(id, name, minArgs, maxArgs, sources, flags, handler) &CommandParser::handler,
+    COMMAND_TABLE(COMMAND_HANDLER)
+#undef COMMAND_HANDLER
+};
+
 CommandParser::CommandParser() {
 }
 
-bool CommandParser::processCommand(const String& cmd, ICommandResponse* response, CommandSource source) {
-    // 去除前後空白
-    String trimmed = cmd;
-    trimmed.trim();
-
-    // 空命令
-    if (trimmed.length() == 0) {
-        return false;
+const char* CommandParser::getSourceName(CommandSource source) {
+    switch (source) {
+        case CMD_SOURCE_CDC:       return "CDC";
+        case CMD_SOURCE_HID:       return "HID";
+        case CMD_SOURCE_BLE:       return "BLE";
+        case CMD_SOURCE_WEBSOCKET: return "WebSocket";
+        default:                   return "UNKNOWN";
     }
+}
 
-    // 轉換為大寫以進行不區分大小寫的比較
-    String upper = trimmed;
-    upper.toUpperCase();
+namespace {
 
-    // SCPI 標準識別命令
-    if (upper == "*IDN?") {
-        handleIDN(response);
-        return true;
+inline bool isLineSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+// SET 數值範圍（handleSetXxx 與批次預先檢查共用）
+constexpr uint32_t PWM_FREQ_MIN = 10;
+constexpr uint32_t PWM_FREQ_MAX = 500000;
+constexpr uint32_t POLE_PAIRS_MIN = 1;
+constexpr uint32_t POLE_PAIRS_MAX = 12;
+constexpr uint32_t MAX_RPM_MIN = 100;
+constexpr uint32_t MAX_RPM_MAX = 1000000;
+
+// 參數格式或範圍錯誤（含欄位位置）；數值都正確但設定被拒絕時不輸出
+void reportArgError(ICommandResponse* response, const CommandArgs& args) {
+    if (args.error() != CommandArgs::ARG_OK) {
+        response->printf("❌ 參數錯誤: %s\n", args.errorText());
     }
+}
 
-    // 說明命令
-    if (upper == "HELP" || upper == "?") {
-        handleHelp(response);
-        return true;
+// 批次彙總回應：各命令輸出依序收集（去除空行、每個命令前加 [n]），
+// 緩衝區滿或結束時才整段交給原始介面，HID/BLE 只需少數幾個封包
+class BatchResponse : public ICommandResponse {
+public:
+    explicit BatchResponse(ICommandResponse* target) : _target(target) {}
+
+    void beginCommand(unsigned index) {
+        if (!_atLineStart) {
+            append("\n");
+        }
+        char tag[8];
+        snprintf(tag, sizeof(tag), "[%u] ", index);
+        append(tag);
+        _atLineStart = true;  // 處理函式開頭的空行不輸出
     }
 
-    // 資訊命令
-    if (upper == "INFO") {
-        handleInfo(response);
-        return true;
+    void endCommands() {
+        if (!_atLineStart) {
+            append("\n");
+        }
     }
 
-    // 狀態命令
-    if (upper == "STATUS") {
-        handleStatus(response);
-        return true;
+    void print(const char* str) override {
+        append(str);
     }
 
-    // 發送測試 HID 報告
-    if (upper == "SEND") {
-        handleSend(response);
-        return true;
+    void println(const char* str) override {
+        append(str);
+        append("\n");
     }
 
-    // 讀取 HID OUT 緩衝區
-    if (upper == "READ") {
-        handleRead(response);
-        return true;
+    void printf(const char* format, ...) override {
+        char buffer[256];
+        va_list args;
+        va_start(args, format);
+        vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        append(buffer);
     }
 
-    // 清除 HID OUT 緩衝區
-    if (upper == "CLEAR") {
-        handleClear(response);
-        return true;
+    void flush() {
+        if (_used > 0) {
+            _buffer[_used] = '\0';
+            _target->print(_buffer);
+            _used = 0;
+        }
     }
 
-    // 延遲命令 (毫秒)
-    if (upper.startsWith("DELAY ")) {
-        handleDelay(trimmed, response);
-        return true;
+private:
+    void append(const char* str) {
+        for (; *str != '\0'; str++) {
+            char c = *str;
+            if (c == '\r' || (c == '\n' && _atLineStart)) {
+                continue;
+            }
+            _atLineStart = (c == '\n');
+            if (_used == sizeof(_buffer) - 1) {
+                flush();
+            }
+            _buffer[_used++] = c;
+        }
     }
 
-    // 清除緊急停止狀態 (恢復 PWM 輸出)
-    if (upper == "CLEAR ERROR" || upper == "CLEAR_ERROR" || upper == "RESUME") {
-        // Route to UART1 motor control (migrated from old MotorControl)
-        peripheralManager.getUART1().setPWMEnabled(true);
-        response->println("✅ PWM 輸出已恢復 - 系統已恢復正常");
-        response->println("PWM output resumed - System restored");
+    ICommandResponse* _target;
+    char _buffer[256];
+    size_t _used = 0;
+    bool _atLineStart = true;
+};
 
-        // Notify web clients that error is cleared
-        if (webServerManager.isRunning()) {
-            webServerManager.broadcastStatus();
-        }
-        return true;
+}  // namespace
+
+bool CommandParser::processCommand(const char* cmd, ICommandResponse* response, CommandSource source) {
+    if (cmd == nullptr) {
+        return false;
     }
 
-    // RPM 讀取
-    if (upper == "RPM") {
-        handleRPM(response);
-        return true;
+    // 去除前導空白（結尾空白由 CommandArgs 忽略）
+    while (isLineSpace(*cmd)) {
+        cmd++;
     }
 
-    // 濾波器狀態 - REMOVED IN v3.0 (filtering not available)
-    // if (upper == "FILTER STATUS") {
-    //     handleFilterStatus(response);
-    //     return true;
-    // }
-
-    // RAMP 命令 - REMOVED IN v3.0 (ramping not available)
-    // if (upper.startsWith("RAMP ")) {
-    //     String params = upper.substring(5);  // Remove "RAMP "
-    //     params.trim();
-    //
-    //     // Parse: PARAMETER VALUE TIME
-    //     int firstSpace = params.indexOf(' ');
-    //     if (firstSpace == -1) {
-    //         response->println("❌ 錯誤：格式應為 RAMP <parameter> <value> <time_ms>");
-    //         return true;
-    //     }
-    //
-    //     String parameter = params.substring(0, firstSpace);
-    //     parameter.trim();
-    //
-    //     String rest = params.substring(firstSpace + 1);
-    //     rest.trim();
-    //
-    //     int secondSpace = rest.indexOf(' ');
-    //     if (secondSpace == -1) {
-    //         response->println("❌ 錯誤：格式應為 RAMP <parameter> <value> <time_ms>");
-    //         return true;
-    //     }
-    //
-    //     String value = rest.substring(0, secondSpace);
-    //     value.trim();
-    //
-    //     String timeStr = rest.substring(secondSpace + 1);
-    //     timeStr.trim();
-    //     uint32_t rampTimeMs = timeStr.toInt();
-    //
-    //     if (parameter == "PWM_FREQ") {
-    //         uint32_t freq = value.toInt();
-    //         handleSetPWMFreqRamped(response, freq, rampTimeMs);
-    //         return true;
-    //     }
-    //
-    //     if (parameter == "PWM_DUTY") {
-    //         float duty = value.toFloat();
-    //         handleSetPWMDutyRamped(response, duty, rampTimeMs);
-    //         return true;
-    //     }
-    //
-    //     response->println("❌ 錯誤：不支援的 RAMP 參數（支援: PWM_FREQ, PWM_DUTY）");
-    //     return true;
-    // }
-
-    // 馬達停止
-    if (upper == "MOTOR STOP") {
-        handleMotorStop(response);
-        return true;
+    // 空命令
+    if (*cmd == '\0') {
+        return false;
     }
 
-    // 馬達狀態
-    if (upper == "MOTOR STATUS") {
-        handleMotorStatus(response);
-        return true;
+    // 閒置逾時的交易先取消，再處理這一行
+    Transaction& tx = transactions[source];
+    if (tx.open && millis() - tx.lastMs > TRANSACTION_TIMEOUT_MS) {
+        response->printf("⚠️ 交易閒置超過 %u 秒已取消 (%u 個命令未執行)\n",
+                         (unsigned)(TRANSACTION_TIMEOUT_MS / 1000), tx.count);
+        tx.open = false;
+        tx.count = 0;
+        tx.used = 0;
     }
 
-    // 儲存設定
-    if (upper == "SAVE") {
-        handleSaveSettings(response);
-        return true;
+    // 批次或進行中的交易
+    if (tx.open || strchr(cmd, ';') != nullptr) {
+        return processBatch(cmd, response, source);
     }
 
-    // 載入設定
-    if (upper == "LOAD") {
-        handleLoadSettings(response);
-        return true;
+    CommandMatch match;
+    if (!checkCommand(cmd, source, match, response)) {
+        return false;
     }
+    return invokeCommand(cmd, match, source, response);
+}
 
-    // 重設設定
-    if (upper == "RESET") {
-        handleResetSettings(response);
-        return true;
+bool CommandParser::checkCommand(const char* cmd, CommandSource source, CommandMatch& match,
+                                 ICommandResponse* response) {
+    // 查表 (完美雜湊, 與命令數量無關)
+    if (!findCommand(cmd, match)) {
+        int len = (int)strnlen(cmd, MAX_LINE_LENGTH);
+        while (len > 0 && isLineSpace(cmd[len - 1])) {
+            len--;
+        }
+        response->printf("未知命令: %.*s\n", len, cmd);
+        response->println("輸入 'HELP' 查看可用命令");
+        return false;
     }
 
-    // SET 命令處理
-    if (upper.startsWith("SET ")) {
-        String params = upper.substring(4);
-        params.trim();
+    const CommandSpec& spec = getCommandSpec(match.id);
+    if ((spec.sources & (1u << source)) == 0) {
+        response->printf("❌ %s 不接受來自 %s 的命令\n", spec.name, getSourceName(source));
+        return false;
+    }
 
-        int spaceIndex = params.indexOf(' ');
-        if (spaceIndex > 0) {
-            String parameter = params.substring(0, spaceIndex);
-            String value = params.substring(spaceIndex + 1);
-            value.trim();
+    if (match.argCount < spec.minArgs ||
+        (spec.maxArgs != CMD_ARGS_ANY && match.argCount > spec.maxArgs)) {
+        if (spec.maxArgs == CMD_ARGS_ANY) {
+            response->printf("❌ %s 需要至少 %u 個參數\n", spec.name, spec.minArgs);
+        } else if (spec.minArgs == spec.maxArgs) {
+            response->printf("❌ %s 需要 %u 個參數\n", spec.name, spec.minArgs);
+        } else {
+            response->printf("❌ %s 需要 %u-%u 個參數\n", spec.name, spec.minArgs, spec.maxArgs);
+        }
+        response->println("輸入 'HELP' 查看可用命令");
+        return false;
+    }
+    return true;
+}
 
-            // SET PWM_FREQ <Hz>
-            if (parameter == "PWM_FREQ") {
-                uint32_t freq = value.toInt();
-                handleSetPWMFreq(response, freq);
-                return true;
-            }
+bool CommandParser::processInline(const char* cmd, ICommandResponse* response, CommandSource source) {
+    if (cmd == nullptr) {
+        return false;
+    }
+    while (isLineSpace(*cmd)) {
+        cmd++;
+    }
 
-            // SET PWM_DUTY <%>
-            if (parameter == "PWM_DUTY") {
-                float duty = value.toFloat();
-                handleSetPWMDuty(response, duty);
-                return true;
-            }
+    CommandMatch match;
+    if (!checkCommand(cmd, source, match, response)) {
+        return false;
+    }
+    if ((getCommandSpec(match.id).flags & CMD_FLAG_INLINE) == 0) {
+        return false;
+    }
+    invokeCommand(cmd, match, source, response);
+    return true;
+}
 
-            // SET PWM <freq> <duty> - Atomic frequency and duty update
-            if (parameter == "PWM") {
-                // Parse two parameters: frequency and duty
-                int secondSpace = value.indexOf(' ');
-                if (secondSpace > 0) {
-                    String freqStr = value.substring(0, secondSpace);
-                    String dutyStr = value.substring(secondSpace + 1);
-                    freqStr.trim();
-                    dutyStr.trim();
-
-                    uint32_t freq = freqStr.toInt();
-                    float duty = dutyStr.toFloat();
-
-                    handleSetPWMFreqAndDuty(response, freq, duty);
-                    return true;
-                } else {
-                    response->println("❌ 錯誤：格式應為 SET PWM <frequency> <duty>");
-                    return true;
-                }
-            }
+bool CommandParser::invokeCommand(const char* cmd, const CommandMatch& match, CommandSource source,
+                                  ICommandResponse* response) {
+    const CommandHandler& handler = HANDLERS[match.id];
+    if (handler.plain) {
+        return (this->*handler.plain)(response);
+    }
+    if (handler.sourced) {
+        return (this->*handler.sourced)(source, response);
+    }
 
-            // SET RPM_FILTER_SIZE <size> - REMOVED IN v3.0 (filtering not available)
-            // if (parameter == "RPM_FILTER_SIZE") {
-            //     uint8_t size = value.toInt();
-            //     handleSetRPMFilterSize(response, size);
-            //     return true;
-            // }
-
-            // SET POLE_PAIRS <num>
-            if (parameter == "POLE_PAIRS") {
-                uint8_t pairs = value.toInt();
-                handleSetPolePairs(response, pairs);
-                return true;
-            }
+    // 參數以 (位移, 長度) 指向原始命令列，保留原始大小寫 (SSID、密碼、UART 資料)
+    CommandArgs args(match.args, cmd);
+    return (this->*handler.line)(args, response);
+}
 
-            // SET MAX_FREQ <Hz>
-            if (parameter == "MAX_FREQ") {
-                uint32_t maxFreq = value.toInt();
-                handleSetMaxFreq(response, maxFreq);
-                return true;
-            }
+// ============================================================================
+// 批次與交易
+// ============================================================================
 
-            // SET MAX_RPM <rpm>
-            if (parameter == "MAX_RPM") {
-                uint32_t maxRPM = value.toInt();
-                handleSetMaxRPM(response, maxRPM);
-                return true;
-            }
+bool CommandParser::processBatch(const char* cmd, ICommandResponse* response, CommandSource source) {
+    size_t len = strnlen(cmd, MAX_LINE_LENGTH + 1);
+    if (len > MAX_LINE_LENGTH) {
+        response->printf("❌ 命令列過長 (最多 %u 字元)\n", (unsigned)MAX_LINE_LENGTH);
+        return false;
+    }
 
-            // SET LED_BRIGHTNESS <0-255>
-            if (parameter == "LED_BRIGHTNESS") {
-                uint8_t brightness = value.toInt();
-                handleSetLEDBrightness(response, brightness);
-                return true;
-            }
-        }
+    // 在副本上以 NUL 取代分隔符號，原始命令列不修改
+    char work[MAX_LINE_LENGTH + 1];
+    memcpy(work, cmd, len + 1);
 
-        response->println("❌ Invalid SET command format");
-        response->println("Usage: SET <parameter> <value>");
+    const char* commands[MAX_BATCH_COMMANDS];
+    bool overflow = false;
+    uint8_t count = splitBatch(work, commands, overflow);
+    if (overflow) {
+        response->printf("❌ 批次最多 %u 個命令\n", MAX_BATCH_COMMANDS);
         return false;
     }
-
-    // WiFi 連線命令: WIFI <ssid> <password>
-    if (upper.startsWith("WIFI ") && !upper.startsWith("WIFI STATUS") &&
-        !upper.startsWith("WIFI START") && !upper.startsWith("WIFI STOP") &&
-        !upper.startsWith("WIFI SCAN")) {
-        handleWiFiConnect(trimmed, response);
-        return true;
+    if (count == 0) {
+        return false;
     }
 
-    // IP 地址顯示
-    if (upper == "IP") {
-        handleIPAddress(response);
-        return true;
+    Transaction& tx = transactions[source];
+    if (tx.open) {
+        // 交易控制與緊急命令 (MOTOR STOP, FAULT) 立即執行，其他命令驗證後排入交易
+        CommandMatch match;
+        if (count == 1 && findCommand(commands[0], match) &&
+            (getCommandSpec(match.id).flags & (CMD_FLAG_SINGLE | CMD_FLAG_URGENT))) {
+            if (!checkCommand(commands[0], source, match, response)) {
+                return false;
+            }
+            return invokeCommand(commands[0], match, source, response);
+        }
+        if (!checkBatch(commands, count, source, response)) {
+            return false;
+        }
+        return appendTransaction(tx, commands, count, response);
     }
 
-    // WiFi 狀態
-    if (upper == "WIFI STATUS") {
-        handleWiFiStatus(response);
-        return true;
+    if (count == 1) {
+        CommandMatch match;
+        if (!checkCommand(commands[0], source, match, response)) {
+            return false;
+        }
+        return invokeCommand(commands[0], match, source, response);
     }
 
-    // WiFi 啟動
-    if (upper == "WIFI START") {
-        handleWiFiStart(response);
-        return true;
+    if (!checkBatch(commands, count, source, response)) {
+        return false;
     }
+    return runBatch(commands, count, source, response);
+}
 
-    // WiFi 停止
-    if (upper == "WIFI STOP") {
-        handleWiFiStop(response);
-        return true;
-    }
+uint8_t CommandParser::splitBatch(char* work, const char** commands, bool& overflow) {
+    uint8_t count = 0;
+    overflow = false;
 
-    // WiFi 掃描
-    if (upper == "WIFI SCAN") {
-        handleWiFiScan(response);
-        return true;
-    }
+    char* p = work;
+    while (*p != '\0') {
+        // 略過空白與空的命令 ("A;;B", 結尾的 ";")
+        while (isLineSpace(*p) || *p == ';') {
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
 
-    // Web 伺服器狀態
-    if (upper == "WEB STATUS") {
-        handleWebStatus(response);
-        return true;
-    }
+        char* separator = strchr(p, ';');
+        if (separator != nullptr) {
+            *separator = '\0';
+            // 自由文字參數 (UART WRITE 資料、WiFi 密碼) 延伸到行尾，; 屬於參數
+            CommandMatch match;
+            if (findCommand(p, match) && (getCommandSpec(match.id).flags & CMD_FLAG_TEXT)) {
+                *separator = ';';
+                separator = nullptr;
+            }
+        }
 
-    // ========================================================================
-    // Peripheral Commands
-    // ========================================================================
+        if (count == MAX_BATCH_COMMANDS) {
+            overflow = true;
+            break;
+        }
+        commands[count++] = p;
 
-    // UART1 Commands
-    if (upper.startsWith("UART1 MODE ")) {
-        handleUART1Mode(upper, response);
-        return true;
-    }
-    if (upper.startsWith("UART1 CONFIG ")) {
-        handleUART1Config(upper, response);
-        return true;
-    }
-    if (upper.startsWith("UART1 PWM ")) {
-        handleUART1PWM(upper, response);
-        return true;
-    }
-    if (upper == "UART1 STATUS") {
-        handleUART1Status(response);
-        return true;
-    }
-    if (upper.startsWith("UART1 WRITE ")) {
-        handleUART1Write(trimmed, response);
-        return true;
+        if (separator == nullptr) {
+            break;
+        }
+        p = separator + 1;
     }
+    return count;
+}
 
-    // UART2 Commands
-    if (upper.startsWith("UART2 CONFIG ")) {
-        handleUART2Config(upper, response);
-        return true;
-    }
-    if (upper == "UART2 STATUS") {
-        handleUART2Status(response);
-        return true;
-    }
-    if (upper.startsWith("UART2 WRITE ")) {
-        handleUART2Write(trimmed, response);
-        return true;
+bool CommandParser::checkBatch(const char* const* commands, uint8_t count, CommandSource source,
+                               ICommandResponse* response) {
+    // 全部命令先檢查，任何一個有誤整批都不執行
+    for (uint8_t i = 0; i < count; i++) {
+        CommandMatch match;
+        bool ok = checkCommand(commands[i], source, match, response);
+        if (ok) {
+            const CommandSpec& spec = getCommandSpec(match.id);
+            if (spec.flags & (CMD_FLAG_SINGLE | CMD_FLAG_INLINE)) {
+                response->printf("❌ %s 不能用於批次或交易\n", spec.name);
+                ok = false;
+            } else if (match.id == CMD_SET) {
+                CommandArgs args(match.args, commands[i]);
+                ok = checkSetValues(args, response);
+            }
+        }
+        if (!ok) {
+            response->printf("❌ 批次未執行: 第 %u/%u 個命令有誤\n", i + 1, count);
+            return false;
+        }
     }
+    return true;
+}
 
-    // Buzzer Commands
-    if (upper.startsWith("BUZZER BEEP ")) {
-        handleBuzzerBeep(upper, response);
-        return true;
-    }
-    if (upper.startsWith("BUZZER ")) {
-        handleBuzzerControl(upper, response);
-        return true;
+bool CommandParser::checkSetValues(CommandArgs& args, ICommandResponse* response) {
+    // 與 handleSetXxx 相同的範圍；MAX_FREQ 可能在同一批次中修改，頻率安全上限留到執行時檢查
+    uint32_t value = 0;
+    float duty = 0.0f;
+    bool ok;
+
+    if (args.is(0, "PWM_FREQ")) {
+        ok = args.getUInt(1, PWM_FREQ_MIN, PWM_FREQ_MAX, value);
+    } else if (args.is(0, "PWM_DUTY")) {
+        ok = args.getFloat(1, 0.0f, 100.0f, duty);
+    } else if (args.is(0, "PWM")) {
+        ok = args.count() == 3 && args.getUInt(1, PWM_FREQ_MIN, PWM_FREQ_MAX, value) &&
+             args.getFloat(2, 0.0f, 100.0f, duty);
+    } else if (args.is(0, "POLE_PAIRS")) {
+        ok = args.getUInt(1, POLE_PAIRS_MIN, POLE_PAIRS_MAX, value);
+    } else if (args.is(0, "MAX_FREQ")) {
+        ok = args.getUInt(1, PWM_FREQ_MIN, PWM_FREQ_MAX, value);
+    } else if (args.is(0, "MAX_RPM")) {
+        ok = args.getUInt(1, MAX_RPM_MIN, MAX_RPM_MAX, value);
+    } else if (args.is(0, "LED_BRIGHTNESS")) {
+        ok = args.getUInt(1, 0, 255, value);
+    } else {
+        response->println("❌ Invalid SET command format");
+        return false;
     }
 
-    // LED PWM Commands
-    if (upper.startsWith("LED_PWM FADE ") || upper.startsWith("LEDPWM FADE ")) {
-        handleLEDFade(upper, response);
-        return true;
-    }
-    if (upper.startsWith("LED_PWM ") || upper.startsWith("LEDPWM ")) {
-        handleLEDPWM(upper, response);
-        return true;
+    if (!ok) {
+        if (args.error() == CommandArgs::ARG_OK) {
+            response->println("❌ 錯誤：格式應為 SET PWM <frequency> <duty>");
+        }
+        reportArgError(response, args);
     }
+    return ok;
+}
 
-    // Relay Commands
-    if (upper.startsWith("RELAY ")) {
-        handleRelayControl(upper, response);
-        return true;
+bool CommandParser::runBatch(const char* const* commands, uint8_t count, CommandSource source,
+                             ICommandResponse* response) {
+    BatchResponse batchResponse(response);
+    auto& uart1 = peripheralManager.getUART1();
+    uint32_t startUs = micros();
+
+    // PWM 預除頻/週期/占空比在批次結束時一次寫入，同一個 TEZ 載入
+    // 執行期的失敗（設定被拒絕）不會復原之前的命令，也不會中止之後的命令
+    uint8_t succeeded = 0;
+    uint8_t firstFailed = 0;
+    uart1.holdPWMUpdates();
+    for (uint8_t i = 0; i < count; i++) {
+        CommandMatch match;
+        findCommand(commands[i], match);  // 已由 checkBatch 驗證
+        batchResponse.beginCommand(i + 1);
+        if (invokeCommand(commands[i], match, source, &batchResponse)) {
+            succeeded++;
+        } else if (firstFailed == 0) {
+            firstFailed = i + 1;
+        }
     }
+    uart1.releasePWMUpdates();
 
-    // GPIO Commands
-    if (upper.startsWith("GPIO ")) {
-        handleGPIOControl(upper, response);
-        return true;
+    batchResponse.endCommands();
+    unsigned long elapsedUs = (unsigned long)(micros() - startUs);
+    if (succeeded == count) {
+        batchResponse.printf("✅ 批次完成: %u 個命令, %lu us\n", count, elapsedUs);
+    } else {
+        batchResponse.printf("⚠️ 批次部分完成: %u/%u 個命令成功, 第 %u 個命令首先失敗, %lu us\n",
+                             succeeded, count, firstFailed, elapsedUs);
     }
+    batchResponse.flush();
+    return succeeded == count;
+}
 
-    // Keys Commands
-    if (upper == "KEYS STATUS" || upper == "KEYS") {
-        handleKeysStatus(response);
-        return true;
-    }
-    if (upper.startsWith("KEYS CONFIG ")) {
-        handleKeysConfig(upper, response);
-        return true;
+bool CommandParser::appendTransaction(Transaction& tx, const char* const* commands, uint8_t count,
+                                      ICommandResponse* response) {
+    // 整行一起加入或一起拒絕
+    size_t needed = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        needed += strlen(commands[i]) + 1;
     }
-    if (upper.startsWith("KEYS MODE ")) {
-        handleKeysMode(upper, response);
-        return true;
+    if (tx.count + count > MAX_BATCH_COMMANDS || tx.used + needed > TRANSACTION_SIZE) {
+        response->printf("❌ 交易已滿 (最多 %u 個命令, %u 位元組)，輸入 COMMIT 或 ABORT\n",
+                         MAX_BATCH_COMMANDS, (unsigned)TRANSACTION_SIZE);
+        return false;
     }
 
-    // Peripheral Status Commands
-    if (upper == "PERIPHERAL STATUS" || upper == "PERIPHERALS") {
-        handlePeripheralStatus(response);
-        return true;
+    for (uint8_t i = 0; i < count; i++) {
+        size_t len = strlen(commands[i]) + 1;
+        memcpy(tx.text + tx.used, commands[i], len);
+        tx.used += len;
+        tx.count++;
     }
-    if (upper == "PERIPHERAL STATS") {
-        handlePeripheralStats(response);
-        return true;
+    tx.lastMs = millis();
+    response->printf("✅ 已加入交易 (%u 個命令)\n", tx.count);
+    return true;
+}
+
+bool CommandParser::handleBegin(CommandSource source, ICommandResponse* response) {
+    Transaction& tx = transactions[source];
+    if (tx.open) {
+        response->printf("❌ 交易已開始 (%u 個命令待執行)，輸入 COMMIT 或 ABORT\n", tx.count);
+        return false;
     }
+    tx.open = true;
+    tx.count = 0;
+    tx.used = 0;
+    tx.lastMs = millis();
+    response->println("✅ 交易開始: 命令先驗證並暫存，COMMIT 一起執行，ABORT 取消");
+    return true;
+}
 
-    // Peripheral Settings Commands
-    if (upper == "PERIPHERAL SAVE") {
-        handlePeripheralSave(response);
-        return true;
+bool CommandParser::handleCommit(CommandSource source, ICommandResponse* response) {
+    Transaction& tx = transactions[source];
+    if (!tx.open) {
+        response->println("❌ 沒有進行中的交易 (先輸入 BEGIN)");
+        return false;
     }
-    if (upper == "PERIPHERAL LOAD") {
-        handlePeripheralLoad(response);
-        return true;
+    tx.open = false;
+
+    const char* commands[MAX_BATCH_COMMANDS];
+    const char* p = tx.text;
+    for (uint8_t i = 0; i < tx.count; i++) {
+        commands[i] = p;
+        p += strlen(p) + 1;
     }
-    if (upper == "PERIPHERAL RESET") {
-        handlePeripheralReset(response);
-        return true;
+
+    bool ok = true;
+    if (tx.count == 0) {
+        response->println("✅ 交易已提交 (沒有命令)");
+    } else {
+        ok = runBatch(commands, tx.count, source, response);
     }
+    tx.count = 0;
+    tx.used = 0;
+    return ok;
+}
 
-    // 未知命令
-    response->print("未知命令: ");
-    response->println(trimmed.c_str());
-    response->println("輸入 'HELP' 查看可用命令");
-    return false;
+bool CommandParser::handleAbort(CommandSource source, ICommandResponse* response) {
+    Transaction& tx = transactions[source];
+    if (!tx.open) {
+        response->println("❌ 沒有進行中的交易");
+        return false;
+    }
+    response->printf("✅ 交易已取消 (%u 個命令未執行)\n", tx.count);
+    tx.open = false;
+    tx.count = 0;
+    tx.used = 0;
+    return true;
 }
 
-bool CommandParser::feedChar(char c, String& buffer, ICommandResponse* response, CommandSource source) {
+bool CommandParser::feedChar(char c, char* buffer, size_t& length, ICommandResponse* response,
+                             CommandSource source) {
     // 換行符表示命令結束
     if (c == '\n' || c == '\r') {
-        if (buffer.length() > 0) {
+        if (length > 0) {
             // 處理命令
+            buffer[length] = '\0';
             bool result = processCommand(buffer, response, source);
-            buffer = "";  // 清空緩衝區
+            length = 0;  // 清空緩衝區
             return result;
         }
         return false;
@@ -469,15 +546,17 @@ bool CommandParser::feedChar(char c, String& buffer, ICommandResponse* response,
 
     // 退格鍵
     if (c == '\b' || c == 127) {
-        if (buffer.length() > 0) {
-            buffer.remove(buffer.length() - 1);
+        if (length > 0) {
+            length--;
         }
         return false;
     }
 
-    // 可列印字元
+    // 可列印字元（超過 MAX_LINE_LENGTH 的部分捨棄）
     if (c >= 32 && c < 127) {
-        buffer += c;
+        if (length < MAX_LINE_LENGTH) {
+            buffer[length++] = c;
+        }
         // 不回顯字元（用戶不希望看到輸入的命令）
         return false;
     }
@@ -485,17 +564,18 @@ bool CommandParser::feedChar(char c, String& buffer, ICommandResponse* response,
     return false;
 }
 
-bool CommandParser::isSCPICommand(const String& cmd) {
-    // 去除前後空白
-    String trimmed = cmd;
-    trimmed.trim();
+bool CommandParser::isSCPICommand(const char* cmd) {
+    if (cmd == nullptr) {
+        return false;
+    }
 
-    // 轉換為大寫以進行不區分大小寫的比較
-    String upper = trimmed;
-    upper.toUpperCase();
+    // 去除前導空白
+    while (isLineSpace(*cmd)) {
+        cmd++;
+    }
 
     // 檢查是否為 SCPI 命令（以 * 開頭或符合 SCPI 模式）
-    if (upper.startsWith("*")) {
+    if (*cmd == '*') {
         return true;  // 所有以 * 開頭的都是 SCPI 命令，例如 *IDN?, *RST, *CLS
     }
 
@@ -505,11 +585,12 @@ bool CommandParser::isSCPICommand(const String& cmd) {
     return false;
 }
 
-void CommandParser::handleIDN(ICommandResponse* response) {
+bool CommandParser::handleIDN(ICommandResponse* response) {
     response->println("HID_ESP32_S3");
+    return true;
 }
 
-void CommandParser::handleHelp(ICommandResponse* response) {
+bool CommandParser::handleHelp(ICommandResponse* response) {
     response->println("");
     response->println("可用命令:");
     response->println("");
@@ -526,6 +607,9 @@ void CommandParser::handleHelp(ICommandResponse* response) {
     response->println("");
     response->println("實用工具:");
     response->println("  DELAY <ms>    - 延遲指定毫秒數 (1-60000ms)");
+    response->println("  EXECUTOR [RESET] - 命令執行器佇列/執行延遲統計");
+    response->println("  <命令>; <命令>; ... - 批次: 全部驗證後連續執行，一份彙總回應");
+    response->println("  BEGIN / COMMIT / ABORT - 交易: 暫存之後的命令，COMMIT 一起執行 (WebSocket 不適用)");
     response->println("");
     response->println("馬達控制:");
     response->println("  SET PWM_FREQ <Hz>    - 設定 PWM 頻率 (10-500000 Hz)");
@@ -537,13 +621,70 @@ void CommandParser::handleHelp(ICommandResponse* response) {
     response->println("  SET MAX_RPM <rpm>    - 設定最大 RPM 限制");
     response->println("  SET LED_BRIGHTNESS <val> - 設定 LED 亮度 (0-255)");
     response->println("  RPM               - 顯示當前 RPM 讀數");
+    response->println("  RPM STATS [N]     - 顯示最近 N 個週期的統計 (平均/中位數/最小/最大)");
+    response->println("  RPM AVG <N> [ms]  - 設定 RPM 平均週期數 (1-128) 與時間窗 (0=不限)");
+    response->println("  RPM AVG ADAPTIVE <ms> - 自適應平均 (時間窗內全部週期, 高速低雜訊/低速快反應)");
+    response->println("  RPM AVG REV [N]   - 以整圈平均 (極對數 × N 週期)");
+    response->println("  RPM TIMEOUT <N> [ms] - 訊號逾時 = N 個預期週期 (上限 ms)");
+    response->println("  RPM EVENT ON [N] [us] - 事件驅動量測 (每 N 個邊緣或 us 微秒通知)");
+    response->println("  RPM EVENT OFF     - 回到 50ms 輪詢量測");
+    response->println("  RPM LATENCY [RESET] - 顯示/重設 邊緣→發佈 延遲統計");
+    response->println("  RPM DUTY [ON|OFF|RESET] - 雙邊緣擷取量測輸入 PWM 占空比");
+    response->println("  RPM FILTER [STATUS|RESET] - 轉速輸入濾波設定與剔除計數");
+    response->println("  RPM FILTER <預除頻> <最小週期 us> <離群 %> - 擷取預除頻、ISR 最小週期、中位數離群剔除");
+    response->println("  RPM COUNTER [ON [Hz] [%] [ms] | OFF] - 高頻改用 PCNT 閘控計數 (交越頻率/遲滯/閘時間)");
+    response->println("");
+    response->println("閉迴路轉速控制 (PID):");
+    response->println("  RPM SET <rpm>            - 設定目標 RPM 並啟動閉迴路控制");
+    response->println("  PID [STATUS]             - 顯示 PID 狀態");
+    response->println("  PID ON/OFF               - 啟動/停止閉迴路控制");
+    response->println("  PID KP/KI/KD <val>       - 設定單一增益");
+    response->println("  PID GAINS <kp> <ki> <kd> - 設定全部增益");
+    response->println("  PID LIMIT <min%> <max%>  - 設定輸出占空比限制");
+    response->println("  PID RATE <Hz>            - 設定控制迴路頻率 (50-5000 Hz)");
+    response->println("  PID FF [ADD <rpm> <%>|CLEAR] - 前饋表 (最多 16 點)");
+    response->println("  FAULT [STATUS]           - 顯示轉速保護狀態與鎖定的故障");
+    response->println("  FAULT ON/OFF             - 啟用/停用轉速保護 (ISR 內判斷)");
+    response->println("  FAULT LIMIT <max> <min> <stall_ms> [N] - 超速/低速 RPM、失速逾時、確認週期數");
+    response->println("  FAULT SAFE LOW|HIGH      - 故障時強制輸出準位");
+    response->println("  FAULT CLEAR              - 解除鎖定並恢復輸出");
+    response->println("");
+    response->println("多風扇通道 (通道 0 = UART1):");
+    response->println("  FAN [STATUS]             - 顯示所有通道");
+    response->println("  FAN COUNT <1-6>          - 啟用的通道數 (佔用對應腳位)");
+    response->println("  FAN <ch> [STATUS]        - 顯示單一通道");
+    response->println("  FAN <ch> PWM <Hz> <%>    - 同時設定頻率與占空比");
+    response->println("  FAN <ch> FREQ <Hz> | DUTY <%> | ON | OFF");
+    response->println("  FAN <ch> POLES <n> | MAXFREQ <Hz> | LIMIT <min%> <max%>");
+    response->println("");
+    response->println("風扇特性掃描 (占空比/頻率 → 轉速曲線):");
+    response->println("  SWEEP [STATUS]           - 掃描進度與設定");
+    response->println("  SWEEP START <ch> <d0> <d1> <step> [<f0> <f1> <fstep>] - 開始掃描");
+    response->println("  SWEEP SETTLE <ms> <N> <tol%> <min_ms> <timeout_ms> <samples> - 穩定判定");
+    response->println("  SWEEP STOP               - 中止掃描 (保留已量測點)");
+    response->println("  SWEEP CSV | BIN          - 輸出 CSV 或十六進位二進位資料");
+    response->println("  SWEEP APPLY [Hz]         - 將曲線載入 PID 前饋表");
+    response->println("");
+    response->println("步階響應分析 (UART1):");
+    response->println("  STEP <duty%> [Hz] [ms]   - 套用占空比步階並記錄每個轉速邊緣");
+    response->println("  STEP [STATUS]            - 上升時間、過衝、安定時間、漣波");
+    response->println("  STEP BAND <%> | SMOOTH <n> - 安定帶寬 / 平均週期數 (0 = 一圈)");
+    response->println("  STEP RAW | STOP          - 輸出原始邊緣資料 / 中止記錄");
     response->println("  MOTOR STATUS      - 顯示馬達控制狀態");
     response->println("  MOTOR STOP        - 緊急停止（設定占空比為 0%）");
     response->println("  CLEAR ERROR (or RESUME) - 清除緊急停止狀態");
     response->println("");
     response->println("進階功能 (Priority 3):");
-    response->println("  RAMP PWM_FREQ <Hz> <ms>  - 漸變 PWM 頻率");
-    response->println("  RAMP PWM_DUTY <%> <ms>   - 漸變 PWM 占空比");
+    response->println("  RAMP PWM_FREQ <Hz> <ms> [LINEAR|SCURVE] - 漸變 PWM 頻率");
+    response->println("  RAMP PWM_DUTY <%> <ms> [LINEAR|SCURVE]  - 漸變 PWM 占空比");
+    response->println("  RAMP PWM <Hz> <%> <ms> [LINEAR|SCURVE]  - 同時漸變頻率與占空比");
+    response->println("  RAMP STOP / RAMP STATUS  - 停止漸變 / 顯示漸變狀態");
+    response->println("  FOLLOW [STATUS]          - 顯示跟隨模式 (追蹤誤差/鎖定狀態)");
+    response->println("  FOLLOW ON [比例] [偏移Hz] [N] - 輸出頻率 = 輸入 × 比例 + 偏移, 每 N 個週期更新");
+    response->println("  FOLLOW LOOP <增益> <ppm> - 迴路增益 (0.01-1) 與鎖定範圍");
+    response->println("  FOLLOW OFF               - 停止跟隨 (輸出維持目前頻率)");
+    response->println("  DITHER [STATUS]          - 顯示占空比解析度 (原生 / 抖動)");
+    response->println("  DITHER ON [Hz] | OFF     - 占空比抖動 (16 位元平均解析度, 更新率 100-20000 Hz)");
     response->println("  SET RPM_FILTER_SIZE <n>  - 設定 RPM 濾波器大小 (1-20)");
     response->println("  FILTER STATUS           - 顯示濾波器狀態");
     response->println("");
@@ -566,6 +707,8 @@ void CommandParser::handleHelp(ICommandResponse* response) {
     response->println("  UART1 CONFIG <baud>       - 設定 UART1 參數");
     response->println("  UART1 PWM <freq> <duty>   - 設定 UART1 PWM");
     response->println("  UART1 STATUS              - 顯示 UART1 狀態");
+    response->println("  UART1 SWITCH RESET        - 重設模式切換延遲統計");
+    response->println("  UART1 COMPL [ON [ns] [ns]|OFF] - 互補輸出 (GPIO 17/8) 與死區時間");
     response->println("  UART1 WRITE <text>        - 寫入 UART1");
     response->println("  UART2 CONFIG <baud>       - 設定 UART2 參數");
     response->println("  UART2 STATUS              - 顯示 UART2 狀態");
@@ -592,15 +735,22 @@ void CommandParser::handleHelp(ICommandResponse* response) {
     response->println("  PERIPHERAL LOAD           - 從 NVS 加載外設設置");
     response->println("  PERIPHERAL RESET          - 重置外設設置為默認值");
     response->println("");
+    response->println("診斷追蹤:");
+    response->println("  TRACE [STATUS]            - 顯示追蹤環狀緩衝狀態");
+    response->println("  TRACE LEVEL <0-3>         - 設定追蹤等級 (0=關 1=事件 2=暫存器 3=詳細)");
+    response->println("  TRACE DUMP [N]            - 解碼最近 N 筆追蹤紀錄");
+    response->println("  TRACE CLEAR               - 清除追蹤紀錄");
+    response->println("");
     response->println("支援的介面:");
     response->println("  - USB CDC (序列埠)");
     response->println("  - USB HID (64位元組自訂協定)");
     response->println("  - BLE GATT (低功耗藍牙)");
     response->println("");
     response->println("所有命令必須以換行符結尾");
+    return true;
 }
 
-void CommandParser::handleInfo(ICommandResponse* response) {
+bool CommandParser::handleInfo(ICommandResponse* response) {
     response->println("");
     response->println("=== ESP32-S3 裝置資訊 ===");
     response->println("");
@@ -633,17 +783,19 @@ void CommandParser::handleInfo(ICommandResponse* response) {
     response->println("  USB CDC: 已啟用");
     response->println("  USB HID: 64 位元組（無 Report ID）");
     response->println("  BLE GATT: 已啟用");
+    return true;
 }
 
-void CommandParser::handleStatus(ICommandResponse* response) {
+bool CommandParser::handleStatus(ICommandResponse* response) {
     response->println("");
     response->println("系統狀態:");
     response->printf("  運行時間: %lu ms\n", millis());
     response->printf("  自由記憶體: %d bytes\n", ESP.getFreeHeap());
     response->printf("  HID OUT 已接收: %s\n", hid_data_ready ? "是" : "否");
+    return true;
 }
 
-void CommandParser::handleSend(ICommandResponse* response) {
+bool CommandParser::handleSend(ICommandResponse* response) {
     // 填充測試資料（0x00 到 0x3F）
     uint8_t test_data[64];
     for (int i = 0; i < 64; i++) {
@@ -666,10 +818,12 @@ void CommandParser::handleSend(ICommandResponse* response) {
         response->println("...");
     } else {
         response->println("傳送失敗！");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleRead(ICommandResponse* response) {
+bool CommandParser::handleRead(ICommandResponse* response) {
     // 取得 mutex 保護緩衝區存取
     if (bufferMutex && xSemaphoreTake(bufferMutex, pdMS_TO_TICKS(100))) {
         if (hid_data_ready) {
@@ -688,10 +842,12 @@ void CommandParser::handleRead(ICommandResponse* response) {
         xSemaphoreGive(bufferMutex);
     } else {
         response->println("錯誤：無法存取緩衝區");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleClear(ICommandResponse* response) {
+bool CommandParser::handleClear(ICommandResponse* response) {
     // 取得 mutex 保護緩衝區存取
     if (bufferMutex && xSemaphoreTake(bufferMutex, pdMS_TO_TICKS(100))) {
         memset(hid_out_buffer, 0, 64);
@@ -700,45 +856,165 @@ void CommandParser::handleClear(ICommandResponse* response) {
         response->println("HID OUT 緩衝區已清除");
     } else {
         response->println("錯誤：無法存取緩衝區");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleDelay(const String& cmd, ICommandResponse* response) {
-    // Parse delay value in milliseconds
-    // Format: DELAY <ms>
-    int spaceIndex = cmd.indexOf(' ');
-    if (spaceIndex == -1) {
-        response->println("Usage: DELAY <milliseconds>");
-        response->println("Example: DELAY 1000  (delays 1000ms = 1 second)");
-        return;
-    }
+bool CommandParser::handleClearError(ICommandResponse* response) {
+    // 清除緊急停止狀態 (恢復 PWM 輸出)
+    // Route to UART1 motor control (migrated from old MotorControl)
+    peripheralManager.getUART1().clearFault();
+    peripheralManager.getUART1().setPWMEnabled(true);
+    response->println("✅ PWM 輸出已恢復 - 系統已恢復正常");
+    response->println("PWM output resumed - System restored");
 
-    String delayStr = cmd.substring(spaceIndex + 1);
-    delayStr.trim();
+    // Notify web clients that error is cleared
+    if (webServerManager.isRunning()) {
+        webServerManager.broadcastStatus();
+    }
+    return true;
+}
 
-    unsigned long delayMs = delayStr.toInt();
+bool CommandParser::handleDelay(CommandArgs& args, ICommandResponse* response) {
+    // Parse delay value in milliseconds
+    // Format: DELAY <ms>
+    uint32_t delayMs = 0;
 
     // Validate delay range (1ms to 60000ms = 1 minute max)
-    if (delayMs < 1 || delayMs > 60000) {
+    if (!args.getUInt(0, 1, 60000, delayMs)) {
         response->println("Error: Delay must be between 1 and 60000 milliseconds (1ms - 60s)");
-        return;
+        reportArgError(response, args);
+        return false;
     }
 
-    response->printf("Delaying %lu ms...\n", delayMs);
+    response->printf("Delaying %lu ms...\n", (unsigned long)delayMs);
     delay(delayMs);
     response->println("Delay completed");
+    return true;
+}
+
+bool CommandParser::handleExecutor(CommandArgs& args, ICommandResponse* response) {
+    if (args.is(0, "RESET")) {
+        commandExecutor.resetStats();
+        response->println("✅ 命令執行器統計已重設");
+        return true;
+    }
+    if (!args.empty()) {
+        response->println("❌ 用法: EXECUTOR [RESET]");
+        return false;
+    }
+
+    CommandExecutor::Stats stats = commandExecutor.getStats();
+
+    response->println("");
+    response->println("命令執行器:");
+    response->printf("  狀態: %s\n", commandExecutor.isRunning() ? "執行中 (單一任務依序執行)" : "未啟動 (呼叫端直接執行)");
+    response->printf("  已投遞: %u (緊急 %u)\n", stats.posted, stats.urgent);
+    response->printf("  已執行: %u\n", stats.executed);
+    response->printf("  呼叫端直接執行: %u\n", stats.inlined);
+    response->printf("  佇列滿拒絕: %u\n", stats.rejected);
+    response->printf("  最大佇列深度: %u / %u\n", stats.maxDepth, CommandMailbox::CAPACITY * 2);
+    if (stats.executed > 0) {
+        response->printf("  排隊延遲: 最近 %u us, 平均 %u us, 最大 %u us\n",
+                         stats.queueLastUs, stats.queueAvgUs, stats.queueMaxUs);
+        response->printf("  執行時間: 最近 %u us, 平均 %u us, 最大 %u us\n",
+                         stats.execLastUs, stats.execAvgUs, stats.execMaxUs);
+    }
+    response->println("");
+    return true;
 }
 
 // ==================== Motor Control Command Handlers ====================
 
-void CommandParser::handleSetPWMFreq(ICommandResponse* response, uint32_t freq) {
+bool CommandParser::handleSet(CommandArgs& args, ICommandResponse* response) {
+    // SET <parameter> <value>
+    // 數值只在此檢查格式；範圍由各個 handleSetXxx 檢查
+    uint32_t value = 0;
+    float duty = 0.0f;
+
+    // SET PWM_FREQ <Hz>
+    if (args.is(0, "PWM_FREQ")) {
+        if (!args.getUInt(1, 0, UINT32_MAX, value)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetPWMFreq(response, value);
+    }
+
+    // SET PWM_DUTY <%>
+    if (args.is(0, "PWM_DUTY")) {
+        if (!args.getFloat(1, -1e6f, 1e6f, duty)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetPWMDuty(response, duty);
+    }
+
+    // SET PWM <freq> <duty> - Atomic frequency and duty update
+    if (args.is(0, "PWM")) {
+        if (args.count() != 3) {
+            response->println("❌ 錯誤：格式應為 SET PWM <frequency> <duty>");
+            return false;
+        }
+        if (!args.getUInt(1, 0, UINT32_MAX, value) || !args.getFloat(2, -1e6f, 1e6f, duty)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetPWMFreqAndDuty(response, value, duty);
+    }
+
+    // SET RPM_FILTER_SIZE <size> - REMOVED IN v3.0 (filtering not available)
+
+    // SET POLE_PAIRS <num>
+    if (args.is(0, "POLE_PAIRS")) {
+        if (!args.getUInt(1, 0, 255, value)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetPolePairs(response, (uint8_t)value);
+    }
+
+    // SET MAX_FREQ <Hz>
+    if (args.is(0, "MAX_FREQ")) {
+        if (!args.getUInt(1, 0, UINT32_MAX, value)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetMaxFreq(response, value);
+    }
+
+    // SET MAX_RPM <rpm>
+    if (args.is(0, "MAX_RPM")) {
+        if (!args.getUInt(1, 0, UINT32_MAX, value)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetMaxRPM(response, value);
+    }
+
+    // SET LED_BRIGHTNESS <0-255>
+    if (args.is(0, "LED_BRIGHTNESS")) {
+        if (!args.getUInt(1, 0, 255, value)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetLEDBrightness(response, (uint8_t)value);
+    }
+
+    response->println("❌ Invalid SET command format");
+    response->println("Usage: SET <parameter> <value>");
+    return false;
+}
+
+bool CommandParser::handleSetPWMFreq(ICommandResponse* response, uint32_t freq) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
     // Check against absolute hardware limits
-    if (freq < 10 || freq > 500000) {
+    if (freq < PWM_FREQ_MIN || freq > PWM_FREQ_MAX) {
         response->printf("❌ 錯誤：頻率必須在 10 - 500000 Hz 之間 (硬體限制)\n");
-        return;
+        return false;
     }
 
     // Check against user-configurable safety limit
@@ -746,7 +1022,7 @@ void CommandParser::handleSetPWMFreq(ICommandResponse* response, uint32_t freq)
         response->printf("❌ 錯誤：頻率 %d Hz 超過安全限制 %d Hz\n",
                         freq, uart1.getMaxFrequency());
         response->printf("   使用 'SET MAX_FREQ %d' 來提高限制\n", freq);
-        return;
+        return false;
     }
 
     if (uart1.setPWMFrequency(freq)) {
@@ -758,20 +1034,23 @@ void CommandParser::handleSetPWMFreq(ICommandResponse* response, uint32_t freq)
         }
     } else {
         response->println("❌ 設定 PWM 頻率失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleSetPWMDuty(ICommandResponse* response, float duty) {
+bool CommandParser::handleSetPWMDuty(ICommandResponse* response, float duty) {
     // Route to UART1 motor control
     auto& uart1 = peripheralManager.getUART1();
 
     if (duty < 0.0 || duty > 100.0) {
         response->printf("❌ 錯誤：占空比必須在 0 - 100%% 之間\n");
-        return;
+        return false;
     }
 
     if (uart1.setPWMDuty(duty)) {
-        response->printf("✅ PWM 占空比設定為: %.1f%%\n", duty);
+        response->printf("✅ PWM 占空比設定為: %.3f%% (實際 %.3f%%, 解析度 %.4f%%)\n",
+                         duty, uart1.getPWMDutyActual(), uart1.getDutyResolution());
 
         // Notify web clients about the change
         if (webServerManager.isRunning()) {
@@ -779,94 +1058,71 @@ void CommandParser::handleSetPWMDuty(ICommandResponse* response, float duty) {
         }
     } else {
         response->println("❌ 設定 PWM 占空比失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleSetPWMFreqAndDuty(ICommandResponse* response, uint32_t freq, float duty) {
+bool CommandParser::handleSetPWMFreqAndDuty(ICommandResponse* response, uint32_t freq, float duty) {
     // Route to UART1 motor control - atomic frequency and duty update
     auto& uart1 = peripheralManager.getUART1();
 
     // Validate frequency
-    if (freq < 10 || freq > 500000) {
+    if (freq < PWM_FREQ_MIN || freq > PWM_FREQ_MAX) {
         response->printf("❌ 錯誤：頻率必須在 10 - 500000 Hz 之間\n");
-        return;
+        return false;
     }
 
     // Validate duty
     if (duty < 0.0 || duty > 100.0) {
         response->printf("❌ 錯誤：占空比必須在 0 - 100%% 之間\n");
-        return;
+        return false;
     }
 
-    // Atomically update both parameters
-    response->println("═══════════════════════════════════════");
-    response->printf("🔵 DEBUG: Request - freq=%u Hz, duty=%.1f%%\n", freq, duty);
+    // Register-level debug dump only at TRACE LEVEL 3 (slows the update down)
+    bool debug = uart1Trace.enabled(TRACE_LEVEL_VERBOSE);
 
     // Get current state BEFORE update
     uint32_t old_freq = uart1.getPWMFrequency();
     float old_duty = uart1.getPWMDuty();
     uint32_t old_prescaler = uart1.getPWMPrescaler();
     uint32_t old_period = uart1.getPWMPeriod();
-    response->printf("🔵 BEFORE - freq=%u Hz, duty=%.1f%%, prescaler=%u, period=%u ticks\n",
-                     old_freq, old_duty, old_prescaler, old_period);
-
-    // Call the update function
-    response->println("🔵 Calling setPWMFrequencyAndDuty()...");
-
-    // Read MCPWM register BEFORE update
     uint32_t cfg0_before = MCPWM1.timer[0].timer_cfg0.val;
-    response->printf("🔵 Register BEFORE: cfg0=0x%08X, prescaler=%u, period=%u\n",
-                     cfg0_before, (cfg0_before & 0xFF), ((cfg0_before >> 8) & 0xFFFF));
 
+    // Atomically update both parameters
     bool result = uart1.setPWMFrequencyAndDuty(freq, duty);
-    response->printf("🔵 Function returned: %s\n", result ? "SUCCESS" : "FAILED");
-
-    // Wait a bit for shadow register to load (if used)
-    delayMicroseconds(100);
-
-    // Read MCPWM register AFTER update
-    uint32_t cfg0_after = MCPWM1.timer[0].timer_cfg0.val;
-    response->printf("🔵 Register AFTER:  cfg0=0x%08X, prescaler=%u, period=%u\n",
-                     cfg0_after, (cfg0_after & 0xFF), ((cfg0_after >> 8) & 0xFFFF));
-
-    // Read again after 1ms to check if shadow register loaded
-    delay(1);
-    uint32_t cfg0_after_delay = MCPWM1.timer[0].timer_cfg0.val;
-    if (cfg0_after_delay != cfg0_after) {
-        response->printf("⚠️  Register changed after delay: cfg0=0x%08X, prescaler=%u, period=%u\n",
-                         cfg0_after_delay, (cfg0_after_delay & 0xFF), ((cfg0_after_delay >> 8) & 0xFFFF));
-    }
-
-    // Calculate expected frequency
-    uint32_t reg_prescaler = (cfg0_after & 0xFF);
-    uint32_t reg_period = ((cfg0_after >> 8) & 0xFFFF);
-    if (reg_prescaler > 0 && reg_period > 0) {
-        uint32_t calculated_freq = 80000000 / (reg_prescaler * reg_period);
-        response->printf("🔵 Calculated from register: 80MHz / (%u × %u) = %u Hz\n",
-                         reg_prescaler, reg_period, calculated_freq);
-    }
-
-    // Get state AFTER update
-    uint32_t new_freq = uart1.getPWMFrequency();
-    float new_duty = uart1.getPWMDuty();
-    uint32_t new_prescaler = uart1.getPWMPrescaler();
-    uint32_t new_period = uart1.getPWMPeriod();
-    response->printf("🔵 AFTER  - freq=%u Hz, duty=%.1f%%, prescaler=%u, period=%u ticks\n",
-                     new_freq, new_duty, new_prescaler, new_period);
 
-    // Analyze what changed
-    if (old_prescaler != new_prescaler) {
-        response->printf("⚠️  PRESCALER CHANGED: %u → %u (calls mcpwm_set_frequency)\n", old_prescaler, new_prescaler);
-    }
-    if (old_period != new_period) {
-        response->printf("⚠️  PERIOD CHANGED: %u → %u (calls mcpwm_set_frequency)\n", old_period, new_period);
-    }
-    if (old_freq == new_freq && old_duty != new_duty && old_prescaler == new_prescaler && old_period == new_period) {
-        response->println("✅ DUTY-ONLY UPDATE (mcpwm_set_duty TEZ-sync, should be glitch-free!)");
+    if (debug) {
+        response->println("═══════════════════════════════════════");
+        response->printf("🔵 DEBUG: Request - freq=%u Hz, duty=%.1f%%\n", freq, duty);
+        response->printf("🔵 BEFORE - freq=%u Hz, duty=%.1f%%, prescaler=%u, period=%u ticks\n",
+                         old_freq, old_duty, old_prescaler, old_period);
+        response->printf("🔵 Register BEFORE: cfg0=0x%08X, prescaler=%u, period=%u\n",
+                         cfg0_before, (cfg0_before & 0xFF), ((cfg0_before >> 8) & 0xFFFF));
+        response->printf("🔵 Function returned: %s\n", result ? "SUCCESS" : "FAILED");
+
+        // Read again after 1ms to check if shadow register loaded
+        delay(1);
+        uint32_t cfg0_after = MCPWM1.timer[0].timer_cfg0.val;
+        response->printf("🔵 Register AFTER:  cfg0=0x%08X, prescaler=%u, period=%u\n",
+                         cfg0_after, (cfg0_after & 0xFF), ((cfg0_after >> 8) & 0xFFFF));
+
+        // Get state AFTER update
+        uint32_t new_prescaler = uart1.getPWMPrescaler();
+        uint32_t new_period = uart1.getPWMPeriod();
+        response->printf("🔵 AFTER  - freq=%u Hz, duty=%.1f%%, prescaler=%u, period=%u ticks\n",
+                         uart1.getPWMFrequency(), uart1.getPWMDuty(), new_prescaler, new_period);
+
+        // Analyze what changed
+        if (old_prescaler != new_prescaler) {
+            response->printf("⚠️  PRESCALER CHANGED: %u → %u\n", old_prescaler, new_prescaler);
+        }
+        if (old_period != new_period) {
+            response->printf("⚠️  PERIOD CHANGED: %u → %u\n", old_period, new_period);
+        }
+        response->println("═══════════════════════════════════════");
     }
 
-    response->println("═══════════════════════════════════════");
-
     if (result) {
         response->printf("✅ PWM 原子性更新: %u Hz, %.1f%%\n", freq, duty);
         response->println("ℹ️ 頻率和占空比已在下一個 PWM 週期同時生效");
@@ -877,16 +1133,18 @@ void CommandParser::handleSetPWMFreqAndDuty(ICommandResponse* response, uint32_t
         }
     } else {
         response->println("❌ 設定 PWM 參數失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleSetPolePairs(ICommandResponse* response, uint8_t pairs) {
+bool CommandParser::handleSetPolePairs(ICommandResponse* response, uint8_t pairs) {
     // Route to UART1 motor control
     auto& uart1 = peripheralManager.getUART1();
 
-    if (pairs < 1 || pairs > 12) {
+    if (pairs < POLE_PAIRS_MIN || pairs > POLE_PAIRS_MAX) {
         response->printf("❌ 錯誤：極對數必須在 1 - 12 之間\n");
-        return;
+        return false;
     }
 
     if (uart1.setPolePairs(pairs)) {
@@ -899,16 +1157,18 @@ void CommandParser::handleSetPolePairs(ICommandResponse* response, uint8_t pairs
         }
     } else {
         response->println("❌ 設定極對數失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleSetMaxFreq(ICommandResponse* response, uint32_t maxFreq) {
+bool CommandParser::handleSetMaxFreq(ICommandResponse* response, uint32_t maxFreq) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
-    if (maxFreq < 10 || maxFreq > 500000) {
+    if (maxFreq < PWM_FREQ_MIN || maxFreq > PWM_FREQ_MAX) {
         response->printf("❌ 錯誤：最大頻率必須在 10 - 500000 Hz 之間 (硬體限制)\n");
-        return;
+        return false;
     }
 
     if (uart1.setMaxFrequency(maxFreq)) {
@@ -921,26 +1181,28 @@ void CommandParser::handleSetMaxFreq(ICommandResponse* response, uint32_t maxFre
         }
     } else {
         response->println("❌ 設定最大頻率失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleSetMaxRPM(ICommandResponse* response, uint32_t maxRPM) {
+bool CommandParser::handleSetMaxRPM(ICommandResponse* response, uint32_t maxRPM) {
     // Route to UART1 motor control (migrated from old MotorControl)
     // Convert RPM to frequency: maxFreq = (maxRPM * polePairs) / 60
     auto& uart1 = peripheralManager.getUART1();
 
-    if (maxRPM < 100 || maxRPM > 1000000) {
+    if (maxRPM < MAX_RPM_MIN || maxRPM > MAX_RPM_MAX) {
         response->println("❌ 錯誤：最大 RPM 必須在 100 - 1000000 之間");
-        return;
+        return false;
     }
 
     uint32_t polePairs = uart1.getPolePairs();
     uint32_t maxFreq = (maxRPM * polePairs) / 60;
 
-    if (maxFreq > 500000) {
+    if (maxFreq > PWM_FREQ_MAX) {
         response->printf("❌ 錯誤：換算後頻率 %d Hz 超過硬體限制 (500000 Hz)\n", maxFreq);
         response->printf("   當前極對數: %d, 建議降低 RPM 或極對數\n", polePairs);
-        return;
+        return false;
     }
 
     if (uart1.setMaxFrequency(maxFreq)) {
@@ -953,10 +1215,12 @@ void CommandParser::handleSetMaxRPM(ICommandResponse* response, uint32_t maxRPM)
         }
     } else {
         response->println("❌ 設定最大 RPM 失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleSetLEDBrightness(ICommandResponse* response, uint8_t brightness) {
+bool CommandParser::handleSetLEDBrightness(ICommandResponse* response, uint8_t brightness) {
     // Apply brightness to LED hardware immediately
     if (statusLED.isInitialized()) {
         statusLED.setBrightness(brightness);
@@ -971,9 +1235,10 @@ void CommandParser::handleSetLEDBrightness(ICommandResponse* response, uint8_t b
     if (webServerManager.isRunning()) {
         webServerManager.broadcastStatus();
     }
+    return true;
 }
 
-void CommandParser::handleRPM(ICommandResponse* response) {
+bool CommandParser::handleRPM(ICommandResponse* response) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
@@ -981,14 +1246,384 @@ void CommandParser::handleRPM(ICommandResponse* response) {
     response->println("RPM 讀數:");
     response->printf("  當前 RPM: %.1f\n", uart1.getCalculatedRPM());
     response->printf("  輸入頻率: %.2f Hz\n", uart1.getRPMFrequency());
+    response->printf("  量測方式: %s\n", uart1.getRPMMethodName());
+    RPMWindowStats window = uart1.getRPMWindowStats();
+    response->printf("  量測視窗: %u 週期 / %.3f ms (頻寬 %.2f Hz, 逾時 %u ms)\n",
+                     window.periods, window.windowUs / 1000.0f, window.bandwidthHz, window.timeoutMs);
     response->printf("  極對數: %d\n", uart1.getPolePairs());
     response->printf("  PWM 頻率: %d Hz\n", uart1.getPWMFrequency());
     response->printf("  PWM 占空比: %.1f%%\n", uart1.getPWMDuty());
     response->printf("  UART1 模式: %s\n", uart1.getModeName());
     response->println("");
+    return true;
+}
+
+bool CommandParser::handleRPMStats(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    // Optional edge count, default to the configured averaging length
+    uint32_t edges = uart1.getRPMAveragingEdges();
+    if (args.has(0) && !args.getUInt(0, 1, PeriodHistory::HISTORY_SIZE, edges)) {
+        response->printf("❌ 週期數超出範圍 (有效範圍: 1-%u)\n", PeriodHistory::HISTORY_SIZE);
+        reportArgError(response, args);
+        return false;
+    }
+
+    CaptureStats stats;
+    if (!uart1.getCaptureStats(edges, 0, stats)) {
+        response->println("❌ 尚無擷取資料 (需在 PWM/RPM 模式且有轉速訊號)");
+        return false;
+    }
+
+    const float tickUs = 1000000.0f / UART1Mux::CAPTURE_CLK_HZ;
+    float meanHz = (float)((double)UART1Mux::CAPTURE_CLK_HZ * stats.count * uart1.getCapturePrescale() /
+                           (double)stats.spanTicks);
+
+    response->println("");
+    response->printf("RPM 擷取統計 (最近 %u 個週期):\n", stats.count);
+    response->printf("  平均週期: %.2f us (%u ticks)\n", stats.meanTicks * tickUs, stats.meanTicks);
+    response->printf("  中位週期: %.2f us (%u ticks)\n", stats.medianTicks * tickUs, stats.medianTicks);
+    response->printf("  最小週期: %.2f us (%u ticks)\n", stats.minTicks * tickUs, stats.minTicks);
+    response->printf("  最大週期: %.2f us (%u ticks)\n", stats.maxTicks * tickUs, stats.maxTicks);
+    response->printf("  平均頻率: %.3f Hz\n", meanHz);
+    response->printf("  平均 RPM: %.1f\n", (meanHz * 60.0f) / uart1.getPolePairs());
+    TachSnapshot tach = uart1.getTachSnapshot();
+    response->printf("  發佈讀值 #%u: 週期 Q4=%u, 頻率 Q10=%u, RPM Q6=%u\n",
+                     tach.seq, tach.periodQ4, tach.freqQ10, tach.rpmQ6);
+    response->printf("  環形緩衝溢位: %u\n", uart1.getCaptureOverflowCount());
+    if (uart1.getCapturePrescale() > 1) {
+        response->printf("  擷取預除頻: %u (週期值為 %u 個輸入週期)\n",
+                         uart1.getCapturePrescale(), uart1.getCapturePrescale());
+    }
+    CaptureTimeline timeline = uart1.getCaptureTimeline();
+    response->printf("  擷取時間軸: 最新邊緣 %llu ticks @ %lld us, 計數器回繞 %u 次\n",
+                     (unsigned long long)timeline.lastEdgeTicks, (long long)timeline.lastEdgeUs,
+                     timeline.wraps);
+    if (timeline.multiWrapPeriods > 0) {
+        response->printf("  跨多次回繞的週期: %u (超過 53.7 s 飽和: %u)\n",
+                         timeline.multiWrapPeriods, timeline.saturatedPeriods);
+    }
+    TachFilterStats filter = uart1.getTachFilterStats();
+    response->printf("  剔除: 最小週期 %u, 過短 %u, 過長 %u, 重新同步 %u (RPM FILTER)\n",
+                     filter.glitchRejects, filter.shortRejects, filter.longRejects, filter.resyncs);
+    response->printf("  平均設定: %u 週期, 時間窗 %u ms\n",
+                     uart1.getRPMAveragingEdges(), uart1.getRPMAveragingWindowMs());
+    response->println("");
+    return true;
+}
+
+bool CommandParser::handleRPMAveraging(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.empty()) {
+        RPMWindowStats window = uart1.getRPMWindowStats();
+        response->println("");
+        response->printf("RPM 平均設定 (%s):\n", uart1.getRPMWindowModeName());
+        switch (uart1.getRPMWindowMode()) {
+            case UART1Mux::RPM_WINDOW_ADAPTIVE:
+                response->printf("  時間窗 %u ms 內的全部週期 (1-128)\n", uart1.getRPMAveragingWindowMs());
+                break;
+            case UART1Mux::RPM_WINDOW_REVOLUTION:
+                response->printf("  每次讀值 %u 圈 (%u 週期)\n", uart1.getRPMWindowRevolutions(),
+                                 uart1.getRPMWindowRevolutions() * uart1.getPolePairs());
+                break;
+            default:
+                response->printf("  %u 週期, 時間窗 %u ms\n",
+                                 uart1.getRPMAveragingEdges(), uart1.getRPMAveragingWindowMs());
+                break;
+        }
+        response->printf("  目前視窗: %u 週期, %.3f ms\n", window.periods, window.windowUs / 1000.0f);
+        response->printf("  有效頻寬: %.2f Hz\n", window.bandwidthHz);
+        response->printf("  訊號逾時: %u ms (%u 週期, 上限 %u ms)\n", window.timeoutMs,
+                         uart1.getRPMTimeoutPeriods(), uart1.getRPMTimeoutMaxMs());
+        response->println("");
+        response->println("用法: RPM AVG <週期數 1-128> [時間窗 ms, 0=不限]");
+        response->println("      RPM AVG ADAPTIVE <ms> | RPM AVG REV [圈數]");
+        return true;
+    }
+
+    if (args.is(0, "ADAPTIVE")) {
+        uint32_t windowMs = 0;
+        if (!args.getUInt(1, 1, 10000, windowMs) || !uart1.setRPMAveragingAdaptive(windowMs)) {
+            response->println("❌ 無效的時間窗 (1-10000 ms)");
+            reportArgError(response, args);
+            return false;
+        }
+        response->printf("✅ RPM 自適應平均: 時間窗 %u ms 內的全部週期\n", windowMs);
+        response->println("   使用 SAVE 儲存到 NVS");
+        return true;
+    }
+
+    if (args.is(0, "REV")) {
+        uint32_t revs = 1;
+        if ((args.has(1) && !args.getUInt(1, 1, 16, revs)) || !uart1.setRPMAveragingRevolutions(revs)) {
+            response->printf("❌ 無效的圈數 (1-16, 且極對數 × 圈數 ≤ %u)\n", PeriodHistory::HISTORY_SIZE);
+            reportArgError(response, args);
+            return false;
+        }
+        response->printf("✅ RPM 整圈平均: %u 圈 (%u 週期)\n", revs, revs * uart1.getPolePairs());
+        response->println("   使用 SAVE 儲存到 NVS");
+        return true;
+    }
+
+    uint32_t edges = 0;
+    uint32_t windowMs = uart1.getRPMAveragingWindowMs();
+    if (!args.getUInt(0, 1, 128, edges) || (args.has(1) && !args.getUInt(1, 0, 10000, windowMs)) ||
+        !uart1.setRPMAveraging(edges, windowMs)) {
+        response->println("❌ 無效的平均設定 (週期數: 1-128, 時間窗: 0-10000 ms)");
+        reportArgError(response, args);
+        return false;
+    }
+
+    response->printf("✅ RPM 平均設定為 %u 週期, 時間窗 %u ms\n", edges, windowMs);
+    response->println("   使用 SAVE 儲存到 NVS");
+    return true;
+}
+
+bool CommandParser::handleRPMTimeout(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.empty()) {
+        response->printf("RPM 訊號逾時: 目前 %u ms (%u 個預期週期, %u-%u ms)\n",
+                         uart1.getRPMWindowStats().timeoutMs, uart1.getRPMTimeoutPeriods(),
+                         UART1Mux::RPM_TIMEOUT_MIN_MS, uart1.getRPMTimeoutMaxMs());
+        response->println("用法: RPM TIMEOUT <週期數 2-100> [上限 ms]");
+        return true;
+    }
+
+    uint32_t periods = 0;
+    uint32_t maxMs = uart1.getRPMTimeoutMaxMs();
+    if (!args.getUInt(0, 2, 100, periods) ||
+        (args.has(1) && !args.getUInt(1, UART1Mux::RPM_TIMEOUT_MIN_MS, UART1Mux::RPM_TIMEOUT_MAX_MS, maxMs)) ||
+        !uart1.setRPMTimeout(periods, maxMs)) {
+        response->printf("❌ 無效的逾時設定 (週期數: 2-100, 上限: %u-%u ms)\n",
+                         UART1Mux::RPM_TIMEOUT_MIN_MS, UART1Mux::RPM_TIMEOUT_MAX_MS);
+        reportArgError(response, args);
+        return false;
+    }
+
+    response->printf("✅ RPM 訊號逾時: %u 個預期週期 (上限 %u ms)\n", periods, maxMs);
+    response->println("   使用 SAVE 儲存到 NVS");
+    return true;
+}
+
+bool CommandParser::handleRPMEvent(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.empty()) {
+        response->println("");
+        response->println("RPM 量測模式:");
+        response->printf("  模式: %s\n", uart1.isRPMEventMode() ? "事件驅動 (ISR 通知)" : "輪詢 (50ms)");
+        response->printf("  通知條件: 每 %u 個邊緣或 %u us\n",
+                         uart1.getRPMEventEdges(), uart1.getRPMEventIntervalUs());
+        response->printf("  ISR 通知次數: %u\n", uart1.getRPMNotifyCount());
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "OFF")) {
+        uart1.setRPMEventMode(false, uart1.getRPMEventEdges(), uart1.getRPMEventIntervalUs());
+        response->println("✅ RPM 量測已切換為輪詢模式 (50ms)");
+        return true;
+    }
+
+    if (!args.is(0, "ON")) {
+        response->println("❌ 用法: RPM EVENT [ON [邊緣數 1-1000] [間隔 us 0-1000000] | OFF]");
+        return false;
+    }
+
+    // Optional throttle arguments: ON [edges] [interval_us]
+    uint32_t edges = uart1.getRPMEventEdges();
+    uint32_t intervalUs = uart1.getRPMEventIntervalUs();
+    if ((args.has(1) && !args.getUInt(1, 1, 1000, edges)) ||
+        (args.has(2) && !args.getUInt(2, 0, 1000000, intervalUs)) ||
+        !uart1.setRPMEventMode(true, edges, intervalUs)) {
+        response->println("❌ 無法啟用事件驅動量測 (邊緣數: 1-1000, 間隔: 0-1000000 us)");
+        reportArgError(response, args);
+        return false;
+    }
+
+    response->printf("✅ RPM 事件驅動量測已啟用 (每 %u 個邊緣或 %u us)\n", edges, intervalUs);
+    response->println("   使用 RPM LATENCY 查看延遲統計");
+    return true;
+}
+
+bool CommandParser::handleRPMCounter(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.empty()) {
+        response->println("");
+        response->println("RPM 混合量測:");
+        response->printf("  自動切換: %s\n", uart1.isRPMAutoSwitch() ? "啟用" : "停用 (僅擷取)");
+        response->printf("  目前方式: %s\n", uart1.getRPMMethodName());
+        response->printf("  交越頻率: %u Hz (遲滯 ±%u%%)\n",
+                         uart1.getRPMCrossoverHz(), uart1.getRPMHysteresisPct());
+        response->printf("  閘時間: %u ms\n", uart1.getRPMGateMs());
+        response->printf("  計數器讀數: %.1f Hz\n", uart1.getRPMCounterFrequency());
+        response->printf("  切換次數: %u\n", uart1.getRPMMethodSwitchCount());
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "OFF")) {
+        uart1.setRPMCounterConfig(false, uart1.getRPMCrossoverHz(), uart1.getRPMHysteresisPct(),
+                                  uart1.getRPMGateMs());
+        response->println("✅ RPM 量測固定使用 MCPWM 擷取");
+        return true;
+    }
+
+    if (!args.is(0, "ON")) {
+        response->println("❌ 用法: RPM COUNTER [ON [交越 Hz 1000-400000] [遲滯 % 0-50] [閘時間 ms 5-60] | OFF]");
+        return false;
+    }
+
+    // Optional arguments: ON [crossover_hz] [hysteresis_pct] [gate_ms]
+    uint32_t crossoverHz = uart1.getRPMCrossoverHz();
+    uint32_t hysteresisPct = uart1.getRPMHysteresisPct();
+    uint32_t gateMs = uart1.getRPMGateMs();
+    if ((args.has(1) && !args.getUInt(1, 1000, 400000, crossoverHz)) ||
+        (args.has(2) && !args.getUInt(2, 0, 50, hysteresisPct)) ||
+        (args.has(3) && !args.getUInt(3, 5, 60, gateMs)) ||
+        !uart1.setRPMCounterConfig(true, crossoverHz, hysteresisPct, gateMs)) {
+        response->println("❌ 參數無效 (交越: 1000-400000 Hz, 遲滯: 0-50%, 閘時間: 5-60 ms)");
+        reportArgError(response, args);
+        return false;
+    }
+
+    response->printf("✅ RPM 混合量測已啟用: 高於 %u Hz 改用 PCNT 閘控計數 (±%u%%, 閘時間 %u ms)\n",
+                     crossoverHz, hysteresisPct, gateMs);
+    return true;
+}
+
+bool CommandParser::handleRPMLatency(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.is(0, "RESET")) {
+        uart1.resetRPMLatencyStats();
+        response->println("✅ RPM 延遲統計已重設");
+        return true;
+    }
+
+    RPMLatencyStats stats = uart1.getRPMLatencyStats();
+
+    response->println("");
+    response->println("RPM 邊緣→發佈 延遲:");
+    response->printf("  模式: %s\n", uart1.isRPMEventMode() ? "事件驅動" : "輪詢 (50ms)");
+    response->printf("  樣本數: %u\n", stats.count);
+    if (stats.count > 0) {
+        response->printf("  最近: %u us\n", stats.lastUs);
+        response->printf("  最小: %u us\n", stats.minUs);
+        response->printf("  平均: %u us\n", stats.avgUs);
+        response->printf("  最大: %u us\n", stats.maxUs);
+    }
+    response->println("");
+    return true;
 }
 
-void CommandParser::handleMotorStatus(ICommandResponse* response) {
+bool CommandParser::handleRPMDuty(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.is(0, "ON") || args.is(0, "OFF")) {
+        bool enable = args.is(0, "ON");
+        if (!uart1.setInputDutyCapture(enable)) {
+            response->println("❌ 擷取通道重新設定失敗");
+            return false;
+        }
+        if (enable) {
+            response->println("✅ 輸入占空比量測已啟用 (雙邊緣擷取，PCNT 計數模式暫停)");
+        } else {
+            response->println("✅ 輸入占空比量測已停用 (僅上升緣)");
+        }
+        return true;
+    }
+
+    if (args.is(0, "RESET")) {
+        uart1.resetInputDutyStats();
+        response->println("✅ 輸入占空比統計已重設");
+        return true;
+    }
+
+    if (!args.empty()) {
+        response->println("❌ 用法: RPM DUTY [ON|OFF|RESET]");
+        return false;
+    }
+
+    response->println("");
+    response->println("輸入 PWM 占空比 (GPIO 18):");
+    response->printf("  狀態: %s\n", uart1.isInputDutyCapture() ? "啟用 (雙邊緣)" : "停用 (RPM DUTY ON 啟用)");
+    if (!uart1.isInputDutyCapture()) {
+        response->println("");
+        return true;
+    }
+
+    InputDutyStats stats = uart1.getInputDutyStats();
+    if (stats.cycles == 0 || !uart1.hasRPMSignal()) {
+        // No edges: a constant level is 0 % or 100 %
+        response->printf("  無訊號 (輸入固定為 %s)\n",
+                         gpio_get_level((gpio_num_t)PIN_UART1_RX) ? "高電位 = 100%" : "低電位 = 0%");
+        response->println("");
+        return true;
+    }
+    response->printf("  最近週期: %.2f%%\n", stats.dutyLast);
+    response->printf("  最近 %u 週期: 平均 %.2f%%, 最小 %.2f%%, 最大 %.2f%%, 標準差 %.3f%%\n",
+                     stats.cycles, stats.dutyMean, stats.dutyMin, stats.dutyMax, stats.dutyStdDev);
+    response->printf("  高電位時間: %.2f us, 週期: %.2f us (%.2f Hz)\n",
+                     stats.highMeanUs, stats.periodMeanUs, stats.frequency);
+    response->printf("  累計週期: %u, 溢位丟棄: %u\n", stats.totalCycles, stats.overflows);
+    response->println("");
+    return true;
+}
+
+bool CommandParser::handleRPMFilter(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.is(0, "RESET")) {
+        uart1.resetTachFilterStats();
+        response->println("✅ 轉速輸入剔除計數已重設");
+        return true;
+    }
+
+    if (!args.empty() && !args.is(0, "STATUS")) {
+        uint32_t prescale = 0, minUs = 0, outlierPct = 0;
+        if (args.count() != 3 || !args.getUInt(0, 1, 256, prescale) ||
+            !args.getUInt(1, 0, 100000, minUs) || !args.getUInt(2, 0, 90, outlierPct) ||
+            !uart1.setTachFilter(prescale, minUs, outlierPct)) {
+            response->println("❌ 用法: RPM FILTER <預除頻 1-256> <最小週期 0-100000 us> <離群 0 或 5-90 %>");
+            response->println("   (預除頻 > 1 時需先 RPM DUTY OFF)");
+            reportArgError(response, args);
+            return false;
+        }
+        response->printf("✅ 轉速輸入濾波: 預除頻 %u, 最小週期 %u us, 離群剔除 ±%u%% (0 = 停用)\n",
+                         prescale, minUs, outlierPct);
+        return true;
+    }
+
+    TachFilterStats st = uart1.getTachFilterStats();
+    response->println("");
+    response->println("轉速輸入濾波 (GPIO 18):");
+    response->printf("  擷取預除頻: 每 %u 個上升緣擷取一次\n", st.prescale);
+    if (st.minPeriodUs > 0) {
+        response->printf("  最小週期: %u us (相當於 %.0f RPM 以上視為雜訊)\n", st.minPeriodUs,
+                         60.0f * 1000000.0f / ((float)st.minPeriodUs * uart1.getPolePairs()));
+    } else {
+        response->println("  最小週期: 停用");
+    }
+    if (st.outlierPct > 0) {
+        response->printf("  離群剔除: 最近 %u 週期中位數 ±%u%%\n", PeriodHistory::OUTLIER_WINDOW, st.outlierPct);
+    } else {
+        response->println("  離群剔除: 停用");
+    }
+    response->println("  剔除計數:");
+    response->printf("    ISR 最小週期: %u\n", st.glitchRejects);
+    response->printf("    過短 (雜訊邊緣): %u\n", st.shortRejects);
+    response->printf("    過長 (遺失邊緣): %u\n", st.longRejects);
+    response->printf("    轉速變化重新同步: %u\n", st.resyncs);
+    response->printf("    環形緩衝溢位: %u\n", uart1.getCaptureOverflowCount());
+    response->println("");
+    return true;
+}
+
+bool CommandParser::handleMotorStatus(ICommandResponse* response) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
@@ -1006,7 +1641,12 @@ void CommandParser::handleMotorStatus(ICommandResponse* response) {
     // PWM output status
     response->println("PWM 輸出:");
     response->printf("  頻率: %d Hz\n", uart1.getPWMFrequency());
-    response->printf("  占空比: %.1f%%\n", uart1.getPWMDuty());
+    response->printf("  實際頻率: %.3f Hz (誤差 %+d ppm, 預除頻 %u, 週期 %u)\n",
+                     uart1.getPWMActualFrequency(), uart1.getPWMFrequencyErrorPpm(),
+                     uart1.getPWMPrescaler(), uart1.getPWMPeriod());
+    response->printf("  占空比: %.3f%% (實際 %.3f%%)\n", uart1.getPWMDuty(), uart1.getPWMDutyActual());
+    response->printf("  占空比解析度: %.4f%%%s\n", uart1.getDutyResolution(),
+                     uart1.isDutyDither() ? " (抖動)" : "");
     response->printf("  最大頻率限制: %d Hz\n", uart1.getMaxFrequency());
     response->println("");
 
@@ -1028,14 +1668,17 @@ void CommandParser::handleMotorStatus(ICommandResponse* response) {
         response->printf("  鮑率: %u bps\n", uart1.getUARTBaudRate());
         response->println("");
     }
+    return true;
 }
 
-void CommandParser::handleMotorStop(ICommandResponse* response) {
+bool CommandParser::handleMotorStop(ICommandResponse* response) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
-    // Emergency stop: set duty to 0% and disable PWM
+    // Emergency stop: stop closed-loop control and the follower, set duty to 0% and disable PWM
     float currentRPM = uart1.getCalculatedRPM();
+    peripheralManager.getRPMController().setEnabled(false);
+    uart1.setFollowMode(false);
     uart1.setPWMDuty(0.0);
     uart1.setPWMEnabled(false);
 
@@ -1046,24 +1689,30 @@ void CommandParser::handleMotorStop(ICommandResponse* response) {
     if (webServerManager.isRunning()) {
         webServerManager.broadcastStatus();
     }
+    return true;
 }
 
-void CommandParser::handleSaveSettings(ICommandResponse* response) {
+bool CommandParser::handleSaveSettings(ICommandResponse* response) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
-    if (uart1.saveSettings()) {
+    if (uart1.saveSettings() && peripheralManager.getRPMController().saveSettings() &&
+        peripheralManager.getFans().saveSettings()) {
         response->println("✅ UART1 馬達控制設定已儲存到 NVS");
     } else {
         response->println("❌ 儲存 UART1 設定失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleLoadSettings(ICommandResponse* response) {
+bool CommandParser::handleLoadSettings(ICommandResponse* response) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
     if (uart1.loadSettings()) {
+        peripheralManager.getRPMController().loadSettings();
+        peripheralManager.getFans().loadSettings();
         response->println("✅ UART1 馬達控制設定已從 NVS 載入");
         response->printf("  PWM 頻率: %d Hz\n", uart1.getPWMFrequency());
         response->printf("  PWM 占空比: %.1f%%\n", uart1.getPWMDuty());
@@ -1077,15 +1726,21 @@ void CommandParser::handleLoadSettings(ICommandResponse* response) {
         }
     } else {
         response->println("❌ 載入 UART1 設定失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleResetSettings(ICommandResponse* response) {
+bool CommandParser::handleResetSettings(ICommandResponse* response) {
     // Route to UART1 motor control (migrated from old MotorControl)
     auto& uart1 = peripheralManager.getUART1();
 
     uart1.resetToDefaults();
     uart1.saveSettings();
+    peripheralManager.getRPMController().resetToDefaults();
+    peripheralManager.getRPMController().saveSettings();
+    peripheralManager.getFans().resetToDefaults();
+    peripheralManager.getFans().saveSettings();
 
     response->println("✅ UART1 馬達控制設定已重設為出廠預設值");
     response->printf("  PWM 頻率: %d Hz\n", uart1.getPWMFrequency());
@@ -1097,64 +1752,312 @@ void CommandParser::handleResetSettings(ICommandResponse* response) {
     if (webServerManager.isRunning()) {
         webServerManager.broadcastStatus();
     }
+    return true;
 }
 
 // ==================== Advanced Features (Priority 3) ====================
-// REMOVED IN v3.0: Motor control merged to UART1, ramping and filtering not available
+// Ramping reinstated on the UART1 ramp engine (TEZ shadow register updates).
+// Filtering is still not available.
 
-// void CommandParser::handleSetPWMFreqRamped(ICommandResponse* response, uint32_t freq, uint32_t rampTimeMs) {
-//     if (freq < MotorLimits::MIN_FREQUENCY || freq > MotorLimits::MAX_FREQUENCY) {
-//         response->printf("❌ 錯誤：頻率必須在 %d - %d Hz 之間\n",
-//                         MotorLimits::MIN_FREQUENCY, MotorLimits::MAX_FREQUENCY);
-//         return;
-//     }
-//
-//     if (rampTimeMs == 0) {
-//         response->println("⚠️ 漸變時間為 0，將立即設定");
-//         handleSetPWMFreq(response, freq);
-//         return;
-//     }
-//
-//     if (motorControl.setPWMFrequencyRamped(freq, rampTimeMs)) {
-//         response->printf("✅ 開始頻率漸變: %d Hz → %d Hz (耗時 %d ms)\n",
-//                         motorControl.getPWMFrequency(), freq, rampTimeMs);
-//
-//         // Notify web clients - they will see gradual change via periodic updates
-//         if (webServerManager.isRunning()) {
-//             webServerManager.broadcastStatus();
-//         }
-//     } else {
-//         response->println("❌ 啟動頻率漸變失敗");
-//     }
-// }
-//
-// void CommandParser::handleSetPWMDutyRamped(ICommandResponse* response, float duty, uint32_t rampTimeMs) {
-//     if (duty < MotorLimits::MIN_DUTY || duty > MotorLimits::MAX_DUTY) {
-//         response->printf("❌ 錯誤：占空比必須在 %.0f - %.0f%% 之間\n",
-//                         MotorLimits::MIN_DUTY, MotorLimits::MAX_DUTY);
-//         return;
-//     }
-//
-//     if (rampTimeMs == 0) {
-//         response->println("⚠️ 漸變時間為 0，將立即設定");
-//         handleSetPWMDuty(response, duty);
-//         return;
-//     }
-//
-//     if (motorControl.setPWMDutyRamped(duty, rampTimeMs)) {
-//         response->printf("✅ 開始占空比漸變: %.1f%% → %.1f%% (耗時 %d ms)\n",
-//                         motorControl.getPWMDuty(), duty, rampTimeMs);
-//
-//         // Notify web clients - they will see gradual change via periodic updates
-//         if (webServerManager.isRunning()) {
-//             webServerManager.broadcastStatus();
-//         }
-//     } else {
-//         response->println("❌ 啟動占空比漸變失敗");
-//     }
-// }
-//
-// void CommandParser::handleSetRPMFilterSize(ICommandResponse* response, uint8_t size) {
+bool CommandParser::handleRamp(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.is(0, "STOP")) {
+        bool wasRamping = uart1.isRamping();
+        uart1.stopRamp();
+        response->println(wasRamping ? "⏹️ 漸變已停止 (保持目前輸出)" : "ℹ️ 沒有進行中的漸變");
+        return true;
+    }
+
+    if (args.is(0, "STATUS")) {
+        response->println("");
+        response->println("PWM 漸變狀態:");
+        response->printf("  狀態: %s\n", uart1.isRamping() ? "⚙️ 進行中" : "閒置");
+        response->printf("  進度: %.1f%%\n", uart1.getRampProgress() * 100.0f);
+        response->printf("  目標: %u Hz, %.1f%% (%u ms, %s)\n",
+                         uart1.getRampTargetFrequency(), uart1.getRampTargetDuty(),
+                         uart1.getRampDurationMs(),
+                         uart1.getRampProfile() == UART1Mux::RAMP_SCURVE ? "S-curve" : "linear");
+        response->printf("  當前: %u Hz, %.1f%%\n", uart1.getPWMFrequency(), uart1.getPWMDuty());
+        response->printf("  暫存器更新次數: %u\n", uart1.getRampSteps());
+        response->println("");
+        return true;
+    }
+
+    // Optional trailing profile keyword
+    uint8_t count = args.count();
+    UART1Mux::RampProfile profile = UART1Mux::RAMP_LINEAR;
+    if (count > 1 && (args.is(count - 1, "SCURVE") || args.is(count - 1, "S"))) {
+        profile = UART1Mux::RAMP_SCURVE;
+        count--;
+    } else if (count > 1 && args.is(count - 1, "LINEAR")) {
+        count--;
+    }
+
+    // Parse: PARAMETER VALUE [VALUE2] TIME
+    if (count < 2) {
+        response->println("❌ 錯誤：格式應為 RAMP <PWM_FREQ|PWM_DUTY|PWM> <value...> <time_ms> [LINEAR|SCURVE]");
+        return false;
+    }
+
+    if (peripheralManager.getRPMController().isEnabled()) {
+        response->println("❌ 閉迴路 PID 控制中，請先執行 PID OFF");
+        return false;
+    }
+
+    if (args.is(0, "PWM")) {
+        uint32_t freq = 0;
+        float duty = 0.0f;
+        uint32_t rampTimeMs = 0;
+        if (count != 4) {
+            response->println("❌ 錯誤：格式應為 RAMP PWM <Hz> <%> <time_ms> [LINEAR|SCURVE]");
+            return false;
+        }
+        if (!args.getUInt(1, 0, UINT32_MAX, freq) || !args.getFloat(2, -1e6f, 1e6f, duty) ||
+            !args.getUInt(3, 0, UINT32_MAX, rampTimeMs)) {
+            response->println("❌ 錯誤：格式應為 RAMP PWM <Hz> <%> <time_ms> [LINEAR|SCURVE]");
+            reportArgError(response, args);
+            return false;
+        }
+        if (freq < 10 || freq > uart1.getMaxFrequency() || duty < 0.0 || duty > 100.0) {
+            response->printf("❌ 錯誤：頻率必須在 10 - %u Hz，占空比 0 - 100%%\n", uart1.getMaxFrequency());
+            return false;
+        }
+        if (uart1.startRamp(freq, duty, rampTimeMs, profile)) {
+            response->printf("✅ 開始漸變: %u Hz / %.1f%% (耗時 %u ms, %s)\n", freq, duty, rampTimeMs,
+                             profile == UART1Mux::RAMP_SCURVE ? "S-curve" : "linear");
+        } else {
+            response->println("❌ 啟動漸變失敗 (目標需在目前預分頻器範圍內)");
+            return false;
+        }
+        return true;
+    }
+
+    if (count != 3) {
+        response->println("❌ 錯誤：格式應為 RAMP <parameter> <value> <time_ms>");
+        return false;
+    }
+    uint32_t rampTimeMs = 0;
+
+    if (args.is(0, "PWM_FREQ")) {
+        uint32_t freq = 0;
+        if (!args.getUInt(1, 0, UINT32_MAX, freq) || !args.getUInt(2, 0, UINT32_MAX, rampTimeMs)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetPWMFreqRamped(response, freq, rampTimeMs, profile);
+    }
+
+    if (args.is(0, "PWM_DUTY")) {
+        float duty = 0.0f;
+        if (!args.getFloat(1, -1e6f, 1e6f, duty) || !args.getUInt(2, 0, UINT32_MAX, rampTimeMs)) {
+            reportArgError(response, args);
+            return false;
+        }
+        return handleSetPWMDutyRamped(response, duty, rampTimeMs, profile);
+    }
+
+    response->println("❌ 錯誤：不支援的 RAMP 參數（支援: PWM_FREQ, PWM_DUTY, PWM, STOP, STATUS）");
+    return false;
+}
+
+bool CommandParser::handleFollow(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.is(0, "OFF")) {
+        uart1.setFollowMode(false);
+        response->printf("✅ 跟隨模式已停止，輸出維持 %u Hz\n", uart1.getPWMFrequency());
+        return true;
+    }
+
+    if (args.is(0, "LOOP")) {
+        float gain = 0.0f;
+        uint32_t lockPpm = 0;
+        if (!args.getFloat(1, 0.01f, 1.0f, gain) || !args.getUInt(2, 1, 100000, lockPpm) ||
+            !uart1.setFollowLoop(gain, lockPpm)) {
+            response->println("❌ 用法: FOLLOW LOOP <增益 0.01-1> <鎖定範圍 1-100000 ppm>");
+            reportArgError(response, args);
+            return false;
+        }
+        response->printf("✅ 跟隨迴路: 增益 %.2f, 鎖定範圍 ±%u ppm\n", gain, lockPpm);
+        return true;
+    }
+
+    if (args.is(0, "ON")) {
+        if (uart1.getMode() != UART1Mux::MODE_PWM_RPM) {
+            response->println("❌ UART1 不在 PWM/RPM 模式");
+            return false;
+        }
+        if (peripheralManager.getRPMController().isEnabled()) {
+            response->println("❌ 閉迴路 PID 控制中，請先執行 PID OFF");
+            return false;
+        }
+        if (peripheralManager.getStepAnalyzer().getState() == StepAnalyzer::STEP_RUNNING ||
+            (peripheralManager.getSweep().getState() == FanSweep::SWEEP_RUNNING &&
+             peripheralManager.getSweep().getConfig().channel == 0)) {
+            response->println("❌ 步階測試或特性掃描執行中");
+            return false;
+        }
+        if (uart1.isFaultLatched()) {
+            response->println("❌ 轉速保護已觸發，請先執行 FAULT CLEAR");
+            return false;
+        }
+
+        // Optional arguments: ON [ratio] [offset_hz] [N]
+        float ratio = 1.0f;
+        float offsetHz = 0.0f;
+        uint32_t everyN = 1;
+        if ((args.has(1) && !args.getFloat(1, 0.001f, 1000.0f, ratio)) ||
+            (args.has(2) && !args.getFloat(2, -100000.0f, 100000.0f, offsetHz)) ||
+            (args.has(3) && !args.getUInt(3, 1, 1000, everyN)) ||
+            !uart1.setFollowMode(true, ratio, offsetHz, everyN)) {
+            response->println("❌ 參數錯誤 (比例 0.001-1000, 偏移 ±100000 Hz, N 1-1000)");
+            reportArgError(response, args);
+            return false;
+        }
+        if (!uart1.isFollowing()) {
+            response->println("⚠️ 量測 Task 尚未就緒，將於就緒後啟用");
+            return true;
+        }
+        response->printf("✅ 跟隨模式已啟用: 輸出 = 輸入 × %.4f %+.1f Hz (每 %u 個週期更新)\n",
+                         ratio, offsetHz, everyN);
+        response->println("   使用 FOLLOW STATUS 查看追蹤誤差與鎖定狀態");
+        return true;
+    }
+
+    if (!args.empty() && !args.is(0, "STATUS")) {
+        response->println("❌ 用法: FOLLOW [STATUS | ON [比例] [偏移Hz] [N] | LOOP <增益> <ppm> | OFF]");
+        return false;
+    }
+
+    FollowStatus st = uart1.getFollowStatus();
+    response->println("");
+    response->println("跟隨模式 (軟體 FLL):");
+    response->printf("  狀態: %s\n", st.enabled ? (st.locked ? "🔒 已鎖定" : "🔓 追蹤中") : "停用");
+    response->printf("  設定: 輸出 = 輸入 × %.4f %+.1f Hz, 每 %u 個週期更新\n",
+                     st.ratio, st.offsetHz, st.everyN);
+    response->printf("  迴路: 增益 %.2f, 鎖定範圍 ±%u ppm (連續 %u 次)\n",
+                     st.gain, st.lockPpm, UART1Mux::FOLLOW_LOCK_UPDATES);
+    if (st.enabled) {
+        response->printf("  輸入: %.3f Hz%s\n", st.inputHz, st.signal ? "" : " (無訊號，輸出保持)");
+        response->printf("  目標: %.3f Hz%s\n", st.targetHz, st.clamped ? " (超出輸出範圍，已限制)" : "");
+        response->printf("  輸出: %.3f Hz\n", st.outputHz);
+        response->printf("  追蹤誤差: %+.3f Hz (%+ld ppm)\n", st.errorHz, (long)st.errorPpm);
+        response->printf("  更新次數: %u, 失鎖次數: %u, 預分頻器切換: %u\n",
+                         st.updates, st.lockLosses, st.prescalerChanges);
+    }
+    response->println("");
+    return true;
+}
+
+bool CommandParser::handleDither(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.is(0, "OFF")) {
+        uart1.setDutyDither(false, uart1.getDutyDitherRate());
+        response->printf("✅ 占空比抖動已停止，解析度 %.4f%%\n", uart1.getDutyResolution());
+        return true;
+    }
+
+    if (args.is(0, "ON")) {
+        uint32_t rateHz = uart1.getDutyDitherRate();
+        if ((args.has(1) && !args.getUInt(1, 100, 20000, rateHz)) || !uart1.setDutyDither(true, rateHz)) {
+            response->println("❌ 更新率必須在 100 - 20000 Hz 之間 (或計時器初始化失敗)");
+            reportArgError(response, args);
+            return false;
+        }
+        response->printf("✅ 占空比抖動已啟用: %u 次/秒, 平均解析度 %.4f%%\n",
+                         rateHz, uart1.getDutyResolution());
+        if (uart1.getMode() != UART1Mux::MODE_PWM_RPM) {
+            response->println("   將於進入 PWM/RPM 模式時生效");
+        }
+        return true;
+    }
+
+    if (!args.empty() && !args.is(0, "STATUS")) {
+        response->println("❌ 用法: DITHER [STATUS | ON [更新率 Hz] | OFF]");
+        return false;
+    }
+
+    uint32_t period = uart1.getPWMPeriod();
+    response->println("");
+    response->println("占空比解析度:");
+    response->printf("  原生: %.4f%% (週期 %u ticks)\n", (period > 0) ? 100.0f / (float)period : 0.0f, period);
+    response->printf("  抖動: %s, 更新率 %u Hz\n", uart1.isDutyDither() ? "啟用" : "停用",
+                     uart1.getDutyDitherRate());
+    response->printf("  有效解析度: %.4f%%\n", uart1.getDutyResolution());
+    if (uart1.isDutyDither()) {
+        response->printf("  達到 0.01%% 的平均時間: %.1f ms\n", uart1.getDutyDitherWindowMs(0.01f));
+        response->printf("  更新次數: %u\n", uart1.getDutyDitherUpdates());
+    }
+    response->printf("  占空比: 設定 %.3f%%, 實際 %.3f%%\n", uart1.getPWMDuty(), uart1.getPWMDutyActual());
+    response->println("");
+    return true;
+}
+
+bool CommandParser::handleSetPWMFreqRamped(ICommandResponse* response, uint32_t freq, uint32_t rampTimeMs,
+                                           UART1Mux::RampProfile profile) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (freq < 10 || freq > uart1.getMaxFrequency()) {
+        response->printf("❌ 錯誤：頻率必須在 10 - %u Hz 之間\n", uart1.getMaxFrequency());
+        return false;
+    }
+
+    if (rampTimeMs == 0) {
+        response->println("⚠️ 漸變時間為 0，將立即設定");
+        return handleSetPWMFreq(response, freq);
+    }
+
+    uint32_t startFreq = uart1.getPWMFrequency();
+    if (uart1.startRamp(freq, -1.0f, rampTimeMs, profile)) {
+        response->printf("✅ 開始頻率漸變: %u Hz → %u Hz (耗時 %u ms, %s)\n",
+                        startFreq, freq, rampTimeMs,
+                        profile == UART1Mux::RAMP_SCURVE ? "S-curve" : "linear");
+
+        // Notify web clients - they will see gradual change via periodic updates
+        if (webServerManager.isRunning()) {
+            webServerManager.broadcastStatus();
+        }
+    } else {
+        response->println("❌ 啟動頻率漸變失敗 (目標需在目前預分頻器範圍內)");
+        return false;
+    }
+    return true;
+}
+
+bool CommandParser::handleSetPWMDutyRamped(ICommandResponse* response, float duty, uint32_t rampTimeMs,
+                                           UART1Mux::RampProfile profile) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (duty < 0.0 || duty > 100.0) {
+        response->println("❌ 錯誤：占空比必須在 0 - 100% 之間");
+        return false;
+    }
+
+    if (rampTimeMs == 0) {
+        response->println("⚠️ 漸變時間為 0，將立即設定");
+        return handleSetPWMDuty(response, duty);
+    }
+
+    float startDuty = uart1.getPWMDuty();
+    if (uart1.startRamp(0, duty, rampTimeMs, profile)) {
+        response->printf("✅ 開始占空比漸變: %.1f%% → %.1f%% (耗時 %u ms, %s)\n",
+                        startDuty, duty, rampTimeMs,
+                        profile == UART1Mux::RAMP_SCURVE ? "S-curve" : "linear");
+
+        // Notify web clients - they will see gradual change via periodic updates
+        if (webServerManager.isRunning()) {
+            webServerManager.broadcastStatus();
+        }
+    } else {
+        response->println("❌ 啟動占空比漸變失敗");
+        return false;
+    }
+    return true;
+}
+
+// bool CommandParser::handleSetRPMFilterSize(ICommandResponse* response, uint8_t size) {
 //     if (size < 1 || size > 20) {
 //         response->println("❌ 錯誤：濾波器大小必須在 1 - 20 之間");
 //         return;
@@ -1164,7 +2067,7 @@ void CommandParser::handleResetSettings(ICommandResponse* response) {
 //     response->printf("✅ RPM 濾波器大小已設定為: %d 個樣本\n", size);
 // }
 //
-// void CommandParser::handleFilterStatus(ICommandResponse* response) {
+// bool CommandParser::handleFilterStatus(ICommandResponse* response) {
 //     response->println("=== RPM 濾波器狀態 ===");
 //     response->printf("濾波器大小: %d 個樣本\n", motorControl.getRPMFilterSize());
 //     response->printf("原始 RPM: %.0f RPM\n", motorControl.getRawRPM());
@@ -1185,7 +2088,7 @@ void CommandParser::handleResetSettings(ICommandResponse* response) {
 
 // ==================== WiFi and Web Server Commands ====================
 
-void CommandParser::handleWiFiStatus(ICommandResponse* response) {
+bool CommandParser::handleWiFiStatus(ICommandResponse* response) {
     response->println("=== WiFi 狀態 ===");
 
     const WiFiSettings& settings = wifiSettingsManager.get();
@@ -1213,9 +2116,10 @@ void CommandParser::handleWiFiStatus(ICommandResponse* response) {
     }
 
     response->println("");
+    return true;
 }
 
-void CommandParser::handleWiFiStart(ICommandResponse* response) {
+bool CommandParser::handleWiFiStart(ICommandResponse* response) {
     response->println("🔧 啟動 WiFi...");
 
     if (wifiManager.start()) {
@@ -1224,22 +2128,25 @@ void CommandParser::handleWiFiStart(ICommandResponse* response) {
         response->printf("  模式: %s\n", wifiManager.getModeString().c_str());
     } else {
         response->println("❌ WiFi 啟動失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleWiFiStop(ICommandResponse* response) {
+bool CommandParser::handleWiFiStop(ICommandResponse* response) {
     wifiManager.stop();
     response->println("✅ WiFi 已停止");
+    return true;
 }
 
-void CommandParser::handleWiFiScan(ICommandResponse* response) {
+bool CommandParser::handleWiFiScan(ICommandResponse* response) {
     response->println("🔍 掃描 WiFi 網路...");
 
     int n = wifiManager.scanNetworks();
 
     if (n <= 0) {
         response->println("⚠️ 未找到網路");
-        return;
+        return true;
     }
 
     response->printf("找到 %d 個網路:\n\n", n);
@@ -1260,9 +2167,10 @@ void CommandParser::handleWiFiScan(ICommandResponse* response) {
     }
 
     response->println("");
+    return true;
 }
 
-void CommandParser::handleWebStatus(ICommandResponse* response) {
+bool CommandParser::handleWebStatus(ICommandResponse* response) {
     response->println("=== Web 伺服器狀態 ===");
 
     response->printf("執行中: %s\n", webServerManager.isRunning() ? "是" : "否");
@@ -1275,52 +2183,30 @@ void CommandParser::handleWebStatus(ICommandResponse* response) {
     }
 
     response->println("");
+    return true;
 }
 
-void CommandParser::handleWiFiConnect(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleWiFiConnect(CommandArgs& args, ICommandResponse* response) {
     // Parse command: WIFI <ssid> <password>
-    // Format: "WIFI ssid password" or "wifi ssid password"
+    // Format: "WIFI ssid password" or "wifi ssid password" (SSID and password keep their case;
+    // the password is the rest of the line and may contain spaces)
 
-    int firstSpace = cmd.indexOf(' ');
-    if (firstSpace == -1) {
-        response->println("❌ 格式錯誤");
-        response->println("用法: WIFI <ssid> <password>");
-        return;
-    }
-
-    String remainder = cmd.substring(firstSpace + 1);
-    remainder.trim();
-
-    int secondSpace = remainder.indexOf(' ');
-    if (secondSpace == -1) {
+    if (args.count() < 2) {
         response->println("❌ 格式錯誤: 缺少密碼");
         response->println("用法: WIFI <ssid> <password>");
-        return;
-    }
-
-    String ssid = remainder.substring(0, secondSpace);
-    String password = remainder.substring(secondSpace + 1);
-
-    ssid.trim();
-    password.trim();
-
-    if (ssid.length() == 0) {
-        response->println("❌ SSID 不能為空");
-        return;
+        return false;
     }
 
     // Update WiFi settings
     WiFiSettings& settings = wifiSettingsManager.get();
-    strncpy(settings.sta_ssid, ssid.c_str(), sizeof(settings.sta_ssid) - 1);
-    settings.sta_ssid[sizeof(settings.sta_ssid) - 1] = '\0';
-    strncpy(settings.sta_password, password.c_str(), sizeof(settings.sta_password) - 1);
-    settings.sta_password[sizeof(settings.sta_password) - 1] = '\0';
+    args.copy(0, settings.sta_ssid, sizeof(settings.sta_ssid));
+    args.copyRest(1, settings.sta_password, sizeof(settings.sta_password));
     settings.mode = WiFiMode::STA;  // Set to Station mode
 
     // Save settings
     wifiSettingsManager.save();
 
-    response->printf("🔧 正在連接到 WiFi: %s\n", ssid.c_str());
+    response->printf("🔧 正在連接到 WiFi: %s\n", settings.sta_ssid);
 
     // Stop current WiFi
     wifiManager.stop();
@@ -1351,19 +2237,22 @@ void CommandParser::handleWiFiConnect(const String& cmd, ICommandResponse* respo
         } else {
             response->println("❌ WiFi 連接失敗");
             response->println("  請檢查 SSID 和密碼是否正確");
+            return false;
         }
     } else {
         response->println("❌ WiFi 啟動失敗");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleIPAddress(ICommandResponse* response) {
+bool CommandParser::handleIPAddress(ICommandResponse* response) {
     response->println("=== IP 位址資訊 ===");
 
     if (!wifiManager.isConnected()) {
         response->println("⚠️ WiFi 未連接");
         response->println("");
-        return;
+        return true;
     }
 
     const WiFiSettings& settings = wifiSettingsManager.get();
@@ -1395,6 +2284,7 @@ void CommandParser::handleIPAddress(ICommandResponse* response) {
     }
 
     response->println("");
+    return true;
 }
 
 // ==================== HID Response Implementation ====================
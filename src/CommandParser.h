@@ -2,6 +2,9 @@
 #define COMMAND_PARSER_H
 
 #include <Arduino.h>
+#include "UART1Mux.h"
+#include "CommandTable.h"
+#include "CommandArgs.h"
 
 // 命令來源類型
 enum CommandSource {
@@ -22,86 +25,184 @@ public:
 // 命令解析器類別
 class CommandParser {
 public:
+    // 單一命令列的最大長度（不含結尾 NUL）
+    static constexpr size_t MAX_LINE_LENGTH = 256;
+
+    // 批次（以 ; 分隔）與交易（BEGIN ... COMMIT）的命令數上限
+    static constexpr uint8_t MAX_BATCH_COMMANDS = 16;
+    // 每個來源的交易緩衝區（已驗證的命令以 NUL 分隔存放）
+    static constexpr size_t TRANSACTION_SIZE = 512;
+    // 交易閒置超過此時間即取消，斷線的用戶端不會讓該來源一直停在交易中
+    static constexpr uint32_t TRANSACTION_TIMEOUT_MS = 30000;
+
     CommandParser();
 
-    // 處理單一命令（必須以 \n 結尾）
-    // 返回 true 表示命令已處理
-    bool processCommand(const String& cmd, ICommandResponse* response, CommandSource source);
+    // 處理單一命令（NUL 結尾，前後空白與換行會被忽略）
+    // 以 ; 分隔的多個命令為一個批次：全部先驗證，再連續執行並回傳一份彙總回應
+    // 解析過程不配置堆積記憶體；命令列不會被修改
+    // 返回 true 表示命令已執行且成功（批次為全部成功）；未知命令、參數錯誤或被拒絕時為 false
+    bool processCommand(const char* cmd, ICommandResponse* response, CommandSource source);
+    bool processCommand(const String& cmd, ICommandResponse* response, CommandSource source) {
+        return processCommand(cmd.c_str(), response, source);
+    }
+
+    // 在呼叫者的任務中執行 CMD_FLAG_INLINE 命令（DELAY），可與執行器同時進行
+    // 不讀寫批次/交易狀態；其他命令回傳 false 且不執行
+    bool processInline(const char* cmd, ICommandResponse* response, CommandSource source);
 
-    // 添加字元到緩衝區，自動處理換行和命令執行
-    // 返回 true 表示有完整命令被處理
-    bool feedChar(char c, String& buffer, ICommandResponse* response, CommandSource source);
+    // 處理一個 HID 二進位請求（0xA0 封包，見 HIDBinary），回應寫入 reply（64 bytes，0xA2 封包）
+    // 不產生文字輸出；返回 false 表示 opcode 或參數錯誤（reply 中帶狀態碼）
+    bool processBinary(const uint8_t* request, uint8_t* reply);
+
+    // 添加字元到緩衝區（buffer 至少 MAX_LINE_LENGTH + 1 位元組），自動處理換行和命令執行
+    // 返回 processCommand() 的結果；沒有完整命令時為 false
+    bool feedChar(char c, char* buffer, size_t& length, ICommandResponse* response, CommandSource source);
 
     // 檢查命令是否為 SCPI 命令
-    static bool isSCPICommand(const String& cmd);
+    static bool isSCPICommand(const char* cmd);
+    static bool isSCPICommand(const String& cmd) { return isSCPICommand(cmd.c_str()); }
+
+    static const char* getSourceName(CommandSource source);
 
 private:
-    void handleIDN(ICommandResponse* response);
-    void handleHelp(ICommandResponse* response);
-    void handleInfo(ICommandResponse* response);
-    void handleStatus(ICommandResponse* response);
-    void handleSend(ICommandResponse* response);
-    void handleRead(ICommandResponse* response);
-    void handleClear(ICommandResponse* response);
-    void handleDelay(const String& cmd, ICommandResponse* response);
+    // BEGIN 之後、COMMIT 之前的命令（每個來源一份）
+    // WebSocket 的所有用戶端共用一個來源，不開放交易，該欄位不會被開啟
+    struct Transaction {
+        bool open = false;
+        uint8_t count = 0;
+        uint16_t used = 0;
+        uint32_t lastMs = 0;  // BEGIN 或最後一次加入命令的時間
+        char text[TRANSACTION_SIZE];
+    };
+    Transaction transactions[CMD_SOURCE_WEBSOCKET + 1];
+
+    // 處理函式回傳 false 表示命令被拒絕（參數或數值錯誤、週邊設定失敗），批次彙總依此計算成功數
+    typedef bool (CommandParser::*LineHandler)(CommandArgs& args, ICommandResponse* response);
+    typedef bool (CommandParser::*PlainHandler)(ICommandResponse* response);
+    typedef bool (CommandParser::*SourceHandler)(CommandSource source, ICommandResponse* response);
+
+    // COMMAND_TABLE 處理函式：接收參數、只接收回應介面，或接收命令來源（交易控制）
+    // 來源以參數傳入，不存成成員：inline 命令可能與執行器同時呼叫 invokeCommand
+    struct CommandHandler {
+        LineHandler line;
+        PlainHandler plain;
+        SourceHandler sourced;
+        constexpr CommandHandler(LineHandler h) : line(h), plain(nullptr), sourced(nullptr) {}
+        constexpr CommandHandler(PlainHandler h) : line(nullptr), plain(h), sourced(nullptr) {}
+        constexpr CommandHandler(SourceHandler h) : line(nullptr), plain(nullptr), sourced(h) {}
+    };
+    static const CommandHandler HANDLERS[CMD_COUNT];
+
+    // 查表並檢查來源與參數數量（錯誤輸出到 response，不執行）
+    bool checkCommand(const char* cmd, CommandSource source, CommandMatch& match, ICommandResponse* response);
+    bool invokeCommand(const char* cmd, const CommandMatch& match, CommandSource source,
+                       ICommandResponse* response);
+
+    // 批次與交易
+    bool processBatch(const char* cmd, ICommandResponse* response, CommandSource source);
+    uint8_t splitBatch(char* work, const char** commands, bool& overflow);
+    bool checkBatch(const char* const* commands, uint8_t count, CommandSource source, ICommandResponse* response);
+    bool checkSetValues(CommandArgs& args, ICommandResponse* response);
+    bool runBatch(const char* const* commands, uint8_t count, CommandSource source, ICommandResponse* response);
+    bool appendTransaction(Transaction& tx, const char* const* commands, uint8_t count, ICommandResponse* response);
+
+    bool handleIDN(ICommandResponse* response);
+    bool handleHelp(ICommandResponse* response);
+    bool handleInfo(ICommandResponse* response);
+    bool handleStatus(ICommandResponse* response);
+    bool handleSend(ICommandResponse* response);
+    bool handleRead(ICommandResponse* response);
+    bool handleClear(ICommandResponse* response);
+    bool handleDelay(CommandArgs& args, ICommandResponse* response);
+    bool handleClearError(ICommandResponse* response);
+    bool handleExecutor(CommandArgs& args, ICommandResponse* response);
+    bool handleBegin(CommandSource source, ICommandResponse* response);
+    bool handleCommit(CommandSource source, ICommandResponse* response);
+    bool handleAbort(CommandSource source, ICommandResponse* response);
 
     // Motor control command handlers
-    void handleSetPWMFreq(ICommandResponse* response, uint32_t freq);
-    void handleSetPWMDuty(ICommandResponse* response, float duty);
-    void handleSetPWMFreqAndDuty(ICommandResponse* response, uint32_t freq, float duty);
-    void handleSetPolePairs(ICommandResponse* response, uint8_t pairs);
-    void handleSetMaxFreq(ICommandResponse* response, uint32_t maxFreq);
-    void handleSetMaxRPM(ICommandResponse* response, uint32_t maxRPM);
-    void handleSetLEDBrightness(ICommandResponse* response, uint8_t brightness);
-    void handleRPM(ICommandResponse* response);
-    void handleMotorStatus(ICommandResponse* response);
-    void handleMotorStop(ICommandResponse* response);
-    void handleSaveSettings(ICommandResponse* response);
-    void handleLoadSettings(ICommandResponse* response);
-    void handleResetSettings(ICommandResponse* response);
-
-    // Advanced features (Priority 3) - REMOVED IN v3.0
-    // These functions were removed when motor control merged to UART1
-    // Ramping and filtering features are not available in v3.0
-    // void handleSetPWMFreqRamped(ICommandResponse* response, uint32_t freq, uint32_t rampTimeMs);
-    // void handleSetPWMDutyRamped(ICommandResponse* response, float duty, uint32_t rampTimeMs);
-    // void handleSetRPMFilterSize(ICommandResponse* response, uint8_t size);
-    // void handleFilterStatus(ICommandResponse* response);
+    bool handleSet(CommandArgs& args, ICommandResponse* response);
+    bool handleSetPWMFreq(ICommandResponse* response, uint32_t freq);
+    bool handleSetPWMDuty(ICommandResponse* response, float duty);
+    bool handleSetPWMFreqAndDuty(ICommandResponse* response, uint32_t freq, float duty);
+    bool handleSetPolePairs(ICommandResponse* response, uint8_t pairs);
+    bool handleSetMaxFreq(ICommandResponse* response, uint32_t maxFreq);
+    bool handleSetMaxRPM(ICommandResponse* response, uint32_t maxRPM);
+    bool handleSetLEDBrightness(ICommandResponse* response, uint8_t brightness);
+    bool handleRPM(ICommandResponse* response);
+    bool handleRPMStats(CommandArgs& args, ICommandResponse* response);
+    bool handleRPMAveraging(CommandArgs& args, ICommandResponse* response);
+    bool handleRPMTimeout(CommandArgs& args, ICommandResponse* response);
+    bool handleRPMEvent(CommandArgs& args, ICommandResponse* response);
+    bool handleRPMCounter(CommandArgs& args, ICommandResponse* response);
+    bool handleRPMLatency(CommandArgs& args, ICommandResponse* response);
+    bool handleRPMDuty(CommandArgs& args, ICommandResponse* response);
+    bool handleRPMFilter(CommandArgs& args, ICommandResponse* response);
+
+    // Closed-loop RPM control commands (MotorCommands.cpp)
+    bool handleRPMSet(CommandArgs& args, ICommandResponse* response);
+    bool handlePID(CommandArgs& args, ICommandResponse* response);
+    bool handleFault(CommandArgs& args, ICommandResponse* response);
+    bool handleFan(CommandArgs& args, ICommandResponse* response);
+    bool handleSweep(CommandArgs& args, ICommandResponse* response);
+    bool handleStep(CommandArgs& args, ICommandResponse* response);
+    bool handleMotorStatus(ICommandResponse* response);
+    bool handleMotorStop(ICommandResponse* response);
+    bool handleSaveSettings(ICommandResponse* response);
+    bool handleLoadSettings(ICommandResponse* response);
+    bool handleResetSettings(ICommandResponse* response);
+
+    // Advanced features (Priority 3)
+    // Ramping runs on the UART1 ramp engine; filtering is not available in v3.0
+    bool handleRamp(CommandArgs& args, ICommandResponse* response);
+    bool handleFollow(CommandArgs& args, ICommandResponse* response);
+    bool handleDither(CommandArgs& args, ICommandResponse* response);
+    bool handleSetPWMFreqRamped(ICommandResponse* response, uint32_t freq, uint32_t rampTimeMs,
+                                UART1Mux::RampProfile profile);
+    bool handleSetPWMDutyRamped(ICommandResponse* response, float duty, uint32_t rampTimeMs,
+                                UART1Mux::RampProfile profile);
+    // bool handleSetRPMFilterSize(ICommandResponse* response, uint8_t size);
+    // bool handleFilterStatus(ICommandResponse* response);
 
     // WiFi and Web Server commands (WiFi Web Server feature)
-    void handleWiFiConnect(const String& cmd, ICommandResponse* response);
-    void handleIPAddress(ICommandResponse* response);
-    void handleWiFiStatus(ICommandResponse* response);
-    void handleWiFiStart(ICommandResponse* response);
-    void handleWiFiStop(ICommandResponse* response);
-    void handleWiFiScan(ICommandResponse* response);
-    void handleWebStatus(ICommandResponse* response);
+    bool handleWiFiConnect(CommandArgs& args, ICommandResponse* response);
+    bool handleIPAddress(ICommandResponse* response);
+    bool handleWiFiStatus(ICommandResponse* response);
+    bool handleWiFiStart(ICommandResponse* response);
+    bool handleWiFiStop(ICommandResponse* response);
+    bool handleWiFiScan(ICommandResponse* response);
+    bool handleWebStatus(ICommandResponse* response);
 
     // Peripheral commands (UART, Buzzer, LED, Relay, GPIO, Keys)
-    void handleUART1Mode(const String& cmd, ICommandResponse* response);
-    void handleUART1Config(const String& cmd, ICommandResponse* response);
-    void handleUART1PWM(const String& cmd, ICommandResponse* response);
-    void handleUART1Status(ICommandResponse* response);
-    void handleUART1Write(const String& cmd, ICommandResponse* response);
-    void handleUART2Config(const String& cmd, ICommandResponse* response);
-    void handleUART2Status(ICommandResponse* response);
-    void handleUART2Write(const String& cmd, ICommandResponse* response);
-    void handleBuzzerControl(const String& cmd, ICommandResponse* response);
-    void handleBuzzerBeep(const String& cmd, ICommandResponse* response);
-    void handleLEDPWM(const String& cmd, ICommandResponse* response);
-    void handleLEDFade(const String& cmd, ICommandResponse* response);
-    void handleRelayControl(const String& cmd, ICommandResponse* response);
-    void handleGPIOControl(const String& cmd, ICommandResponse* response);
-    void handleKeysStatus(ICommandResponse* response);
-    void handleKeysConfig(const String& cmd, ICommandResponse* response);
-    void handleKeysMode(const String& cmd, ICommandResponse* response);
-    void handlePeripheralStatus(ICommandResponse* response);
-    void handlePeripheralStats(ICommandResponse* response);
+    bool handleUART1Mode(CommandArgs& args, ICommandResponse* response);
+    bool handleUART1Config(CommandArgs& args, ICommandResponse* response);
+    bool handleUART1PWM(CommandArgs& args, ICommandResponse* response);
+    bool handleUART1Status(ICommandResponse* response);
+    bool handleUART1Switch(CommandArgs& args, ICommandResponse* response);
+    bool handleUART1Complementary(CommandArgs& args, ICommandResponse* response);
+    bool handleUART1Write(CommandArgs& args, ICommandResponse* response);
+    bool handleUART2Config(CommandArgs& args, ICommandResponse* response);
+    bool handleUART2Status(ICommandResponse* response);
+    bool handleUART2Write(CommandArgs& args, ICommandResponse* response);
+    bool handleBuzzerControl(CommandArgs& args, ICommandResponse* response);
+    bool handleBuzzerBeep(CommandArgs& args, ICommandResponse* response);
+    bool handleLEDPWM(CommandArgs& args, ICommandResponse* response);
+    bool handleLEDFade(CommandArgs& args, ICommandResponse* response);
+    bool handleRelayControl(CommandArgs& args, ICommandResponse* response);
+    bool handleGPIOControl(CommandArgs& args, ICommandResponse* response);
+    bool handleKeysStatus(ICommandResponse* response);
+    bool handleKeysConfig(CommandArgs& args, ICommandResponse* response);
+    bool handleKeysMode(CommandArgs& args, ICommandResponse* response);
+    bool handlePeripheralStatus(ICommandResponse* response);
+    bool handlePeripheralStats(ICommandResponse* response);
 
     // Peripheral settings commands
-    void handlePeripheralSave(ICommandResponse* response);
-    void handlePeripheralLoad(ICommandResponse* response);
-    void handlePeripheralReset(ICommandResponse* response);
+    bool handlePeripheralSave(ICommandResponse* response);
+    bool handlePeripheralLoad(ICommandResponse* response);
+    bool handlePeripheralReset(ICommandResponse* response);
+
+    // Trace ring commands
+    bool handleTrace(CommandArgs& args, ICommandResponse* response);
 };
 
 // CDC 回應實作
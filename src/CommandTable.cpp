@@ -0,0 +1,107 @@
+#include "CommandTable.h"
+
+namespace {
+
+inline bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+inline const char* skipSpaces(const char* p) {
+    while (isSpace(*p)) {
+        p++;
+    }
+    return p;
+}
+
+// Case-insensitive compare of one table word against [word, word + len)
+bool wordEquals(const char*& name, const char* word, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        if (*name == '\0' || (uint8_t)*name != CommandHash::fold(word[i])) {
+            return false;
+        }
+        name++;
+    }
+    return true;
+}
+
+bool pathEquals(CommandId id, const char* word1, size_t len1, const char* word2, size_t len2) {
+    if (id == CMD_NONE) {
+        return false;
+    }
+    const char* name = CommandHash::SPECS[id].name;
+    if (!wordEquals(name, word1, len1)) {
+        return false;
+    }
+    if (word2 != nullptr) {
+        if (*name++ != ' ' || !wordEquals(name, word2, len2)) {
+            return false;
+        }
+    }
+    return *name == '\0';
+}
+
+uint8_t countArgs(const char* p) {
+    uint8_t count = 0;
+    while (*p != '\0') {
+        if (count < CMD_ARGS_ANY - 1) {
+            count++;
+        }
+        while (*p != '\0' && !isSpace(*p)) {
+            p++;
+        }
+        p = skipSpaces(p);
+    }
+    return count;
+}
+
+}  // namespace
+
+const CommandSpec& getCommandSpec(CommandId id) {
+    return CommandHash::SPECS[id];
+}
+
+bool findCommand(const char* line, CommandMatch& match) {
+    match = CommandMatch();
+    if (line == nullptr) {
+        return false;
+    }
+
+    // First word
+    const char* word1 = skipSpaces(line);
+    const char* p = word1;
+    uint32_t h = CommandHash::FNV_OFFSET;
+    while (*p != '\0' && !isSpace(*p)) {
+        h = CommandHash::step(h, *p++);
+    }
+    size_t len1 = p - word1;
+    if (len1 == 0) {
+        return false;
+    }
+    CommandId one = (CommandId)CommandHash::Slots::owners[CommandHash::slot(h)];
+    const char* after1 = skipSpaces(p);
+
+    // Second word continues the same hash through the separating space
+    if (*after1 != '\0') {
+        const char* word2 = after1;
+        p = word2;
+        h = CommandHash::step(h, ' ');
+        while (*p != '\0' && !isSpace(*p)) {
+            h = CommandHash::step(h, *p++);
+        }
+        CommandId two = (CommandId)CommandHash::Slots::owners[CommandHash::slot(h)];
+        if (pathEquals(two, word1, len1, word2, p - word2)) {
+            match.id = two;
+            match.args = skipSpaces(p);
+            match.argCount = countArgs(match.args);
+            return true;
+        }
+    }
+
+    if (pathEquals(one, word1, len1, nullptr, 0)) {
+        match.id = one;
+        match.args = after1;
+        match.argCount = countArgs(after1);
+        return true;
+    }
+    return false;
+}
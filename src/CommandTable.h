@@ -0,0 +1,257 @@
+#ifndef COMMAND_TABLE_H
+#define COMMAND_TABLE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Command source masks (bit n = CommandSource n)
+ *
+ * Kept free of Arduino headers so the table also builds on the host
+ * (scripts/bench_dispatch.cpp). CommandParser.cpp checks the bit order.
+ */
+#define CMD_SRC_CDC        0x01
+#define CMD_SRC_HID        0x02
+#define CMD_SRC_BLE        0x04
+#define CMD_SRC_WEBSOCKET  0x08
+#define CMD_SRC_ALL        0x0F
+#define CMD_SRC_LOCAL      (CMD_SRC_CDC | CMD_SRC_HID | CMD_SRC_BLE)  // Not over the web session
+
+#define CMD_ARGS_ANY       0xFF   // No upper bound on argument tokens
+
+/**
+ * @brief Command flags (CommandExecutor scheduling)
+ */
+#define CMD_FLAG_URGENT    0x01   // Urgent lane: runs before queued normal commands
+#define CMD_FLAG_INLINE    0x02   // No shared state: runs in the caller's task
+#define CMD_FLAG_TEXT      0x04   // Free-text arguments: ';' does not end the command
+#define CMD_FLAG_SINGLE    0x08   // Not allowed inside a batch or transaction
+
+/**
+ * @brief Command registry
+ *
+ * One row per keyword path: X(id, name, minArgs, maxArgs, sources, flags, handler)
+ *
+ * - name: one or two upper-case words separated by a single space. The
+ *   longest matching path wins, so "RPM STATS 10" resolves to RPM STATS
+ *   and "RPM" alone to RPM.
+ * - minArgs/maxArgs: whitespace-separated tokens after the keyword path,
+ *   checked before the handler runs (handlers still validate values)
+ * - flags: CMD_FLAG_* bits, see CommandExecutor and CommandParser batches
+ * - handler: CommandParser member taking (CommandArgs& args, response),
+ *   (response) for commands without arguments, or (CommandSource, response)
+ *   for commands that act on per-source state. Arguments keep their
+ *   original case; handlers compare keywords with CommandArgs::is().
+ */
+#define COMMAND_TABLE(X) \
+    X(IDN,               "*IDN?",             0, 0,            CMD_SRC_ALL,   0,               handleIDN) \
+    X(HELP,              "HELP",              0, 0,            CMD_SRC_ALL,   0,               handleHelp) \
+    X(HELP_SHORT,        "?",                 0, 0,            CMD_SRC_ALL,   0,               handleHelp) \
+    X(INFO,              "INFO",              0, 0,            CMD_SRC_ALL,   0,               handleInfo) \
+    X(STATUS,            "STATUS",            0, 0,            CMD_SRC_ALL,   0,               handleStatus) \
+    X(SEND,              "SEND",              0, 0,            CMD_SRC_ALL,   0,               handleSend) \
+    X(READ,              "READ",              0, 0,            CMD_SRC_ALL,   0,               handleRead) \
+    X(CLEAR,             "CLEAR",             0, 0,            CMD_SRC_ALL,   0,               handleClear) \
+    X(DELAY,             "DELAY",             1, 1,            CMD_SRC_LOCAL, CMD_FLAG_INLINE, handleDelay) \
+    X(CLEAR_ERROR,       "CLEAR ERROR",       0, 0,            CMD_SRC_ALL,   0,               handleClearError) \
+    X(CLEAR_ERROR_ALT,   "CLEAR_ERROR",       0, 0,            CMD_SRC_ALL,   0,               handleClearError) \
+    X(RESUME,            "RESUME",            0, 0,            CMD_SRC_ALL,   0,               handleClearError) \
+    X(RPM,               "RPM",               0, 0,            CMD_SRC_ALL,   0,               handleRPM) \
+    X(RPM_STATS,         "RPM STATS",         0, 1,            CMD_SRC_ALL,   0,               handleRPMStats) \
+    X(RPM_SET,           "RPM SET",           0, 1,            CMD_SRC_ALL,   0,               handleRPMSet) \
+    X(RPM_EVENT,         "RPM EVENT",         0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRPMEvent) \
+    X(RPM_COUNTER,       "RPM COUNTER",       0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRPMCounter) \
+    X(RPM_LATENCY,       "RPM LATENCY",       0, 1,            CMD_SRC_ALL,   0,               handleRPMLatency) \
+    X(RPM_DUTY,          "RPM DUTY",          0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRPMDuty) \
+    X(RPM_FILTER,        "RPM FILTER",        0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRPMFilter) \
+    X(RPM_TIMEOUT,       "RPM TIMEOUT",       0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRPMTimeout) \
+    X(RPM_AVG,           "RPM AVG",           0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRPMAveraging) \
+    X(PID,               "PID",               0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handlePID) \
+    X(FAN,               "FAN",               0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleFan) \
+    X(STEP,              "STEP",              0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleStep) \
+    X(SWEEP,             "SWEEP",             0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleSweep) \
+    X(FAULT,             "FAULT",             0, CMD_ARGS_ANY, CMD_SRC_ALL,   CMD_FLAG_URGENT, handleFault) \
+    X(RAMP,              "RAMP",              1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRamp) \
+    X(FOLLOW,            "FOLLOW",            0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleFollow) \
+    X(DITHER,            "DITHER",            0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleDither) \
+    X(MOTOR_STOP,        "MOTOR STOP",        0, 0,            CMD_SRC_ALL,   CMD_FLAG_URGENT, handleMotorStop) \
+    X(MOTOR_STATUS,      "MOTOR STATUS",      0, 0,            CMD_SRC_ALL,   0,               handleMotorStatus) \
+    X(SAVE,              "SAVE",              0, 0,            CMD_SRC_ALL,   0,               handleSaveSettings) \
+    X(LOAD,              "LOAD",              0, 0,            CMD_SRC_ALL,   0,               handleLoadSettings) \
+    X(RESET,             "RESET",             0, 0,            CMD_SRC_ALL,   0,               handleResetSettings) \
+    X(SET,               "SET",               2, 3,            CMD_SRC_ALL,   0,               handleSet) \
+    X(WIFI,              "WIFI",              2, CMD_ARGS_ANY, CMD_SRC_LOCAL, CMD_FLAG_TEXT,   handleWiFiConnect) \
+    X(IP,                "IP",                0, 0,            CMD_SRC_ALL,   0,               handleIPAddress) \
+    X(WIFI_STATUS,       "WIFI STATUS",       0, 0,            CMD_SRC_ALL,   0,               handleWiFiStatus) \
+    X(WIFI_START,        "WIFI START",        0, 0,            CMD_SRC_ALL,   0,               handleWiFiStart) \
+    X(WIFI_STOP,         "WIFI STOP",         0, 0,            CMD_SRC_LOCAL, 0,               handleWiFiStop) \
+    X(WIFI_SCAN,         "WIFI SCAN",         0, 0,            CMD_SRC_ALL,   0,               handleWiFiScan) \
+    X(WEB_STATUS,        "WEB STATUS",        0, 0,            CMD_SRC_ALL,   0,               handleWebStatus) \
+    X(UART1_MODE,        "UART1 MODE",        1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleUART1Mode) \
+    X(UART1_CONFIG,      "UART1 CONFIG",      1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleUART1Config) \
+    X(UART1_PWM,         "UART1 PWM",         1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleUART1PWM) \
+    X(UART1_COMPL,       "UART1 COMPL",       0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleUART1Complementary) \
+    X(UART1_STATUS,      "UART1 STATUS",      0, 0,            CMD_SRC_ALL,   0,               handleUART1Status) \
+    X(UART1_SWITCH,      "UART1 SWITCH",      1, 1,            CMD_SRC_ALL,   0,               handleUART1Switch) \
+    X(UART1_WRITE,       "UART1 WRITE",       1, CMD_ARGS_ANY, CMD_SRC_ALL,   CMD_FLAG_TEXT,   handleUART1Write) \
+    X(UART2_CONFIG,      "UART2 CONFIG",      1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleUART2Config) \
+    X(UART2_STATUS,      "UART2 STATUS",      0, 0,            CMD_SRC_ALL,   0,               handleUART2Status) \
+    X(UART2_WRITE,       "UART2 WRITE",       1, CMD_ARGS_ANY, CMD_SRC_ALL,   CMD_FLAG_TEXT,   handleUART2Write) \
+    X(BUZZER_BEEP,       "BUZZER BEEP",       1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleBuzzerBeep) \
+    X(BUZZER,            "BUZZER",            1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleBuzzerControl) \
+    X(LED_PWM_FADE,      "LED_PWM FADE",      1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleLEDFade) \
+    X(LEDPWM_FADE,       "LEDPWM FADE",       1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleLEDFade) \
+    X(LED_PWM,           "LED_PWM",           1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleLEDPWM) \
+    X(LEDPWM,            "LEDPWM",            1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleLEDPWM) \
+    X(RELAY,             "RELAY",             1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleRelayControl) \
+    X(GPIO,              "GPIO",              1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleGPIOControl) \
+    X(KEYS,              "KEYS",              0, 0,            CMD_SRC_ALL,   0,               handleKeysStatus) \
+    X(KEYS_STATUS,       "KEYS STATUS",       0, 0,            CMD_SRC_ALL,   0,               handleKeysStatus) \
+    X(KEYS_CONFIG,       "KEYS CONFIG",       1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleKeysConfig) \
+    X(KEYS_MODE,         "KEYS MODE",         1, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleKeysMode) \
+    X(PERIPHERALS,       "PERIPHERALS",       0, 0,            CMD_SRC_ALL,   0,               handlePeripheralStatus) \
+    X(PERIPHERAL_STATUS, "PERIPHERAL STATUS", 0, 0,            CMD_SRC_ALL,   0,               handlePeripheralStatus) \
+    X(PERIPHERAL_STATS,  "PERIPHERAL STATS",  0, 0,            CMD_SRC_ALL,   0,               handlePeripheralStats) \
+    X(PERIPHERAL_SAVE,   "PERIPHERAL SAVE",   0, 0,            CMD_SRC_ALL,   0,               handlePeripheralSave) \
+    X(PERIPHERAL_LOAD,   "PERIPHERAL LOAD",   0, 0,            CMD_SRC_ALL,   0,               handlePeripheralLoad) \
+    X(PERIPHERAL_RESET,  "PERIPHERAL RESET",  0, 0,            CMD_SRC_ALL,   0,               handlePeripheralReset) \
+    X(TRACE,             "TRACE",             0, CMD_ARGS_ANY, CMD_SRC_ALL,   0,               handleTrace) \
+    X(EXECUTOR,          "EXECUTOR",          0, 1,            CMD_SRC_ALL,   0,               handleExecutor) \
+    X(BEGIN,             "BEGIN",             0, 0,            CMD_SRC_LOCAL, CMD_FLAG_SINGLE, handleBegin) \
+    X(COMMIT,            "COMMIT",            0, 0,            CMD_SRC_LOCAL, CMD_FLAG_SINGLE, handleCommit) \
+    X(ABORT,             "ABORT",             0, 0,            CMD_SRC_LOCAL, CMD_FLAG_SINGLE, handleAbort)
+
+enum CommandId : uint8_t {
+#define COMMAND_ID(id, name, minArgs, maxArgs, sources, flags, handler) CMD_##id,
+    COMMAND_TABLE(COMMAND_ID)
+#undef COMMAND_ID
+    CMD_COUNT,
+    CMD_NONE = 0xFF
+};
+
+/**
+ * @brief Descriptor fields that do not depend on CommandParser
+ */
+struct CommandSpec {
+    const char* name;
+    uint8_t minArgs;
+    uint8_t maxArgs;
+    uint8_t sources;
+    uint8_t flags;
+};
+
+/**
+ * @brief Result of a table lookup
+ */
+struct CommandMatch {
+    CommandId id = CMD_NONE;
+    const char* args = nullptr;   ///< First character after the keyword path (spaces skipped)
+    uint8_t argCount = 0;         ///< Argument tokens, saturating at CMD_ARGS_ANY - 1
+};
+
+// ============================================================================
+// Compile-time perfect hash
+// ============================================================================
+
+/**
+ * @brief Keyword path hash (FNV-1a over upper-cased characters)
+ *
+ * The slot is the top SLOT_BITS of hash × SEED. SEED is chosen so every
+ * name in COMMAND_TABLE lands in its own slot; the static_assert below
+ * fails the build when a new command collides. Pick a new seed with
+ * `bench_dispatch --seed` (scripts/bench_dispatch.cpp, built with
+ * -DCOMMAND_TABLE_SEED_SEARCH).
+ */
+namespace CommandHash {
+
+static constexpr uint32_t FNV_OFFSET = 2166136261u;
+static constexpr uint32_t FNV_PRIME = 16777619u;
+static constexpr uint32_t SEED = 0xF78C3EA7u;
+static constexpr uint32_t SLOT_BITS = 9;
+static constexpr uint32_t SLOT_COUNT = 1u << SLOT_BITS;
+
+constexpr uint8_t fold(char c) {
+    return (c >= 'a' && c <= 'z') ? (uint8_t)(c - 'a' + 'A') : (uint8_t)c;
+}
+
+constexpr uint32_t step(uint32_t h, char c) {
+    return (h ^ fold(c)) * FNV_PRIME;
+}
+
+constexpr uint32_t of(const char* s, uint32_t h = FNV_OFFSET) {
+    return *s ? of(s + 1, step(h, *s)) : h;
+}
+
+constexpr uint32_t slot(uint32_t h, uint32_t seed = SEED) {
+    return (h * seed) >> (32 - SLOT_BITS);
+}
+
+static constexpr CommandSpec SPECS[CMD_COUNT] = {
+#define COMMAND_SPEC(id, name, minArgs, maxArgs, sources, flags, handler) \
+    { name, minArgs, maxArgs, sources, flags },
+    COMMAND_TABLE(COMMAND_SPEC)
+#undef COMMAND_SPEC
+};
+
+static constexpr uint32_t HASHES[CMD_COUNT] = {
+#define COMMAND_HASH(id, name, minArgs, maxArgs, sources, flags, handler) of(name),
+    COMMAND_TABLE(COMMAND_HASH)
+#undef COMMAND_HASH
+};
+
+constexpr bool collidesWith(uint32_t i, uint32_t j) {
+    return j < CMD_COUNT && (slot(HASHES[i]) == slot(HASHES[j]) || collidesWith(i, j + 1));
+}
+
+constexpr bool anyCollision(uint32_t i = 0) {
+    return i < CMD_COUNT && (collidesWith(i, i + 1) || anyCollision(i + 1));
+}
+
+static_assert(CMD_COUNT < CMD_NONE, "Command ids must fit below CMD_NONE");
+#ifndef COMMAND_TABLE_SEED_SEARCH
+static_assert(!anyCollision(), "COMMAND_TABLE hash collision: pick a new CommandHash::SEED");
+#endif
+
+constexpr uint8_t owner(uint32_t s, uint32_t i = 0) {
+    return (i == CMD_COUNT) ? (uint8_t)CMD_NONE
+         : (slot(HASHES[i]) == s) ? (uint8_t)i
+         : owner(s, i + 1);
+}
+
+template <uint32_t... I> struct Seq {};
+template <uint32_t N, uint32_t... I> struct MakeSeq : MakeSeq<N - 1, N - 1, I...> {};
+template <uint32_t... I> struct MakeSeq<0, I...> { typedef Seq<I...> type; };
+
+template <typename S> struct SlotTable;
+template <uint32_t... I> struct SlotTable<Seq<I...> > {
+    static constexpr uint8_t owners[sizeof...(I)] = { owner(I)... };
+};
+template <uint32_t... I> constexpr uint8_t SlotTable<Seq<I...> >::owners[sizeof...(I)];
+
+/**
+ * @brief Slot → CommandId (CMD_NONE if empty), built by the compiler into flash
+ */
+typedef SlotTable<MakeSeq<SLOT_COUNT>::type> Slots;
+
+}  // namespace CommandHash
+
+/**
+ * @brief Resolve the keyword path of a command line
+ *
+ * Hashes at most two words (case-insensitive) and probes the slot table
+ * once per word, so the cost depends on the keyword length only, not on
+ * the number of commands. The candidate name is compared once to reject
+ * inputs that are not in the table.
+ *
+ * @param line Command line, leading spaces allowed
+ * @param match Resolved command, argument start and argument count
+ * @return false if no keyword path matches
+ */
+bool findCommand(const char* line, CommandMatch& match);
+
+/**
+ * @brief Descriptor fields of a command (name, argument schema, sources, flags)
+ */
+const CommandSpec& getCommandSpec(CommandId id);
+
+#endif // COMMAND_TABLE_H
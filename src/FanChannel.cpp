@@ -0,0 +1,313 @@
+#include "FanChannel.h"
+#include "MCPWMCapture.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+
+FanChannel::~FanChannel() {
+    end();
+}
+
+bool FanChannel::begin(const FanChannelHW& config, uint8_t channelIndex) {
+    if (active) {
+        return true;
+    }
+
+    hw = config;
+    index = channelIndex;
+    pwmDev = (hw.pwmUnit == MCPWM_UNIT_0) ? &MCPWM0 : &MCPWM1;
+
+    if (!initPWM()) {
+        return false;
+    }
+    if (!initCapture()) {
+        mcpwm_stop(hw.pwmUnit, hw.pwmTimer);
+        gpio_reset_pin((gpio_num_t)hw.pwmPin);
+        return false;
+    }
+
+    active = true;
+    Serial.printf("[FAN%u] ✅ PWM GPIO %d (MCPWM%d timer %d), tach GPIO %d (MCPWM%d CAP%d)\n",
+                 index, hw.pwmPin, hw.pwmUnit, hw.pwmTimer,
+                 hw.tachPin, hw.capUnit, hw.capChannel);
+    return true;
+}
+
+void FanChannel::end() {
+    if (!active) {
+        return;
+    }
+
+    MCPWMCapture::disable(hw.capUnit, hw.capChannel);
+    mcpwm_stop(hw.pwmUnit, hw.pwmTimer);
+    gpio_reset_pin((gpio_num_t)hw.pwmPin);
+    gpio_reset_pin((gpio_num_t)hw.tachPin);
+
+    active = false;
+    enabled = false;
+    publish(0);
+}
+
+// ============================================================================
+// PWM Output
+// ============================================================================
+
+bool FanChannel::initPWM() {
+    mcpwm_gpio_init(hw.pwmUnit, hw.pwmSignal, hw.pwmPin);
+
+    mcpwm_config_t pwm_config;
+    pwm_config.frequency = frequency;
+    pwm_config.cmpr_a = duty;
+    pwm_config.cmpr_b = 0;
+    pwm_config.duty_mode = MCPWM_DUTY_MODE_0;  // Active high
+    pwm_config.counter_mode = MCPWM_UP_COUNTER;
+
+    esp_err_t err = mcpwm_init(hw.pwmUnit, hw.pwmTimer, &pwm_config);
+    if (err != ESP_OK) {
+        Serial.printf("[FAN%u] ❌ MCPWM PWM init failed: %s\n", index, esp_err_to_name(err));
+        return false;
+    }
+    mcpwm_set_duty_type(hw.pwmUnit, hw.pwmTimer, MCPWM_OPR_A, MCPWM_DUTY_MODE_0);
+
+    // Replace the driver's prescaler/period with the minimum-error pair
+    PWMSolution sol;
+    if (PWMSolver::solve(PWMSolver::TIMER_CLK_HZ, frequency, 0, sol)) {
+        writePeriod(sol.prescaler, sol.period);
+        mcpwm_set_duty(hw.pwmUnit, hw.pwmTimer, MCPWM_OPR_A, duty);
+    }
+
+    enabled = true;
+    return true;
+}
+
+void FanChannel::writePeriod(uint32_t newPrescaler, uint32_t newPeriod) {
+    // Same cfg0 layout as UART1: prescaler[7:0], period[23:8], update
+    // method in [31:24] kept. Only the period is shadowed (loads at TEZ);
+    // the prescaler switches at once, so when it changes the rest of the
+    // running period is counted at the new rate (one transitional period)
+    taskENTER_CRITICAL(&mux);
+    uint32_t cfg0 = pwmDev->timer[hw.pwmTimer].timer_cfg0.val;
+    pwmDev->timer[hw.pwmTimer].timer_cfg0.val = (cfg0 & 0xFF000000)
+                                              | (((newPeriod - 1) & 0xFFFF) << 8)
+                                              | ((newPrescaler - 1) & 0xFF);
+    prescaler = newPrescaler;
+    period = newPeriod;
+    taskEXIT_CRITICAL(&mux);
+}
+
+bool FanChannel::setFrequency(uint32_t newFrequency) {
+    if (!active) {
+        return false;
+    }
+    if (newFrequency < 10 || newFrequency > maxFrequency) {
+        Serial.printf("[FAN%u] Invalid PWM frequency: %u (valid: 10-%u Hz)\n",
+                     index, newFrequency, maxFrequency);
+        return false;
+    }
+
+    PWMSolution sol;
+    if (!PWMSolver::solve(PWMSolver::TIMER_CLK_HZ, newFrequency, prescaler, sol)) {
+        return false;
+    }
+
+    writePeriod(sol.prescaler, sol.period);
+    frequency = newFrequency;
+
+    // Compare value is derived from the period: re-apply the duty
+    mcpwm_set_duty(hw.pwmUnit, hw.pwmTimer, MCPWM_OPR_A, duty);
+    return true;
+}
+
+bool FanChannel::setDuty(float newDuty) {
+    if (!active || newDuty < 0.0f || newDuty > 100.0f) {
+        return false;
+    }
+
+    if (newDuty < dutyMin) newDuty = dutyMin;
+    if (newDuty > dutyMax) newDuty = dutyMax;
+
+    if (mcpwm_set_duty(hw.pwmUnit, hw.pwmTimer, MCPWM_OPR_A, newDuty) != ESP_OK) {
+        return false;
+    }
+    duty = newDuty;
+    return true;
+}
+
+bool FanChannel::setPWM(uint32_t newFrequency, float newDuty) {
+    if (newDuty < 0.0f || newDuty > 100.0f) {
+        return false;
+    }
+    // Duty first so setFrequency() re-applies the new value with the new period
+    float previousDuty = duty;
+    duty = (newDuty < dutyMin) ? dutyMin : (newDuty > dutyMax) ? dutyMax : newDuty;
+    if (!setFrequency(newFrequency)) {
+        duty = previousDuty;
+        return false;
+    }
+    return true;
+}
+
+void FanChannel::setEnabled(bool enable) {
+    if (!active) {
+        return;
+    }
+    enabled = enable;
+    if (enable) {
+        mcpwm_start(hw.pwmUnit, hw.pwmTimer);
+    } else {
+        mcpwm_stop(hw.pwmUnit, hw.pwmTimer);
+    }
+}
+
+float FanChannel::getActualFrequency() const {
+    uint32_t ticks = prescaler * period;
+    return (ticks > 0) ? (float)PWMSolver::TIMER_CLK_HZ / (float)ticks : 0.0f;
+}
+
+// ============================================================================
+// Limits
+// ============================================================================
+
+bool FanChannel::setPolePairs(uint32_t poles) {
+    if (poles < 1 || poles > 12) {
+        Serial.printf("[FAN%u] Invalid pole pairs: %u (valid: 1-12)\n", index, poles);
+        return false;
+    }
+    polePairs = poles;
+    publish(freqQ10);
+    return true;
+}
+
+bool FanChannel::setMaxFrequency(uint32_t freq) {
+    if (freq < 10 || freq > 500000) {
+        Serial.printf("[FAN%u] Invalid max frequency: %u (valid: 10-500000 Hz)\n", index, freq);
+        return false;
+    }
+    maxFrequency = freq;
+    return true;
+}
+
+bool FanChannel::setDutyLimits(float minDuty, float maxDuty) {
+    if (minDuty < 0.0f || maxDuty > 100.0f || minDuty >= maxDuty) {
+        return false;
+    }
+    dutyMin = minDuty;
+    dutyMax = maxDuty;
+    return true;
+}
+
+// ============================================================================
+// Tach Measurement
+// ============================================================================
+
+bool FanChannel::initCapture() {
+    esp_err_t err = mcpwm_gpio_init(hw.capUnit, hw.capSignal, hw.tachPin);
+    if (err != ESP_OK) {
+        Serial.printf("[FAN%u] ❌ MCPWM capture GPIO init failed: %s\n", index, esp_err_to_name(err));
+        return false;
+    }
+    gpio_set_pull_mode((gpio_num_t)hw.tachPin, GPIO_PULLUP_ONLY);
+
+    captureHasLast = false;
+    captureRing.clear();
+    periodHistory.reset();
+    publish(0);
+
+    mcpwm_capture_config_t cap_conf;
+    cap_conf.cap_edge = MCPWM_POS_EDGE;
+    cap_conf.cap_prescale = 1;
+    cap_conf.capture_cb = captureCallback;
+    cap_conf.user_data = this;
+
+    err = MCPWMCapture::enable(hw.capUnit, hw.capChannel, &cap_conf);
+    if (err != ESP_OK) {
+        Serial.printf("[FAN%u] ❌ MCPWM capture enable failed: %s\n", index, esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool IRAM_ATTR FanChannel::captureCallback(mcpwm_unit_t mcpwm,
+                                            mcpwm_capture_channel_id_t cap_channel,
+                                            const cap_event_data_t* edata,
+                                            void* user_data) {
+    FanChannel* self = static_cast<FanChannel*>(user_data);
+    uint32_t currentCapture = edata->cap_value;
+    int64_t nowUs = esp_timer_get_time();
+
+    // Extend to 64 bits across capture counter wraps, same as UART1
+    uint64_t extended;
+    if (self->captureHasLast) {
+        uint64_t last = self->lastCaptureExt;
+        extended = last + CaptureRing::extendPeriod(last, currentCapture, nowUs - self->lastCaptureUs,
+                                                    CAPTURE_CLK_HZ / 1000000);
+    } else {
+        extended = currentCapture;
+        self->captureHasLast = true;
+    }
+    self->lastCaptureExt = extended;
+
+    // update() reads the edge time on the other core (seqlock: odd while writing)
+    self->captureAnchorSeq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    self->lastCaptureUs = nowUs;
+    self->captureAnchorSeq.fetch_add(1, std::memory_order_release);
+
+    self->captureRing.push(extended);
+    return false;
+}
+
+int64_t FanChannel::readLastCaptureUs() const {
+    // 64-bit ISR-written value: a plain load can tear on this 32-bit core
+    uint32_t seq;
+    int64_t us;
+    do {
+        seq = captureAnchorSeq.load(std::memory_order_acquire);
+        us = lastCaptureUs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != captureAnchorSeq.load(std::memory_order_relaxed));
+    return us;
+}
+
+void FanChannel::update() {
+    if (!active) {
+        return;
+    }
+
+    uint64_t edges[32];
+    uint32_t count;
+    uint32_t drained = 0;
+    bool newPeriods = false;
+    while (drained < DRAIN_MAX && (count = captureRing.pop(edges, 32)) > 0) {
+        drained += count;
+        for (uint32_t i = 0; i < count; i++) {
+            if (periodHistory.addEdge(edges[i])) {
+                newPeriods = true;
+            }
+        }
+    }
+
+    if (newPeriods) {
+        CaptureStats stats;
+        uint64_t windowTicks = 100ULL * (CAPTURE_CLK_HZ / 1000);
+        if (periodHistory.computeStats(16, windowTicks, stats) && stats.spanTicks > 0) {
+            uint64_t q10 = (((uint64_t)CAPTURE_CLK_HZ * stats.count) << 10) / stats.spanTicks;
+            publish(q10 > UINT32_MAX ? UINT32_MAX : (uint32_t)q10);
+
+            // Timeout = 4 expected periods, 20-500 ms
+            uint64_t ms = ((uint64_t)stats.meanTicks * 4 + (CAPTURE_CLK_HZ / 1000) - 1) /
+                          (CAPTURE_CLK_HZ / 1000);
+            timeoutMs = (ms < 20) ? 20 : (ms > 500) ? 500 : (uint32_t)ms;
+        }
+    }
+
+    if (freqQ10 != 0 && (esp_timer_get_time() - readLastCaptureUs()) > (int64_t)timeoutMs * 1000) {
+        publish(0);  // Signal lost
+    }
+}
+
+void FanChannel::publish(uint32_t newFreqQ10) {
+    // RPM Q26.6 = freq Q22.10 × (60 / pole pairs) Q16.16 >> 20
+    uint64_t q6 = ((uint64_t)newFreqQ10 * ((60u << 16) / polePairs)) >> 20;
+    freqQ10 = newFreqQ10;
+    rpmQ6 = (q6 > UINT32_MAX) ? UINT32_MAX : (uint32_t)q6;
+}
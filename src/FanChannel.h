@@ -0,0 +1,202 @@
+#ifndef FAN_CHANNEL_H
+#define FAN_CHANNEL_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "driver/mcpwm.h"
+#include "soc/mcpwm_struct.h"
+#include "CaptureRing.h"
+#include "PWMSolver.h"
+
+/**
+ * @brief Hardware resources of one fan channel (PWM out + tach in)
+ */
+struct FanChannelHW {
+    int pwmPin;                            ///< PWM output GPIO
+    int tachPin;                           ///< Tach input GPIO
+    mcpwm_unit_t pwmUnit;                  ///< MCPWM unit of the PWM timer
+    mcpwm_timer_t pwmTimer;                ///< Timer (operator with the same index)
+    mcpwm_io_signals_t pwmSignal;          ///< MCPWMxA signal of that operator
+    mcpwm_unit_t capUnit;                  ///< MCPWM unit of the capture channel
+    mcpwm_capture_channel_id_t capChannel; ///< MCPWM_SELECT_CAPn
+    mcpwm_io_signals_t capSignal;          ///< MCPWM_CAP_n
+};
+
+/**
+ * @brief One independent fan: MCPWM PWM output and MCPWM capture tach input
+ *
+ * The PWM side follows UART1Mux: prescaler/period from PWMSolver, period
+ * written directly to timer_cfg0 (TEZ shadow update; the prescaler is not
+ * shadowed and switches immediately), duty through
+ * mcpwm_set_duty(). The tach side uses the same capture pipeline
+ * (ISR → CaptureRing → PeriodHistory) and fixed-point tach format as UART1
+ * (freq Q22.10, RPM Q26.6), averaged over up to 16 periods / 100 ms with a
+ * timeout of 4 expected periods (20-500 ms).
+ *
+ * All channels share one static capture callback; the MCPWM driver's unit
+ * ISR dispatches per capture channel and user_data is the channel itself,
+ * so demultiplexing costs no lookup.
+ *
+ * Channel 0 of the fan array is UART1Mux (see FanManager); FanChannel is
+ * used for channels 1 and up.
+ */
+class FanChannel {
+public:
+    FanChannel() = default;
+    ~FanChannel();
+
+    /**
+     * @brief Claim the pins, start PWM output and tach capture
+     * @param hw Hardware resources
+     * @param index Channel number (for log output)
+     * @return true if both PWM and capture were initialized
+     */
+    bool begin(const FanChannelHW& hw, uint8_t index);
+
+    /**
+     * @brief Stop PWM and capture, release the pins
+     */
+    void end();
+
+    bool isActive() const { return active; }
+
+    // ========================================================================
+    // PWM Output
+    // ========================================================================
+
+    /**
+     * @brief Set PWM frequency (minimum-error prescaler/period)
+     * @param frequency 10 Hz - maxFrequency
+     * @return true if successful
+     */
+    bool setFrequency(uint32_t frequency);
+
+    /**
+     * @brief Set PWM duty, clamped to the channel's duty limits
+     * @param duty 0-100 %
+     * @return true if successful
+     */
+    bool setDuty(float duty);
+
+    /**
+     * @brief Set frequency and duty together (period and duty load at TEZ)
+     *
+     * A frequency that needs a different prescaler gives one transitional
+     * period: the prescaler is not shadowed and switches immediately.
+     */
+    bool setPWM(uint32_t frequency, float duty);
+
+    /**
+     * @brief Start/stop the PWM timer
+     */
+    void setEnabled(bool enable);
+
+    bool isEnabled() const { return enabled; }
+    uint32_t getFrequency() const { return frequency; }
+    float getDuty() const { return duty; }
+    float getActualFrequency() const;
+
+    // ========================================================================
+    // Limits
+    // ========================================================================
+
+    /**
+     * @brief Set motor pole pairs (1-12)
+     */
+    bool setPolePairs(uint32_t poles);
+
+    /**
+     * @brief Set maximum PWM frequency (10-500000 Hz)
+     */
+    bool setMaxFrequency(uint32_t freq);
+
+    /**
+     * @brief Set allowed duty range (0 ≤ min < max ≤ 100)
+     */
+    bool setDutyLimits(float minDuty, float maxDuty);
+
+    uint32_t getPolePairs() const { return polePairs; }
+    uint32_t getMaxFrequency() const { return maxFrequency; }
+    float getDutyMin() const { return dutyMin; }
+    float getDutyMax() const { return dutyMax; }
+
+    // ========================================================================
+    // Tach Measurement
+    // ========================================================================
+
+    /**
+     * @brief Drain queued edges and publish a new reading (call periodically)
+     */
+    void update();
+
+    /**
+     * @brief Get measured tach frequency in Hz (0 without signal)
+     */
+    float getRPMFrequency() const { return (float)freqQ10 * (1.0f / 1024.0f); }
+
+    /**
+     * @brief Get motor RPM (frequency × 60 / pole pairs)
+     */
+    float getCalculatedRPM() const { return (float)rpmQ6 * (1.0f / 64.0f); }
+
+    /**
+     * @brief Check if tach edges arrived within the timeout
+     */
+    bool hasSignal() const { return freqQ10 > 0; }
+
+    /**
+     * @brief Edges dropped because the capture ring was full
+     */
+    uint32_t getOverflowCount() const { return captureRing.getOverflowCount(); }
+
+    static constexpr uint32_t CAPTURE_CLK_HZ = 80000000;  // APB clock
+
+    // Edges handled per update() call; an edge storm cannot keep the caller
+    // in the drain loop (the rest waits in the ring or is counted as overflow)
+    static constexpr uint32_t DRAIN_MAX = CaptureRing::CAPACITY;
+
+private:
+    FanChannelHW hw = {};
+    uint8_t index = 0;
+    bool active = false;
+    mcpwm_dev_t* pwmDev = nullptr;      // MCPWM0 or MCPWM1
+
+    // PWM state
+    bool enabled = false;
+    uint32_t frequency = 25000;         // Default 25 kHz (4-wire fan standard)
+    float duty = 50.0;
+    uint32_t prescaler = 1;
+    uint32_t period = 3200;
+    uint32_t polePairs = 2;
+    uint32_t maxFrequency = 100000;
+    float dutyMin = 0.0;
+    float dutyMax = 100.0;
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Capture pipeline (ISR producer, update() consumer)
+    CaptureRing captureRing;
+    PeriodHistory periodHistory;
+    volatile uint64_t lastCaptureExt = 0;   // ISR only
+    volatile bool captureHasLast = false;   // ISR only
+    volatile int64_t lastCaptureUs = 0;     // esp_timer time of the newest edge
+    std::atomic<uint32_t> captureAnchorSeq{0};  // Seqlock over lastCaptureUs
+    uint32_t timeoutMs = 500;
+
+    // Published reading (single-word stores, read without locking)
+    volatile uint32_t freqQ10 = 0;
+    volatile uint32_t rpmQ6 = 0;
+
+    bool initPWM();
+    bool initCapture();
+    void writePeriod(uint32_t newPrescaler, uint32_t newPeriod);
+    void publish(uint32_t newFreqQ10);
+    int64_t readLastCaptureUs() const;
+
+    // Shared by every channel; user_data is the FanChannel
+    static bool IRAM_ATTR captureCallback(mcpwm_unit_t mcpwm,
+                                          mcpwm_capture_channel_id_t cap_channel,
+                                          const cap_event_data_t* edata,
+                                          void* user_data);
+};
+
+#endif // FAN_CHANNEL_H
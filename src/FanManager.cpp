@@ -0,0 +1,292 @@
+#include "FanManager.h"
+#include <Preferences.h>
+
+// NVS namespace for fan channel settings
+static const char* NVS_NAMESPACE = "fan_channels";
+
+// Hardware of channels 1..5 (channel 0 is UART1: MCPWM1 timer 0, MCPWM0 CAP1)
+static const FanChannelHW FAN_HW[FAN_CHANNEL_MAX - 1] = {
+    {PIN_FAN1_PWM, PIN_FAN1_TACH, MCPWM_UNIT_1, MCPWM_TIMER_1, MCPWM1A,
+     MCPWM_UNIT_1, MCPWM_SELECT_CAP0, MCPWM_CAP_0},
+    {PIN_FAN2_PWM, PIN_FAN2_TACH, MCPWM_UNIT_1, MCPWM_TIMER_2, MCPWM2A,
+     MCPWM_UNIT_1, MCPWM_SELECT_CAP1, MCPWM_CAP_1},
+    {PIN_FAN3_PWM, PIN_FAN3_TACH, MCPWM_UNIT_0, MCPWM_TIMER_0, MCPWM0A,
+     MCPWM_UNIT_1, MCPWM_SELECT_CAP2, MCPWM_CAP_2},
+    {PIN_FAN4_PWM, PIN_FAN4_TACH, MCPWM_UNIT_0, MCPWM_TIMER_1, MCPWM1A,
+     MCPWM_UNIT_0, MCPWM_SELECT_CAP0, MCPWM_CAP_0},
+    {PIN_FAN5_PWM, PIN_FAN5_TACH, MCPWM_UNIT_0, MCPWM_TIMER_2, MCPWM2A,
+     MCPWM_UNIT_0, MCPWM_SELECT_CAP2, MCPWM_CAP_2},
+};
+
+FanManager::FanManager(UART1Mux& uart1) : uart1(uart1) {
+    channelLock = xSemaphoreCreateMutexStatic(&channelLockBuf);
+}
+
+bool FanManager::begin() {
+    loadSettings();
+    return channelCount == 1 || channels[0].isActive();
+}
+
+void FanManager::update() {
+    // Channels being reconfigured are picked up on the next call
+    if (xSemaphoreTake(channelLock, 0) != pdTRUE) {
+        return;
+    }
+    for (uint32_t i = 1; i < channelCount; i++) {
+        channels[i - 1].update();
+    }
+    xSemaphoreGive(channelLock);
+}
+
+bool FanManager::setChannelCount(uint32_t count) {
+    if (count < 1 || count > FAN_CHANNEL_MAX) {
+        Serial.printf("[FAN] Invalid channel count: %u (valid: 1-%u)\n", count, FAN_CHANNEL_MAX);
+        return false;
+    }
+
+    xSemaphoreTake(channelLock, portMAX_DELAY);
+
+    // Release channels beyond the new count first, then claim new ones
+    for (uint32_t i = count; i < FAN_CHANNEL_MAX; i++) {
+        channels[i - 1].end();
+    }
+
+    bool ok = true;
+    for (uint32_t i = 1; i < count; i++) {
+        if (!channels[i - 1].begin(FAN_HW[i - 1], i)) {
+            ok = false;
+        }
+    }
+
+    channelCount = count;
+    xSemaphoreGive(channelLock);
+    return ok;
+}
+
+bool FanManager::isActiveChannel(uint8_t channel) const {
+    return channel >= 1 && channel < channelCount && channels[channel - 1].isActive();
+}
+
+FanChannel* FanManager::getChannel(uint8_t channel) {
+    return isActiveChannel(channel) ? &channels[channel - 1] : nullptr;
+}
+
+float FanManager::clampUART1Duty(float duty) const {
+    if (duty < uart1DutyMin) return uart1DutyMin;
+    if (duty > uart1DutyMax) return uart1DutyMax;
+    return duty;
+}
+
+// ============================================================================
+// Per-Channel Control
+// ============================================================================
+
+bool FanManager::setPWM(uint8_t channel, uint32_t frequency, float duty) {
+    if (channel == 0) {
+        return duty >= 0.0f && duty <= 100.0f &&
+               uart1.setPWMFrequencyAndDuty(frequency, clampUART1Duty(duty));
+    }
+    FanChannel* fan = getChannel(channel);
+    return fan != nullptr && fan->setPWM(frequency, duty);
+}
+
+bool FanManager::setFrequency(uint8_t channel, uint32_t frequency) {
+    if (channel == 0) {
+        return uart1.setPWMFrequency(frequency);
+    }
+    FanChannel* fan = getChannel(channel);
+    return fan != nullptr && fan->setFrequency(frequency);
+}
+
+bool FanManager::setDuty(uint8_t channel, float duty) {
+    if (channel == 0) {
+        return duty >= 0.0f && duty <= 100.0f && uart1.setPWMDuty(clampUART1Duty(duty));
+    }
+    FanChannel* fan = getChannel(channel);
+    return fan != nullptr && fan->setDuty(duty);
+}
+
+bool FanManager::setEnabled(uint8_t channel, bool enable) {
+    if (channel == 0) {
+        if (uart1.getMode() != UART1Mux::MODE_PWM_RPM) {
+            return false;
+        }
+        uart1.setPWMEnabled(enable);
+        return true;
+    }
+    FanChannel* fan = getChannel(channel);
+    if (fan == nullptr) {
+        return false;
+    }
+    fan->setEnabled(enable);
+    return true;
+}
+
+bool FanManager::setPolePairs(uint8_t channel, uint32_t poles) {
+    if (channel == 0) {
+        return uart1.setPolePairs(poles);
+    }
+    FanChannel* fan = getChannel(channel);
+    return fan != nullptr && fan->setPolePairs(poles);
+}
+
+bool FanManager::setMaxFrequency(uint8_t channel, uint32_t freq) {
+    if (channel == 0) {
+        return uart1.setMaxFrequency(freq);
+    }
+    FanChannel* fan = getChannel(channel);
+    return fan != nullptr && fan->setMaxFrequency(freq);
+}
+
+bool FanManager::setDutyLimits(uint8_t channel, float minDuty, float maxDuty) {
+    if (channel == 0) {
+        if (minDuty < 0.0f || maxDuty > 100.0f || minDuty >= maxDuty) {
+            return false;
+        }
+        uart1DutyMin = minDuty;
+        uart1DutyMax = maxDuty;
+        return true;
+    }
+    FanChannel* fan = getChannel(channel);
+    return fan != nullptr && fan->setDutyLimits(minDuty, maxDuty);
+}
+
+FanStatus FanManager::getStatus(uint8_t channel) {
+    FanStatus status;
+    status.channel = channel;
+
+    if (channel == 0) {
+        status.active = (uart1.getMode() == UART1Mux::MODE_PWM_RPM);
+        status.enabled = status.active && uart1.isPWMEnabled();
+        status.frequency = uart1.getPWMFrequency();
+        status.actualHz = uart1.getPWMActualFrequency();
+        status.duty = uart1.getPWMDuty();
+        status.rpm = uart1.getCalculatedRPM();
+        status.inputHz = uart1.getRPMFrequency();
+        status.signal = uart1.hasRPMSignal();
+        status.polePairs = uart1.getPolePairs();
+        status.maxFrequency = uart1.getMaxFrequency();
+        status.dutyMin = uart1DutyMin;
+        status.dutyMax = uart1DutyMax;
+        return status;
+    }
+
+    if (channel >= FAN_CHANNEL_MAX) {
+        return status;
+    }
+
+    // Configuration is reported even while the channel is not claimed
+    FanChannel& fan = channels[channel - 1];
+    status.active = isActiveChannel(channel);
+    status.enabled = status.active && fan.isEnabled();
+    status.frequency = fan.getFrequency();
+    status.actualHz = status.active ? fan.getActualFrequency() : 0.0f;
+    status.duty = fan.getDuty();
+    status.rpm = fan.getCalculatedRPM();
+    status.inputHz = fan.getRPMFrequency();
+    status.signal = fan.hasSignal();
+    status.polePairs = fan.getPolePairs();
+    status.maxFrequency = fan.getMaxFrequency();
+    status.dutyMin = fan.getDutyMin();
+    status.dutyMax = fan.getDutyMax();
+    return status;
+}
+
+// ============================================================================
+// Settings Persistence
+// ============================================================================
+
+bool FanManager::saveSettings() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("[FAN] Failed to open NVS for saving");
+        return false;
+    }
+
+    prefs.putUInt("count", channelCount);
+    prefs.putFloat("f0DMin", uart1DutyMin);
+    prefs.putFloat("f0DMax", uart1DutyMax);
+
+    char key[16];
+    for (uint32_t i = 1; i < FAN_CHANNEL_MAX; i++) {
+        const FanChannel& fan = channels[i - 1];
+        snprintf(key, sizeof(key), "f%uFreq", i);
+        prefs.putUInt(key, fan.getFrequency());
+        snprintf(key, sizeof(key), "f%uDuty", i);
+        prefs.putFloat(key, fan.getDuty());
+        snprintf(key, sizeof(key), "f%uPoles", i);
+        prefs.putUInt(key, fan.getPolePairs());
+        snprintf(key, sizeof(key), "f%uMaxF", i);
+        prefs.putUInt(key, fan.getMaxFrequency());
+        snprintf(key, sizeof(key), "f%uDMin", i);
+        prefs.putFloat(key, fan.getDutyMin());
+        snprintf(key, sizeof(key), "f%uDMax", i);
+        prefs.putFloat(key, fan.getDutyMax());
+        snprintf(key, sizeof(key), "f%uEn", i);
+        prefs.putBool(key, fan.isEnabled());
+    }
+
+    prefs.end();
+    Serial.println("[FAN] Settings saved to NVS");
+    return true;
+}
+
+bool FanManager::loadSettings() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {  // Read-only
+        Serial.println("[FAN] No saved settings found, using defaults");
+        return false;
+    }
+
+    if (!setDutyLimits(0, prefs.getFloat("f0DMin", 0.0f), prefs.getFloat("f0DMax", 100.0f))) {
+        setDutyLimits(0, 0.0f, 100.0f);
+    }
+
+    // Limits first: they validate the PWM settings applied after begin()
+    char key[16];
+    for (uint32_t i = 1; i < FAN_CHANNEL_MAX; i++) {
+        FanChannel& fan = channels[i - 1];
+        snprintf(key, sizeof(key), "f%uPoles", i);
+        if (!fan.setPolePairs(prefs.getUInt(key, 2))) fan.setPolePairs(2);
+        snprintf(key, sizeof(key), "f%uMaxF", i);
+        if (!fan.setMaxFrequency(prefs.getUInt(key, 100000))) fan.setMaxFrequency(100000);
+        char keyMax[16];
+        snprintf(key, sizeof(key), "f%uDMin", i);
+        snprintf(keyMax, sizeof(keyMax), "f%uDMax", i);
+        if (!fan.setDutyLimits(prefs.getFloat(key, 0.0f), prefs.getFloat(keyMax, 100.0f))) {
+            fan.setDutyLimits(0.0f, 100.0f);
+        }
+    }
+
+    uint32_t count = prefs.getUInt("count", 1);
+    if (count < 1 || count > FAN_CHANNEL_MAX) {
+        count = 1;
+    }
+    setChannelCount(count);
+
+    for (uint32_t i = 1; i < channelCount; i++) {
+        FanChannel& fan = channels[i - 1];
+        char keyDuty[16];
+        snprintf(key, sizeof(key), "f%uFreq", i);
+        snprintf(keyDuty, sizeof(keyDuty), "f%uDuty", i);
+        fan.setPWM(prefs.getUInt(key, 25000), prefs.getFloat(keyDuty, 50.0f));
+        snprintf(key, sizeof(key), "f%uEn", i);
+        fan.setEnabled(prefs.getBool(key, true));
+    }
+
+    prefs.end();
+    Serial.printf("[FAN] Settings loaded from NVS (%u channels)\n", channelCount);
+    return true;
+}
+
+void FanManager::resetToDefaults() {
+    setChannelCount(1);
+    setDutyLimits(0, 0.0f, 100.0f);
+    for (uint32_t i = 1; i < FAN_CHANNEL_MAX; i++) {
+        FanChannel& fan = channels[i - 1];
+        fan.setPolePairs(2);
+        fan.setMaxFrequency(100000);
+        fan.setDutyLimits(0.0f, 100.0f);
+    }
+    Serial.println("[FAN] Settings reset to defaults (UART1 only)");
+}
@@ -0,0 +1,110 @@
+#ifndef FAN_MANAGER_H
+#define FAN_MANAGER_H
+
+#include <Arduino.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "UART1Mux.h"
+#include "FanChannel.h"
+#include "PeripheralPins.h"
+
+/**
+ * @brief Snapshot of one fan channel
+ */
+struct FanStatus {
+    uint8_t channel = 0;
+    bool active = false;          ///< Channel hardware claimed (UART1: in PWM/RPM mode)
+    bool enabled = false;         ///< PWM output running
+    uint32_t frequency = 0;       ///< Requested PWM frequency (Hz)
+    float actualHz = 0.0f;        ///< Frequency produced by prescaler × period
+    float duty = 0.0f;            ///< PWM duty (%)
+    float rpm = 0.0f;             ///< Measured RPM
+    float inputHz = 0.0f;         ///< Measured tach frequency
+    bool signal = false;          ///< Tach edges within the timeout
+    uint32_t polePairs = 0;
+    uint32_t maxFrequency = 0;
+    float dutyMin = 0.0f;
+    float dutyMax = 100.0f;
+};
+
+/**
+ * @brief N independent fans behind one channel index
+ *
+ * Channel 0 is the existing UART1Mux PWM/RPM pair (GPIO 17/18), so every
+ * UART1 feature (ramps, PID, protection, hybrid measurement) keeps working
+ * on it unchanged. Channels 1..FAN_CHANNEL_MAX-1 are FanChannel instances
+ * on the remaining MCPWM timers and capture channels; only the first
+ * getChannelCount() channels claim their pins.
+ *
+ * Channel 0 settings persist with UART1 ("uart1_settings"); this class
+ * stores the channel count, the channel 0 duty limits and everything of
+ * channels 1 and up in its own NVS namespace.
+ */
+class FanManager {
+public:
+    explicit FanManager(UART1Mux& uart1);
+
+    /**
+     * @brief Load settings and start the configured channels
+     */
+    bool begin();
+
+    /**
+     * @brief Publish new tach readings (call periodically)
+     *
+     * UART1 (channel 0) is updated by its own measurement path. Skipped
+     * while setChannelCount() is starting or stopping channels.
+     */
+    void update();
+
+    /**
+     * @brief Set the number of fan channels in use
+     * @param count 1-FAN_CHANNEL_MAX (1 = UART1 only)
+     * @return false if a channel failed to start
+     */
+    bool setChannelCount(uint32_t count);
+
+    uint32_t getChannelCount() const { return channelCount; }
+
+    // Per-channel control (channel 0 delegates to UART1Mux)
+    bool setPWM(uint8_t channel, uint32_t frequency, float duty);
+    bool setFrequency(uint8_t channel, uint32_t frequency);
+    bool setDuty(uint8_t channel, float duty);
+    bool setEnabled(uint8_t channel, bool enable);
+    bool setPolePairs(uint8_t channel, uint32_t poles);
+    bool setMaxFrequency(uint8_t channel, uint32_t freq);
+    bool setDutyLimits(uint8_t channel, float minDuty, float maxDuty);
+
+    /**
+     * @brief Get a snapshot of one channel
+     */
+    FanStatus getStatus(uint8_t channel);
+
+    /**
+     * @brief Direct access to an additional channel (1..FAN_CHANNEL_MAX-1)
+     */
+    FanChannel* getChannel(uint8_t channel);
+
+    // Settings persistence
+    bool saveSettings();
+    bool loadSettings();
+    void resetToDefaults();
+
+private:
+    UART1Mux& uart1;
+    FanChannel channels[FAN_CHANNEL_MAX - 1];  // Channels 1..N-1
+    uint32_t channelCount = 1;
+    float uart1DutyMin = 0.0;                  // Channel 0 limits (FAN commands only)
+    float uart1DutyMax = 100.0;
+
+    // Held by setChannelCount() while channels begin()/end(), and by update()
+    // while it drains them: begin() clears the capture ring and period
+    // history, which only the consumer may touch
+    StaticSemaphore_t channelLockBuf;
+    SemaphoreHandle_t channelLock = nullptr;
+
+    bool isActiveChannel(uint8_t channel) const;
+    float clampUART1Duty(float duty) const;
+};
+
+#endif // FAN_MANAGER_H
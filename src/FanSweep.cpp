@@ -0,0 +1,403 @@
+#include "FanSweep.h"
+#include "esp_heap_caps.h"
+#include <math.h>
+
+const char* FanSweep::CSV_HEADER =
+    "index,frequency_hz,duty_pct,rpm_mean,rpm_stddev,samples,settle_ms,settled,signal";
+
+FanSweep::FanSweep(UART1Mux& uart1, FanManager& fans, RPMController& pid)
+    : uart1(uart1), fans(fans), pid(pid) {
+}
+
+FanSweep::~FanSweep() {
+    if (timer) {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+        timer = nullptr;
+    }
+    if (table) {
+        heap_caps_free(table);
+        table = nullptr;
+    }
+}
+
+bool FanSweep::begin() {
+    if (timer) {
+        return true;
+    }
+
+    // The table is the binary blob: header followed by the point records
+    size_t size = sizeof(SweepBlobHeader) + sizeof(SweepPoint) * MAX_POINTS;
+    table = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (!table) {
+        table = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_8BIT);
+    }
+    if (!table) {
+        Serial.printf("[SWEEP] Table allocation failed (%u bytes)\n", (unsigned)size);
+        return false;
+    }
+    header = reinterpret_cast<SweepBlobHeader*>(table);
+    points = reinterpret_cast<SweepPoint*>(table + sizeof(SweepBlobHeader));
+    memset(header, 0, sizeof(SweepBlobHeader));
+    header->magic = SWEEP_BLOB_MAGIC;
+    header->version = SWEEP_BLOB_VERSION;
+    header->pointSize = sizeof(SweepPoint);
+
+    esp_timer_create_args_t args = {};
+    args.callback = timerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "fan_sweep";
+
+    esp_err_t err = esp_timer_create(&args, &timer);
+    if (err != ESP_OK) {
+        Serial.printf("[SWEEP] Timer create failed: %s\n", esp_err_to_name(err));
+        timer = nullptr;
+        return false;
+    }
+    return true;
+}
+
+const char* FanSweep::getStateName(State state) {
+    switch (state) {
+        case SWEEP_IDLE:    return "IDLE";
+        case SWEEP_RUNNING: return "RUNNING";
+        case SWEEP_DONE:    return "DONE";
+        case SWEEP_ABORTED: return "ABORTED";
+        default:            return "UNKNOWN";
+    }
+}
+
+// ============================================================================
+// Sweep Control
+// ============================================================================
+
+bool FanSweep::start(const Config& newConfig) {
+    if (!timer || state == SWEEP_RUNNING) {
+        return false;
+    }
+
+    Config cfg = newConfig;
+    if (cfg.channel >= fans.getChannelCount() ||
+        cfg.dutyStart < 0.0f || cfg.dutyStart > 100.0f ||
+        cfg.dutyEnd < 0.0f || cfg.dutyEnd > 100.0f || cfg.dutyStep <= 0.0f ||
+        cfg.sampleMs < 10 || cfg.sampleMs > 1000 ||
+        cfg.settleWindow < 3 || cfg.settleWindow > MAX_WINDOW ||
+        cfg.tolerance <= 0.0f || cfg.tolerance >= 1.0f ||
+        cfg.measureSamples < 1 || cfg.measureSamples > 255 ||
+        cfg.settleTimeoutMs < cfg.settleMinMs) {
+        Serial.println("[SWEEP] Invalid sweep configuration");
+        return false;
+    }
+
+    FanStatus fan = fans.getStatus(cfg.channel);
+    if (!fan.active) {
+        Serial.printf("[SWEEP] Fan channel %u is not running\n", cfg.channel);
+        return false;
+    }
+    if (cfg.channel == 0) {
+        // The sweep owns the UART1 duty: no PID, no ramp, no latched fault
+        if (pid.isEnabled() || uart1.isFaultLatched()) {
+            Serial.println("[SWEEP] Channel 0 busy (PID enabled or fault latched)");
+            return false;
+        }
+        uart1.stopRamp();
+    }
+
+    if (cfg.freqStart == 0) {
+        cfg.freqStart = fan.frequency;
+        cfg.freqEnd = fan.frequency;
+        cfg.freqStep = 0;
+    }
+    if (cfg.freqEnd == 0) {
+        cfg.freqEnd = cfg.freqStart;
+    }
+
+    uint32_t freqSpan = (cfg.freqEnd > cfg.freqStart) ? cfg.freqEnd - cfg.freqStart
+                                                       : cfg.freqStart - cfg.freqEnd;
+    uint32_t nFreq = (cfg.freqStep == 0) ? 1 : freqSpan / cfg.freqStep + 1;
+    uint32_t nDuty = (uint32_t)(fabsf(cfg.dutyEnd - cfg.dutyStart) / cfg.dutyStep + 0.001f) + 1;
+    if ((uint64_t)nFreq * nDuty > MAX_POINTS) {
+        Serial.printf("[SWEEP] Grid too large: %u × %u points (max %u)\n", nFreq, nDuty, MAX_POINTS);
+        return false;
+    }
+
+    taskENTER_CRITICAL(&lock);
+    config = cfg;
+    freqCount = nFreq;
+    dutyCount = nDuty;
+    totalPoints = nFreq * nDuty;
+    header->channel = cfg.channel;
+    header->pointCount = 0;
+    header->sampleMs = (uint16_t)cfg.sampleMs;
+    header->tolerance = (uint16_t)lroundf(cfg.tolerance * 1000.0f);
+    taskEXIT_CRITICAL(&lock);
+
+    restoreFrequency = fan.frequency;
+    restoreDuty = fan.duty;
+    pointIndex = 0;
+
+    if (!applyPoint(0)) {
+        return false;
+    }
+
+    state = SWEEP_RUNNING;
+    esp_err_t err = esp_timer_start_periodic(timer, (uint64_t)cfg.sampleMs * 1000ULL);
+    if (err != ESP_OK) {
+        Serial.printf("[SWEEP] Timer start failed: %s\n", esp_err_to_name(err));
+        state = SWEEP_ABORTED;
+        return false;
+    }
+
+    Serial.printf("[SWEEP] Started on fan %u: %u points (%u frequencies × %u duties)\n",
+                 cfg.channel, totalPoints, freqCount, dutyCount);
+    return true;
+}
+
+bool FanSweep::setSettleCriteria(uint32_t sampleMs, uint32_t settleWindow, float tolerance,
+                                 uint32_t settleMinMs, uint32_t settleTimeoutMs,
+                                 uint32_t measureSamples) {
+    if (state == SWEEP_RUNNING ||
+        sampleMs < 10 || sampleMs > 1000 ||
+        settleWindow < 3 || settleWindow > MAX_WINDOW ||
+        tolerance <= 0.0f || tolerance >= 1.0f ||
+        measureSamples < 1 || measureSamples > 255 ||
+        settleTimeoutMs < settleMinMs) {
+        return false;
+    }
+    config.sampleMs = sampleMs;
+    config.settleWindow = settleWindow;
+    config.tolerance = tolerance;
+    config.settleMinMs = settleMinMs;
+    config.settleTimeoutMs = settleTimeoutMs;
+    config.measureSamples = measureSamples;
+    return true;
+}
+
+void FanSweep::abort() {
+    if (state == SWEEP_RUNNING) {
+        finish(SWEEP_ABORTED, true);
+    }
+}
+
+void FanSweep::finish(State endState, bool restore) {
+    esp_timer_stop(timer);
+    state = endState;
+    if (restore) {
+        fans.setPWM(config.channel, restoreFrequency, restoreDuty);
+    }
+    Serial.printf("[SWEEP] %s: %u of %u points\n", getStateName(endState),
+                 getPointCount(), totalPoints);
+}
+
+float FanSweep::dutyAt(uint32_t index) const {
+    float offset = (float)(index % dutyCount) * config.dutyStep;
+    float duty = (config.dutyEnd >= config.dutyStart) ? config.dutyStart + offset
+                                                      : config.dutyStart - offset;
+    return (duty < 0.0f) ? 0.0f : (duty > 100.0f) ? 100.0f : duty;
+}
+
+uint32_t FanSweep::frequencyAt(uint32_t index) const {
+    uint32_t offset = (index / dutyCount) * config.freqStep;
+    return (config.freqEnd >= config.freqStart) ? config.freqStart + offset
+                                                : config.freqStart - offset;
+}
+
+bool FanSweep::applyPoint(uint32_t index) {
+    if (!fans.setPWM(config.channel, frequencyAt(index), dutyAt(index))) {
+        Serial.printf("[SWEEP] Fan %u rejected %u Hz / %.2f%%\n", config.channel,
+                     frequencyAt(index), dutyAt(index));
+        return false;
+    }
+    measuring = false;
+    settled = false;
+    windowCount = 0;
+    windowHead = 0;
+    stepStartUs = esp_timer_get_time();
+    return true;
+}
+
+// ============================================================================
+// Settle Detection and Measurement
+// ============================================================================
+
+void FanSweep::timerCallback(void* arg) {
+    static_cast<FanSweep*>(arg)->sweepStep();
+}
+
+void FanSweep::sweepStep() {
+    if (state != SWEEP_RUNNING) {
+        return;
+    }
+
+    // Someone else took over the channel: stop without touching the output
+    if (config.channel == 0 &&
+        (pid.isEnabled() || uart1.isFaultLatched() || uart1.getMode() != UART1Mux::MODE_PWM_RPM)) {
+        finish(SWEEP_ABORTED, false);
+        return;
+    }
+
+    FanStatus fan = fans.getStatus(config.channel);
+    if (!fan.active) {
+        finish(SWEEP_ABORTED, false);
+        return;
+    }
+
+    uint32_t elapsedMs = (uint32_t)((esp_timer_get_time() - stepStartUs) / 1000);
+
+    if (!measuring) {
+        window[windowHead] = fan.rpm;
+        windowHead = (windowHead + 1) % config.settleWindow;
+        if (windowCount < config.settleWindow) {
+            windowCount++;
+        }
+        if (windowCount < config.settleWindow || elapsedMs < config.settleMinMs) {
+            return;
+        }
+
+        float sum = 0.0f;
+        for (uint32_t i = 0; i < windowCount; i++) {
+            sum += window[i];
+        }
+        float windowMean = sum / (float)windowCount;
+        float var = 0.0f;
+        for (uint32_t i = 0; i < windowCount; i++) {
+            float d = window[i] - windowMean;
+            var += d * d;
+        }
+        float stdDev = sqrtf(var / (float)(windowCount - 1));
+
+        // A stopped fan (all zero) is settled as well
+        settled = (stdDev <= config.tolerance * windowMean);
+        if (!settled && elapsedMs < config.settleTimeoutMs) {
+            return;
+        }
+
+        measuring = true;
+        settleMs = elapsedMs;
+        sampleCount = 0;
+        mean = 0.0;
+        m2 = 0.0;
+        signalLost = false;
+        return;
+    }
+
+    // Welford running mean/variance
+    sampleCount++;
+    double delta = fan.rpm - mean;
+    mean += delta / sampleCount;
+    m2 += delta * (fan.rpm - mean);
+    if (!fan.signal) {
+        signalLost = true;
+    }
+    if (sampleCount < config.measureSamples) {
+        return;
+    }
+
+    SweepPoint& point = points[pointIndex];
+    point.frequency = frequencyAt(pointIndex);
+    point.dutyX100 = (uint16_t)lroundf(dutyAt(pointIndex) * 100.0f);
+    point.flags = (settled ? SWEEP_POINT_SETTLED : 0) | (signalLost ? SWEEP_POINT_NO_SIGNAL : 0);
+    point.samples = (uint8_t)sampleCount;
+    point.rpmMean = (float)mean;
+    point.rpmStdDev = (sampleCount > 1) ? (float)sqrt(m2 / (sampleCount - 1)) : 0.0f;
+    point.settleMs = settleMs;
+
+    taskENTER_CRITICAL(&lock);
+    header->pointCount = (uint16_t)(pointIndex + 1);
+    taskEXIT_CRITICAL(&lock);
+
+    pointIndex++;
+    if (pointIndex >= totalPoints) {
+        finish(SWEEP_DONE, true);
+    } else if (!applyPoint(pointIndex)) {
+        finish(SWEEP_ABORTED, true);
+    }
+}
+
+// ============================================================================
+// Results
+// ============================================================================
+
+bool FanSweep::getPoint(uint32_t index, SweepPoint& point) const {
+    if (index >= getPointCount()) {
+        return false;
+    }
+    point = points[index];
+    return true;
+}
+
+const uint8_t* FanSweep::getBlob(size_t& size) const {
+    if (!table) {
+        size = 0;
+        return nullptr;
+    }
+    size = sizeof(SweepBlobHeader) + sizeof(SweepPoint) * getPointCount();
+    return table;
+}
+
+size_t FanSweep::formatCSV(uint32_t index, char* buf, size_t len) const {
+    SweepPoint point;
+    if (!getPoint(index, point)) {
+        return 0;
+    }
+    int n = snprintf(buf, len, "%u,%u,%.2f,%.1f,%.2f,%u,%u,%u,%u",
+                     index, point.frequency, point.dutyX100 / 100.0f,
+                     point.rpmMean, point.rpmStdDev, point.samples, point.settleMs,
+                     (point.flags & SWEEP_POINT_SETTLED) ? 1 : 0,
+                     (point.flags & SWEEP_POINT_NO_SIGNAL) ? 0 : 1);
+    return (n < 0) ? 0 : ((size_t)n >= len ? len - 1 : (size_t)n);
+}
+
+uint32_t FanSweep::applyToFeedForward(uint32_t frequency) {
+    uint32_t count = getPointCount();
+    if (count == 0 || state == SWEEP_RUNNING) {
+        return 0;
+    }
+    if (frequency == 0) {
+        frequency = points[0].frequency;
+    }
+
+    // Walk the curve in increasing duty, keeping points where RPM rises.
+    // First pass counts them, second pass picks an even subset.
+    bool descending = config.dutyEnd < config.dutyStart;
+    RPMController::FFPoint ff[RPMController::FF_TABLE_SIZE];
+    uint32_t usableCount = 0;
+    uint32_t ffCount = 0;
+
+    for (int pass = 0; pass < 2; pass++) {
+        uint32_t usable = 0;
+        float lastRpm = 0.0f;
+        for (uint32_t n = 0; n < count && ffCount < RPMController::FF_TABLE_SIZE; n++) {
+            const SweepPoint& p = points[descending ? count - 1 - n : n];
+            if (p.frequency != frequency || !(p.flags & SWEEP_POINT_SETTLED) ||
+                (p.flags & SWEEP_POINT_NO_SIGNAL) || p.rpmMean <= lastRpm) {
+                continue;
+            }
+            lastRpm = p.rpmMean;
+            if (pass == 1) {
+                // k-th table entry takes usable point round(k × (N-1) / (M-1)), both ends kept
+                uint32_t tableSize = (usableCount < RPMController::FF_TABLE_SIZE)
+                                         ? usableCount : RPMController::FF_TABLE_SIZE;
+                uint32_t pick = (tableSize == 1) ? 0
+                    : (ffCount * (usableCount - 1) + (tableSize - 1) / 2) / (tableSize - 1);
+                if (usable == pick) {
+                    ff[ffCount].rpm = p.rpmMean;
+                    ff[ffCount].duty = p.dutyX100 / 100.0f;
+                    ffCount++;
+                }
+            }
+            usable++;
+        }
+        usableCount = usable;
+        if (usableCount == 0) {
+            return 0;
+        }
+    }
+
+    if (!pid.setFeedForwardTable(ff, ffCount)) {
+        return 0;
+    }
+    Serial.printf("[SWEEP] Feed-forward table loaded: %u points at %u Hz\n", ffCount, frequency);
+    return ffCount;
+}
@@ -0,0 +1,200 @@
+#ifndef FAN_SWEEP_H
+#define FAN_SWEEP_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "UART1Mux.h"
+#include "FanManager.h"
+#include "RPMController.h"
+
+/**
+ * @brief One measured point of a characterization sweep (20 bytes, little-endian)
+ */
+struct __attribute__((packed)) SweepPoint {
+    uint32_t frequency;   ///< PWM frequency (Hz)
+    uint16_t dutyX100;    ///< PWM duty × 100 (0.01 % units)
+    uint8_t flags;        ///< SWEEP_POINT_* bits
+    uint8_t samples;      ///< Readings averaged for mean/stddev
+    float rpmMean;        ///< Mean RPM after settling
+    float rpmStdDev;      ///< Standard deviation of the readings (RPM)
+    uint32_t settleMs;    ///< Time from the PWM change until settled
+};
+
+#define SWEEP_POINT_SETTLED    0x01  // Variance criterion met (else settle timeout)
+#define SWEEP_POINT_NO_SIGNAL  0x02  // No tach signal while measuring
+
+/**
+ * @brief Header of the binary sweep blob (16 bytes, little-endian)
+ *
+ * The blob is the header followed by pointCount SweepPoint records. It is
+ * kept in memory in exactly this layout, so it can be sent without copying.
+ */
+struct __attribute__((packed)) SweepBlobHeader {
+    uint32_t magic;        ///< SWEEP_BLOB_MAGIC
+    uint8_t version;       ///< SWEEP_BLOB_VERSION
+    uint8_t channel;       ///< Fan channel swept
+    uint16_t pointCount;   ///< Number of SweepPoint records that follow
+    uint16_t pointSize;    ///< sizeof(SweepPoint)
+    uint16_t sampleMs;     ///< Reading interval
+    uint16_t tolerance;    ///< Settle tolerance (stddev/mean) × 1000
+    uint16_t reserved;
+};
+
+#define SWEEP_BLOB_MAGIC    0x50575346  // "FSWP"
+#define SWEEP_BLOB_VERSION  1
+
+/**
+ * @brief On-device fan characterization sweep (duty/frequency → RPM curve)
+ *
+ * Steps a fan channel over a duty × frequency grid. After each step the
+ * tach reading is sampled every sampleMs; the point counts as settled once
+ * the last settleWindow readings have a standard deviation within
+ * tolerance × mean (and the minimum dwell has passed), or the settle
+ * timeout expires. Then measureSamples readings are averaged into the
+ * point's mean/stddev (Welford).
+ *
+ * The table lives in PSRAM when available (internal RAM otherwise) in the
+ * binary blob layout (SweepBlobHeader + SweepPoint[]). The curve of one
+ * frequency can be loaded into the RPMController feed-forward table.
+ *
+ * Runs from an esp_timer (ESP_TIMER_TASK) like the PID loop; the sweep
+ * aborts if the PID takes over channel 0 or a speed fault latches.
+ */
+class FanSweep {
+public:
+    static constexpr uint32_t MAX_POINTS = 1024;
+    static constexpr uint32_t MAX_WINDOW = 32;     // Settle window readings
+
+    /**
+     * @brief Sweep grid and settle criteria
+     */
+    struct Config {
+        uint8_t channel = 0;
+        float dutyStart = 10.0f;           ///< % (may be above dutyEnd to sweep down)
+        float dutyEnd = 100.0f;
+        float dutyStep = 10.0f;            ///< > 0
+        uint32_t freqStart = 0;            ///< 0 = keep the channel's current frequency
+        uint32_t freqEnd = 0;
+        uint32_t freqStep = 0;             ///< 0 = single frequency
+        uint32_t sampleMs = 50;            ///< Reading interval (10-1000 ms)
+        uint32_t settleWindow = 8;         ///< Readings in the variance window (3-MAX_WINDOW)
+        float tolerance = 0.01f;           ///< Settled when stddev <= tolerance × mean
+        uint32_t settleMinMs = 300;        ///< Minimum dwell after each step
+        uint32_t settleTimeoutMs = 10000;  ///< Give up settling after this
+        uint32_t measureSamples = 20;      ///< Readings per point (1-255)
+    };
+
+    enum State {
+        SWEEP_IDLE,
+        SWEEP_RUNNING,
+        SWEEP_DONE,
+        SWEEP_ABORTED
+    };
+
+    FanSweep(UART1Mux& uart1, FanManager& fans, RPMController& pid);
+    ~FanSweep();
+
+    /**
+     * @brief Allocate the table and create the sweep timer
+     */
+    bool begin();
+
+    /**
+     * @brief Validate the grid and start sweeping (previous results are discarded)
+     * @return false if invalid, too many points, or the channel is busy
+     */
+    bool start(const Config& config);
+
+    /**
+     * @brief Stop a running sweep; points measured so far are kept
+     */
+    void abort();
+
+    /**
+     * @brief Set the settle/measure criteria used by later sweeps
+     * @return false if out of range or a sweep is running
+     */
+    bool setSettleCriteria(uint32_t sampleMs, uint32_t settleWindow, float tolerance,
+                           uint32_t settleMinMs, uint32_t settleTimeoutMs, uint32_t measureSamples);
+
+    State getState() const { return state; }
+    static const char* getStateName(State state);
+    const Config& getConfig() const { return config; }
+
+    uint32_t getPointCount() const { return header ? header->pointCount : 0; }
+    uint32_t getTotalPoints() const { return totalPoints; }
+
+    /**
+     * @brief Get a completed point
+     * @return false if index >= getPointCount()
+     */
+    bool getPoint(uint32_t index, SweepPoint& point) const;
+
+    /**
+     * @brief Binary blob (header + points) of the current results
+     * @param size Set to the blob size in bytes
+     * @return Pointer into the table, nullptr before begin()
+     */
+    const uint8_t* getBlob(size_t& size) const;
+
+    /**
+     * @brief Format one point as a CSV line (no newline)
+     * @return Characters written
+     */
+    size_t formatCSV(uint32_t index, char* buf, size_t len) const;
+
+    static const char* CSV_HEADER;
+
+    /**
+     * @brief Load the curve of one frequency into the PID feed-forward table
+     *
+     * Uses settled points with a tach signal whose RPM increases with duty,
+     * thinned evenly to RPMController::FF_TABLE_SIZE points.
+     *
+     * @param frequency PWM frequency of the curve (0 = first frequency swept)
+     * @return Number of points loaded (0 = nothing usable, table unchanged)
+     */
+    uint32_t applyToFeedForward(uint32_t frequency = 0);
+
+private:
+    UART1Mux& uart1;
+    FanManager& fans;
+    RPMController& pid;
+    esp_timer_handle_t timer = nullptr;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    uint8_t* table = nullptr;           // SweepBlobHeader + SweepPoint[MAX_POINTS]
+    SweepBlobHeader* header = nullptr;
+    SweepPoint* points = nullptr;
+
+    Config config;
+    volatile State state = SWEEP_IDLE;
+    uint32_t totalPoints = 0;
+    uint32_t dutyCount = 0;
+    uint32_t freqCount = 0;
+
+    // Current point
+    uint32_t pointIndex = 0;
+    bool measuring = false;
+    int64_t stepStartUs = 0;
+    uint32_t settleMs = 0;
+    bool settled = false;
+    uint32_t restoreFrequency = 0;      // PWM before the sweep
+    float restoreDuty = 0.0f;
+    float window[MAX_WINDOW];
+    uint32_t windowCount = 0;
+    uint32_t windowHead = 0;
+    uint32_t sampleCount = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+    bool signalLost = false;
+
+    static void timerCallback(void* arg);
+    void sweepStep();
+    bool applyPoint(uint32_t index);
+    void finish(State endState, bool restore);
+    float dutyAt(uint32_t index) const;
+    uint32_t frequencyAt(uint32_t index) const;
+};
+
+#endif // FAN_SWEEP_H
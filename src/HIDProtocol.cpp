@@ -101,3 +101,34 @@ uint8_t HIDProtocol::encodeResponse(uint8_t* out, const uint8_t* payload, uint8_
 
     return 64;  // 固定回傳 64 bytes
 }
+
+bool HIDProtocol::isBinaryRequest(const uint8_t* data) {
+    // [0xA0][opcode][seq_lo][seq_hi][length][payload...]
+    return data[0] == TYPE_DATA && data[4] <= HIDBinary::MAX_REQUEST_PAYLOAD;
+}
+
+uint8_t HIDProtocol::encodeBinaryResponse(uint8_t* out, uint8_t opcode, uint16_t seq, uint8_t status,
+                                          const void* payload, uint8_t payload_len) {
+    if (payload == nullptr) {
+        payload_len = 0;
+    }
+    if (payload_len > HIDBinary::MAX_RESPONSE_PAYLOAD) {
+        payload_len = HIDBinary::MAX_RESPONSE_PAYLOAD;
+    }
+
+    // 6-byte header（序號 little-endian）
+    out[0] = TYPE_RESPONSE;
+    out[1] = opcode;
+    out[2] = (uint8_t)(seq & 0xFF);
+    out[3] = (uint8_t)(seq >> 8);
+    out[4] = status;
+    out[5] = payload_len;
+
+    if (payload_len > 0) {
+        memcpy(out + HIDBinary::RESPONSE_HEADER_SIZE, payload, payload_len);
+    }
+    memset(out + HIDBinary::RESPONSE_HEADER_SIZE + payload_len, 0,
+           64 - HIDBinary::RESPONSE_HEADER_SIZE - payload_len);
+
+    return 64;
+}
@@ -3,6 +3,115 @@
 
 #include <Arduino.h>
 
+/**
+ * HID 二進位協定（0xA0 請求 / 0xA2 回應）
+ *
+ * 與文字命令並存的快速路徑：固定格式的 little-endian 結構，不經過字串
+ * 格式化與解析。每個請求帶 16-bit 序號，回應原樣帶回並附狀態碼。
+ *
+ * 請求：[0xA0][opcode][seq_lo][seq_hi][length][payload (0-59 bytes)]
+ * 回應：[0xA2][opcode][seq_lo][seq_hi][status][length][payload (0-58 bytes)]
+ *
+ * 詳見 PROTOCOL.md「二進位命令封包」。
+ */
+namespace HIDBinary {
+
+enum Opcode : uint8_t {
+    OP_SET_PWM = 0x10,            ///< SetPWMRequest → PWMReply
+    OP_READ_MEASUREMENTS = 0x20,  ///< (無 payload) → Measurements
+    OP_READ_STATUS = 0x21,        ///< (無 payload) → StatusReply
+    OP_BATCH_GET = 0x30           ///< 欄位 ID 清單 → [id][len][value] TLV
+};
+
+enum Status : uint8_t {
+    STATUS_OK = 0x00,
+    STATUS_BAD_OPCODE = 0x01,     ///< 未知 opcode
+    STATUS_BAD_LENGTH = 0x02,     ///< payload 長度與結構不符
+    STATUS_OUT_OF_RANGE = 0x03,   ///< 數值超出範圍
+    STATUS_WRONG_MODE = 0x04,     ///< UART1 不在 PWM/RPM 模式
+    STATUS_BUSY = 0x05,           ///< 命令佇列已滿，請重送
+    STATUS_TRUNCATED = 0x06,      ///< BATCH_GET 回應放不下全部欄位（已回傳前面的欄位）
+    STATUS_FAULT = 0x07           ///< 速度保護已鎖定，輸出維持安全位準（先 FAULT CLEAR）
+};
+
+/**
+ * @brief BATCH_GET 欄位 ID（值為 little-endian，長度固定）
+ */
+enum Field : uint8_t {
+    FIELD_PWM_FREQUENCY = 0x01,   ///< u32 Hz（設定值）
+    FIELD_PWM_DUTY = 0x02,        ///< u16 0.01 %
+    FIELD_PWM_ENABLED = 0x03,     ///< u8
+    FIELD_RPM_Q6 = 0x04,          ///< u32 RPM × 64
+    FIELD_FREQ_Q10 = 0x05,        ///< u32 輸入頻率 Hz × 1024
+    FIELD_PERIOD_Q4 = 0x06,       ///< u32 輸入週期 (12.5 ns ticks) × 16
+    FIELD_TACH_SEQ = 0x07,        ///< u32 轉速讀數序號
+    FIELD_POLE_PAIRS = 0x08,      ///< u8
+    FIELD_UART1_MODE = 0x09,      ///< u8 UART1Mux::Mode
+    FIELD_FAULT_CODE = 0x0A,      ///< u8 UART1Mux::FaultCode（未鎖定為 0）
+    FIELD_UPTIME_MS = 0x0B,       ///< u32
+    FIELD_FREE_HEAP = 0x0C        ///< u32 bytes
+};
+
+static const uint8_t REQUEST_HEADER_SIZE = 5;
+static const uint8_t RESPONSE_HEADER_SIZE = 6;
+static const uint8_t MAX_REQUEST_PAYLOAD = 64 - REQUEST_HEADER_SIZE;    // 59
+static const uint8_t MAX_RESPONSE_PAYLOAD = 64 - RESPONSE_HEADER_SIZE;  // 58
+
+// SET_PWM mask 位元
+static const uint8_t SET_FREQUENCY = 0x01;
+static const uint8_t SET_DUTY = 0x02;
+
+struct __attribute__((packed)) SetPWMRequest {
+    uint32_t frequencyHz;   ///< 10-500000（mask 含 SET_FREQUENCY 時）
+    uint16_t dutyCenti;     ///< 0-10000 = 0.00-100.00 %（mask 含 SET_DUTY 時）
+    uint8_t mask;           ///< SET_FREQUENCY | SET_DUTY，兩者同時設定時於同一個 PWM 週期生效
+    uint8_t reserved;
+};
+
+struct __attribute__((packed)) PWMReply {
+    uint32_t frequencyHz;         ///< 設定頻率
+    uint32_t actualFrequencyMHz;  ///< 實際輸出頻率 (mHz)
+    uint16_t dutyCenti;           ///< 0.01 %
+    uint8_t enabled;
+    uint8_t reserved;
+};
+
+struct __attribute__((packed)) Measurements {
+    uint32_t rpmQ6;           ///< RPM × 64
+    uint32_t freqQ10;         ///< 輸入頻率 Hz × 1024
+    uint32_t periodQ4;        ///< 輸入週期 ticks × 16
+    uint32_t tachSeq;         ///< 讀數序號（與前一次比較可知是否為新讀數）
+    uint32_t ageUs;           ///< 最新邊緣到現在的時間
+    uint32_t pwmFrequencyHz;
+    uint16_t pwmDutyCenti;
+    uint8_t hasSignal;
+    uint8_t rpmMethod;        ///< UART1Mux::RPMMethod
+};
+
+struct __attribute__((packed)) StatusReply {
+    uint32_t uptimeMs;
+    uint32_t freeHeap;
+    uint32_t faultTrips;      ///< 開機以來的保護觸發次數
+    uint8_t uart1Mode;        ///< UART1Mux::Mode
+    uint8_t faultCode;        ///< 鎖定中的 UART1Mux::FaultCode（未鎖定為 0）
+    uint8_t flags;            ///< STATUS_FLAG_*
+    uint8_t polePairs;
+};
+
+static const uint8_t STATUS_FLAG_PWM_ENABLED = 0x01;
+static const uint8_t STATUS_FLAG_FAULT_ARMED = 0x02;
+static const uint8_t STATUS_FLAG_FAULT_LATCHED = 0x04;
+static const uint8_t STATUS_FLAG_RAMPING = 0x08;
+static const uint8_t STATUS_FLAG_FOLLOWING = 0x10;
+static const uint8_t STATUS_FLAG_DITHER = 0x20;
+
+static_assert(sizeof(SetPWMRequest) == 8, "SetPWMRequest layout");
+static_assert(sizeof(PWMReply) == 12, "PWMReply layout");
+static_assert(sizeof(Measurements) == 28, "Measurements layout");
+static_assert(sizeof(StatusReply) == 16, "StatusReply layout");
+
+}  // namespace HIDBinary
+
 /**
  * HID 協定處理類別
  *
@@ -11,13 +120,14 @@
  * - Header 長度：3 bytes
  * - Command string 最大長度：61 bytes
  * - 總長度：固定 64 bytes
+ * - 二進位請求/回應：0xA0 / 0xA2（見 HIDBinary）
  */
 class HIDProtocol {
 public:
     // 封包類型定義
     static const uint8_t TYPE_COMMAND = 0xA1;    // 命令封包
-    static const uint8_t TYPE_DATA = 0xA0;       // 原始資料（保留供未來使用）
-    static const uint8_t TYPE_RESPONSE = 0xA2;   // 命令回應（保留供未來使用）
+    static const uint8_t TYPE_DATA = 0xA0;       // 二進位命令請求
+    static const uint8_t TYPE_RESPONSE = 0xA2;   // 二進位命令回應
 
     /**
      * 檢查是否為命令封包（0xA1 header）
@@ -59,6 +169,28 @@ public:
      * @return 實際編碼後的長度（固定 64）
      */
     static uint8_t encodeResponse(uint8_t* out, const uint8_t* payload, uint8_t payload_len);
+
+    /**
+     * 檢查是否為二進位命令請求（0xA0 header，長度欄位合理）
+     *
+     * @param data 64-byte HID 封包
+     * @return true 表示交給 CommandParser::processBinary()
+     */
+    static bool isBinaryRequest(const uint8_t* data);
+
+    /**
+     * 編碼二進位回應封包（6-byte header，補零到 64 bytes）
+     *
+     * @param out 輸出緩衝區，至少 64 bytes
+     * @param opcode 請求的 opcode
+     * @param seq 請求的序號
+     * @param status HIDBinary::Status
+     * @param payload 回應結構（可為 nullptr）
+     * @param payload_len 長度（最多 58 bytes）
+     * @return 實際編碼後的長度（固定 64）
+     */
+    static uint8_t encodeBinaryResponse(uint8_t* out, uint8_t opcode, uint16_t seq, uint8_t status,
+                                        const void* payload, uint8_t payload_len);
 };
 
 #endif // HID_PROTOCOL_H
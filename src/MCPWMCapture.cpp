@@ -0,0 +1,45 @@
+#include "MCPWMCapture.h"
+#include "soc/mcpwm_struct.h"
+
+SemaphoreHandle_t MCPWMCapture::lock(mcpwm_unit_t unit) {
+    // Static storage, created on first use (before any capture is enabled)
+    static StaticSemaphore_t buffers[MCPWM_UNIT_MAX];
+    static SemaphoreHandle_t locks[MCPWM_UNIT_MAX] = {
+        xSemaphoreCreateMutexStatic(&buffers[0]),
+        xSemaphoreCreateMutexStatic(&buffers[1]),
+    };
+    return locks[unit];
+}
+
+esp_err_t MCPWMCapture::enable(mcpwm_unit_t unit, mcpwm_capture_channel_id_t channel,
+                               const mcpwm_capture_config_t* config) {
+    SemaphoreHandle_t l = lock(unit);
+    xSemaphoreTake(l, portMAX_DELAY);
+    esp_err_t err = mcpwm_capture_enable_channel(unit, channel, config);
+    xSemaphoreGive(l);
+    return err;
+}
+
+esp_err_t MCPWMCapture::disable(mcpwm_unit_t unit, mcpwm_capture_channel_id_t channel) {
+    SemaphoreHandle_t l = lock(unit);
+    xSemaphoreTake(l, portMAX_DELAY);
+    esp_err_t err = mcpwm_capture_disable_channel(unit, channel);
+    xSemaphoreGive(l);
+    return err;
+}
+
+void MCPWMCapture::setInterrupt(mcpwm_unit_t unit, mcpwm_capture_channel_id_t channel, bool enable) {
+    // MCPWM int_ena/int_clr: CAP0..CAP2 interrupts are bits [29:27]
+    const uint32_t capBit = 1u << (27 + (uint32_t)channel);
+    mcpwm_dev_t* dev = (unit == MCPWM_UNIT_0) ? &MCPWM0 : &MCPWM1;
+
+    SemaphoreHandle_t l = lock(unit);
+    xSemaphoreTake(l, portMAX_DELAY);
+    if (enable) {
+        dev->int_clr.val = capBit;  // Drop the edge latched while masked
+        dev->int_ena.val |= capBit;
+    } else {
+        dev->int_ena.val &= ~capBit;
+    }
+    xSemaphoreGive(l);
+}
@@ -0,0 +1,46 @@
+#ifndef MCPWM_CAPTURE_H
+#define MCPWM_CAPTURE_H
+
+#include <Arduino.h>
+#include "driver/mcpwm.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+/**
+ * @brief Single owner of the MCPWM capture channel / interrupt-enable state
+ *
+ * MCPWM0 carries UART1's tach capture next to fan channel captures, and all
+ * of them share the unit's int_ena register. The legacy driver updates it in
+ * mcpwm_capture_enable_channel()/mcpwm_capture_disable_channel() under its
+ * own private lock, while UART1Mux masks its channel (gated counter, parked
+ * mode) with a direct read-modify-write. Every capture enable, disable and
+ * mask on a unit goes through this class instead, serialized by one mutex
+ * per unit, so no caller can drop another channel's enable bit.
+ *
+ * Task context only (the lock is a FreeRTOS mutex).
+ */
+class MCPWMCapture {
+public:
+    /**
+     * @brief mcpwm_capture_enable_channel() under the unit lock
+     */
+    static esp_err_t enable(mcpwm_unit_t unit, mcpwm_capture_channel_id_t channel,
+                            const mcpwm_capture_config_t* config);
+
+    /**
+     * @brief mcpwm_capture_disable_channel() under the unit lock
+     */
+    static esp_err_t disable(mcpwm_unit_t unit, mcpwm_capture_channel_id_t channel);
+
+    /**
+     * @brief Mask or unmask one capture interrupt; the channel stays enabled
+     *
+     * Unmasking first clears the edge latched while masked.
+     */
+    static void setInterrupt(mcpwm_unit_t unit, mcpwm_capture_channel_id_t channel, bool enable);
+
+private:
+    static SemaphoreHandle_t lock(mcpwm_unit_t unit);
+};
+
+#endif // MCPWM_CAPTURE_H
@@ -0,0 +1,650 @@
+#include "CommandParser.h"
+#include "PeripheralManager.h"
+#include "WebServer.h"
+#include <float.h>
+
+// External references (defined in main.cpp)
+extern PeripheralManager peripheralManager;
+extern WebServerManager webServerManager;
+
+// Argument syntax/range error with its column; silent when the values parsed but the setter refused
+static void reportArgError(ICommandResponse* response, const CommandArgs& args) {
+    if (args.error() != CommandArgs::ARG_OK) {
+        response->printf("ERROR: %s\n", args.errorText());
+    }
+}
+
+// ============================================================================
+// Closed-Loop RPM Control Commands
+// ============================================================================
+
+bool CommandParser::handleRPMSet(CommandArgs& args, ICommandResponse* response) {
+    // RPM SET <rpm>
+    if (args.empty()) {
+        response->println("Usage: RPM SET <rpm>");
+        return false;
+    }
+
+    float rpm = 0.0f;
+    auto& pid = peripheralManager.getRPMController();
+
+    if (!args.getFloat(0, 0.0f, 500000.0f, rpm) || !pid.setSetpoint(rpm)) {
+        response->println("ERROR: RPM setpoint must be 0-500000");
+        reportArgError(response, args);
+        return false;
+    }
+
+    if (!pid.isEnabled() && !pid.setEnabled(true)) {
+        response->println("ERROR: Failed to start closed-loop control (UART1 must be in PWM mode)");
+        return false;
+    }
+
+    response->printf("RPM setpoint: %.1f (closed-loop @ %u Hz)\n", rpm, pid.getRate());
+
+    if (webServerManager.isRunning()) {
+        webServerManager.broadcastStatus();
+    }
+    return true;
+}
+
+bool CommandParser::handlePID(CommandArgs& args, ICommandResponse* response) {
+    auto& pid = peripheralManager.getRPMController();
+
+    // "PID" alone or "PID STATUS"
+    if (args.empty() || args.is(0, "STATUS")) {
+        RPMController::Status status = pid.getStatus();
+
+        response->println("");
+        response->println("PID Controller Status:");
+        response->printf("  State: %s\n", status.enabled ? "ENABLED" : "DISABLED");
+        response->printf("  Setpoint: %.1f RPM\n", status.setpoint);
+        response->printf("  Measured: %.1f RPM\n", status.measurement);
+        response->printf("  Error: %.1f RPM\n", status.error);
+        response->printf("  Output: %.2f%% (FF %.2f%%, I %.2f%%)%s\n", status.output,
+                         status.feedForward, status.integral,
+                         status.saturated ? " [SATURATED]" : "");
+        response->printf("  Gains: Kp=%.5f Ki=%.5f Kd=%.5f\n", pid.getKp(), pid.getKi(), pid.getKd());
+        response->printf("  Output Limits: %.1f%% - %.1f%%\n", pid.getOutputMin(), pid.getOutputMax());
+        response->printf("  Loop Rate: %u Hz\n", pid.getRate());
+        response->printf("  Loop Count: %u (max %u us)\n", status.loopCount, status.maxLoopUs);
+        response->printf("  Feed-Forward Points: %u\n", pid.getFeedForwardCount());
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "ON")) {
+        if (pid.setEnabled(true)) {
+            response->printf("PID enabled (setpoint %.1f RPM)\n", pid.getSetpoint());
+        } else {
+            response->println("ERROR: Failed to enable PID (UART1 must be in PWM mode)");
+            return false;
+        }
+        return true;
+    }
+
+    if (args.is(0, "OFF")) {
+        pid.setEnabled(false);
+        response->println("PID disabled (duty held at last output)");
+        return true;
+    }
+
+    if (args.is(0, "KP") || args.is(0, "KI") || args.is(0, "KD")) {
+        float value = 0.0f;
+        if (!args.getFloat(1, 0.0f, FLT_MAX, value)) {
+            response->println("ERROR: Gains must be >= 0");
+            reportArgError(response, args);
+            return false;
+        }
+        float kp = pid.getKp();
+        float ki = pid.getKi();
+        float kd = pid.getKd();
+
+        if (args.is(0, "KP")) kp = value;
+        else if (args.is(0, "KI")) ki = value;
+        else kd = value;
+
+        if (pid.setGains(kp, ki, kd)) {
+            response->printf("PID gains: Kp=%.5f Ki=%.5f Kd=%.5f\n", kp, ki, kd);
+        } else {
+            response->println("ERROR: Gains must be >= 0");
+            return false;
+        }
+        return true;
+    }
+
+    if (args.is(0, "GAINS")) {
+        // PID GAINS <kp> <ki> <kd>
+        float kp = 0.0f, ki = 0.0f, kd = 0.0f;
+        if (args.count() != 4 || !args.getFloat(1, 0.0f, FLT_MAX, kp) ||
+            !args.getFloat(2, 0.0f, FLT_MAX, ki) || !args.getFloat(3, 0.0f, FLT_MAX, kd)) {
+            response->println("Usage: PID GAINS <kp> <ki> <kd>");
+            reportArgError(response, args);
+            return false;
+        }
+        if (pid.setGains(kp, ki, kd)) {
+            response->printf("PID gains: Kp=%.5f Ki=%.5f Kd=%.5f\n", kp, ki, kd);
+        } else {
+            response->println("ERROR: Gains must be >= 0");
+            return false;
+        }
+        return true;
+    }
+
+    if (args.is(0, "LIMIT")) {
+        // PID LIMIT <min_duty> <max_duty>
+        float minDuty = 0.0f, maxDuty = 0.0f;
+        if (args.count() != 3 || !args.getFloat(1, 0.0f, 100.0f, minDuty) ||
+            !args.getFloat(2, 0.0f, 100.0f, maxDuty)) {
+            response->println("Usage: PID LIMIT <min%> <max%>");
+            reportArgError(response, args);
+            return false;
+        }
+        if (pid.setOutputLimits(minDuty, maxDuty)) {
+            response->printf("PID output limits: %.1f%% - %.1f%%\n", minDuty, maxDuty);
+        } else {
+            response->println("ERROR: Limits must satisfy 0 <= min < max <= 100");
+            return false;
+        }
+        return true;
+    }
+
+    if (args.is(0, "RATE")) {
+        uint32_t hz = 0;
+        if (args.getUInt(1, 50, 5000, hz) && pid.setRate(hz)) {
+            response->printf("PID loop rate: %u Hz\n", hz);
+        } else {
+            response->println("ERROR: Rate must be 50-5000 Hz");
+            reportArgError(response, args);
+            return false;
+        }
+        return true;
+    }
+
+    if (args.is(0, "FF") && args.count() == 1) {
+        uint32_t count = pid.getFeedForwardCount();
+        response->printf("Feed-forward table (%u/%u points):\n", count, RPMController::FF_TABLE_SIZE);
+        for (uint32_t i = 0; i < count; i++) {
+            RPMController::FFPoint p = pid.getFeedForwardPoint(i);
+            response->printf("  %2u: %.1f RPM -> %.2f%%\n", i, p.rpm, p.duty);
+        }
+        return true;
+    }
+
+    if (args.is(0, "FF") && args.is(1, "CLEAR") && args.count() == 2) {
+        pid.clearFeedForward();
+        response->println("Feed-forward table cleared");
+        return true;
+    }
+
+    if (args.is(0, "FF") && args.is(1, "ADD")) {
+        // PID FF ADD <rpm> <duty>
+        float rpm = 0.0f, duty = 0.0f;
+        if (args.count() != 4 || !args.getFloat(2, 0.0f, 500000.0f, rpm) ||
+            !args.getFloat(3, 0.0f, 100.0f, duty)) {
+            response->println("Usage: PID FF ADD <rpm> <duty%>");
+            reportArgError(response, args);
+            return false;
+        }
+        if (pid.addFeedForwardPoint(rpm, duty)) {
+            response->printf("Feed-forward point: %.1f RPM -> %.2f%%\n", rpm, duty);
+        } else {
+            response->println("ERROR: Invalid point or table full (max 16)");
+            return false;
+        }
+        return true;
+    }
+
+    response->println("Usage: PID [STATUS|ON|OFF|KP|KI|KD <v>|GAINS <kp> <ki> <kd>|LIMIT <min> <max>|RATE <hz>|FF [ADD <rpm> <duty>|CLEAR]]");
+    return false;
+}
+
+// ============================================================================
+// Speed Protection Commands
+// ============================================================================
+
+bool CommandParser::handleFault(CommandArgs& args, ICommandResponse* response) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    // "FAULT" alone or "FAULT STATUS"
+    if (args.empty() || args.is(0, "STATUS")) {
+        FaultStatus status = uart1.getFaultStatus();
+
+        response->println("");
+        response->println("Speed Protection:");
+        response->printf("  State: %s%s\n", status.armed ? "ARMED" : "OFF",
+                         (uart1.isFaultProtectionEnabled() && !status.armed) ? " (arms in PWM mode)" : "");
+        response->printf("  Fault: %s\n", status.latched ? UART1Mux::getFaultName(status.code) : "NONE");
+        if (status.latched) {
+            if (status.periodTicks > 0) {
+                response->printf("  Trip Speed: %.1f RPM (period %u ticks)\n", status.rpm, status.periodTicks);
+            }
+            response->printf("  Trip Time: %lld us (reaction %u us)\n", status.timestampUs, status.reactionUs);
+            response->printf("  Output: forced %s\n", uart1.isFaultSafeHigh() ? "HIGH" : "LOW");
+        }
+        char value[16];
+        snprintf(value, sizeof(value), "%u", (unsigned)uart1.getFaultMaxRpm());
+        response->printf("  Overspeed: %s\n", uart1.getFaultMaxRpm() ? value : "off");
+        snprintf(value, sizeof(value), "%u", (unsigned)uart1.getFaultMinRpm());
+        response->printf("  Underspeed: %s\n", uart1.getFaultMinRpm() ? value : "off");
+        snprintf(value, sizeof(value), "%u ms", (unsigned)uart1.getFaultStallMs());
+        response->printf("  Stall Timeout: %s\n", uart1.getFaultStallMs() ? value : "off");
+        response->printf("  Confirm: %u consecutive periods\n", uart1.getFaultConfirmEdges());
+        response->printf("  Safe Level: %s\n", uart1.isFaultSafeHigh() ? "HIGH (100%)" : "LOW (0%)");
+        response->printf("  Trips Since Boot: %u\n", status.tripCount);
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "ON")) {
+        if (!uart1.setFaultProtection(true)) {
+            response->println("ERROR: Failed to arm speed protection");
+            return false;
+        }
+        if (uart1.isFaultArmed()) {
+            response->println("Speed protection armed");
+        } else {
+            response->println("Speed protection enabled (arms when UART1 enters PWM mode)");
+        }
+        return true;
+    }
+
+    if (args.is(0, "OFF")) {
+        uart1.setFaultProtection(false);
+        response->println("Speed protection disabled (latched fault, if any, stays until FAULT CLEAR)");
+        return true;
+    }
+
+    if (args.is(0, "CLEAR")) {
+        bool wasLatched = uart1.isFaultLatched();
+        uart1.clearFault();
+        response->println(wasLatched ? "Fault cleared, output released" : "No fault latched");
+        if (wasLatched && webServerManager.isRunning()) {
+            webServerManager.broadcastStatus();
+        }
+        return true;
+    }
+
+    if (args.is(0, "LIMIT")) {
+        // FAULT LIMIT <max_rpm> <min_rpm> <stall_ms> [confirm]
+        uint32_t maxRpm = 0, minRpm = 0, stallMs = 0;
+        uint32_t confirm = uart1.getFaultConfirmEdges();
+        if (args.count() > 5 || !args.getUInt(1, 0, UINT32_MAX, maxRpm) ||
+            !args.getUInt(2, 0, UINT32_MAX, minRpm) || !args.getUInt(3, 0, 5000, stallMs) ||
+            (args.has(4) && !args.getUInt(4, 1, 16, confirm))) {
+            response->println("Usage: FAULT LIMIT <max_rpm> <min_rpm> <stall_ms> [confirm_periods]");
+            reportArgError(response, args);
+            return false;
+        }
+        if (!uart1.setFaultLimits(maxRpm, minRpm, stallMs, confirm)) {
+            response->println("ERROR: Limits must satisfy min < max (0 = off), stall 0-5000 ms, confirm 1-16");
+            return false;
+        }
+        response->printf("Fault limits: overspeed %u, underspeed %u RPM, stall %u ms, confirm %u\n",
+                         maxRpm, minRpm, stallMs, confirm);
+        return true;
+    }
+
+    if (args.is(0, "SAFE") && args.count() == 2 && (args.is(1, "LOW") || args.is(1, "HIGH"))) {
+        uart1.setFaultSafeHigh(args.is(1, "HIGH"));
+        response->printf("Fault safe level: %s\n", uart1.isFaultSafeHigh() ? "HIGH (100%)" : "LOW (0%)");
+        return true;
+    }
+
+    response->println("Usage: FAULT [STATUS|ON|OFF|CLEAR|LIMIT <max> <min> <stall_ms> [N]|SAFE LOW|HIGH]");
+    return false;
+}
+
+// ============================================================================
+// Multi-Fan Channel Commands
+// ============================================================================
+
+static void printFanRow(const FanStatus& fan, ICommandResponse* response) {
+    response->printf("  %u  %-8s %7u Hz %6.1f%% %9.1f RPM %9.2f Hz  %s\n",
+                     fan.channel,
+                     !fan.active ? "inactive" : (fan.enabled ? "on" : "off"),
+                     fan.frequency, fan.duty, fan.rpm, fan.inputHz,
+                     fan.signal ? "" : "(no tach)");
+}
+
+bool CommandParser::handleFan(CommandArgs& args, ICommandResponse* response) {
+    auto& fans = peripheralManager.getFans();
+
+    // "FAN" alone or "FAN STATUS"
+    if (args.empty() || args.is(0, "STATUS")) {
+        response->println("");
+        response->printf("Fan Channels (%u of %u in use, channel 0 = UART1):\n",
+                         fans.getChannelCount(), FAN_CHANNEL_MAX);
+        response->println("  ch state       PWM freq   duty           speed        tach");
+        for (uint32_t i = 0; i < fans.getChannelCount(); i++) {
+            printFanRow(fans.getStatus(i), response);
+        }
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "COUNT")) {
+        uint32_t count = 0;
+        if (!args.getUInt(1, 1, FAN_CHANNEL_MAX, count)) {
+            response->printf("Usage: FAN COUNT <1-%u>\n", FAN_CHANNEL_MAX);
+            reportArgError(response, args);
+            return false;
+        }
+        if (!fans.setChannelCount(count)) {
+            response->println("ERROR: Some fan channels failed to start (see log)");
+            return false;
+        }
+        response->printf("Fan channels in use: %u\n", count);
+        return true;
+    }
+
+    // FAN <ch> [subcommand]
+    uint32_t channel = 0;
+    if (!args.getUInt(0, 0, fans.getChannelCount() - 1, channel)) {
+        response->printf("ERROR: Channel must be 0-%u (FAN COUNT sets how many are in use)\n",
+                         fans.getChannelCount() - 1);
+        reportArgError(response, args);
+        return false;
+    }
+
+    bool ok = true;
+    uint32_t value = 0;
+    float duty = 0.0f;
+
+    if (args.count() == 1 || args.is(1, "STATUS")) {
+        FanStatus fan = fans.getStatus(channel);
+        response->println("");
+        response->printf("Fan %u%s:\n", channel, channel == 0 ? " (UART1)" : "");
+        response->printf("  State: %s\n", !fan.active ? "INACTIVE" : (fan.enabled ? "ON" : "OFF"));
+        response->printf("  PWM: %u Hz (actual %.3f Hz), %.2f%%\n", fan.frequency, fan.actualHz, fan.duty);
+        response->printf("  Speed: %.1f RPM (tach %.2f Hz)%s\n", fan.rpm, fan.inputHz,
+                         fan.signal ? "" : " [NO SIGNAL]");
+        response->printf("  Pole Pairs: %u\n", fan.polePairs);
+        response->printf("  Limits: max %u Hz, duty %.1f%% - %.1f%%\n",
+                         fan.maxFrequency, fan.dutyMin, fan.dutyMax);
+        response->println("");
+        return true;
+    } else if (args.is(1, "PWM")) {
+        if (args.count() != 4 || !args.getUInt(2, 0, UINT32_MAX, value) ||
+            !args.getFloat(3, 0.0f, 100.0f, duty)) {
+            response->println("Usage: FAN <ch> PWM <Hz> <duty%>");
+            reportArgError(response, args);
+            return false;
+        }
+        ok = fans.setPWM(channel, value, duty);
+    } else if (args.is(1, "FREQ") || args.is(1, "POLES") || args.is(1, "MAXFREQ")) {
+        if (!args.getUInt(2, 0, UINT32_MAX, value)) {
+            reportArgError(response, args);
+            return false;
+        }
+        if (args.is(1, "FREQ")) ok = fans.setFrequency(channel, value);
+        else if (args.is(1, "POLES")) ok = fans.setPolePairs(channel, value);
+        else ok = fans.setMaxFrequency(channel, value);
+    } else if (args.is(1, "DUTY")) {
+        if (!args.getFloat(2, 0.0f, 100.0f, duty)) {
+            reportArgError(response, args);
+            return false;
+        }
+        ok = fans.setDuty(channel, duty);
+    } else if (args.is(1, "ON") || args.is(1, "OFF")) {
+        ok = fans.setEnabled(channel, args.is(1, "ON"));
+    } else if (args.is(1, "LIMIT")) {
+        float minDuty = 0.0f, maxDuty = 0.0f;
+        if (args.count() != 4 || !args.getFloat(2, 0.0f, 100.0f, minDuty) ||
+            !args.getFloat(3, 0.0f, 100.0f, maxDuty)) {
+            response->println("Usage: FAN <ch> LIMIT <min%> <max%>");
+            reportArgError(response, args);
+            return false;
+        }
+        ok = fans.setDutyLimits(channel, minDuty, maxDuty);
+    } else {
+        response->println("Usage: FAN [STATUS|COUNT <n>] | FAN <ch> [STATUS|PWM <Hz> <%>|FREQ <Hz>|DUTY <%>|ON|OFF|POLES <n>|MAXFREQ <Hz>|LIMIT <min> <max>]");
+        return false;
+    }
+
+    if (!ok) {
+        response->printf("ERROR: Fan %u rejected the setting (check range%s)\n", channel,
+                         channel == 0 ? " and that UART1 is in PWM mode" : "");
+        return false;
+    }
+
+    FanStatus fan = fans.getStatus(channel);
+    response->printf("Fan %u: %u Hz, %.2f%%, %s\n", channel, fan.frequency, fan.duty,
+                     fan.enabled ? "ON" : "OFF");
+
+    if (webServerManager.isRunning()) {
+        webServerManager.broadcastStatus();
+    }
+    return true;
+}
+
+// ============================================================================
+// Fan Characterization Sweep Commands
+// ============================================================================
+
+bool CommandParser::handleSweep(CommandArgs& args, ICommandResponse* response) {
+    FanSweep& sweep = peripheralManager.getSweep();
+
+    if (args.empty() || args.is(0, "STATUS")) {
+        const FanSweep::Config& cfg = sweep.getConfig();
+        response->println("");
+        response->println("Fan Sweep:");
+        response->printf("  State: %s (%u of %u points)\n",
+                         FanSweep::getStateName(sweep.getState()),
+                         sweep.getPointCount(), sweep.getTotalPoints());
+        response->printf("  Grid: fan %u, duty %.2f%% -> %.2f%% step %.2f%%, freq %u -> %u Hz step %u\n",
+                         cfg.channel, cfg.dutyStart, cfg.dutyEnd, cfg.dutyStep,
+                         cfg.freqStart, cfg.freqEnd, cfg.freqStep);
+        response->printf("  Settle: every %u ms, window %u, stddev <= %.2f%% of mean, %u-%u ms\n",
+                         cfg.sampleMs, cfg.settleWindow, cfg.tolerance * 100.0f,
+                         cfg.settleMinMs, cfg.settleTimeoutMs);
+        response->printf("  Measure: %u readings per point\n", cfg.measureSamples);
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "START")) {
+        FanSweep::Config cfg = sweep.getConfig();
+        uint32_t channel = 0;
+        uint32_t f0 = 0, f1 = 0, fStep = 0;
+        if ((args.count() != 5 && args.count() != 8) || !args.getUInt(1, 0, 255, channel) ||
+            !args.getFloat(2, 0.0f, 100.0f, cfg.dutyStart) || !args.getFloat(3, 0.0f, 100.0f, cfg.dutyEnd) ||
+            !args.getFloat(4, 0.0f, 100.0f, cfg.dutyStep) ||
+            (args.count() == 8 && (!args.getUInt(5, 0, UINT32_MAX, f0) || !args.getUInt(6, 0, UINT32_MAX, f1) ||
+                                   !args.getUInt(7, 0, UINT32_MAX, fStep)))) {
+            response->println("Usage: SWEEP START <ch> <duty_start> <duty_end> <duty_step> [<freq_start> <freq_end> <freq_step>]");
+            reportArgError(response, args);
+            return false;
+        }
+        cfg.channel = (uint8_t)channel;
+        cfg.freqStart = f0;
+        cfg.freqEnd = f1;
+        cfg.freqStep = fStep;
+        if (!sweep.start(cfg)) {
+            response->println("ERROR: Sweep not started (check channel, grid size and that PID is off)");
+            return false;
+        }
+        response->printf("Sweep started: %u points on fan %u\n", sweep.getTotalPoints(), channel);
+        return true;
+    }
+
+    if (args.is(0, "SETTLE")) {
+        uint32_t sampleMs = 0, window = 0, minMs = 0, timeoutMs = 0, samples = 0;
+        float tolPercent = 0.0f;
+        if (args.count() != 7 || !args.getUInt(1, 10, 1000, sampleMs) ||
+            !args.getUInt(2, 3, FanSweep::MAX_WINDOW, window) || !args.getFloat(3, 0.0f, 100.0f, tolPercent) ||
+            !args.getUInt(4, 0, UINT32_MAX, minMs) || !args.getUInt(5, 0, UINT32_MAX, timeoutMs) ||
+            !args.getUInt(6, 1, 255, samples)) {
+            response->println("Usage: SWEEP SETTLE <sample_ms> <window> <tol%> <min_ms> <timeout_ms> <samples>");
+            reportArgError(response, args);
+            return false;
+        }
+        if (!sweep.setSettleCriteria(sampleMs, window, tolPercent / 100.0f, minMs, timeoutMs, samples)) {
+            response->printf("ERROR: Invalid settle criteria (sample 10-1000 ms, window 3-%u, "
+                             "tol 0-100%%, timeout >= min, samples 1-255) or sweep running\n",
+                             FanSweep::MAX_WINDOW);
+            return false;
+        }
+        response->println("Sweep settle criteria updated");
+        return true;
+    }
+
+    if (args.is(0, "STOP")) {
+        sweep.abort();
+        response->printf("Sweep stopped: %u points kept\n", sweep.getPointCount());
+        return true;
+    }
+
+    if (args.is(0, "CSV")) {
+        char line[128];
+        response->println(FanSweep::CSV_HEADER);
+        for (uint32_t i = 0; i < sweep.getPointCount(); i++) {
+            sweep.formatCSV(i, line, sizeof(line));
+            response->println(line);
+        }
+        return true;
+    }
+
+    if (args.is(0, "BIN")) {
+        // Binary blob (SweepBlobHeader + SweepPoint[]) as hex, 32 bytes per line
+        size_t size;
+        const uint8_t* blob = sweep.getBlob(size);
+        if (!blob) {
+            response->println("ERROR: Sweep table not allocated");
+            return false;
+        }
+        response->printf("BIN %u\n", (unsigned)size);
+        char line[65];
+        for (size_t offset = 0; offset < size; offset += 32) {
+            size_t chunk = (size - offset < 32) ? size - offset : 32;
+            for (size_t i = 0; i < chunk; i++) {
+                snprintf(line + i * 2, 3, "%02X", blob[offset + i]);
+            }
+            line[chunk * 2] = '\0';
+            response->println(line);
+        }
+        return true;
+    }
+
+    if (args.is(0, "APPLY")) {
+        uint32_t freq = 0;
+        if (args.has(1) && !args.getUInt(1, 0, UINT32_MAX, freq)) {
+            reportArgError(response, args);
+            return false;
+        }
+        uint32_t loaded = sweep.applyToFeedForward(freq);
+        if (loaded == 0) {
+            response->println("ERROR: No settled, monotonic sweep points for that frequency (or sweep running)");
+            return false;
+        }
+        response->printf("Feed-forward table loaded: %u points (SAVE to keep)\n", loaded);
+        return true;
+    }
+
+    response->println("Usage: SWEEP [STATUS|START ...|SETTLE ...|STOP|CSV|BIN|APPLY [Hz]]");
+    return false;
+}
+
+// ============================================================================
+// Step-Response Analyzer Commands
+// ============================================================================
+
+bool CommandParser::handleStep(CommandArgs& args, ICommandResponse* response) {
+    StepAnalyzer& step = peripheralManager.getStepAnalyzer();
+
+    if (args.empty() || args.is(0, "STATUS")) {
+        StepAnalyzer::Result r = step.getResult();
+        response->println("");
+        response->printf("Step Response: %s (band ±%.1f%%, smoothing %u periods%s)\n",
+                         StepAnalyzer::getStateName(step.getState()), step.getSettleBand(),
+                         step.getSmoothing(), step.getSmoothing() == 0 ? " = 1 rev" : "");
+        if (step.getState() == StepAnalyzer::STEP_IDLE) {
+            response->println("  No test run yet. Usage: STEP <duty%> [Hz] [ms]");
+            response->println("");
+            return true;
+        }
+        response->printf("  Step: %.2f%% -> %.2f%% at %u Hz\n", r.fromDuty, r.toDuty, r.frequency);
+        response->printf("  Edges: %u%s\n", r.edges, r.bufferFull ? " (buffer full)" : "");
+        if (step.getState() != StepAnalyzer::STEP_DONE) {
+            response->println("");
+            return true;
+        }
+        if (!r.valid) {
+            response->println("  Not enough edges to analyze (fan stopped or too short)");
+            response->println("");
+            return true;
+        }
+        response->printf("  Speed: %.1f -> %.1f RPM (peak %.1f)\n", r.initialRpm, r.finalRpm, r.peakRpm);
+        response->printf("  First edge: %.2f ms\n", r.firstEdgeUs / 1000.0f);
+        if (r.t90Us > 0) {
+            response->printf("  Time to 10%% / 90%%: %.2f / %.2f ms (rise %.2f ms)\n",
+                             r.t10Us / 1000.0f, r.t90Us / 1000.0f, (r.t90Us - r.t10Us) / 1000.0f);
+        } else {
+            response->println("  Time to 90%: not reached");
+        }
+        response->printf("  Overshoot: %.1f%%\n", r.overshootPct);
+        response->printf("  Settling: %.2f ms%s\n", r.settlingUs / 1000.0f,
+                         r.settled ? "" : " (NOT settled by end of recording)");
+        response->printf("  Ripple: %.2f RPM stddev, %.2f RPM pk-pk\n", r.rippleStdDev, r.ripplePkPk);
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "STOP")) {
+        step.abort();
+        response->println("Step recording stopped");
+        return true;
+    }
+
+    if (args.is(0, "BAND")) {
+        float band = 0.0f;
+        if (!args.getFloat(1, 0.1f, 50.0f, band) || !step.setSettleBand(band)) {
+            response->println("ERROR: Band must be 0.1-50 %");
+            reportArgError(response, args);
+            return false;
+        }
+        response->printf("Settling band: ±%.1f%%\n", step.getSettleBand());
+        return true;
+    }
+
+    if (args.is(0, "SMOOTH")) {
+        uint32_t periods = 0;
+        if (!args.getUInt(1, 0, 64, periods) || !step.setSmoothing(periods)) {
+            response->println("ERROR: Smoothing must be 0-64 periods (0 = one revolution)");
+            reportArgError(response, args);
+            return false;
+        }
+        response->printf("Smoothing: %u periods\n", step.getSmoothing());
+        return true;
+    }
+
+    if (args.is(0, "RAW")) {
+        StepAnalyzer::Result r = step.getResult();
+        uint32_t timeUs, periodTicks;
+        float rpm;
+        response->println("index,t_us,period_ticks,rpm");
+        for (uint32_t i = 1; i < r.edges; i++) {
+            if (!step.getSample(i, timeUs, periodTicks, rpm)) {
+                break;
+            }
+            response->printf("%u,%u,%u,%.1f\n", i, timeUs, periodTicks, rpm);
+        }
+        return true;
+    }
+
+    // STEP <duty> [freq] [ms]
+    float duty = 0.0f;
+    uint32_t freq = 0, durationMs = 2000;
+    if (args.count() > 3 || !args.getFloat(0, 0.0f, 100.0f, duty) ||
+        (args.has(1) && !args.getUInt(1, 0, UINT32_MAX, freq)) ||
+        (args.has(2) && !args.getUInt(2, 100, 30000, durationMs))) {
+        response->println("Usage: STEP <duty%> [Hz (0 = current)] [ms] | STATUS | RAW | STOP | BAND <%> | SMOOTH <n>");
+        reportArgError(response, args);
+        return false;
+    }
+    if (!step.start(duty, freq, durationMs)) {
+        response->println("ERROR: Step not started (UART1 must be in PWM mode with PID, sweep and fault clear; 100-30000 ms)");
+        return false;
+    }
+    response->printf("Step applied, recording %u ms (STEP STATUS for results)\n", durationMs);
+    return true;
+}
@@ -0,0 +1,102 @@
+#include "PWMSolver.h"
+
+uint32_t PWMSolver::bestPeriod(uint32_t clockHz, uint32_t frequency, uint32_t prescaler) {
+    // f × prescaler ≤ 500 kHz × 256, fits in 32 bits
+    uint32_t divisor = frequency * prescaler;
+    uint32_t lower = clockHz / divisor;
+
+    // Round to nearest: compare floor and floor + 1 exactly
+    uint32_t period = lower;
+    if (residual(clockHz, frequency, prescaler, lower + 1) <
+        residual(clockHz, frequency, prescaler, lower)) {
+        period = lower + 1;
+    }
+    return period;
+}
+
+bool PWMSolver::solve(uint32_t clockHz, uint32_t frequency, uint32_t preferredPrescaler,
+                      PWMSolution& out) {
+    out = PWMSolution();
+    if (frequency == 0 || clockHz / frequency < MIN_PERIOD) {
+        return false;
+    }
+
+    // Smallest prescaler that can reach the tick count with a 16-bit period
+    uint32_t ticks = clockHz / frequency;
+    uint32_t first = ticks / MAX_PERIOD;
+    if (first < MIN_PRESCALER) {
+        first = MIN_PRESCALER;
+    }
+    if (first > MAX_PRESCALER) {
+        return false;  // Below clock / (256 × 65535)
+    }
+
+    uint64_t bestResidual = UINT64_MAX;
+
+    for (uint32_t p = first; p <= MAX_PRESCALER; p++) {
+        uint32_t rounded = bestPeriod(clockHz, frequency, p);
+        uint32_t q = rounded;
+        if (q < MIN_PERIOD) q = MIN_PERIOD;
+        if (q > MAX_PERIOD) q = MAX_PERIOD;
+
+        uint64_t r = residual(clockHz, frequency, p, q);
+        if (r < bestResidual) {
+            bestResidual = r;
+            out.prescaler = p;
+            out.period = q;
+        }
+
+        // Exact hit, or prescaler 1 reaching the nearest integer tick count:
+        // nothing can do better
+        if (bestResidual == 0 || (p == 1 && q == rounded)) {
+            break;
+        }
+    }
+
+    // Keep the current prescaler when it is just as good (no prescaler write)
+    if (preferredPrescaler >= MIN_PRESCALER && preferredPrescaler <= MAX_PRESCALER &&
+        preferredPrescaler != out.prescaler) {
+        uint32_t q = bestPeriod(clockHz, frequency, preferredPrescaler);
+        if (q >= MIN_PERIOD && q <= MAX_PERIOD &&
+            residual(clockHz, frequency, preferredPrescaler, q) == bestResidual) {
+            out.prescaler = preferredPrescaler;
+            out.period = q;
+        }
+    }
+
+    evaluate(clockHz, frequency, out);
+    return true;
+}
+
+bool PWMSolver::solveForPrescaler(uint32_t clockHz, uint32_t frequency, uint32_t prescaler,
+                                  PWMSolution& out) {
+    out = PWMSolution();
+    if (frequency == 0 || prescaler < MIN_PRESCALER || prescaler > MAX_PRESCALER) {
+        return false;
+    }
+
+    uint32_t q = bestPeriod(clockHz, frequency, prescaler);
+    if (q < MIN_PERIOD || q > MAX_PERIOD) {
+        return false;
+    }
+
+    out.prescaler = prescaler;
+    out.period = q;
+    evaluate(clockHz, frequency, out);
+    return true;
+}
+
+void PWMSolver::evaluate(uint32_t clockHz, uint32_t frequency, PWMSolution& sol) {
+    uint32_t ticks = sol.prescaler * sol.period;
+    if (ticks == 0 || frequency == 0) {
+        sol.actualHz = 0.0f;
+        sol.errorPpm = 0;
+        return;
+    }
+
+    sol.actualHz = (float)clockHz / (float)ticks;
+
+    // (clock − ticks·f) / (ticks·f) × 1e6 in integer math
+    int64_t produced = (int64_t)ticks * frequency;
+    sol.errorPpm = (int32_t)((((int64_t)clockHz - produced) * 1000000LL) / produced);
+}
@@ -0,0 +1,83 @@
+#ifndef PWM_SOLVER_H
+#define PWM_SOLVER_H
+
+#include <stdint.h>
+
+/**
+ * @brief Result of a prescaler/period search
+ */
+struct PWMSolution {
+    uint32_t prescaler = 0;  ///< Timer prescaler (1 - 256)
+    uint32_t period = 0;     ///< Timer period in prescaled ticks (2 - 65535)
+    float actualHz = 0.0f;   ///< Frequency produced by this pair
+    int32_t errorPpm = 0;    ///< (actual - requested) / requested × 1e6
+};
+
+/**
+ * @brief Minimum-error MCPWM prescaler/period solver
+ *
+ * Output frequency = clock / (prescaler × period). For a requested frequency
+ * the ideal tick count N = clock / f is usually not an integer, and not every
+ * integer near N can be written as prescaler × period within the register
+ * limits. The solver returns the pair whose product is closest to N.
+ *
+ * All comparisons are exact integer math on |prescaler × period × f − clock|
+ * (no floats, no 64-bit division):
+ * - N ≤ 65535 (f ≥ ~1.2 kHz at 80 MHz): prescaler 1, period = round(N) is
+ *   globally optimal, found in O(1)
+ * - Otherwise each prescaler from ceil(N / 65535) to 256 is tried with its
+ *   rounded period (one hardware 32-bit divide each), stopping at the first
+ *   exact hit. Ties keep the preferred prescaler (avoids a prescaler change),
+ *   then the smallest one (finest duty resolution).
+ */
+class PWMSolver {
+public:
+    static constexpr uint32_t MIN_PRESCALER = 1;
+    static constexpr uint32_t MAX_PRESCALER = 256;    // timer_prescale[7:0] + 1
+    static constexpr uint32_t MIN_PERIOD = 2;
+    static constexpr uint32_t MAX_PERIOD = 65535;     // timer_period[23:8]
+
+    // MCPWM timer clock as configured by mcpwm_init() (80 MHz APB); shared by
+    // UART1 and the fan channels so both solve against the same tick rate
+    static constexpr uint32_t TIMER_CLK_HZ = 80000000;
+
+    /**
+     * @brief Find the prescaler/period pair with minimum frequency error
+     * @param clockHz Timer source clock (80 MHz APB)
+     * @param frequency Requested output frequency (Hz)
+     * @param preferredPrescaler Prescaler to keep on equal error (0 = none)
+     * @param out Best solution
+     * @return false if the frequency cannot be produced at all
+     */
+    static bool solve(uint32_t clockHz, uint32_t frequency, uint32_t preferredPrescaler,
+                      PWMSolution& out);
+
+    /**
+     * @brief Best period for a fixed prescaler (rounded, O(1))
+     * @param clockHz Timer source clock
+     * @param frequency Requested output frequency (Hz)
+     * @param prescaler Fixed prescaler (1 - 256)
+     * @param out Solution with this prescaler
+     * @return false if the rounded period is outside 2 - 65535
+     */
+    static bool solveForPrescaler(uint32_t clockHz, uint32_t frequency, uint32_t prescaler,
+                                  PWMSolution& out);
+
+    /**
+     * @brief Fill actualHz/errorPpm for an existing pair
+     */
+    static void evaluate(uint32_t clockHz, uint32_t frequency, PWMSolution& sol);
+
+private:
+    // |prescaler × period × f − clock|, the error scaled by f
+    static inline uint64_t residual(uint32_t clockHz, uint32_t frequency,
+                                    uint32_t prescaler, uint32_t period) {
+        uint64_t produced = (uint64_t)prescaler * period * frequency;
+        return (produced > clockHz) ? produced - clockHz : clockHz - produced;
+    }
+
+    // Rounded period for one prescaler, clamped to the register range
+    static uint32_t bestPeriod(uint32_t clockHz, uint32_t frequency, uint32_t prescaler);
+};
+
+#endif // PWM_SOLVER_H
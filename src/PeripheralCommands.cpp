@@ -1,62 +1,68 @@
 #include "CommandParser.h"
 #include "PeripheralManager.h"
+#include "TraceRing.h"
 #include "soc/mcpwm_struct.h"
 
 // External reference to peripheral manager (defined in main.cpp)
 extern PeripheralManager peripheralManager;
 
+// Argument syntax/range error with its column; silent when the values parsed but the setter refused
+static void reportArgError(ICommandResponse* response, const CommandArgs& args) {
+    if (args.error() != CommandArgs::ARG_OK) {
+        response->printf("ERROR: %s\n", args.errorText());
+    }
+}
+
 // ============================================================================
 // UART1 Commands
 // ============================================================================
 
-void CommandParser::handleUART1Mode(const String& cmd, ICommandResponse* response) {
-    // Extract mode parameter
-    int spaceIndex = cmd.lastIndexOf(' ');  // Find last space to get the mode parameter
-    if (spaceIndex == -1) {
+bool CommandParser::handleUART1Mode(CommandArgs& args, ICommandResponse* response) {
+    // UART1 MODE <UART|PWM|OFF>
+    if (args.count() != 1) {
         response->println("Usage: UART1 MODE <UART|PWM|OFF>");
-        return;
+        return false;
     }
 
-    String mode = cmd.substring(spaceIndex + 1);
-    mode.trim();
-    mode.toUpperCase();
-
-    if (mode == "UART") {
-        if (peripheralManager.getUART1().setModeUART(115200)) {
-            response->println("UART1 switched to UART mode (115200 baud)");
+    auto& uart1 = peripheralManager.getUART1();
+    if (args.is(0, "UART")) {
+        if (uart1.setModeUART(115200)) {
+            response->printf("UART1 switched to UART mode (115200 baud, %u us)\n",
+                             uart1.getModeSwitchStats().lastUs);
         } else {
             response->println("ERROR: Failed to switch UART1 to UART mode");
+            return false;
         }
-    } else if (mode == "PWM") {
-        if (peripheralManager.getUART1().setModePWM_RPM()) {
-            response->println("UART1 switched to PWM/RPM mode");
+    } else if (args.is(0, "PWM")) {
+        if (uart1.setModePWM_RPM()) {
+            response->printf("UART1 switched to PWM/RPM mode (%u us)\n",
+                             uart1.getModeSwitchStats().lastUs);
         } else {
             response->println("ERROR: Failed to switch UART1 to PWM/RPM mode");
+            return false;
         }
-    } else if (mode == "OFF") {
-        peripheralManager.getUART1().disable();
+    } else if (args.is(0, "OFF")) {
+        uart1.disable();
         response->println("UART1 disabled");
     } else {
         response->println("ERROR: Invalid mode. Use UART, PWM, or OFF");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleUART1Config(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleUART1Config(CommandArgs& args, ICommandResponse* response) {
     // UART1 CONFIG <baud> [stop_bits] [parity]
-    // "UART1 CONFIG " is exactly 13 characters, params start at position 13
-    String params = cmd.substring(13);
-    params.trim();
-
-    if (params.length() == 0) {
+    if (args.empty()) {
         response->println("Usage: UART1 CONFIG <baud> [1|2] [N|E|O]");
-        return;
+        return false;
     }
 
-    int baud = params.toInt();
-
-    if (baud < 2400 || baud > 1500000) {
+    uint32_t baud = 0;
+    if (!args.getUInt(0, 2400, 1500000, baud)) {
         response->println("ERROR: Baud rate must be 2400-1500000");
-        return;
+        reportArgError(response, args);
+        return false;
     }
 
     // Optional: Parse stop bits and parity (default: 1 stop bit, no parity)
@@ -64,123 +70,91 @@ void CommandParser::handleUART1Config(const String& cmd, ICommandResponse* respo
     uart_parity_t parity = UART_PARITY_DISABLE;
 
     if (peripheralManager.getUART1().reconfigureUART(baud, stopBits, parity)) {
-        response->printf("UART1 configured: %d baud\n", baud);
+        response->printf("UART1 configured: %u baud\n", baud);
     } else {
         response->println("ERROR: Failed to configure UART1");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleUART1PWM(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleUART1PWM(CommandArgs& args, ICommandResponse* response) {
     // UART1 PWM <freq> <duty> [ON|OFF]
-    // "UART1 PWM " is exactly 10 characters (positions 0-9), so freq starts at position 10
-    int idx1 = 9;  // Fixed: Position of space after "PWM"
-
-    int idx2 = cmd.indexOf(' ', idx1 + 1);  // Find space after frequency
-    if (idx2 == -1) {
+    if (args.count() < 2) {
         response->println("Usage: UART1 PWM <freq> <duty> [ON|OFF]");
-        return;
+        return false;
     }
 
-    // Parse frequency and duty
-    uint32_t freq = cmd.substring(idx1 + 1, idx2).toInt();
-
-    // Check if there's an optional ON/OFF parameter
-    String dutyStr = cmd.substring(idx2 + 1);
-    dutyStr.trim();
-    int idx3 = dutyStr.indexOf(' ');
-
-    float duty;
-    bool enablePWM = true;  // Default to enabled
-
-    if (idx3 != -1) {
-        // Has ON/OFF parameter
-        duty = dutyStr.substring(0, idx3).toFloat();
-        String enableStr = dutyStr.substring(idx3 + 1);
-        enableStr.trim();
-        enableStr.toUpperCase();
-
-        if (enableStr == "ON") {
-            enablePWM = true;
-        } else if (enableStr == "OFF") {
-            enablePWM = false;
-        }
-    } else {
-        // No ON/OFF parameter, just duty
-        duty = dutyStr.toFloat();
+    // Parse frequency and duty (range checked by setPWMFrequencyAndDuty)
+    uint32_t freq = 0;
+    float duty = 0.0f;
+    if (!args.getUInt(0, 0, UINT32_MAX, freq) || !args.getFloat(1, 0.0f, 100.0f, duty)) {
+        reportArgError(response, args);
+        return false;
     }
 
-    // Use atomic setPWMFrequencyAndDuty() to update both parameters with single pulse
-    response->printf("[DEBUG] handleUART1PWM: Calling setPWMFrequencyAndDuty(%u Hz, %.1f%%)\n", freq, duty);
+    // Optional ON/OFF parameter, default to enabled
+    bool enablePWM = !args.is(2, "OFF");
+
+    // Register-level debug dump only at TRACE LEVEL 3
+    bool debug = uart1Trace.enabled(TRACE_LEVEL_VERBOSE);
 
     // 讀取register BEFORE
     uint32_t cfg0_before = MCPWM1.timer[0].timer_cfg0.val;
-    uint32_t prescale_before = cfg0_before & 0xFF;
-    uint32_t period_before_alt1 = (cfg0_before >> 16) & 0xFF;
-    uint32_t period_before_alt2 = (cfg0_before >> 8) & 0xFFFF;
 
+    // Use atomic setPWMFrequencyAndDuty() to update both parameters with single pulse
     if (peripheralManager.getUART1().setPWMFrequencyAndDuty(freq, duty)) {
-        response->println("[DEBUG] setPWMFrequencyAndDuty() returned TRUE");
-
-        // 讀取register AFTER
-        uint32_t cfg0_after = MCPWM1.timer[0].timer_cfg0.val;
-        uint32_t prescale_after = cfg0_after & 0xFF;
-        uint32_t period_after_alt1 = (cfg0_after >> 16) & 0xFF;
-        uint32_t period_after_alt2 = (cfg0_after >> 8) & 0xFFFF;
-
-        response->printf("[REG] BEFORE: cfg0=0x%08X, prescale=%u, period_alt1=%u, period_alt2=%u\n",
-                        cfg0_before, prescale_before+1, period_before_alt1+1, period_before_alt2+1);
-        response->printf("[REG] AFTER:  cfg0=0x%08X\n", cfg0_after);
-        response->printf("[REG]   bits[7:0] (prescale): 0x%02X = %u (actual: %u)\n",
-                        prescale_after, prescale_after, prescale_after+1);
-        response->printf("[REG]   bits[15:8]: 0x%02X = %u\n",
-                        (cfg0_after >> 8) & 0xFF, (cfg0_after >> 8) & 0xFF);
-        response->printf("[REG]   bits[23:16]: 0x%02X = %u\n",
-                        (cfg0_after >> 16) & 0xFF, (cfg0_after >> 16) & 0xFF);
-        response->printf("[REG]   bits[23:8] (period_alt2): 0x%04X = %u (actual: %u)\n",
-                        period_after_alt2, period_after_alt2, period_after_alt2+1);
-        response->printf("[REG]   bits[31:24]: 0x%02X\n",
-                        (cfg0_after >> 24) & 0xFF);
-
-        // 計算期望的period
-        uint32_t expected_period = 80000000 / ((prescale_after+1) * freq);
-        response->printf("[CALC] Expected period for %u Hz (prescale=%u): %u\n",
-                        freq, prescale_after+1, expected_period);
-
-        // 嘗試反向工程: 實際period是多少? (使用正確的 bits[23:8])
-        uint32_t period_actual = (cfg0_after >> 8) & 0xFFFF;  // bits[23:8] - 正確的16-bit extraction
-        uint32_t actual_freq_calculated = 80000000 / ((prescale_after+1) * (period_actual + 1));
-        response->printf("[VERIFY] Using correct bits[23:8] period=%u, calculated freq: %u Hz ✓\n",
-                        period_actual + 1, actual_freq_calculated);
-
-        // 計算實際MCPWM時鐘
-        uint32_t actual_mcpwm_clk = actual_freq_calculated * (prescale_after+1) * (period_actual + 1);
-        response->printf("[CLOCK] Frequency=%u Hz, prescale=%u, period=%u → MCPWM_CLK: %u Hz (%.1f MHz)\n",
-                        actual_freq_calculated, prescale_after+1, period_actual+1, actual_mcpwm_clk, actual_mcpwm_clk/1000000.0f);
+        if (debug) {
+            // 讀取register AFTER
+            uint32_t cfg0_after = MCPWM1.timer[0].timer_cfg0.val;
+            uint32_t prescale_after = cfg0_after & 0xFF;
+            uint32_t period_after = (cfg0_after >> 8) & 0xFFFF;  // bits[23:8]
+
+            response->printf("[REG] BEFORE: cfg0=0x%08X, prescale=%u, period=%u\n",
+                            cfg0_before, (cfg0_before & 0xFF) + 1, ((cfg0_before >> 8) & 0xFFFF) + 1);
+            response->printf("[REG] AFTER:  cfg0=0x%08X, prescale=%u, period=%u\n",
+                            cfg0_after, prescale_after + 1, period_after + 1);
+            response->printf("[REG]   bits[31:24]: 0x%02X\n", (cfg0_after >> 24) & 0xFF);
+            response->printf("[CALC] 80 MHz / (%u × %u) = %u Hz\n", prescale_after + 1, period_after + 1,
+                            80000000 / ((prescale_after + 1) * (period_after + 1)));
+        }
 
         peripheralManager.getUART1().setPWMEnabled(enablePWM);
 
-        // Get actual frequency (may differ from requested due to hardware limitations)
-        uint32_t actualFreq = peripheralManager.getUART1().getPWMFrequency();
-        response->printf("UART1 PWM: %u Hz, %.1f%% duty, %s\n", actualFreq, duty, enablePWM ? "enabled" : "disabled");
+        // Achieved frequency (integer prescaler × period may not hit the request exactly)
+        auto& uart1 = peripheralManager.getUART1();
+        float actualFreq = uart1.getPWMActualFrequency();
+        int32_t errorPpm = uart1.getPWMFrequencyErrorPpm();
+        response->printf("UART1 PWM: %u Hz (actual %.3f Hz, %+d ppm), %.1f%% duty, %s\n",
+                         freq, actualFreq, errorPpm, duty, enablePWM ? "enabled" : "disabled");
 
         // Warn if actual frequency differs significantly from requested
-        if (actualFreq != freq) {
-            float error = abs((int32_t)actualFreq - (int32_t)freq) * 100.0 / freq;
-            if (error > 5.0) {
-                response->printf("WARNING: Requested %u Hz, achieved %u Hz (%.1f%% difference)\n", freq, actualFreq, error);
-                response->println("Note: MCPWM hardware may adjust frequency for optimal resolution");
-            }
+        if (abs(errorPpm) > 50000) {
+            response->printf("WARNING: Requested %u Hz, achieved %.3f Hz (%.1f%% difference)\n",
+                             freq, actualFreq, errorPpm / 10000.0f);
+            response->println("Note: frequency is limited by prescaler (1-256) × period (2-65535)");
         }
     } else {
         response->println("ERROR: Failed to set UART1 PWM parameters");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleUART1Status(ICommandResponse* response) {
+bool CommandParser::handleUART1Status(ICommandResponse* response) {
     auto& uart1 = peripheralManager.getUART1();
 
     response->println("UART1 Status:");
     response->printf("  Mode: %s\n", uart1.getModeName());
+    ModeSwitchStats sw = uart1.getModeSwitchStats();
+    if (sw.count > 0) {
+        response->printf("  Mode Switches: %u (%u fast), last %u us, min %u / avg %u / max %u us\n",
+                         sw.count, sw.fastCount, sw.lastUs, sw.minUs, sw.avgUs, sw.maxUs);
+        if (sw.settleTimeouts > 0) {
+            response->printf("  Settle Timeouts: %u (pin not at idle level within %u us)\n",
+                             sw.settleTimeouts, UART1Mux::MODE_SETTLE_TIMEOUT_US);
+        }
+    }
 
     if (uart1.getMode() == UART1Mux::MODE_UART) {
         response->printf("  Baud: %u\n", uart1.getUARTBaudRate());
@@ -189,64 +163,138 @@ void CommandParser::handleUART1Status(ICommandResponse* response) {
         response->printf("  TX: %u bytes, RX: %u bytes, Errors: %u\n", tx, rx, err);
     } else if (uart1.getMode() == UART1Mux::MODE_PWM_RPM) {
         response->printf("  PWM Frequency: %u Hz\n", uart1.getPWMFrequency());
-        response->printf("  PWM Duty: %.1f%%\n", uart1.getPWMDuty());
+        response->printf("  PWM Actual: %.3f Hz (%+d ppm, prescaler %u, period %u)\n",
+                         uart1.getPWMActualFrequency(), uart1.getPWMFrequencyErrorPpm(),
+                         uart1.getPWMPrescaler(), uart1.getPWMPeriod());
+        response->printf("  PWM Duty: %.3f%% (actual %.3f%%)\n", uart1.getPWMDuty(), uart1.getPWMDutyActual());
+        response->printf("  Duty Resolution: %.4f%% (%s)\n", uart1.getDutyResolution(),
+                         uart1.isDutyDither() ? "dithered" : "native");
         response->printf("  PWM Enabled: %s\n", uart1.isPWMEnabled() ? "Yes" : "No");
+        if (uart1.isComplementaryOutput()) {
+            response->printf("  Complementary: GPIO %d / GPIO %d, dead time %u/%u ns\n",
+                             PIN_UART1_TX, PIN_UART1_PWM_B, uart1.getDeadTimeRisingActualNs(),
+                             uart1.getDeadTimeFallingActualNs());
+        }
         response->printf("  RPM Frequency: %.1f Hz\n", uart1.getRPMFrequency());
         response->printf("  RPM Signal: %s\n", uart1.hasRPMSignal() ? "Present" : "None");
     }
+    return true;
+}
+
+bool CommandParser::handleUART1Complementary(CommandArgs& args, ICommandResponse* response) {
+    // UART1 COMPL [ON [rise_ns] [fall_ns] | OFF]
+    auto& uart1 = peripheralManager.getUART1();
+
+    if (args.empty()) {
+        response->printf("UART1 complementary output: %s\n", uart1.isComplementaryOutput() ? "ON" : "OFF");
+        response->printf("  High side: GPIO %d, low side: GPIO %d\n", PIN_UART1_TX, PIN_UART1_PWM_B);
+        response->printf("  Dead time: rising %u ns, falling %u ns (requested %u/%u ns)\n",
+                         uart1.getDeadTimeRisingActualNs(), uart1.getDeadTimeFallingActualNs(),
+                         uart1.getDeadTimeRisingNs(), uart1.getDeadTimeFallingNs());
+        response->printf("  Resolution: %.2f ns\n", uart1.getDeadTimeResolutionNs());
+        return true;
+    }
+
+    if (args.is(0, "OFF")) {
+        uart1.setComplementaryOutput(false, uart1.getDeadTimeRisingNs(), uart1.getDeadTimeFallingNs());
+        response->printf("UART1 complementary output OFF (GPIO %d held low)\n", PIN_UART1_PWM_B);
+        return true;
+    }
+
+    // ON alone keeps the configured dead time
+    uint32_t risingNs = uart1.getDeadTimeRisingNs();
+    uint32_t fallingNs = uart1.getDeadTimeFallingNs();
+    if (!args.is(0, "ON") || args.count() > 3) {
+        response->println("Usage: UART1 COMPL [ON [rise_ns] [fall_ns] | OFF]");
+        return false;
+    }
+    if ((args.has(1) && !args.getUInt(1, 0, UART1Mux::DEADTIME_MAX_NS, risingNs)) ||
+        (args.has(2) && !args.getUInt(2, 0, UART1Mux::DEADTIME_MAX_NS, fallingNs))) {
+        response->printf("ERROR: Invalid dead time (0-%u ns, at most 65535 dead-time clocks)\n",
+                         UART1Mux::DEADTIME_MAX_NS);
+        reportArgError(response, args);
+        return false;
+    }
+    if (args.count() == 2) {
+        fallingNs = risingNs;  // Symmetric dead time
+    }
+
+    if (!uart1.setComplementaryOutput(true, risingNs, fallingNs)) {
+        response->printf("ERROR: Invalid dead time (0-%u ns, at most 65535 dead-time clocks)\n",
+                         UART1Mux::DEADTIME_MAX_NS);
+        return false;
+    }
+    if (uart1.getMode() != UART1Mux::MODE_PWM_RPM) {
+        response->println("UART1 complementary output stored, applied in PWM mode");
+        return true;
+    }
+    response->printf("UART1 complementary output ON: GPIO %d / GPIO %d, dead time %u/%u ns\n",
+                     PIN_UART1_TX, PIN_UART1_PWM_B, uart1.getDeadTimeRisingActualNs(),
+                     uart1.getDeadTimeFallingActualNs());
+    return true;
 }
 
-void CommandParser::handleUART1Write(const String& cmd, ICommandResponse* response) {
-    // UART1 WRITE <text>
-    // "UART1 WRITE " is exactly 12 characters, text starts at position 12
-    String text = cmd.substring(12);
-    text.trim();
+bool CommandParser::handleUART1Switch(CommandArgs& args, ICommandResponse* response) {
+    // UART1 SWITCH RESET
+    if (!args.is(0, "RESET")) {
+        response->println("Usage: UART1 SWITCH RESET");
+        return false;
+    }
+    peripheralManager.getUART1().resetModeSwitchStats();
+    response->println("UART1 mode switch statistics reset");
+    return true;
+}
 
-    if (text.length() == 0) {
+bool CommandParser::handleUART1Write(CommandArgs& args, ICommandResponse* response) {
+    // UART1 WRITE <text> (rest of the line, original case and spacing)
+    if (args.empty()) {
         response->println("Usage: UART1 WRITE <text>");
-        return;
+        return false;
     }
 
-    text += "\n";  // Add newline
+    char text[MAX_LINE_LENGTH + 2];
+    size_t length = args.copyRest(0, text, sizeof(text) - 1);
+    text[length++] = '\n';  // Add newline
+    text[length] = '\0';
 
-    int written = peripheralManager.getUART1().write(text.c_str());
+    int written = peripheralManager.getUART1().write(text);
     if (written > 0) {
         response->printf("Wrote %d bytes to UART1\n", written);
     } else {
         response->println("ERROR: Failed to write to UART1");
+        return false;
     }
+    return true;
 }
 
 // ============================================================================
 // UART2 Commands
 // ============================================================================
 
-void CommandParser::handleUART2Config(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleUART2Config(CommandArgs& args, ICommandResponse* response) {
     // UART2 CONFIG <baud>
-    // "UART2 CONFIG " is exactly 13 characters, baud starts at position 13
-    String baudStr = cmd.substring(13);
-    baudStr.trim();
-
-    if (baudStr.length() == 0) {
+    if (args.empty()) {
         response->println("Usage: UART2 CONFIG <baud>");
-        return;
+        return false;
     }
 
-    uint32_t baud = baudStr.toInt();
-
-    if (baud < 2400 || baud > 1500000) {
+    uint32_t baud = 0;
+    if (!args.getUInt(0, 2400, 1500000, baud)) {
         response->println("ERROR: Baud rate must be 2400-1500000");
-        return;
+        reportArgError(response, args);
+        return false;
     }
 
     if (peripheralManager.getUART2().reconfigure(baud)) {
         response->printf("UART2 configured: %u baud\n", baud);
     } else {
         response->println("ERROR: Failed to configure UART2");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleUART2Status(ICommandResponse* response) {
+bool CommandParser::handleUART2Status(ICommandResponse* response) {
     auto& uart2 = peripheralManager.getUART2();
 
     response->println("UART2 Status:");
@@ -254,288 +302,235 @@ void CommandParser::handleUART2Status(ICommandResponse* response) {
     uint32_t tx, rx, err;
     uart2.getStatistics(&tx, &rx, &err);
     response->printf("  TX: %u bytes, RX: %u bytes, Errors: %u\n", tx, rx, err);
+    return false;
 }
 
-void CommandParser::handleUART2Write(const String& cmd, ICommandResponse* response) {
-    // UART2 WRITE <text>
-    // "UART2 WRITE " is exactly 12 characters, text starts at position 12
-    String text = cmd.substring(12);
-    text.trim();
-
-    if (text.length() == 0) {
+bool CommandParser::handleUART2Write(CommandArgs& args, ICommandResponse* response) {
+    // UART2 WRITE <text> (rest of the line, original case and spacing)
+    if (args.empty()) {
         response->println("Usage: UART2 WRITE <text>");
-        return;
+        return false;
     }
 
-    text += "\n";
+    char text[MAX_LINE_LENGTH + 2];
+    size_t length = args.copyRest(0, text, sizeof(text) - 1);
+    text[length++] = '\n';  // Add newline
+    text[length] = '\0';
 
-    int written = peripheralManager.getUART2().write(text.c_str());
+    int written = peripheralManager.getUART2().write(text);
     if (written > 0) {
         response->printf("Wrote %d bytes to UART2\n", written);
     } else {
         response->println("ERROR: Failed to write to UART2");
+        return false;
     }
+    return true;
 }
 
 // ============================================================================
 // Buzzer Commands
 // ============================================================================
 
-void CommandParser::handleBuzzerControl(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleBuzzerControl(CommandArgs& args, ICommandResponse* response) {
     // BUZZER <freq> <duty> [ON|OFF] or BUZZER ON/OFF
-    // "BUZZER " is exactly 7 characters (positions 0-6), so params start at position 7
-    int idx = 6;  // Fixed: Position of space after "BUZZER"
-
-    String param = cmd.substring(idx + 1);
-    param.trim();
 
     // Check if it's just ON/OFF toggle
-    String paramUpper = param;
-    paramUpper.toUpperCase();
-
-    if (paramUpper == "ON") {
+    if (args.is(0, "ON") && args.count() == 1) {
         peripheralManager.getBuzzer().enable(true);
         response->println("Buzzer enabled");
-        return;
-    } else if (paramUpper == "OFF") {
+        return true;
+    } else if (args.is(0, "OFF") && args.count() == 1) {
         peripheralManager.getBuzzer().enable(false);
         response->println("Buzzer disabled");
-        return;
+        return true;
     }
 
     // Parse frequency and duty with optional ON/OFF
-    int idx2 = param.indexOf(' ');
-    if (idx2 == -1) {
+    if (args.count() < 2) {
         response->println("Usage: BUZZER <freq> <duty> [ON|OFF]");
-        return;
+        return false;
     }
 
-    uint32_t freq = param.substring(0, idx2).toInt();
-
-    // Check if there's an optional ON/OFF parameter
-    String dutyStr = param.substring(idx2 + 1);
-    dutyStr.trim();
-    int idx3 = dutyStr.indexOf(' ');
-
-    float duty;
-    bool enableBuzzer = true;  // Default to enabled
-
-    if (idx3 != -1) {
-        // Has ON/OFF parameter
-        duty = dutyStr.substring(0, idx3).toFloat();
-        String enableStr = dutyStr.substring(idx3 + 1);
-        enableStr.trim();
-        enableStr.toUpperCase();
-
-        if (enableStr == "ON") {
-            enableBuzzer = true;
-        } else if (enableStr == "OFF") {
-            enableBuzzer = false;
-        }
-    } else {
-        // No ON/OFF parameter, just duty
-        duty = dutyStr.toFloat();
+    uint32_t freq = 0;
+    float duty = 0.0f;
+    if (!args.getUInt(0, 0, UINT32_MAX, freq) || !args.getFloat(1, 0.0f, 100.0f, duty)) {
+        reportArgError(response, args);
+        return false;
     }
 
+    // Optional ON/OFF parameter, default to enabled
+    bool enableBuzzer = !args.is(2, "OFF");
+
     if (peripheralManager.getBuzzer().setFrequency(freq) &&
         peripheralManager.getBuzzer().setDuty(duty)) {
         peripheralManager.getBuzzer().enable(enableBuzzer);
         response->printf("Buzzer: %u Hz, %.1f%% duty, %s\n", freq, duty, enableBuzzer ? "enabled" : "disabled");
     } else {
         response->println("ERROR: Invalid buzzer parameters");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleBuzzerBeep(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleBuzzerBeep(CommandArgs& args, ICommandResponse* response) {
     // BUZZER BEEP <freq> <duration_ms>
-    int idx1 = cmd.indexOf(' ', 12);  // After "BUZZER BEEP "
-    if (idx1 == -1) {
+    if (args.count() != 2) {
         response->println("Usage: BUZZER BEEP <freq> <duration_ms>");
-        return;
+        return false;
     }
 
-    int idx2 = cmd.indexOf(' ', idx1 + 1);
-    if (idx2 == -1) {
-        response->println("Usage: BUZZER BEEP <freq> <duration_ms>");
-        return;
+    uint32_t freq = 0;
+    uint32_t duration = 0;
+    if (!args.getUInt(0, 0, UINT32_MAX, freq) || !args.getUInt(1, 0, UINT32_MAX, duration)) {
+        reportArgError(response, args);
+        return false;
     }
 
-    uint32_t freq = cmd.substring(idx1 + 1, idx2).toInt();
-    uint32_t duration = cmd.substring(idx2 + 1).toInt();
-
     peripheralManager.getBuzzer().beep(freq, duration);
     response->printf("Beep: %u Hz for %u ms\n", freq, duration);
+    return true;
 }
 
 // ============================================================================
 // LED PWM Commands
 // ============================================================================
 
-void CommandParser::handleLEDPWM(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleLEDPWM(CommandArgs& args, ICommandResponse* response) {
     // LED_PWM <freq> <brightness> [ON|OFF] or LED_PWM ON/OFF
-    // "LED_PWM " is exactly 8 characters (positions 0-7), so params start at position 8
-    int idx = 7;  // Fixed: Position of space after "LED_PWM"
-
-    String param = cmd.substring(idx + 1);
-    param.trim();
 
     // Check if it's just ON/OFF toggle
-    String paramUpper = param;
-    paramUpper.toUpperCase();
-
-    if (paramUpper == "ON") {
+    if (args.is(0, "ON") && args.count() == 1) {
         peripheralManager.getLEDPWM().enable(true);
         response->println("LED PWM enabled");
-        return;
-    } else if (paramUpper == "OFF") {
+        return true;
+    } else if (args.is(0, "OFF") && args.count() == 1) {
         peripheralManager.getLEDPWM().enable(false);
         response->println("LED PWM disabled");
-        return;
+        return true;
     }
 
     // Parse frequency and brightness with optional ON/OFF
-    int idx2 = param.indexOf(' ');
-    if (idx2 == -1) {
+    if (args.count() < 2) {
         response->println("Usage: LED_PWM <freq> <brightness> [ON|OFF]");
-        return;
+        return false;
     }
 
-    uint32_t freq = param.substring(0, idx2).toInt();
-
-    // Check if there's an optional ON/OFF parameter
-    String brightnessStr = param.substring(idx2 + 1);
-    brightnessStr.trim();
-    int idx3 = brightnessStr.indexOf(' ');
-
-    float brightness;
-    bool enableLED = true;  // Default to enabled
-
-    if (idx3 != -1) {
-        // Has ON/OFF parameter
-        brightness = brightnessStr.substring(0, idx3).toFloat();
-        String enableStr = brightnessStr.substring(idx3 + 1);
-        enableStr.trim();
-        enableStr.toUpperCase();
-
-        if (enableStr == "ON") {
-            enableLED = true;
-        } else if (enableStr == "OFF") {
-            enableLED = false;
-        }
-    } else {
-        // No ON/OFF parameter, just brightness
-        brightness = brightnessStr.toFloat();
+    uint32_t freq = 0;
+    float brightness = 0.0f;
+    if (!args.getUInt(0, 0, UINT32_MAX, freq) || !args.getFloat(1, 0.0f, 100.0f, brightness)) {
+        reportArgError(response, args);
+        return false;
     }
 
+    // Optional ON/OFF parameter, default to enabled
+    bool enableLED = !args.is(2, "OFF");
+
     if (peripheralManager.getLEDPWM().setFrequency(freq) &&
         peripheralManager.getLEDPWM().setBrightness(brightness)) {
         peripheralManager.getLEDPWM().enable(enableLED);
         response->printf("LED PWM: %u Hz, %.1f%% brightness, %s\n", freq, brightness, enableLED ? "enabled" : "disabled");
     } else {
         response->println("ERROR: Invalid LED PWM parameters");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handleLEDFade(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleLEDFade(CommandArgs& args, ICommandResponse* response) {
     // LED_PWM FADE <brightness> <time_ms>
-    int idx1 = cmd.indexOf(' ', 13);  // After "LED_PWM FADE "
-    if (idx1 == -1) {
+    if (args.count() != 2) {
         response->println("Usage: LED_PWM FADE <brightness> <time_ms>");
-        return;
+        return false;
     }
 
-    int idx2 = cmd.indexOf(' ', idx1 + 1);
-    if (idx2 == -1) {
-        response->println("Usage: LED_PWM FADE <brightness> <time_ms>");
-        return;
+    float brightness = 0.0f;
+    uint32_t time = 0;
+    if (!args.getFloat(0, 0.0f, 100.0f, brightness) || !args.getUInt(1, 0, UINT32_MAX, time)) {
+        reportArgError(response, args);
+        return false;
     }
 
-    float brightness = cmd.substring(idx1 + 1, idx2).toFloat();
-    uint32_t time = cmd.substring(idx2 + 1).toInt();
-
     peripheralManager.getLEDPWM().fadeTo(brightness, time);
     response->printf("Fading LED to %.1f%% over %u ms\n", brightness, time);
+    return true;
 }
 
 // ============================================================================
 // Relay Commands
 // ============================================================================
 
-void CommandParser::handleRelayControl(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleRelayControl(CommandArgs& args, ICommandResponse* response) {
     // RELAY ON/OFF/TOGGLE/PULSE <duration_ms>
-    int idx = cmd.indexOf(' ', 6);  // After "RELAY "
-    if (idx == -1) {
+    if (args.empty()) {
         response->println("Usage: RELAY ON | RELAY OFF | RELAY TOGGLE | RELAY PULSE <ms>");
-        return;
+        return false;
     }
 
-    String param = cmd.substring(idx + 1);
-    param.trim();
-    param.toUpperCase();
-
-    if (param == "ON") {
+    if (args.is(0, "ON")) {
         peripheralManager.getRelay().turnOn();
         response->println("Relay ON");
-    } else if (param == "OFF") {
+    } else if (args.is(0, "OFF")) {
         peripheralManager.getRelay().turnOff();
         response->println("Relay OFF");
-    } else if (param == "TOGGLE") {
+    } else if (args.is(0, "TOGGLE")) {
         peripheralManager.getRelay().toggle();
         response->printf("Relay toggled: %s\n",
                         peripheralManager.getRelay().getState() ? "ON" : "OFF");
-    } else if (param.startsWith("PULSE")) {
-        int idx2 = param.indexOf(' ');
-        if (idx2 == -1) {
+    } else if (args.is(0, "PULSE")) {
+        uint32_t duration = 0;
+        if (!args.has(1)) {
             response->println("Usage: RELAY PULSE <duration_ms>");
-            return;
+            return false;
+        }
+        if (!args.getUInt(1, 0, UINT32_MAX, duration)) {
+            reportArgError(response, args);
+            return false;
         }
-        uint32_t duration = param.substring(idx2 + 1).toInt();
         peripheralManager.getRelay().pulse(duration);
         response->printf("Relay pulsed for %u ms\n", duration);
     } else {
         response->println("ERROR: Invalid parameter. Use ON, OFF, TOGGLE, or PULSE <ms>");
+        return false;
     }
+    return true;
 }
 
 // ============================================================================
 // GPIO Commands
 // ============================================================================
 
-void CommandParser::handleGPIOControl(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleGPIOControl(CommandArgs& args, ICommandResponse* response) {
     // GPIO HIGH/LOW/TOGGLE/STATUS
-    int idx = cmd.indexOf(' ', 5);  // After "GPIO "
-    if (idx == -1) {
+    if (args.empty()) {
         response->println("Usage: GPIO HIGH | GPIO LOW | GPIO TOGGLE | GPIO STATUS");
-        return;
+        return false;
     }
 
-    String param = cmd.substring(idx + 1);
-    param.trim();
-    param.toUpperCase();
-
-    if (param == "HIGH") {
+    if (args.is(0, "HIGH")) {
         peripheralManager.getGPIO().setHigh();
         response->println("GPIO set HIGH");
-    } else if (param == "LOW") {
+    } else if (args.is(0, "LOW")) {
         peripheralManager.getGPIO().setLow();
         response->println("GPIO set LOW");
-    } else if (param == "TOGGLE") {
+    } else if (args.is(0, "TOGGLE")) {
         peripheralManager.getGPIO().toggle();
         response->printf("GPIO toggled: %s\n",
                         peripheralManager.getGPIO().getState() ? "HIGH" : "LOW");
-    } else if (param == "STATUS") {
+    } else if (args.is(0, "STATUS")) {
         response->printf("GPIO: %s\n",
                         peripheralManager.getGPIO().getState() ? "HIGH" : "LOW");
     } else {
         response->println("ERROR: Invalid parameter. Use HIGH, LOW, TOGGLE, or STATUS");
+        return false;
     }
+    return true;
 }
 
 // ============================================================================
 // Keys Commands
 // ============================================================================
 
-void CommandParser::handleKeysStatus(ICommandResponse* response) {
+bool CommandParser::handleKeysStatus(ICommandResponse* response) {
     auto& keys = peripheralManager.getKeys();
 
     response->println("User Keys Status:");
@@ -548,57 +543,53 @@ void CommandParser::handleKeysStatus(ICommandResponse* response) {
                     peripheralManager.isKeyControlAdjustingDuty() ? "Duty" : "Frequency");
     response->printf("  Duty Step: %.2f%%\n", peripheralManager.getDutyStep());
     response->printf("  Frequency Step: %u Hz\n", peripheralManager.getFrequencyStep());
+    return true;
 }
 
-void CommandParser::handleKeysConfig(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleKeysConfig(CommandArgs& args, ICommandResponse* response) {
     // KEYS CONFIG <duty_step> <freq_step>
-    int idx1 = cmd.indexOf(' ', 12);  // After "KEYS CONFIG "
-    if (idx1 == -1) {
+    if (args.count() != 2) {
         response->println("Usage: KEYS CONFIG <duty_step> <freq_step>");
-        return;
+        return false;
     }
 
-    int idx2 = cmd.indexOf(' ', idx1 + 1);
-    if (idx2 == -1) {
-        response->println("Usage: KEYS CONFIG <duty_step> <freq_step>");
-        return;
+    float dutyStep = 0.0f;
+    uint32_t freqStep = 0;
+    if (!args.getFloat(0, 0.0f, 100.0f, dutyStep) || !args.getUInt(1, 0, UINT32_MAX, freqStep)) {
+        reportArgError(response, args);
+        return false;
     }
 
-    float dutyStep = cmd.substring(idx1 + 1, idx2).toFloat();
-    uint32_t freqStep = cmd.substring(idx2 + 1).toInt();
-
     peripheralManager.setStepSizes(dutyStep, freqStep);
     response->printf("Key step sizes: Duty=%.2f%%, Freq=%u Hz\n", dutyStep, freqStep);
+    return true;
 }
 
-void CommandParser::handleKeysMode(const String& cmd, ICommandResponse* response) {
+bool CommandParser::handleKeysMode(CommandArgs& args, ICommandResponse* response) {
     // KEYS MODE <DUTY|FREQ>
-    int idx = cmd.lastIndexOf(' ');  // Find last space to get the mode parameter
-    if (idx == -1) {
+    if (args.count() != 1) {
         response->println("Usage: KEYS MODE <DUTY|FREQ>");
-        return;
+        return false;
     }
 
-    String mode = cmd.substring(idx + 1);
-    mode.trim();
-    mode.toUpperCase();
-
-    if (mode == "DUTY") {
+    if (args.is(0, "DUTY")) {
         peripheralManager.setKeyControlMode(true);
         response->println("Key control mode: Duty adjustment");
-    } else if (mode == "FREQ" || mode == "FREQUENCY") {
+    } else if (args.is(0, "FREQ") || args.is(0, "FREQUENCY")) {
         peripheralManager.setKeyControlMode(false);
         response->println("Key control mode: Frequency adjustment");
     } else {
         response->println("ERROR: Invalid mode. Use DUTY or FREQ");
+        return false;
     }
+    return true;
 }
 
 // ============================================================================
 // Peripheral Status Commands
 // ============================================================================
 
-void CommandParser::handlePeripheralStatus(ICommandResponse* response) {
+bool CommandParser::handlePeripheralStatus(ICommandResponse* response) {
     response->println("Peripheral Status Summary:");
     response->printf("  UART1: %s\n", peripheralManager.getUART1().getModeName());
     response->printf("  UART2: %u baud\n", peripheralManager.getUART2().getBaudRate());
@@ -614,26 +605,30 @@ void CommandParser::handlePeripheralStatus(ICommandResponse* response) {
                     peripheralManager.getGPIO().getState() ? "HIGH" : "LOW");
     response->printf("  Keys: %s\n",
                     peripheralManager.isKeyControlEnabled() ? "Enabled" : "Disabled");
+    return true;
 }
 
-void CommandParser::handlePeripheralStats(ICommandResponse* response) {
+bool CommandParser::handlePeripheralStats(ICommandResponse* response) {
     String stats = peripheralManager.getStatistics();
     response->print(stats.c_str());
+    return true;
 }
 
 // ============================================================================
 // Peripheral Settings Commands
 // ============================================================================
 
-void CommandParser::handlePeripheralSave(ICommandResponse* response) {
+bool CommandParser::handlePeripheralSave(ICommandResponse* response) {
     if (peripheralManager.saveSettings()) {
         response->println("OK: Peripheral settings saved to NVS");
     } else {
         response->println("ERROR: Failed to save peripheral settings");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handlePeripheralLoad(ICommandResponse* response) {
+bool CommandParser::handlePeripheralLoad(ICommandResponse* response) {
     if (peripheralManager.loadSettings()) {
         response->println("OK: Peripheral settings loaded from NVS");
         if (peripheralManager.applySettings()) {
@@ -643,11 +638,144 @@ void CommandParser::handlePeripheralLoad(ICommandResponse* response) {
         }
     } else {
         response->println("ERROR: Failed to load peripheral settings");
+        return false;
     }
+    return true;
 }
 
-void CommandParser::handlePeripheralReset(ICommandResponse* response) {
+bool CommandParser::handlePeripheralReset(ICommandResponse* response) {
     peripheralManager.resetSettings();
     response->println("OK: Peripheral settings reset to defaults");
     response->println("INFO: Use 'PERIPHERAL LOAD' to apply default settings");
+    return true;
+}
+
+// ============================================================================
+// Trace Commands (UART1/PWM binary trace ring)
+// ============================================================================
+
+bool CommandParser::handleTrace(CommandArgs& args, ICommandResponse* response) {
+    // TRACE [STATUS] | TRACE LEVEL <0-3> | TRACE CLEAR | TRACE DUMP [count]
+    if (args.empty() || args.is(0, "STATUS")) {
+        response->println("Trace Ring Status:");
+        response->printf("  Runtime level: %u (compile-time max: %u)\n",
+                         uart1Trace.getLevel(), UART1_TRACE_LEVEL);
+        response->printf("  Records written: %u\n", uart1Trace.written());
+        response->printf("  Records held: %u / %u\n",
+                         uart1Trace.written() - uart1Trace.oldest(), TraceRing::CAPACITY);
+        response->println("  Levels: 0=OFF 1=EVENT 2=REGISTER 3=VERBOSE");
+        return true;
+    }
+
+    if (args.is(0, "LEVEL")) {
+        uint32_t level = 0;
+        if (!args.getUInt(1, TRACE_LEVEL_OFF, TRACE_LEVEL_VERBOSE, level)) {
+            response->println("ERROR: Trace level must be 0-3");
+            reportArgError(response, args);
+            return false;
+        }
+        uart1Trace.setLevel((uint8_t)level);
+        response->printf("Trace level set to %u", level);
+        if (level > UART1_TRACE_LEVEL) {
+            response->printf(" (compiled up to %u only)", UART1_TRACE_LEVEL);
+        }
+        response->println("");
+        return true;
+    }
+
+    if (args.is(0, "CLEAR")) {
+        uart1Trace.clear();
+        response->println("Trace ring cleared");
+        return true;
+    }
+
+    if (args.is(0, "DUMP")) {
+        uint32_t count = 64;
+        if (args.has(1) && !args.getUInt(1, 1, TraceRing::CAPACITY, count)) {
+            response->printf("ERROR: Count must be 1-%u\n", TraceRing::CAPACITY);
+            reportArgError(response, args);
+            return false;
+        }
+
+        // Start count records before the newest one
+        uint32_t newest = uart1Trace.written();
+        uint32_t cursor = uart1Trace.oldest();
+        if (newest - cursor > count) {
+            cursor = newest - count;
+        }
+
+        response->printf("Trace dump (seq %u..%u):\n", cursor, newest);
+        response->println("  time_us     dt_us  core event          details");
+
+        TraceRecord rec;
+        uint32_t lastTs = 0;
+        bool first = true;
+        uint32_t printed = 0;
+
+        while (printed < count && uart1Trace.read(cursor, rec)) {
+            uint32_t dt = first ? 0 : rec.timestampUs - lastTs;
+            lastTs = rec.timestampUs;
+            first = false;
+
+            response->printf("  %10u %6u  %u    %-14s ", rec.timestampUs, dt, rec.core,
+                             TraceRing::eventName(rec.event));
+
+            switch (rec.event) {
+                case TRACE_PWM_PERIOD:
+                    response->printf("cfg0 0x%08X -> 0x%08X period=%u\n", rec.a, rec.b, rec.c);
+                    break;
+                case TRACE_PWM_PRESCALER:
+                    response->printf("cfg0 0x%08X -> 0x%08X prescaler=%u\n", rec.a, rec.b, rec.c);
+                    break;
+                case TRACE_PWM_DUTY:
+                    response->printf("duty=%u.%02u%% period=%u\n", rec.a / 100, rec.a % 100, rec.b);
+                    break;
+                case TRACE_PWM_FREQ:
+                    response->printf("freq=%u Hz prescaler=%u period=%u\n", rec.a, rec.b, rec.c);
+                    break;
+                case TRACE_PWM_ENABLE:
+                    response->printf("%s\n", rec.a ? "enabled" : "disabled");
+                    break;
+                case TRACE_PWM_ERROR:
+                    response->printf("err=0x%X (%s) freq=%u period=%u\n", rec.a,
+                                     esp_err_to_name((esp_err_t)rec.a), rec.b, rec.c);
+                    break;
+                case TRACE_RAMP_START:
+                    response->printf("target %u Hz %u.%02u%% in %u ms\n", rec.a,
+                                     rec.b / 100, rec.b % 100, rec.c);
+                    break;
+                case TRACE_RAMP_DONE:
+                    response->printf("%u Hz %u.%02u%% after %u steps\n", rec.a,
+                                     rec.b / 100, rec.b % 100, rec.c);
+                    break;
+                case TRACE_RPM_METHOD:
+                    response->printf("%s at %u Hz (switch #%u)\n",
+                                     rec.a ? "PCNT counter" : "MCPWM capture", rec.b, rec.c);
+                    break;
+                case TRACE_FAULT:
+                    if (rec.a == UART1Mux::FAULT_NONE) {
+                        response->println("cleared");
+                    } else {
+                        response->printf("%s period=%u ticks reaction=%u us\n",
+                                         UART1Mux::getFaultName(rec.a), rec.b, rec.c);
+                    }
+                    break;
+                case TRACE_TACH_EDGE:
+                    response->printf("ticks=%llu period=%u (%.1f us)\n",
+                                     ((unsigned long long)rec.b << 32) | rec.a, rec.c,
+                                     rec.c * 1000000.0f / UART1Mux::CAPTURE_CLK_HZ);
+                    break;
+                default:
+                    response->printf("a=0x%08X b=0x%08X c=0x%08X\n", rec.a, rec.b, rec.c);
+                    break;
+            }
+            printed++;
+        }
+
+        response->printf("%u record(s)\n", printed);
+        return true;
+    }
+
+    response->println("Usage: TRACE [STATUS] | TRACE LEVEL <0-3> | TRACE CLEAR | TRACE DUMP [count]");
+    return false;
 }
@@ -2,7 +2,9 @@
 
 
 
-PeripheralManager::PeripheralManager() {
+PeripheralManager::PeripheralManager()
+    : rpmController(uart1), fans(uart1), sweep(uart1, fans, rpmController),
+      stepAnalyzer(uart1, rpmController, sweep) {
 }
 
 bool PeripheralManager::begin() {
@@ -12,7 +14,44 @@ bool PeripheralManager::begin() {
     // Initialize UART1 (start in disabled mode)
     Serial.print("[PeripheralManager] UART1... ");
     uart1.disable();
-    Serial.println("OK (disabled)");
+    // UART driver installed once and parked, so mode switches only re-route pins
+    if (uart1.prepareDrivers()) {
+        Serial.println("OK (disabled, UART driver parked)");
+    } else {
+        Serial.println("OK (disabled, UART driver installed on first use)");
+    }
+
+    // Initialize closed-loop RPM controller (timer created, loop idle)
+    Serial.print("[PeripheralManager] RPM Controller... ");
+    if (!rpmController.begin()) {
+        Serial.println("FAILED");
+        return false;
+    }
+    Serial.println("OK (idle)");
+
+    // Initialize additional fan channels (count from NVS, default UART1 only)
+    Serial.print("[PeripheralManager] Fan Channels... ");
+    if (!fans.begin()) {
+        Serial.println("PARTIAL");
+    } else {
+        Serial.printf("OK (%u)\n", fans.getChannelCount());
+    }
+
+    // Characterization sweep (table allocated in PSRAM, timer idle)
+    Serial.print("[PeripheralManager] Fan Sweep... ");
+    if (!sweep.begin()) {
+        Serial.println("FAILED");
+    } else {
+        Serial.println("OK (idle)");
+    }
+
+    // Step-response analyzer (edge buffer pre-allocated, timer idle)
+    Serial.print("[PeripheralManager] Step Analyzer... ");
+    if (!stepAnalyzer.begin()) {
+        Serial.println("FAILED");
+    } else {
+        Serial.println("OK (idle)");
+    }
 
     // Initialize UART2
     Serial.print("[PeripheralManager] UART2... ");
@@ -90,11 +129,14 @@ void PeripheralManager::update() {
     // Update user keys (debouncing and event detection)
     keys.update();
 
-    // Update UART1 RPM measurement if in PWM/RPM mode
-    if (uart1.getMode() == UART1Mux::MODE_PWM_RPM) {
+    // Update UART1 RPM measurement if in PWM/RPM mode (polling only)
+    if (uart1.getMode() == UART1Mux::MODE_PWM_RPM && !uart1.isRPMEventMode()) {
         uart1.updateRPMFrequency();
     }
 
+    // Update additional fan channel tach readings
+    fans.update();
+
     // Handle key events (motor control)
     if (keyControlEnabled) {
         handleKeyEvents();
@@ -3,6 +3,10 @@
 
 #include <Arduino.h>
 #include "UART1Mux.h"
+#include "RPMController.h"
+#include "FanManager.h"
+#include "FanSweep.h"
+#include "StepAnalyzer.h"
 #include "UART2Manager.h"
 #include "UserKeys.h"
 #include "BuzzerControl.h"
@@ -17,6 +21,9 @@
  *
  * Manages all peripherals in the system:
  * - UART1 (multiplexable between UART and PWM/RPM)
+ * - Additional fan channels (PWM out + tach in, see FanManager)
+ * - Fan characterization sweep (duty/frequency → RPM table)
+ * - Step-response analyzer (spin-up, overshoot, settling on UART1)
  * - UART2 (standard UART)
  * - User Keys (3 buttons with debouncing)
  * - Buzzer PWM control
@@ -67,6 +74,10 @@ public:
     // ========================================================================
 
     UART1Mux& getUART1() { return uart1; }
+    RPMController& getRPMController() { return rpmController; }
+    FanManager& getFans() { return fans; }
+    FanSweep& getSweep() { return sweep; }
+    StepAnalyzer& getStepAnalyzer() { return stepAnalyzer; }
     UART2Manager& getUART2() { return uart2; }
     UserKeys& getKeys() { return keys; }
     BuzzerControl& getBuzzer() { return buzzer; }
@@ -175,6 +186,10 @@ public:
 private:
     // Peripheral instances
     UART1Mux uart1;
+    RPMController rpmController;  // Closed-loop speed control on uart1 (must follow uart1)
+    FanManager fans;              // Fan channels, channel 0 = uart1 (must follow uart1)
+    FanSweep sweep;               // Characterization sweep (must follow fans/rpmController)
+    StepAnalyzer stepAnalyzer;    // Step response on uart1 (must follow sweep)
     UART2Manager uart2;
     UserKeys keys;
     BuzzerControl buzzer;
@@ -35,6 +35,23 @@
 // Motor control functions (previously on GPIO 10/11) are now on GPIO 17/18
 #define PIN_UART1_TX                17  // UART1 TX / MCPWM PWM output (10Hz-500kHz)
 #define PIN_UART1_RX                18  // UART1 RX / MCPWM Capture (RPM measurement, 1Hz-500kHz)
+#define PIN_UART1_PWM_B             8   // Complementary output (MCPWM1 operator 0 B, half-bridge low side)
+
+// ============================================================================
+// ADDITIONAL FAN CHANNELS (FanManager, channel 0 is UART1 above)
+// ============================================================================
+// Each channel is one PWM output + one tach input. Only the first
+// FAN COUNT channels claim their pins.
+#define PIN_FAN1_PWM                10  // MCPWM1 timer 1 (former motor PWM pin)
+#define PIN_FAN1_TACH               11  // MCPWM1 CAP0 (former motor tach pin)
+#define PIN_FAN2_PWM                4   // MCPWM1 timer 2
+#define PIN_FAN2_TACH               5   // MCPWM1 CAP1
+#define PIN_FAN3_PWM                6   // MCPWM0 timer 0
+#define PIN_FAN3_TACH               7   // MCPWM1 CAP2
+#define PIN_FAN4_PWM                15  // MCPWM0 timer 1
+#define PIN_FAN4_TACH               16  // MCPWM0 CAP0
+#define PIN_FAN5_PWM                38  // MCPWM0 timer 2
+#define PIN_FAN5_TACH               39  // MCPWM0 CAP2
 
 // UART2 - Standard UART (avoids GPIO36/37)
 #define PIN_UART2_TX                43  // UART2 TX (2400-1.5Mbps)
@@ -87,6 +104,24 @@
 #define MCPWM_UNIT_UART1_RPM        MCPWM_UNIT_0
 #define MCPWM_CAP_UART1_RPM         MCPWM_SELECT_CAP1
 
+// MCPWM for additional fan channels: the remaining 5 timers and 5 capture
+// channels (captures fill MCPWM1 first, MCPWM0 CAP1 belongs to UART1).
+// FAN4/FAN5 share MCPWM0's capture interrupt register with UART1: every
+// capture enable/disable/mask goes through MCPWMCapture.
+#define FAN_CHANNEL_MAX             6   // UART1 + 5 FanChannel instances
+
+// Hardware timer stepping the UART1 duty dither (sigma-delta, IRAM ISR)
+#define TIMER_GROUP_UART1_DITHER    TIMER_GROUP_1
+#define TIMER_IDX_UART1_DITHER      TIMER_0
+
+// Hardware timer for the UART1 stall watchdog (one-shot alarm, IRAM ISR)
+#define TIMER_GROUP_UART1_FAULT     TIMER_GROUP_1
+#define TIMER_IDX_UART1_FAULT       TIMER_1
+
+// PCNT for UART1 high-frequency RPM measurement (gated counter on the same pin)
+#define PCNT_UNIT_UART1_RPM         PCNT_UNIT_0
+#define PCNT_CHANNEL_UART1_RPM      PCNT_CHANNEL_0
+
 // UART Numbers
 #define UART_NUM_UART1              UART_NUM_1
 #define UART_NUM_UART2              UART_NUM_2
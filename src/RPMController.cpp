@@ -0,0 +1,375 @@
+#include "RPMController.h"
+#include <Preferences.h>
+#include <math.h>
+
+// NVS namespace for controller settings persistence
+static const char* NVS_NAMESPACE = "rpm_pid";
+
+RPMController::RPMController(UART1Mux& uart1) : uart1(uart1) {
+}
+
+RPMController::~RPMController() {
+    if (timer) {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+        timer = nullptr;
+    }
+}
+
+bool RPMController::begin() {
+    if (timer) {
+        return true;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = timerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "rpm_pid";
+
+    esp_err_t err = esp_timer_create(&args, &timer);
+    if (err != ESP_OK) {
+        Serial.printf("[PID] Timer create failed: %s\n", esp_err_to_name(err));
+        timer = nullptr;
+        return false;
+    }
+
+    loadSettings();
+    return true;
+}
+
+// ============================================================================
+// Configuration
+// ============================================================================
+
+bool RPMController::setEnabled(bool enable) {
+    if (!timer) {
+        return false;
+    }
+
+    if (!enable) {
+        enabled = false;
+        esp_timer_stop(timer);
+        Serial.println("[PID] Closed-loop control disabled");
+        return true;
+    }
+
+    if (uart1.getMode() != UART1Mux::MODE_PWM_RPM) {
+        Serial.println("[PID] Cannot enable: UART1 not in PWM/RPM mode");
+        return false;
+    }
+
+    // The loop owns the duty from now on
+    uart1.stopRamp();
+
+    // Bumpless start: preload integrator so the first output equals current duty
+    float measurement = uart1.getCalculatedRPM();
+    taskENTER_CRITICAL(&lock);
+    float ff = evaluateFeedForwardLocked(setpoint);
+    integral = uart1.getPWMDuty() - ff;
+    lastMeasurement = measurement;
+    lastOutput = uart1.getPWMDuty();
+    firstCycle = true;
+    loopCount = 0;
+    maxLoopUs = 0;
+    taskEXIT_CRITICAL(&lock);
+
+    enabled = true;
+    if (!restartTimer()) {
+        enabled = false;
+        return false;
+    }
+
+    Serial.printf("[PID] Closed-loop control enabled: setpoint=%.1f RPM, %u Hz\n", setpoint, rateHz);
+    return true;
+}
+
+bool RPMController::setSetpoint(float rpm) {
+    if (rpm < 0.0f || rpm > 500000.0f) {
+        return false;
+    }
+    taskENTER_CRITICAL(&lock);
+    setpoint = rpm;
+    taskEXIT_CRITICAL(&lock);
+    return true;
+}
+
+bool RPMController::setGains(float newKp, float newKi, float newKd) {
+    if (newKp < 0.0f || newKi < 0.0f || newKd < 0.0f) {
+        return false;
+    }
+    taskENTER_CRITICAL(&lock);
+    kp = newKp;
+    ki = newKi;
+    kd = newKd;
+    taskEXIT_CRITICAL(&lock);
+    return true;
+}
+
+bool RPMController::setOutputLimits(float minDuty, float maxDuty) {
+    if (minDuty < 0.0f || maxDuty > 100.0f || minDuty >= maxDuty) {
+        return false;
+    }
+    taskENTER_CRITICAL(&lock);
+    outMin = minDuty;
+    outMax = maxDuty;
+    taskEXIT_CRITICAL(&lock);
+    return true;
+}
+
+bool RPMController::setRate(uint32_t hz) {
+    if (hz < 50 || hz > 5000) {
+        return false;
+    }
+    rateHz = hz;
+    return enabled ? restartTimer() : true;
+}
+
+bool RPMController::restartTimer() {
+    esp_timer_stop(timer);  // Ignore error when not running
+    esp_err_t err = esp_timer_start_periodic(timer, 1000000ULL / rateHz);
+    if (err != ESP_OK) {
+        Serial.printf("[PID] Timer start failed: %s\n", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Feed-Forward Table
+// ============================================================================
+
+bool RPMController::addFeedForwardPoint(float rpm, float duty) {
+    if (rpm < 0.0f || duty < 0.0f || duty > 100.0f) {
+        return false;
+    }
+
+    taskENTER_CRITICAL(&lock);
+
+    // Replace existing point at the same speed
+    for (uint32_t i = 0; i < ffCount; i++) {
+        if (ffTable[i].rpm == rpm) {
+            ffTable[i].duty = duty;
+            taskEXIT_CRITICAL(&lock);
+            return true;
+        }
+    }
+
+    if (ffCount >= FF_TABLE_SIZE) {
+        taskEXIT_CRITICAL(&lock);
+        return false;
+    }
+
+    // Insert keeping the table sorted by rpm
+    uint32_t pos = ffCount;
+    while (pos > 0 && ffTable[pos - 1].rpm > rpm) {
+        ffTable[pos] = ffTable[pos - 1];
+        pos--;
+    }
+    ffTable[pos] = {rpm, duty};
+    ffCount++;
+
+    taskEXIT_CRITICAL(&lock);
+    return true;
+}
+
+bool RPMController::setFeedForwardTable(const FFPoint* points, uint32_t count) {
+    if (count > FF_TABLE_SIZE || (count > 0 && points == nullptr)) {
+        return false;
+    }
+    clearFeedForward();
+    for (uint32_t i = 0; i < count; i++) {
+        if (!addFeedForwardPoint(points[i].rpm, points[i].duty)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RPMController::clearFeedForward() {
+    taskENTER_CRITICAL(&lock);
+    ffCount = 0;
+    taskEXIT_CRITICAL(&lock);
+}
+
+RPMController::FFPoint RPMController::getFeedForwardPoint(uint32_t index) const {
+    if (index >= ffCount) {
+        return {0.0f, 0.0f};
+    }
+    return ffTable[index];
+}
+
+float RPMController::evaluateFeedForward(float rpm) const {
+    taskENTER_CRITICAL(&lock);
+    float duty = evaluateFeedForwardLocked(rpm);
+    taskEXIT_CRITICAL(&lock);
+    return duty;
+}
+
+float RPMController::evaluateFeedForwardLocked(float rpm) const {
+    if (ffCount == 0) {
+        return 0.0f;
+    }
+    if (rpm <= ffTable[0].rpm) {
+        return ffTable[0].duty;
+    }
+    if (rpm >= ffTable[ffCount - 1].rpm) {
+        return ffTable[ffCount - 1].duty;
+    }
+
+    for (uint32_t i = 1; i < ffCount; i++) {
+        if (rpm <= ffTable[i].rpm) {
+            const FFPoint& a = ffTable[i - 1];
+            const FFPoint& b = ffTable[i];
+            float t = (rpm - a.rpm) / (b.rpm - a.rpm);
+            return a.duty + t * (b.duty - a.duty);
+        }
+    }
+    return ffTable[ffCount - 1].duty;
+}
+
+// ============================================================================
+// Control Loop
+// ============================================================================
+
+void RPMController::timerCallback(void* arg) {
+    static_cast<RPMController*>(arg)->controlStep();
+}
+
+void RPMController::controlStep() {
+    if (!enabled) {
+        return;
+    }
+
+    // Hold output while the PWM channel is not running or is forced safe
+    if (uart1.getMode() != UART1Mux::MODE_PWM_RPM || !uart1.isPWMEnabled() ||
+        uart1.isFaultLatched()) {
+        return;
+    }
+
+    int64_t startUs = esp_timer_get_time();
+
+    // Fresh measurement when no event-driven task is publishing one
+    if (!uart1.isRPMEventMode()) {
+        uart1.updateRPMFrequency();
+    }
+    float measurement = uart1.getCalculatedRPM();
+
+    taskENTER_CRITICAL(&lock);
+
+    float dt = 1.0f / (float)rateHz;
+    float error = setpoint - measurement;
+    float ff = evaluateFeedForwardLocked(setpoint);
+
+    // Derivative on measurement avoids a kick on setpoint changes
+    float derivative = firstCycle ? 0.0f : (measurement - lastMeasurement) / dt;
+    firstCycle = false;
+
+    integral += ki * error * dt;
+    float unclamped = ff + kp * error + integral - kd * derivative;
+
+    float output = unclamped;
+    if (output > outMax) output = outMax;
+    if (output < outMin) output = outMin;
+
+    // Back-calculation anti-windup: remove the clamped excess from the integrator
+    integral += output - unclamped;
+
+    lastMeasurement = measurement;
+    lastError = error;
+    lastFeedForward = ff;
+    lastSaturated = (output != unclamped);
+    float previousOutput = lastOutput;
+    lastOutput = output;
+
+    taskEXIT_CRITICAL(&lock);
+
+    // Only touch the shadow register when the duty actually changes
+    if (fabsf(output - previousOutput) >= 0.001f) {
+        uart1.setPWMDutyFast(output);
+    }
+
+    uint32_t elapsedUs = (uint32_t)(esp_timer_get_time() - startUs);
+    loopCount++;
+    if (elapsedUs > maxLoopUs) {
+        maxLoopUs = elapsedUs;
+    }
+}
+
+RPMController::Status RPMController::getStatus() {
+    Status status;
+    taskENTER_CRITICAL(&lock);
+    status.enabled = enabled;
+    status.setpoint = setpoint;
+    status.measurement = lastMeasurement;
+    status.error = lastError;
+    status.output = lastOutput;
+    status.feedForward = lastFeedForward;
+    status.integral = integral;
+    status.saturated = lastSaturated;
+    status.loopCount = loopCount;
+    status.maxLoopUs = maxLoopUs;
+    taskEXIT_CRITICAL(&lock);
+    return status;
+}
+
+// ============================================================================
+// Settings Persistence
+// ============================================================================
+
+bool RPMController::saveSettings() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, false)) {
+        Serial.println("[PID] Failed to open NVS for saving");
+        return false;
+    }
+
+    prefs.putFloat("kp", kp);
+    prefs.putFloat("ki", ki);
+    prefs.putFloat("kd", kd);
+    prefs.putFloat("outMin", outMin);
+    prefs.putFloat("outMax", outMax);
+    prefs.putUInt("rate", rateHz);
+    prefs.putUInt("ffCount", ffCount);
+    prefs.putBytes("ffTable", ffTable, sizeof(FFPoint) * ffCount);
+
+    prefs.end();
+    Serial.println("[PID] Settings saved to NVS");
+    return true;
+}
+
+bool RPMController::loadSettings() {
+    Preferences prefs;
+    if (!prefs.begin(NVS_NAMESPACE, true)) {  // Read-only
+        Serial.println("[PID] No saved settings found, using defaults");
+        return false;
+    }
+
+    setGains(prefs.getFloat("kp", 0.01f), prefs.getFloat("ki", 0.05f), prefs.getFloat("kd", 0.0f));
+    if (!setOutputLimits(prefs.getFloat("outMin", 0.0f), prefs.getFloat("outMax", 100.0f))) {
+        setOutputLimits(0.0f, 100.0f);
+    }
+    if (!setRate(prefs.getUInt("rate", DEFAULT_RATE_HZ))) {
+        setRate(DEFAULT_RATE_HZ);
+    }
+
+    FFPoint points[FF_TABLE_SIZE];
+    uint32_t count = prefs.getUInt("ffCount", 0);
+    if (count > FF_TABLE_SIZE ||
+        prefs.getBytes("ffTable", points, sizeof(FFPoint) * count) != sizeof(FFPoint) * count) {
+        count = 0;
+    }
+    setFeedForwardTable(points, count);
+
+    prefs.end();
+    Serial.println("[PID] Settings loaded from NVS");
+    return true;
+}
+
+void RPMController::resetToDefaults() {
+    setGains(0.01f, 0.05f, 0.0f);
+    setOutputLimits(0.0f, 100.0f);
+    setRate(DEFAULT_RATE_HZ);
+    clearFeedForward();
+    Serial.println("[PID] Settings reset to defaults");
+}
@@ -0,0 +1,206 @@
+#ifndef RPM_CONTROLLER_H
+#define RPM_CONTROLLER_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "UART1Mux.h"
+
+/**
+ * @brief Closed-loop RPM controller (PID) for the UART1 PWM output
+ *
+ * Runs a fixed-rate PID loop (default 1 kHz) from an esp_timer callback.
+ * The measurement comes from the UART1 MCPWM capture (getCalculatedRPM())
+ * and the output drives the PWM duty through the TEZ-synchronized shadow
+ * register path (UART1Mux::setPWMDutyFast()), so every correction lands
+ * glitch-free at the next period boundary.
+ *
+ * Control law (output in % duty):
+ *   u = FF(setpoint) + Kp·e + ∫Ki·e·dt − Kd·d(rpm)/dt
+ *
+ * - Feed-forward: piecewise-linear table of (rpm, duty) points
+ * - Derivative on measurement (no kick on setpoint change)
+ * - Output clamped to [outMin, outMax]
+ * - Anti-windup by back-calculation: the integrator is corrected by the
+ *   amount the output was clamped, so it never winds past the limits
+ *
+ * Usage:
+ *   RPMController pid(uart1);
+ *   pid.begin();
+ *   pid.setGains(0.01, 0.05, 0.0);
+ *   pid.setSetpoint(3000);
+ *   pid.setEnabled(true);
+ */
+class RPMController {
+public:
+    static constexpr uint32_t FF_TABLE_SIZE = 16;      // Max feed-forward points
+    static constexpr uint32_t DEFAULT_RATE_HZ = 1000;  // Control loop rate
+
+    /**
+     * @brief Feed-forward table point
+     */
+    struct FFPoint {
+        float rpm;   ///< Speed (RPM)
+        float duty;  ///< Open-loop duty needed for this speed (%)
+    };
+
+    /**
+     * @brief Snapshot of the controller state
+     */
+    struct Status {
+        bool enabled;
+        float setpoint;        ///< Target RPM
+        float measurement;     ///< Last measured RPM
+        float error;           ///< setpoint - measurement
+        float output;          ///< Last duty output (%)
+        float feedForward;     ///< Feed-forward part of output (%)
+        float integral;        ///< Integrator state (%)
+        bool saturated;        ///< Output was clamped in last cycle
+        uint32_t loopCount;    ///< Control cycles executed since enable
+        uint32_t maxLoopUs;    ///< Longest control cycle (µs)
+    };
+
+    /**
+     * @brief Constructor
+     * @param uart1 UART1 PWM/RPM channel to control
+     */
+    explicit RPMController(UART1Mux& uart1);
+
+    ~RPMController();
+
+    /**
+     * @brief Create the control loop timer and load saved settings
+     * @return true if successful
+     */
+    bool begin();
+
+    /**
+     * @brief Enable/disable closed-loop control
+     *
+     * Enabling starts bumpless: the integrator is preloaded so the first
+     * output equals the current duty.
+     *
+     * @param enable true to start the loop, false to stop (duty is left as is)
+     * @return false if enabling failed (UART1 not in PWM/RPM mode)
+     */
+    bool setEnabled(bool enable);
+    bool isEnabled() const { return enabled; }
+
+    /**
+     * @brief Set target speed
+     * @param rpm Target RPM (0 - 500000)
+     * @return true if valid
+     */
+    bool setSetpoint(float rpm);
+    float getSetpoint() const { return setpoint; }
+
+    /**
+     * @brief Set PID gains (units: % duty per RPM, per RPM·s, per RPM/s)
+     * @return true if all gains are non-negative
+     */
+    bool setGains(float kp, float ki, float kd);
+    float getKp() const { return kp; }
+    float getKi() const { return ki; }
+    float getKd() const { return kd; }
+
+    /**
+     * @brief Set output clamp
+     * @param minDuty Lower duty limit (%)
+     * @param maxDuty Upper duty limit (%)
+     * @return true if 0 <= minDuty < maxDuty <= 100
+     */
+    bool setOutputLimits(float minDuty, float maxDuty);
+    float getOutputMin() const { return outMin; }
+    float getOutputMax() const { return outMax; }
+
+    /**
+     * @brief Set control loop rate
+     * @param hz Loop rate (50 - 5000 Hz)
+     * @return true if valid (timer restarted when running)
+     */
+    bool setRate(uint32_t hz);
+    uint32_t getRate() const { return rateHz; }
+
+    /**
+     * @brief Add or replace a feed-forward point (table kept sorted by rpm)
+     * @return false if the table is full or values are out of range
+     */
+    bool addFeedForwardPoint(float rpm, float duty);
+
+    /**
+     * @brief Replace the whole feed-forward table
+     * @param points Points (any order)
+     * @param count Number of points (0 - FF_TABLE_SIZE)
+     * @return true if successful
+     */
+    bool setFeedForwardTable(const FFPoint* points, uint32_t count);
+
+    /**
+     * @brief Remove all feed-forward points (feed-forward becomes 0)
+     */
+    void clearFeedForward();
+
+    uint32_t getFeedForwardCount() const { return ffCount; }
+    FFPoint getFeedForwardPoint(uint32_t index) const;
+
+    /**
+     * @brief Evaluate the feed-forward table (linear interpolation, clamped ends)
+     * @param rpm Speed
+     * @return Duty (%), 0 if table is empty
+     */
+    float evaluateFeedForward(float rpm) const;
+
+    /**
+     * @brief Get controller state snapshot
+     */
+    Status getStatus();
+
+    /**
+     * @brief Save gains, limits, rate and feed-forward table to NVS
+     */
+    bool saveSettings();
+
+    /**
+     * @brief Load settings from NVS
+     */
+    bool loadSettings();
+
+    /**
+     * @brief Reset gains, limits and feed-forward table to defaults
+     */
+    void resetToDefaults();
+
+private:
+    UART1Mux& uart1;
+    esp_timer_handle_t timer = nullptr;
+    mutable portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;  // Guards parameters/state
+
+    // Configuration
+    volatile bool enabled = false;
+    float setpoint = 0.0f;
+    float kp = 0.01f;
+    float ki = 0.05f;
+    float kd = 0.0f;
+    float outMin = 0.0f;
+    float outMax = 100.0f;
+    uint32_t rateHz = DEFAULT_RATE_HZ;
+    FFPoint ffTable[FF_TABLE_SIZE];
+    uint32_t ffCount = 0;
+
+    // Loop state
+    float integral = 0.0f;
+    float lastMeasurement = 0.0f;
+    float lastOutput = 0.0f;
+    float lastFeedForward = 0.0f;
+    float lastError = 0.0f;
+    bool lastSaturated = false;
+    bool firstCycle = true;
+    uint32_t loopCount = 0;
+    uint32_t maxLoopUs = 0;
+
+    static void timerCallback(void* arg);
+    void controlStep();
+    bool restartTimer();
+    float evaluateFeedForwardLocked(float rpm) const;
+};
+
+#endif // RPM_CONTROLLER_H
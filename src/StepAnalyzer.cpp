@@ -0,0 +1,261 @@
+#include "StepAnalyzer.h"
+#include "esp_heap_caps.h"
+#include <math.h>
+
+StepAnalyzer::StepAnalyzer(UART1Mux& uart1, RPMController& pid, FanSweep& sweep)
+    : uart1(uart1), pid(pid), sweep(sweep) {
+}
+
+StepAnalyzer::~StepAnalyzer() {
+    if (timer) {
+        esp_timer_stop(timer);
+        esp_timer_delete(timer);
+        timer = nullptr;
+    }
+    if (edges) {
+        uart1.stopEdgeRecording();
+        heap_caps_free(edges);
+        edges = nullptr;
+    }
+}
+
+bool StepAnalyzer::begin() {
+    if (timer) {
+        return true;
+    }
+
+    // Written from the capture ISR: keep it in internal RAM
+    edges = (uint32_t*)heap_caps_malloc(sizeof(uint32_t) * MAX_EDGES,
+                                        MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!edges) {
+        Serial.printf("[STEP] Edge buffer allocation failed (%u bytes)\n",
+                     (unsigned)(sizeof(uint32_t) * MAX_EDGES));
+        return false;
+    }
+
+    esp_timer_create_args_t args = {};
+    args.callback = timerCallback;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "step_test";
+
+    esp_err_t err = esp_timer_create(&args, &timer);
+    if (err != ESP_OK) {
+        Serial.printf("[STEP] Timer create failed: %s\n", esp_err_to_name(err));
+        timer = nullptr;
+        return false;
+    }
+    return true;
+}
+
+const char* StepAnalyzer::getStateName(State state) {
+    switch (state) {
+        case STEP_IDLE:    return "IDLE";
+        case STEP_RUNNING: return "RUNNING";
+        case STEP_DONE:    return "DONE";
+        case STEP_ABORTED: return "ABORTED";
+        default:           return "UNKNOWN";
+    }
+}
+
+bool StepAnalyzer::setSettleBand(float percent) {
+    if (percent < 0.1f || percent > 50.0f) {
+        return false;
+    }
+    settleBandPct = percent;
+    return true;
+}
+
+bool StepAnalyzer::setSmoothing(uint32_t periods) {
+    if (periods > 64) {
+        return false;
+    }
+    smoothing = periods;
+    return true;
+}
+
+// ============================================================================
+// Test Control
+// ============================================================================
+
+bool StepAnalyzer::start(float duty, uint32_t frequency, uint32_t durationMs) {
+    if (!timer || state == STEP_RUNNING) {
+        return false;
+    }
+    if (duty < 0.0f || duty > 100.0f || durationMs < 100 || durationMs > 30000) {
+        return false;
+    }
+    if (uart1.getMode() != UART1Mux::MODE_PWM_RPM || pid.isEnabled() || uart1.isFaultLatched() ||
+        (sweep.getState() == FanSweep::SWEEP_RUNNING && sweep.getConfig().channel == 0)) {
+        Serial.println("[STEP] UART1 not in PWM mode or busy (PID, sweep or fault)");
+        return false;
+    }
+
+    uart1.stopRamp();
+
+    Result fresh;
+    fresh.fromDuty = uart1.getPWMDuty();
+    fresh.toDuty = duty;
+    fresh.frequency = (frequency != 0) ? frequency : uart1.getPWMFrequency();
+    fresh.initialRpm = uart1.getCalculatedRPM();
+    result = fresh;
+    polePairs = uart1.getPolePairs();
+    prescale = uart1.getCapturePrescale();
+
+    // Step time is taken first so no recorded edge can precede it
+    stepUs = esp_timer_get_time();
+    if (!uart1.startEdgeRecording(edges, MAX_EDGES)) {
+        return false;
+    }
+    if (!uart1.setPWMFrequencyAndDuty(result.frequency, duty)) {
+        uart1.stopEdgeRecording();
+        return false;
+    }
+
+    state = STEP_RUNNING;
+    esp_err_t err = esp_timer_start_once(timer, (uint64_t)durationMs * 1000ULL);
+    if (err != ESP_OK) {
+        Serial.printf("[STEP] Timer start failed: %s\n", esp_err_to_name(err));
+        uart1.stopEdgeRecording();
+        state = STEP_ABORTED;
+        return false;
+    }
+
+    Serial.printf("[STEP] %.2f%% -> %.2f%% at %u Hz, recording %u ms\n",
+                 result.fromDuty, duty, result.frequency, durationMs);
+    return true;
+}
+
+void StepAnalyzer::abort() {
+    if (state != STEP_RUNNING) {
+        return;
+    }
+    esp_timer_stop(timer);
+    result.edges = uart1.stopEdgeRecording();
+    firstEdgeUs = uart1.getRecordedFirstEdgeUs();  // Raw trace stays readable
+    state = STEP_ABORTED;
+}
+
+void StepAnalyzer::timerCallback(void* arg) {
+    StepAnalyzer* self = static_cast<StepAnalyzer*>(arg);
+    if (self->state != STEP_RUNNING) {
+        return;
+    }
+    uint32_t count = self->uart1.stopEdgeRecording();
+    self->firstEdgeUs = self->uart1.getRecordedFirstEdgeUs();
+    self->analyze(count);
+    self->state = STEP_DONE;
+
+    const Result& r = self->result;
+    Serial.printf("[STEP] Done: %u edges, %.0f -> %.0f RPM, t90=%u us, overshoot=%.1f%%, settling=%u us%s\n",
+                 r.edges, r.initialRpm, r.finalRpm, r.t90Us, r.overshootPct, r.settlingUs,
+                 r.settled ? "" : " (not settled)");
+}
+
+// ============================================================================
+// Analysis
+// ============================================================================
+
+uint32_t StepAnalyzer::edgeTimeUs(uint32_t index) const {
+    int64_t offsetUs = firstEdgeUs - stepUs;
+    if (offsetUs < 0) {
+        offsetUs = 0;
+    }
+    return (uint32_t)offsetUs + edges[index] / (UART1Mux::CAPTURE_CLK_HZ / 1000000);
+}
+
+float StepAnalyzer::smoothedRpm(uint32_t index, uint32_t periods) const {
+    // Average over whole periods: k periods divided by their total span
+    uint32_t k = (periods < index) ? periods : index;
+    uint32_t span = edges[index] - edges[index - k];
+    if (span == 0) {
+        return 0.0f;
+    }
+    return 60.0f * (float)UART1Mux::CAPTURE_CLK_HZ * (float)(k * prescale) / ((float)span * (float)polePairs);
+}
+
+void StepAnalyzer::analyze(uint32_t count) {
+    Result& r = result;
+    r.edges = count;
+    r.bufferFull = (count >= MAX_EDGES);
+    r.valid = (count >= 3);
+    if (!r.valid) {
+        r.finalRpm = 0.0f;
+        r.firstEdgeUs = (count > 0) ? edgeTimeUs(0) : 0;
+        return;
+    }
+
+    uint32_t k = (smoothing != 0) ? smoothing : polePairs;
+    uint32_t last = count - 1;
+    r.firstEdgeUs = edgeTimeUs(0);
+
+    // Steady state: mean over the last 20 % of the speed samples (index 1..last)
+    uint32_t tailLen = last / 5;
+    if (tailLen < 1) tailLen = 1;
+    uint32_t tailStart = count - tailLen;
+    float sum = 0.0f;
+    for (uint32_t i = tailStart; i <= last; i++) {
+        sum += smoothedRpm(i, k);
+    }
+    r.finalRpm = sum / (float)tailLen;
+
+    float delta = r.finalRpm - r.initialRpm;
+    float absDelta = fabsf(delta);
+    float dir = (delta >= 0.0f) ? 1.0f : -1.0f;
+    float band = settleBandPct / 100.0f * (r.finalRpm > 1.0f ? r.finalRpm : 1.0f);
+
+    r.peakRpm = smoothedRpm(1, k);
+    uint32_t lastOutside = 0;
+    for (uint32_t i = 1; i <= last; i++) {
+        float s = smoothedRpm(i, k);
+
+        if (absDelta >= 1.0f) {
+            float progress = (s - r.initialRpm) / delta;
+            if (r.t10Us == 0 && progress >= 0.1f) r.t10Us = edgeTimeUs(i);
+            if (r.t90Us == 0 && progress >= 0.9f) r.t90Us = edgeTimeUs(i);
+        }
+        if (dir * s > dir * r.peakRpm) {
+            r.peakRpm = s;
+        }
+        if (fabsf(s - r.finalRpm) > band) {
+            lastOutside = i;
+        }
+    }
+
+    if (absDelta >= 1.0f) {
+        float beyond = dir * (r.peakRpm - r.finalRpm);
+        r.overshootPct = (beyond > 0.0f) ? beyond / absDelta * 100.0f : 0.0f;
+    }
+
+    r.settled = (lastOutside < last);
+    r.settlingUs = r.settled ? edgeTimeUs(lastOutside + 1) : edgeTimeUs(last);
+
+    // Ripple after settling (or over the tail when it never settled)
+    uint32_t rippleStart = r.settled ? lastOutside + 1 : tailStart;
+    uint32_t n = 0;
+    double mean = 0.0, m2 = 0.0;
+    float minS = 0.0f, maxS = 0.0f;
+    for (uint32_t i = rippleStart; i <= last; i++) {
+        float s = smoothedRpm(i, k);
+        n++;
+        double d = s - mean;
+        mean += d / n;
+        m2 += d * (s - mean);
+        if (n == 1 || s < minS) minS = s;
+        if (n == 1 || s > maxS) maxS = s;
+    }
+    r.rippleStdDev = (n > 1) ? (float)sqrt(m2 / (n - 1)) : 0.0f;
+    r.ripplePkPk = maxS - minS;
+}
+
+bool StepAnalyzer::getSample(uint32_t index, uint32_t& timeUs, uint32_t& periodTicks, float& rpm) const {
+    if (state == STEP_RUNNING || index == 0 || index >= result.edges) {
+        return false;
+    }
+    timeUs = edgeTimeUs(index);
+    periodTicks = (edges[index] - edges[index - 1]) / prescale;
+    rpm = (periodTicks > 0)
+        ? 60.0f * (float)UART1Mux::CAPTURE_CLK_HZ / ((float)periodTicks * (float)polePairs)
+        : 0.0f;
+    return true;
+}
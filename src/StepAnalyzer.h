@@ -0,0 +1,133 @@
+#ifndef STEP_ANALYZER_H
+#define STEP_ANALYZER_H
+
+#include <Arduino.h>
+#include "esp_timer.h"
+#include "UART1Mux.h"
+#include "RPMController.h"
+#include "FanSweep.h"
+
+/**
+ * @brief Step-response analyzer for the UART1 fan (spin-up, overshoot, settling)
+ *
+ * Applies a duty (and optionally frequency) step through
+ * UART1Mux::setPWMFrequencyAndDuty() and records every following tach edge
+ * from the capture ISR into a buffer allocated once at begin(). After the
+ * test duration the trace is analyzed from an esp_timer task:
+ *
+ * - Speed per edge is averaged over the last `smoothing` periods (default
+ *   one revolution = pole pairs), which removes magnet asymmetry
+ * - Final speed = mean over the last 20 % of the trace
+ * - Rise: time from the step to 10 % and 90 % of the speed change
+ * - Overshoot: peak beyond the final speed, % of the speed change
+ * - Settling: time after which speed stays within ±band % of final
+ * - Ripple: stddev and peak-to-peak speed after settling
+ *
+ * Times are relative to the step: the first recorded edge is placed with
+ * esp_timer, later edges with the capture timer (12.5 ns resolution).
+ */
+class StepAnalyzer {
+public:
+    static constexpr uint32_t MAX_EDGES = 4096;  // 16 KB internal RAM
+
+    /**
+     * @brief Analysis of the last step
+     */
+    struct Result {
+        bool valid = false;
+        float fromDuty = 0.0f;         ///< Duty before the step (%)
+        float toDuty = 0.0f;           ///< Duty after the step (%)
+        uint32_t frequency = 0;        ///< PWM frequency after the step (Hz)
+        uint32_t edges = 0;            ///< Edges recorded
+        bool bufferFull = false;       ///< Recording stopped at MAX_EDGES
+        float initialRpm = 0.0f;       ///< Speed before the step
+        float finalRpm = 0.0f;         ///< Steady-state speed
+        float peakRpm = 0.0f;          ///< Extreme speed in the step direction
+        uint32_t firstEdgeUs = 0;      ///< Step → first recorded edge
+        uint32_t t10Us = 0;            ///< Step → 10 % of the change (0 = not reached)
+        uint32_t t90Us = 0;            ///< Step → 90 % of the change (0 = not reached)
+        float overshootPct = 0.0f;     ///< Overshoot, % of the change
+        bool settled = false;          ///< Ended within the settling band
+        uint32_t settlingUs = 0;       ///< Step → last entry into the band
+        float rippleStdDev = 0.0f;     ///< Steady-state speed stddev (RPM)
+        float ripplePkPk = 0.0f;       ///< Steady-state speed peak-to-peak (RPM)
+    };
+
+    enum State {
+        STEP_IDLE,
+        STEP_RUNNING,
+        STEP_DONE,
+        STEP_ABORTED
+    };
+
+    StepAnalyzer(UART1Mux& uart1, RPMController& pid, FanSweep& sweep);
+    ~StepAnalyzer();
+
+    /**
+     * @brief Allocate the edge buffer and create the test timer
+     */
+    bool begin();
+
+    /**
+     * @brief Apply a step and start recording
+     * @param duty Duty after the step (0-100 %)
+     * @param frequency PWM frequency after the step (0 = unchanged)
+     * @param durationMs Recording time (100-30000 ms)
+     * @return false if UART1 is not in PWM mode, busy (PID, sweep, fault) or invalid
+     */
+    bool start(float duty, uint32_t frequency, uint32_t durationMs);
+
+    /**
+     * @brief Stop a running test without analysis (the step stays applied)
+     */
+    void abort();
+
+    /**
+     * @brief Settling band (0.1-50 % of the final speed)
+     */
+    bool setSettleBand(float percent);
+    float getSettleBand() const { return settleBandPct; }
+
+    /**
+     * @brief Periods averaged per speed value (0 = pole pairs, i.e. one revolution)
+     */
+    bool setSmoothing(uint32_t periods);
+    uint32_t getSmoothing() const { return smoothing; }
+
+    State getState() const { return state; }
+    static const char* getStateName(State state);
+    Result getResult() const { return result; }
+
+    /**
+     * @brief Raw trace of the last test
+     * @param index Edge index (1 .. getResult().edges - 1)
+     * @param timeUs Edge time relative to the step
+     * @param periodTicks Period ending at this edge (capture ticks)
+     * @param rpm Speed from this single period
+     * @return false if index is out of range or a test is running
+     */
+    bool getSample(uint32_t index, uint32_t& timeUs, uint32_t& periodTicks, float& rpm) const;
+
+private:
+    UART1Mux& uart1;
+    RPMController& pid;
+    FanSweep& sweep;
+    esp_timer_handle_t timer = nullptr;
+
+    uint32_t* edges = nullptr;          // Capture ticks since the first edge
+    volatile State state = STEP_IDLE;
+    Result result;
+    int64_t stepUs = 0;
+    int64_t firstEdgeUs = 0;
+    uint32_t polePairs = 2;
+    uint32_t prescale = 1;              // Input periods per recorded edge
+    float settleBandPct = 2.0f;
+    uint32_t smoothing = 0;
+
+    static void timerCallback(void* arg);
+    void analyze(uint32_t count);
+    uint32_t edgeTimeUs(uint32_t index) const;
+    float smoothedRpm(uint32_t index, uint32_t periods) const;
+};
+
+#endif // STEP_ANALYZER_H
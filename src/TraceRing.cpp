@@ -0,0 +1,59 @@
+#include "TraceRing.h"
+
+// Global UART1/PWM trace ring
+TraceRing uart1Trace;
+
+uint32_t TraceRing::oldest() const {
+    uint32_t w = writeIndex.load(std::memory_order_acquire);
+    uint32_t c = clearIndex.load(std::memory_order_relaxed);
+    // Records before clearIndex were discarded; older than CAPACITY are overwritten
+    return ((w - c) > CAPACITY) ? (w - CAPACITY) : c;
+}
+
+bool TraceRing::read(uint32_t& cursor, TraceRecord& out) const {
+    uint32_t first = oldest();
+    if ((int32_t)(cursor - first) < 0) {
+        cursor = first;  // Reader fell behind, skip overwritten records
+    }
+
+    uint32_t w = writeIndex.load(std::memory_order_acquire);
+    while (cursor != w) {
+        const Slot& slot = slots[cursor & MASK];
+        uint32_t expected = cursor + 1;
+
+        if (slot.seq.load(std::memory_order_acquire) == expected) {
+            out = slot.rec;
+            // Re-check: the slot may have been reclaimed while copying
+            if (slot.seq.load(std::memory_order_acquire) == expected) {
+                cursor++;
+                return true;
+            }
+        }
+
+        // Still being written or already overwritten
+        cursor++;
+    }
+    return false;
+}
+
+void TraceRing::clear() {
+    clearIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+const char* TraceRing::eventName(uint16_t event) {
+    switch (event) {
+        case TRACE_PWM_PERIOD:    return "PWM_PERIOD";
+        case TRACE_PWM_DUTY:      return "PWM_DUTY";
+        case TRACE_PWM_PRESCALER: return "PWM_PRESCALER";
+        case TRACE_PWM_FREQ:      return "PWM_FREQ";
+        case TRACE_PWM_ENABLE:    return "PWM_ENABLE";
+        case TRACE_PWM_ERROR:     return "PWM_ERROR";
+        case TRACE_RAMP_START:    return "RAMP_START";
+        case TRACE_RAMP_DONE:     return "RAMP_DONE";
+        case TRACE_RPM_METHOD:    return "RPM_METHOD";
+        case TRACE_FAULT:         return "FAULT";
+        case TRACE_FOLLOW_LOCK:   return "FOLLOW_LOCK";
+        case TRACE_TACH_EDGE:     return "TACH_EDGE";
+        default:                  return "UNKNOWN";
+    }
+}
@@ -0,0 +1,161 @@
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "esp_timer.h"
+
+/**
+ * @brief Trace levels (compile-time ceiling and runtime filter)
+ */
+#define TRACE_LEVEL_OFF       0   // Nothing recorded
+#define TRACE_LEVEL_EVENT     1   // Parameter changes, ramps, errors
+#define TRACE_LEVEL_REGISTER  2   // MCPWM register before/after values
+#define TRACE_LEVEL_VERBOSE   3   // Every duty write and tach edge, debug dumps in command handlers
+
+/**
+ * @brief Compile-time trace ceiling
+ *
+ * Trace points above this level compile to nothing. Override from
+ * platformio.ini, e.g. build_flags = -DUART1_TRACE_LEVEL=1
+ */
+#ifndef UART1_TRACE_LEVEL
+#define UART1_TRACE_LEVEL TRACE_LEVEL_VERBOSE
+#endif
+
+/**
+ * @brief Trace event identifiers
+ */
+enum TraceEvent : uint16_t {
+    TRACE_PWM_PERIOD = 1,    // a = cfg0 before, b = cfg0 after, c = period
+    TRACE_PWM_DUTY,          // a = duty × 100, b = period
+    TRACE_PWM_PRESCALER,     // a = cfg0 before, b = cfg0 after, c = prescaler
+    TRACE_PWM_FREQ,          // a = frequency, b = prescaler, c = period
+    TRACE_PWM_ENABLE,        // a = enabled
+    TRACE_PWM_ERROR,         // a = esp_err_t, b = frequency, c = period
+    TRACE_RAMP_START,        // a = target frequency, b = target duty × 100, c = duration ms
+    TRACE_RAMP_DONE,         // a = frequency, b = duty × 100, c = steps
+    TRACE_RPM_METHOD,        // a = RPMMethod, b = counter frequency, c = switch count
+    TRACE_FAULT,             // a = FaultCode (0 = cleared), b = period ticks, c = reaction us
+    TRACE_FOLLOW_LOCK,       // a = locked, b = target Hz, c = error ppm
+    TRACE_TACH_EDGE,         // a = capture ticks low, b = ticks high, c = period ticks
+    TRACE_EVENT_COUNT
+};
+
+/**
+ * @brief One binary trace record (16 bytes)
+ */
+struct TraceRecord {
+    uint32_t timestampUs;  ///< esp_timer time (low 32 bits)
+    uint16_t event;        ///< TraceEvent
+    uint8_t level;         ///< Trace level of this record
+    uint8_t core;          ///< CPU core that recorded it
+    uint32_t a;            ///< Event-specific arguments
+    uint32_t b;
+    uint32_t c;
+};
+
+/**
+ * @brief Lock-free multi-producer binary trace ring (flight recorder)
+ *
+ * Hot paths (including critical sections and ISRs) record fixed-size binary
+ * records instead of formatting text. A producer claims a slot with a single
+ * atomic fetch_add, fills it and publishes it by writing its sequence number.
+ * The ring overwrites the oldest records; the reader detects slots that were
+ * overwritten or are still being written and skips them.
+ *
+ * Decoding happens later from a task (TRACE DUMP), never on the hot path.
+ */
+class TraceRing {
+public:
+    static constexpr uint32_t CAPACITY = 512;  // Must be a power of two
+    static constexpr uint32_t MASK = CAPACITY - 1;
+
+    /**
+     * @brief Record an event (safe from ISR and critical sections)
+     */
+    __attribute__((always_inline)) inline void record(uint8_t level, uint16_t event, uint32_t a, uint32_t b, uint32_t c) {
+        if (level > runtimeLevel.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint32_t seq = writeIndex.fetch_add(1, std::memory_order_relaxed);
+        Slot& slot = slots[seq & MASK];
+        slot.seq.store(0, std::memory_order_relaxed);  // Mark slot as being written
+        slot.rec.timestampUs = (uint32_t)esp_timer_get_time();
+        slot.rec.event = event;
+        slot.rec.level = level;
+        slot.rec.core = (uint8_t)xPortGetCoreID();
+        slot.rec.a = a;
+        slot.rec.b = b;
+        slot.rec.c = c;
+        slot.seq.store(seq + 1, std::memory_order_release);  // Publish
+    }
+
+    /**
+     * @brief Read the next record at or after cursor
+     * @param cursor Sequence number to start from; advanced past the record read.
+     *               Records older than the ring capacity are skipped.
+     * @param out Decoded record
+     * @return false when no more complete records are available
+     */
+    bool read(uint32_t& cursor, TraceRecord& out) const;
+
+    /**
+     * @brief Sequence number of the oldest record still in the ring
+     */
+    uint32_t oldest() const;
+
+    /**
+     * @brief Total number of records written since boot/clear
+     */
+    uint32_t written() const { return writeIndex.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Discard all records
+     */
+    void clear();
+
+    /**
+     * @brief Runtime level filter (records above it are dropped)
+     * @param level TRACE_LEVEL_OFF .. UART1_TRACE_LEVEL
+     */
+    void setLevel(uint8_t level) { runtimeLevel.store(level, std::memory_order_relaxed); }
+    uint8_t getLevel() const { return runtimeLevel.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Check if a level is both compiled in and enabled at runtime
+     */
+    bool enabled(uint8_t level) const { return level <= UART1_TRACE_LEVEL && level <= getLevel(); }
+
+    /**
+     * @brief Human-readable event name
+     */
+    static const char* eventName(uint16_t event);
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq{0};  // seq + 1 of the record held, 0 = being written
+        TraceRecord rec;
+    };
+
+    Slot slots[CAPACITY];
+    std::atomic<uint32_t> writeIndex{0};
+    std::atomic<uint32_t> clearIndex{0};
+    std::atomic<uint8_t> runtimeLevel{TRACE_LEVEL_REGISTER};
+};
+
+// Global UART1/PWM trace ring (defined in TraceRing.cpp)
+extern TraceRing uart1Trace;
+
+/**
+ * @brief Record a trace event; compiles out above UART1_TRACE_LEVEL
+ */
+#define UART1_TRACE(level, event, a, b, c)                                        \
+    do {                                                                          \
+        if ((level) <= UART1_TRACE_LEVEL) {                                       \
+            uart1Trace.record((level), (event), (uint32_t)(a), (uint32_t)(b),     \
+                              (uint32_t)(c));                                     \
+        }                                                                         \
+    } while (0)
+
+#endif // TRACE_RING_H
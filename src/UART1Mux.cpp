@@ -1,27 +1,65 @@
 #include "UART1Mux.h"
+#include "TraceRing.h"
+#include "MCPWMCapture.h"
 #include "driver/gpio.h"
 #include "soc/mcpwm_periph.h"
 #include "soc/mcpwm_struct.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/gpio_periph.h"
+#include "esp_rom_gpio.h"
+#include "soc/pcnt_struct.h"
+#include "hal/pcnt_ll.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <Preferences.h>
+#include <math.h>
 
 
 // NVS namespace for UART1 settings persistence
 static const char* NVS_NAMESPACE = "uart1_settings";
 
-// Define static variables for MCPWM Capture
-volatile uint32_t UART1Mux::capturePeriod = 0;
-volatile bool UART1Mux::newCaptureAvailable = false;
-volatile unsigned long UART1Mux::lastCaptureTime = 0;
+// MCPWM group source clock on the ESP32-S3 (PLL_F160M); the group prescaler
+// divides it into the dead-time clock
+static const uint32_t MCPWM_GROUP_SRC_CLK_HZ = 160000000;
 
 UART1Mux::UART1Mux() {
+    // Static storage: usable before the scheduler starts, never fails
+    rpmConsumerLock = xSemaphoreCreateMutexStatic(&rpmConsumerLockBuf);
+
     // Initialize GPIO 12 for PWM parameter change pulse (glitch observation)
     initPWMChangePulse();
 }
 
 UART1Mux::~UART1Mux() {
     disable();
+    if (rampTimer) {
+        esp_timer_delete(rampTimer);
+        rampTimer = nullptr;
+    }
+    if (gateTimer) {
+        esp_timer_delete(gateTimer);
+        gateTimer = nullptr;
+    }
+    if (faultTimerReady) {
+        timer_isr_callback_remove(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT);
+        timer_deinit(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT);
+        faultTimerReady = false;
+    }
+    if (ditherTimerReady) {
+        timer_isr_callback_remove(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER);
+        timer_deinit(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER);
+        ditherTimerReady = false;
+    }
+    // Parked drivers are only released here
+    if (captureReady) {
+        MCPWMCapture::disable(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_UART1_RPM);
+        captureReady = false;
+    }
+    if (uartDriverReady) {
+        uart_driver_delete(uartNum);
+        uartDriverReady = false;
+    }
 }
 
 // ============================================================================
@@ -40,7 +78,10 @@ bool UART1Mux::setModeUART(uint32_t baudRate, uart_stop_bits_t stopBits,
         return reconfigureUART(baudRate, stopBits, parity, dataBits);
     }
 
-    // Disable current mode
+    int64_t startUs = esp_timer_get_time();
+    bool fast = uartDriverReady;
+
+    // Park the current mode
     disable();
 
     // Save UART configuration
@@ -49,18 +90,18 @@ bool UART1Mux::setModeUART(uint32_t baudRate, uart_stop_bits_t stopBits,
     uartParity = parity;
     uartDataBits = dataBits;
 
-    // Initialize UART
+    // Attach the (parked or new) UART driver
     if (!initUART()) {
         Serial.println("[UART1] Failed to initialize UART mode");
         return false;
     }
 
     currentMode = MODE_UART;
-    Serial.printf("[UART1] Switched to UART mode: %u baud\n", baudRate);
-
-    // Settling time
-    delay(10);
+    recordModeSwitch(startUs, fast);
 
+    if (!fast) {
+        Serial.printf("[UART1] Switched to UART mode: %u baud\n", baudRate);
+    }
     return true;
 }
 
@@ -70,10 +111,13 @@ bool UART1Mux::setModePWM_RPM() {
         return true;
     }
 
-    // Disable current mode
+    int64_t startUs = esp_timer_get_time();
+    bool fast = pwmDriverReady && captureReady;
+
+    // Park the current mode
     disable();
 
-    // Initialize PWM and RPM capture
+    // Initialize PWM and RPM capture (re-attach when already set up)
     bool pwmOK = initPWM();
     bool rpmOK = initRPM();
 
@@ -84,20 +128,39 @@ bool UART1Mux::setModePWM_RPM() {
     }
 
     currentMode = MODE_PWM_RPM;
-    printf("[UART1-MODE] Switched to PWM/RPM mode\n");
-    printf("[UART1-STATE] pwmPrescaler=%u, pwmPeriod=%u, pwmFrequency=%u\n",
-           pwmPrescaler, pwmPeriod, pwmFrequency);
-    printf("[UART1-STATE] mcpwmClockFreq=%u (80MHz expected)\n", mcpwmClockFreq);
 
-    Serial.println("[UART1] Switched to PWM/RPM mode");
+    // A latched fault survives mode changes; re-arm protection if requested
+    if (faultLatched) {
+        applyFaultForce(true);
+    }
+    if (faultArmPending) {
+        setFaultProtection(true);
+    }
+    if (followPending) {
+        setFollowMode(true, followRatio, followOffsetHz, followEveryN);
+    }
+
+    // Output driven by the generator: at 0 % / 100 % (or forced) its idle
+    // level is known, otherwise the first TEZ already set it
+    float duty = faultLatched ? (faultSafeHigh ? 100.0f : 0.0f) : pwmDuty;
+    if (duty <= 0.0f || duty >= 100.0f) {
+        waitPinLevel(PIN_UART1_TX, duty >= 100.0f ? 1 : 0, MODE_SETTLE_TIMEOUT_US);
+    }
+    recordModeSwitch(startUs, fast);
 
-    // Settling time
-    delay(10);
+    if (!fast) {
+        printf("[UART1-MODE] Switched to PWM/RPM mode\n");
+        printf("[UART1-STATE] pwmPrescaler=%u, pwmPeriod=%u, pwmFrequency=%u\n",
+               pwmPrescaler, pwmPeriod, pwmFrequency);
+        printf("[UART1-STATE] mcpwmClockFreq=%u (80MHz expected)\n", mcpwmClockFreq);
 
+        Serial.println("[UART1] Switched to PWM/RPM mode");
+    }
     return true;
 }
 
 void UART1Mux::disable() {
+    // Park the active mode: drivers stay installed, their pins are detached
     switch (currentMode) {
         case MODE_UART:
             deinitUART();
@@ -200,266 +263,2036 @@ bool UART1Mux::reconfigureUART(uint32_t baudRate, uart_stop_bits_t stopBits,
     uart_wait_tx_done(uartNum, pdMS_TO_TICKS(1000));
 
     // Configure new parameters
-    uart_config_t uart_config = {
-        .baud_rate = (int)baudRate,
-        .data_bits = dataBits,
-        .parity = parity,
-        .stop_bits = stopBits,
-        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
-        .rx_flow_ctrl_thresh = 122,
-        .source_clk = UART_SCLK_APB,
-    };
+    uart_config_t uart_config = buildUARTConfig();
+    uart_config.baud_rate = (int)baudRate;
+    uart_config.data_bits = dataBits;
+    uart_config.parity = parity;
+    uart_config.stop_bits = stopBits;
 
     esp_err_t err = uart_param_config(uartNum, &uart_config);
     if (err != ESP_OK) {
         Serial.printf("[UART1] Reconfigure failed: %d\n", err);
         return false;
     }
+    uartAppliedConfig = uart_config;
+
+    uartBaudRate = baudRate;
+    uartStopBits = stopBits;
+    uartParity = parity;
+    uartDataBits = dataBits;
+
+    Serial.printf("[UART1] Reconfigured: %u baud\n", baudRate);
+    return true;
+}
+
+// ============================================================================
+// PWM/RPM Mode Functions
+// ============================================================================
+
+bool UART1Mux::setPWMFrequency(uint32_t frequency) {
+    if (currentMode != MODE_PWM_RPM) {
+        return false;
+    }
+
+    if (!validatePWMFrequency(frequency)) {
+        return false;
+    }
+
+    // Manual change overrides a running ramp or the follower
+    stopRamp();
+    setFollowMode(false);
+
+    // Output pulse on GPIO 12 BEFORE changing frequency (to observe glitches)
+    outputPWMChangePulse();
+
+    // TRULY GLITCH-FREE UPDATE USING LL API
+    // Minimum-error prescaler/period pair (keeps the current prescaler on a tie)
+    PWMSolution sol;
+    if (!PWMSolver::solve(mcpwmClockFreq, frequency, pwmPrescaler, sol)) {
+        UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_PWM_ERROR, ESP_ERR_INVALID_ARG, frequency, 0);
+        Serial.printf("[UART1] ❌ %u Hz not reachable (prescaler max %u, period max %u)\n",
+                     frequency, PWMSolver::MAX_PRESCALER, PWMSolver::MAX_PERIOD);
+        return false;
+    }
+
+    // Check if prescaler needs to change
+    if (sol.prescaler != pwmPrescaler) {
+        // Prescaler is not shadowed and switches at once; period and duty load
+        // at the next TEZ, so the rest of the running period is transitional
+        // (new prescaler, old period and duty)
+        Serial.printf("[UART1] ⚠️ Prescaler change (%u → %u), rest of current period transitional\n",
+                     pwmPrescaler, sol.prescaler);
+        updatePWMPrescalerDirectly(sol.prescaler, sol.period);
+    }
+
+    // Period (if still different) and duty through the TEZ shadow registers
+    updatePWMRegistersDirectly(sol.period, pwmDuty);
+    pwmFrequency = frequency;
+
+    UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_PWM_FREQ, pwmFrequency, pwmPrescaler, pwmPeriod);
+    return true;
+}
+
+bool UART1Mux::setPWMDuty(float duty) {
+    if (currentMode != MODE_PWM_RPM) {
+        return false;
+    }
+
+    if (duty < 0.0 || duty > 100.0) {
+        return false;
+    }
+
+    // Manual change overrides a running ramp
+    stopRamp();
+
+    // Output pulse on GPIO 12 BEFORE changing duty cycle (to observe glitches)
+    outputPWMChangePulse();
+
+    // TRULY GLITCH-FREE UPDATE USING LL API
+    // Update duty shadow register only (period unchanged)
+    updatePWMRegistersDirectly(pwmPeriod, duty);
+
+    return true;
+}
+
+bool UART1Mux::setPWMDutyFast(float duty) {
+    if (currentMode != MODE_PWM_RPM) {
+        return false;
+    }
+
+    if (duty < 0.0 || duty > 100.0) {
+        return false;
+    }
+
+    // Period unchanged → only the duty shadow register is written
+    updatePWMRegistersDirectly(pwmPeriod, duty);
+    return true;
+}
+
+bool UART1Mux::setPWMFrequencyAndDuty(uint32_t frequency, float duty) {
+    if (currentMode != MODE_PWM_RPM) {
+        return false;
+    }
+
+    // Validate parameters
+    if (!validatePWMFrequency(frequency)) {
+        return false;
+    }
+
+    if (duty < 0.0 || duty > 100.0) {
+        return false;
+    }
+
+    // Manual change overrides a running ramp or the follower
+    stopRamp();
+    setFollowMode(false);
+
+    // Mark PWM parameter change with GPIO12 toggle (non-blocking, glitch-free)
+    outputPWMChangePulse();
+
+    // Closest period for the current prescaler (rounded, not truncated)
+    PWMSolution sol;
+    if (!PWMSolver::solveForPrescaler(mcpwmClockFreq, frequency, pwmPrescaler, sol)) {
+        UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_PWM_ERROR, ESP_ERR_INVALID_ARG, frequency, pwmPrescaler);
+        Serial.printf("[UART1] ❌ %u Hz out of range for prescaler %u (period must be 2-65535)\n",
+                     frequency, pwmPrescaler);
+        return false;
+    }
+
+    // Use the unified shadow register update function (glitch-free)
+    updatePWMRegistersDirectly(sol.period, duty);
+
+    // Update stored frequency
+    pwmFrequency = frequency;
+
+    UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_PWM_FREQ, pwmFrequency, pwmPrescaler, pwmPeriod);
+    return true;
+}
+
+void UART1Mux::holdPWMUpdates() {
+    pwmHoldTask = xTaskGetCurrentTaskHandle();
+    pwmHoldPending = false;
+}
+
+void UART1Mux::releasePWMUpdates() {
+    if (pwmHoldTask == nullptr || pwmHoldTask != xTaskGetCurrentTaskHandle()) {
+        return;
+    }
+    pwmHoldTask = nullptr;
+    bool pending = pwmHoldPending;
+    pwmHoldPending = false;
+    if (!pending || !pwmDriverReady) {
+        return;
+    }
+
+    // pwmPrescaler/pwmPeriod already hold the new values: compare against the
+    // register so whatever differs from what the timer was given is written
+    uint32_t cfg0 = MCPWM1.timer[0].timer_cfg0.val;
+    uint32_t period = pwmPeriod;
+    pwmPeriod = ((cfg0 >> 8) & 0xFFFF) + 1;
+    if ((cfg0 & 0xFF) + 1 != pwmPrescaler) {
+        // Prescaler and period in one store, duty right behind it
+        updatePWMPrescalerDirectly(pwmPrescaler, period);
+    }
+    updatePWMRegistersDirectly(period, pwmDuty);
+}
+
+// ============================================================================
+// PWM Ramp Engine
+// ============================================================================
+
+bool UART1Mux::startRamp(uint32_t targetFrequency, float targetDuty, uint32_t durationMs,
+                         RampProfile profile) {
+    if (currentMode != MODE_PWM_RPM) {
+        return false;
+    }
+
+    if (durationMs < 1 || durationMs > 600000) {
+        Serial.printf("[UART1] Invalid ramp time: %u ms (valid: 1-600000)\n", durationMs);
+        return false;
+    }
+
+    uint32_t frequency = (targetFrequency == 0) ? pwmFrequency : targetFrequency;
+    float duty = (targetDuty < 0.0) ? pwmDuty : targetDuty;
+
+    if (!validatePWMFrequency(frequency) || duty > 100.0) {
+        return false;
+    }
+
+    // The prescaler stays fixed during a ramp (only the period is shadowed)
+    PWMSolution endpoint;
+    if (!PWMSolver::solveForPrescaler(mcpwmClockFreq, frequency, pwmPrescaler, endpoint)) {
+        Serial.printf("[UART1] Ramp target %u Hz not reachable with prescaler %u\n",
+                     frequency, pwmPrescaler);
+        return false;
+    }
+
+    if (!rampTimer) {
+        esp_timer_create_args_t args = {};
+        args.callback = rampTimerCallback;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "uart1_ramp";
+        if (esp_timer_create(&args, &rampTimer) != ESP_OK) {
+            rampTimer = nullptr;
+            Serial.println("[UART1] Ramp timer create failed");
+            return false;
+        }
+    }
+
+    stopRamp();
+    setFollowMode(false);
+
+    // Step once per PWM period, but not faster than 1 kHz
+    uint32_t periodUs = 1000000 / ((pwmFrequency < frequency) ? pwmFrequency : frequency);
+    uint32_t tickUs = (periodUs > 1000) ? periodUs : 1000;
+
+    rampProfile = profile;
+    rampStartFreq = pwmFrequency;
+    rampTargetFreq = frequency;
+    rampStartDuty = pwmDuty;
+    rampTargetDuty = duty;
+    rampDurationUs = durationMs * 1000;
+    rampSteps = 0;
+    rampCompleteEvent = false;
+    rampFinished = false;
+    rampStartUs = esp_timer_get_time();
+    rampActive = true;
+
+    if (esp_timer_start_periodic(rampTimer, tickUs) != ESP_OK) {
+        rampActive = false;
+        Serial.println("[UART1] Ramp timer start failed");
+        return false;
+    }
+
+    outputPWMChangePulse();
+    UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_RAMP_START, frequency, duty * 100.0f + 0.5f, durationMs);
+    Serial.printf("[UART1] Ramp started: %u Hz → %u Hz, %.1f%% → %.1f%%, %u ms (%s, tick %u us)\n",
+                 rampStartFreq, rampTargetFreq, rampStartDuty, rampTargetDuty, durationMs,
+                 profile == RAMP_SCURVE ? "S-curve" : "linear", tickUs);
+    return true;
+}
+
+void UART1Mux::stopRamp() {
+    if (!rampActive) {
+        return;
+    }
+    rampActive = false;
+    if (rampTimer) {
+        esp_timer_stop(rampTimer);
+    }
+}
+
+float UART1Mux::getRampProgress() const {
+    if (!rampActive) {
+        return rampFinished ? 1.0f : 0.0f;  // Completed vs. stopped/never run
+    }
+    int64_t elapsed = esp_timer_get_time() - rampStartUs;
+    if (elapsed >= (int64_t)rampDurationUs) {
+        return 1.0f;
+    }
+    return (float)elapsed / (float)rampDurationUs;
+}
+
+bool UART1Mux::takeRampCompleteEvent() {
+    if (!rampCompleteEvent) {
+        return false;
+    }
+    rampCompleteEvent = false;
+    return true;
+}
+
+void UART1Mux::rampTimerCallback(void* arg) {
+    static_cast<UART1Mux*>(arg)->rampStep();
+}
+
+void UART1Mux::rampStep() {
+    if (!rampActive) {
+        return;
+    }
+    if (currentMode != MODE_PWM_RPM || faultLatched) {
+        stopRamp();
+        return;
+    }
+
+    int64_t elapsed = esp_timer_get_time() - rampStartUs;
+    bool done = elapsed >= (int64_t)rampDurationUs;
+    float t = done ? 1.0f : (float)elapsed / (float)rampDurationUs;
+
+    // S-curve: smoothstep 3t² - 2t³ (zero slope at start and end)
+    float s = (rampProfile == RAMP_SCURVE) ? t * t * (3.0f - 2.0f * t) : t;
+
+    uint32_t frequency = done ? rampTargetFreq
+        : (uint32_t)((float)rampStartFreq + ((float)rampTargetFreq - (float)rampStartFreq) * s + 0.5f);
+    float duty = done ? rampTargetDuty : rampStartDuty + (rampTargetDuty - rampStartDuty) * s;
+
+    // Both endpoints were validated with this prescaler; the path is monotonic
+    PWMSolution sol;
+    PWMSolver::solveForPrescaler(mcpwmClockFreq, frequency, pwmPrescaler, sol);
+    updatePWMRegistersDirectly(sol.period, duty);
+    pwmFrequency = frequency;
+    rampSteps = rampSteps + 1;
+
+    if (done) {
+        esp_timer_stop(rampTimer);
+        rampActive = false;
+        rampFinished = true;
+        rampCompleteEvent = true;
+        UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_RAMP_DONE, frequency, duty * 100.0f + 0.5f, rampSteps);
+    }
+}
+
+// ============================================================================
+// Tracking / Follower Mode (software FLL)
+// ============================================================================
+
+bool UART1Mux::setFollowMode(bool enable, float ratio, float offsetHz, uint32_t everyN) {
+    if (!enable) {
+        followPending = false;
+        stopFollow();
+        return true;
+    }
+
+    if (ratio < 0.001f || ratio > 1000.0f) {
+        Serial.printf("[UART1] Invalid follow ratio: %.4f (valid: 0.001-1000)\n", ratio);
+        return false;
+    }
+    if (offsetHz < -100000.0f || offsetHz > 100000.0f) {
+        Serial.printf("[UART1] Invalid follow offset: %.1f Hz (valid: ±100000)\n", offsetHz);
+        return false;
+    }
+    if (everyN < 1 || everyN > 1000) {
+        Serial.printf("[UART1] Invalid follow update interval: %u periods (valid: 1-1000)\n", everyN);
+        return false;
+    }
+
+    // Stop first so the ISR never sees a half-applied configuration
+    followActive = false;
+    followRatio = ratio;
+    followOffsetHz = offsetHz;
+    followEveryN = everyN;
+    followPending = true;
+
+    if (currentMode != MODE_PWM_RPM || rpmNotifyTask == nullptr) {
+        return true;  // Applied on entry / once the measurement task registers
+    }
+
+    // The follower owns the frequency from now on; every edge must reach the ISR
+    stopRamp();
+    if (rpmMethod == RPM_METHOD_COUNTER) {
+        switchRPMMethod(RPM_METHOD_CAPTURE);
+    }
+
+    followHasBase = false;  // ISR starts a new span on the next edge
+    followSeqSeen = followSeq.load(std::memory_order_acquire);
+    followPeriodTicks = (double)pwmPrescaler * (double)pwmPeriod;
+    followResidual = 0.0;
+    followInBand = 0;
+
+    FollowStatus fresh;
+    taskENTER_CRITICAL(&mux);
+    followState = fresh;
+    taskEXIT_CRITICAL(&mux);
+    followActive = true;
+
+    // Wake the measurement task so it switches its wait timeout immediately
+    xTaskNotifyGive(rpmNotifyTask);
+
+    Serial.printf("[UART1] Follower: output = input × %.4f %+.1f Hz, update every %u periods "
+                  "(gain %.2f, lock ±%u ppm)\n",
+                  ratio, offsetHz, everyN, followGain, followLockPpm);
+    return true;
+}
+
+bool UART1Mux::setFollowLoop(float gain, uint32_t lockPpm) {
+    if (gain < 0.01f || gain > 1.0f) {
+        Serial.printf("[UART1] Invalid follow gain: %.3f (valid: 0.01-1)\n", gain);
+        return false;
+    }
+    if (lockPpm < 1 || lockPpm > 100000) {
+        Serial.printf("[UART1] Invalid lock band: %u ppm (valid: 1-100000)\n", lockPpm);
+        return false;
+    }
+    followGain = gain;
+    followLockPpm = lockPpm;
+    followInBand = 0;  // Re-qualify the lock against the new band
+    return true;
+}
+
+void UART1Mux::stopFollow() {
+    if (!followActive) {
+        return;
+    }
+    followActive = false;
+    followInBand = 0;
+    taskENTER_CRITICAL(&mux);
+    followState.locked = false;
+    taskEXIT_CRITICAL(&mux);
+    Serial.printf("[UART1] Follower stopped, output holds %u Hz\n", pwmFrequency);
+}
+
+FollowStatus UART1Mux::getFollowStatus() {
+    FollowStatus status;
+    taskENTER_CRITICAL(&mux);
+    status = followState;
+    taskEXIT_CRITICAL(&mux);
+
+    status.enabled = followActive;
+    status.ratio = followRatio;
+    status.offsetHz = followOffsetHz;
+    status.everyN = followEveryN;
+    status.gain = followGain;
+    status.lockPpm = followLockPpm;
+    return status;
+}
+
+void UART1Mux::followStep() {
+    if (!followActive) {
+        return;
+    }
+    if (currentMode != MODE_PWM_RPM || faultLatched) {
+        stopFollow();  // Output is forced safe; FOLLOW ON again after clearing
+        return;
+    }
+
+    // Newest span published by the capture ISR
+    uint32_t before, after;
+    uint64_t spanTicks;
+    uint32_t spanPeriods;
+    do {
+        before = followSeq.load(std::memory_order_acquire);
+        spanTicks = followSpanTicks;
+        spanPeriods = followSpanPeriods;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = followSeq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    FollowStatus st;
+    taskENTER_CRITICAL(&mux);
+    st = followState;
+    taskEXIT_CRITICAL(&mux);
+
+    if (before == followSeqSeen) {
+        // No new span: on input loss hold the output and drop the lock. The
+        // next span must not include the gap, so the ISR restarts it.
+        if (st.signal && !hasRPMSignal()) {
+            followHasBase = false;
+            followInBand = 0;
+            st.signal = false;
+            if (st.locked) {
+                st.locked = false;
+                st.lockLosses++;
+                UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_FOLLOW_LOCK, 0, (uint32_t)st.targetHz, 0);
+            }
+            taskENTER_CRITICAL(&mux);
+            followState = st;
+            taskEXIT_CRITICAL(&mux);
+        }
+        return;
+    }
+    followSeqSeen = before;
+    if (spanTicks == 0 || spanPeriods == 0) {
+        return;
+    }
+
+    // Exact input frequency over the span (integer ticks, no averaging filter)
+    double inputHz = (double)CAPTURE_CLK_HZ * (double)spanPeriods / (double)spanTicks;
+    double targetHz = inputHz * followRatio + followOffsetHz;
+
+    // The follower is unattended: stay within the configured output limit
+    double limitHz = (maxFrequency < 500000) ? (double)maxFrequency : 500000.0;
+    double loopHz = targetHz;
+    bool clamped = false;
+    if (loopHz > limitHz) {
+        loopHz = limitHz;
+        clamped = true;
+    } else if (loopHz < 1.0) {
+        loopHz = 1.0;
+        clamped = true;
+    }
+
+    // First-order loop on the output period (in MCPWM clocks)
+    double targetTicks = (double)mcpwmClockFreq / loopHz;
+    followPeriodTicks += followGain * (targetTicks - followPeriodTicks);
+
+    double desired = followPeriodTicks / (double)pwmPrescaler + followResidual;
+    if (desired < PWMSolver::MIN_PERIOD - 0.5 || desired >= PWMSolver::MAX_PERIOD + 0.5) {
+        // Out of range for the current prescaler: re-solve (rest of the
+        // running period is transitional, see updatePWMPrescalerDirectly)
+        PWMSolution sol;
+        uint32_t frequency = (uint32_t)((double)mcpwmClockFreq / followPeriodTicks + 0.5);
+        if (frequency < 1 ||
+            !PWMSolver::solve(mcpwmClockFreq, frequency, pwmPrescaler, sol)) {
+            followPeriodTicks = (double)pwmPrescaler * (double)pwmPeriod;  // Hold
+            clamped = true;
+            desired = (double)pwmPeriod;
+        } else {
+            updatePWMPrescalerDirectly(sol.prescaler, sol.period);
+            st.prescalerChanges++;
+            desired = followPeriodTicks / (double)pwmPrescaler;
+        }
+        followResidual = 0.0;
+    }
+
+    // Round, carrying the remainder so the mean period equals the loop state
+    uint32_t period = (uint32_t)(desired + 0.5);
+    if (period < PWMSolver::MIN_PERIOD) period = PWMSolver::MIN_PERIOD;
+    if (period > PWMSolver::MAX_PERIOD) period = PWMSolver::MAX_PERIOD;
+    followResidual = desired - (double)period;
+
+    updatePWMRegistersDirectly(period, pwmDuty);
+
+    double outputHz = (double)mcpwmClockFreq / ((double)pwmPrescaler * (double)period);
+    pwmFrequency = (uint32_t)(outputHz + 0.5);
+
+    // Tracking error against the requested target (a clamped target never locks)
+    double errorHz = outputHz - targetHz;
+    double errorPpm = (targetHz > 0.0) ? errorHz / targetHz * 1e6 : 1e6;
+    if (errorPpm > 1e9) errorPpm = 1e9;
+    if (errorPpm < -1e9) errorPpm = -1e9;
+
+    bool inBand = !clamped && fabs(errorPpm) <= (double)followLockPpm;
+    followInBand = inBand ? followInBand + 1 : 0;
+    bool locked = followInBand >= FOLLOW_LOCK_UPDATES;
+    if (locked != st.locked) {
+        if (!locked) {
+            st.lockLosses++;
+        }
+        UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_FOLLOW_LOCK, locked, (uint32_t)(targetHz + 0.5),
+                    (uint32_t)(int32_t)errorPpm);
+    }
+
+    st.locked = locked;
+    st.signal = true;
+    st.clamped = clamped;
+    st.inputHz = (float)inputHz;
+    st.targetHz = (float)targetHz;
+    st.outputHz = (float)outputHz;
+    st.errorHz = (float)errorHz;
+    st.errorPpm = (int32_t)errorPpm;
+    st.updates++;
+
+    taskENTER_CRITICAL(&mux);
+    followState = st;
+    taskEXIT_CRITICAL(&mux);
+}
+
+void UART1Mux::setPWMEnabled(bool enable) {
+    if (currentMode != MODE_PWM_RPM) {
+        return;
+    }
+
+    pwmEnabled = enable;
+    UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_PWM_ENABLE, enable, 0, 0);
+
+    if (enable) {
+        // Start MCPWM timer
+        mcpwm_start(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM);
+    } else {
+        // Stop MCPWM timer
+        mcpwm_stop(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM);
+    }
+}
+
+// ============================================================================
+// Complementary Output with Dead Time
+// ============================================================================
+
+uint32_t UART1Mux::deadTimeClockHz() const {
+    // Dead-time delays count MCPWM group clocks (not prescaled timer ticks)
+    return MCPWM_GROUP_SRC_CLK_HZ / ((MCPWM1.clk_cfg.val & 0xFF) + 1);
+}
+
+float UART1Mux::getDeadTimeResolutionNs() const {
+    return 1e9f / (float)deadTimeClockHz();
+}
+
+uint32_t UART1Mux::getDeadTimeRisingActualNs() const {
+    return (uint32_t)(((uint64_t)deadTimeRisingTicks * 1000000000ULL) / deadTimeClockHz());
+}
+
+uint32_t UART1Mux::getDeadTimeFallingActualNs() const {
+    return (uint32_t)(((uint64_t)deadTimeFallingTicks * 1000000000ULL) / deadTimeClockHz());
+}
+
+bool UART1Mux::setComplementaryOutput(bool enable, uint32_t risingNs, uint32_t fallingNs) {
+    if (risingNs > DEADTIME_MAX_NS || fallingNs > DEADTIME_MAX_NS) {
+        Serial.printf("[UART1] Invalid dead time: %u/%u ns (valid: 0-%u)\n",
+                     risingNs, fallingNs, DEADTIME_MAX_NS);
+        return false;
+    }
+
+    complementaryEnabled = enable;
+    deadTimeRisingNs = risingNs;
+    deadTimeFallingNs = fallingNs;
+
+    if (currentMode != MODE_PWM_RPM) {
+        return true;  // Applied by initPWM()
+    }
+    return applyComplementaryOutput();
+}
+
+bool UART1Mux::applyComplementaryOutput() {
+    if (!complementaryEnabled) {
+        if (!complementaryActive) {
+            return true;
+        }
+        // Generator A straight to GPIO 17 again; hold the low side off
+        mcpwm_deadtime_disable(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM);
+        // gpio_config() reconnects the pin to the GPIO output register
+        gpio_set_level((gpio_num_t)PIN_UART1_PWM_B, 0);
+        gpio_config_t io_conf = {};
+        io_conf.intr_type = GPIO_INTR_DISABLE;
+        io_conf.mode = GPIO_MODE_OUTPUT;
+        io_conf.pin_bit_mask = (1ULL << PIN_UART1_PWM_B);
+        io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+        io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+        gpio_config(&io_conf);
+        gpio_set_level((gpio_num_t)PIN_UART1_PWM_B, 0);
+        complementaryActive = false;
+        deadTimeRisingTicks = 0;
+        deadTimeFallingTicks = 0;
+        Serial.printf("[UART1] Complementary output off (GPIO %d held low)\n", PIN_UART1_PWM_B);
+        return true;
+    }
+
+    // Nearest group-clock tick count (delay registers are 16 bits)
+    uint32_t clockHz = deadTimeClockHz();
+    uint64_t red = ((uint64_t)deadTimeRisingNs * clockHz + 500000000ULL) / 1000000000ULL;
+    uint64_t fed = ((uint64_t)deadTimeFallingNs * clockHz + 500000000ULL) / 1000000000ULL;
+    if (red > 0xFFFF || fed > 0xFFFF) {
+        Serial.printf("[UART1] Dead time exceeds 65535 ticks at %u Hz dead-time clock\n", clockHz);
+        return false;
+    }
+
+    // Both outputs from generator A: A = rising edge delayed, B = inverted,
+    // falling edge delayed. Delays load at TEZ like period and duty.
+    esp_err_t err = mcpwm_deadtime_enable(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM,
+                                          MCPWM_ACTIVE_HIGH_COMPLIMENT_MODE,
+                                          (uint32_t)red, (uint32_t)fed);
+    if (err != ESP_OK) {
+        Serial.printf("[UART1] ❌ Dead-time enable failed: %s\n", esp_err_to_name(err));
+        return false;
+    }
+
+    // Route the low side only once the dead-time module drives it
+    if (!complementaryActive) {
+        mcpwm_gpio_init(MCPWM_UNIT_UART1_PWM, MCPWM0B, PIN_UART1_PWM_B);
+        complementaryActive = true;
+    }
+    deadTimeRisingTicks = (uint32_t)red;
+    deadTimeFallingTicks = (uint32_t)fed;
+
+    // Both edges of one period must fit: warn, the frequency may still change
+    float periodNs = 1e9f / getPWMActualFrequency();
+    if ((float)(deadTimeRisingNs + deadTimeFallingNs) >= periodNs) {
+        Serial.printf("[UART1] ⚠️ Dead time %u+%u ns exceeds the PWM period (%.0f ns)\n",
+                     deadTimeRisingNs, deadTimeFallingNs, periodNs);
+    }
+
+    Serial.printf("[UART1] Complementary output: GPIO %d / GPIO %d, dead time %u/%u ns (%u/%u ticks)\n",
+                 PIN_UART1_TX, PIN_UART1_PWM_B, getDeadTimeRisingActualNs(),
+                 getDeadTimeFallingActualNs(), deadTimeRisingTicks, deadTimeFallingTicks);
+    return true;
+}
+
+// ============================================================================
+// High-Resolution Duty (sigma-delta dithering)
+// ============================================================================
+
+bool UART1Mux::setDutyDither(bool enable, uint32_t rateHz) {
+    if (rateHz < 100 || rateHz > 20000) {
+        Serial.printf("[UART1] Invalid dither rate: %u Hz (valid: 100-20000)\n", rateHz);
+        return false;
+    }
+
+    bool rateChanged = (rateHz != ditherRateHz);
+    ditherEnabled = enable;
+    ditherRateHz = rateHz;
+
+    if (currentMode != MODE_PWM_RPM) {
+        return true;  // Applied by initPWM()
+    }
+    if (!enable) {
+        stopDutyDither();
+        return true;
+    }
+    if (ditherActive && !rateChanged) {
+        return true;
+    }
+    return startDutyDither();
+}
+
+bool UART1Mux::startDutyDither() {
+    if (!ditherTimerReady) {
+        timer_config_t config = {};
+        config.alarm_en = TIMER_ALARM_EN;
+        config.counter_en = TIMER_PAUSE;
+        config.intr_type = TIMER_INTR_LEVEL;
+        config.counter_dir = TIMER_COUNT_UP;
+        config.auto_reload = TIMER_AUTORELOAD_EN;
+        config.divider = 80;  // APB 80 MHz → 1 µs ticks
+
+        esp_err_t err = timer_init(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER, &config);
+        if (err == ESP_OK) {
+            err = timer_isr_callback_add(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER,
+                                         ditherCallback, this, ESP_INTR_FLAG_IRAM);
+        }
+        if (err != ESP_OK) {
+            Serial.printf("[UART1] ❌ Dither timer init failed: %s\n", esp_err_to_name(err));
+            return false;
+        }
+        ditherTimerReady = true;
+    } else {
+        timer_pause(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER);
+    }
+
+    // Seed the modulator from the current duty; the ISR takes over the compare
+    taskENTER_CRITICAL(&mux);
+    ditherPeriod = pwmPeriod;
+    ditherDutyQ16 = (uint32_t)(pwmDuty * 655.36f + 0.5f);
+    ditherAcc = 0;
+    taskEXIT_CRITICAL(&mux);
+
+    timer_set_counter_value(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER, 0);
+    timer_set_alarm_value(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER,
+                          1000000ULL / ditherRateHz);
+    ditherActive = true;
+    timer_start(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER);
+
+    Serial.printf("[UART1] Duty dither on: %u updates/s, resolution %.4f%%\n",
+                 ditherRateHz, getDutyResolution());
+    return true;
+}
+
+void UART1Mux::stopDutyDither() {
+    if (!ditherActive) {
+        return;
+    }
+    timer_pause(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER);
+    ditherActive = false;
+
+    // Back to the nearest tick through the driver
+    mcpwm_set_duty(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM, MCPWM_GEN_UART1_PWM, pwmDuty);
+    Serial.println("[UART1] Duty dither off");
+}
+
+bool IRAM_ATTR UART1Mux::ditherCallback(void* arg) {
+    // ISR: integer only. One modulator step per alarm; the compare value is a
+    // shadow register loaded at the next TEZ, so the PWM never glitches.
+    UART1Mux* self = static_cast<UART1Mux*>(arg);
+
+    portENTER_CRITICAL_ISR(&self->mux);
+    if (self->ditherActive) {
+        uint64_t exact = (uint64_t)self->ditherPeriod * self->ditherDutyQ16;  // Ticks × 65536
+        uint32_t frac = (uint32_t)(exact & 0xFFFF) + self->ditherAcc;
+        uint32_t compare = (uint32_t)(exact >> 16) + (frac >> 16);
+        self->ditherAcc = frac & 0xFFFF;
+        MCPWM1.operators[MCPWM_TIMER_UART1_PWM].timestamp[MCPWM_GEN_UART1_PWM].val = compare;
+        self->ditherUpdates++;
+    }
+    portEXIT_CRITICAL_ISR(&self->mux);
+    return false;  // No task woken
+}
+
+float UART1Mux::getDutyResolution() const {
+    if (ditherEnabled) {
+        return 100.0f / (float)(1UL << DUTY_DITHER_BITS);
+    }
+    return (pwmPeriod > 0) ? 100.0f / (float)pwmPeriod : 0.0f;
+}
+
+float UART1Mux::getDutyDitherWindowMs(float resolution) const {
+    if (pwmPeriod == 0 || resolution <= 0.0f) {
+        return 0.0f;
+    }
+    // The modulator repeats within native step / resolution updates, at most
+    // one update per PWM period counting
+    float steps = ceilf((100.0f / (float)pwmPeriod) / resolution);
+    if (steps <= 1.0f) {
+        return 0.0f;
+    }
+    float pwmHz = getPWMActualFrequency();
+    float rate = ((float)ditherRateHz < pwmHz) ? (float)ditherRateHz : pwmHz;
+    return (rate > 0.0f) ? steps * 1000.0f / rate : 0.0f;
+}
+
+float UART1Mux::getPWMDutyActual() const {
+    if (ditherEnabled) {
+        return (float)(uint32_t)(pwmDuty * 655.36f + 0.5f) / 655.36f;
+    }
+    if (pwmPeriod == 0) {
+        return pwmDuty;
+    }
+    // The driver truncates to whole ticks
+    uint32_t ticks = (uint32_t)((float)pwmPeriod * pwmDuty / 100.0f);
+    return (float)ticks * 100.0f / (float)pwmPeriod;
+}
+
+// ============================================================================
+// MCPWM Capture ISR Callback
+// ============================================================================
+
+bool IRAM_ATTR UART1Mux::captureCallback(mcpwm_unit_t mcpwm,
+                                          mcpwm_capture_channel_id_t cap_channel,
+                                          const cap_event_data_t *edata,
+                                          void *user_data) {
+    // This runs in ISR context - must be fast!
+    UART1Mux* self = static_cast<UART1Mux*>(user_data);
+    uint32_t currentCapture = edata->cap_value;
+    int64_t nowUs = esp_timer_get_time();
+
+    // Both-edge capture: a falling edge only closes the high time
+    if (self->dutyCaptureEnabled && edata->cap_edge == MCPWM_NEG_EDGE) {
+        if (self->captureHasLast) {
+            self->dutyHighTicks = currentCapture - (uint32_t)self->lastCaptureExt;
+            self->dutyHighValid = true;
+        }
+        return false;
+    }
+
+    // Extend the 32-bit capture counter to 64 bits, including whole extra
+    // wraps of periods over 53.7 s (see CaptureRing::extendPeriod)
+    uint64_t extended;
+    uint64_t period64 = 0;
+    if (self->captureHasLast) {
+        uint64_t last = self->lastCaptureExt;
+        period64 = CaptureRing::extendPeriod(last, currentCapture, nowUs - self->lastCaptureUs,
+                                             CAPTURE_CLK_HZ / 1000000);
+        if (period64 > UINT32_MAX) {
+            self->captureMultiWraps = self->captureMultiWraps + 1;
+        }
+
+        // Too close to the last good edge: a glitch, measure the next edge from
+        // the last good one (nothing below sees this edge)
+        if (period64 < self->glitchRejectTicks) {
+            self->glitchRejects = self->glitchRejects + 1;
+            return false;
+        }
+        extended = last + period64;
+
+        uint32_t period = (uint32_t)period64;
+        if (period64 > UINT32_MAX) {
+            period = UINT32_MAX;  // Saturate: slower than any threshold
+            self->captureSaturated = self->captureSaturated + 1;
+        }
+
+        // Speed protection acts here, before anything is queued
+        if (self->faultArmed && !self->faultLatched) {
+            self->checkFaultPeriod(period / self->capturePrescale, nowUs);
+        }
+
+        // Input duty: this rising edge completes the cycle started by the last one
+        if (self->dutyHighValid) {
+            self->dutyRing.push(((uint64_t)self->dutyHighTicks << 32) | period);
+        }
+    } else {
+        // Timeline starts here; a zero capture value is a valid first edge
+        extended = currentCapture;
+    }
+
+    // Publish the edge/time anchor as a pair (seqlock: odd while writing)
+    self->captureAnchorSeq.fetch_add(1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    self->lastCaptureExt = extended;
+    self->lastCaptureUs = nowUs;
+    self->captureHasLast = true;
+    self->captureAnchorSeq.fetch_add(1, std::memory_order_release);
+    self->dutyHighValid = false;
+
+    UART1_TRACE(TRACE_LEVEL_VERBOSE, TRACE_TACH_EDGE, (uint32_t)extended,
+                (uint32_t)(extended >> 32), period64 > UINT32_MAX ? UINT32_MAX : (uint32_t)period64);
+
+    // Every edge is queued; the consumer derives periods from the timestamps
+    self->captureRing.push(extended);
+    self->lastCaptureTime = millis();  // Track last valid capture time
+
+    // Step-response recording into the pre-allocated buffer
+    uint32_t* rec = self->edgeRecBuffer;
+    if (rec != nullptr) {
+        uint32_t n = self->edgeRecCount;
+        if (n == 0) {
+            self->edgeRecBase = extended;
+            self->edgeRecFirstUs = nowUs;
+        }
+        if (n < self->edgeRecCapacity) {
+            rec[n] = (uint32_t)(extended - self->edgeRecBase);
+            self->edgeRecCount = n + 1;
+        }
+    }
+
+    // Follower: publish the exact span of every N periods (integer ticks)
+    bool notify = false;
+    if (self->followActive) {
+        if (!self->followHasBase) {
+            self->followBaseExt = extended;
+            self->followEdges = 0;
+            self->followHasBase = true;
+        } else {
+            uint32_t n = self->followEdges + 1;
+            if (n >= self->followEveryN) {
+                self->followSeq.fetch_add(1, std::memory_order_relaxed);  // Odd: write in progress
+                std::atomic_thread_fence(std::memory_order_release);
+                self->followSpanTicks = extended - self->followBaseExt;
+                self->followSpanPeriods = n * self->capturePrescale;
+                self->followSeq.fetch_add(1, std::memory_order_release);  // Even: span complete
+                self->followBaseExt = extended;
+                n = 0;
+                notify = true;
+            }
+            self->followEdges = n;
+        }
+    }
+
+    // Event mode: wake the measurement task (throttled by edges or time)
+    if (self->rpmEventMode && self->rpmNotifyTask != nullptr) {
+        uint32_t pending = self->edgesSinceNotify + 1;
+        bool timeDue = self->rpmEventIntervalUs > 0 &&
+                       (nowUs - self->lastNotifyUs) >= (int64_t)self->rpmEventIntervalUs;
+
+        if (pending >= self->rpmEventEdges || timeDue) {
+            self->edgesSinceNotify = 0;
+            self->lastNotifyUs = nowUs;
+            self->rpmNotifyCount = self->rpmNotifyCount + 1;
+            notify = true;
+        } else {
+            self->edgesSinceNotify = pending;
+        }
+    }
+
+    if (notify && self->rpmNotifyTask != nullptr) {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(self->rpmNotifyTask, &higherPriorityTaskWoken);
+        return higherPriorityTaskWoken == pdTRUE;  // Yield on ISR exit if needed
+    }
+
+    return false;  // Don't wake higher priority task
+}
+
+void UART1Mux::updateRPMFrequency() {
+    if (currentMode != MODE_PWM_RPM) {
+        taskENTER_CRITICAL(&rpmMux);
+        publishTachLocked(0, 0, 0);
+        taskEXIT_CRITICAL(&rpmMux);
+        return;
+    }
+
+    if (dutyCaptureEnabled) {
+        taskENTER_CRITICAL(&rpmMux);
+        drainDutyRingLocked();
+        taskEXIT_CRITICAL(&rpmMux);
+    }
+
+    // One consumer at a time; a caller already draining publishes for both
+    if (xSemaphoreTake(rpmConsumerLock, 0) == pdTRUE) {
+        // Sample the edge time before draining so the latency never undercounts
+        int64_t edgeUs = readLastCaptureUs();
+
+        // Bounded drain with interrupts enabled: edges beyond RPM_DRAIN_MAX
+        // wait for the next update instead of stretching this one
+        uint64_t edges[32];
+        uint32_t count;
+        uint32_t drained = 0;
+        bool newPeriods = false;
+        while (drained < RPM_DRAIN_MAX && (count = captureRing.pop(edges, 32)) > 0) {
+            for (uint32_t i = 0; i < count; i++) {
+                if (periodHistory.addEdge(edges[i])) {
+                    newPeriods = true;
+                }
+            }
+            drained += count;
+        }
+
+        // Frequency from the averaged period, in fixed point
+        // Formula: frequency = MCPWM_CAPTURE_CLK × periods / sum(periods)
+        // MCPWM_CAPTURE_CLK = 80,000,000 Hz (80 MHz APB clock)
+        CaptureStats stats;
+        uint32_t maxEdges;
+        uint64_t windowTicks;
+        taskENTER_CRITICAL(&rpmMux);
+        selectRPMWindow(maxEdges, windowTicks);
+        taskEXIT_CRITICAL(&rpmMux);
+
+        if (newPeriods && periodHistory.computeStats(maxEdges, windowTicks, stats) &&
+            stats.spanTicks > 0) {
+            // 80e6 × count × prescale × 1024 < 2^64 for any count that fits the history
+            uint64_t inputPeriods = (uint64_t)stats.count * capturePrescale;
+            uint64_t freqQ10 = (((uint64_t)CAPTURE_CLK_HZ * inputPeriods) << TACH_FREQ_FRAC_BITS) /
+                               stats.spanTicks;
+            uint64_t periodQ4 = ((uint64_t)stats.spanTicks << TACH_PERIOD_FRAC_BITS) / inputPeriods;
+
+            // Timeout follows the expected period: N × mean period, clamped
+            uint64_t timeoutMs = ((uint64_t)stats.meanTicks * rpmTimeoutPeriods +
+                                  (CAPTURE_CLK_HZ / 1000) - 1) / (CAPTURE_CLK_HZ / 1000);
+            if (timeoutMs < RPM_TIMEOUT_MIN_MS) timeoutMs = RPM_TIMEOUT_MIN_MS;
+            if (timeoutMs > rpmTimeoutMaxMs) timeoutMs = rpmTimeoutMaxMs;
+
+            // Edge-to-publish latency
+            int64_t latency = esp_timer_get_time() - edgeUs;
+            uint32_t latencyUs = (latency < 0) ? 0 : (latency > UINT32_MAX) ? UINT32_MAX : (uint32_t)latency;
+
+            taskENTER_CRITICAL(&rpmMux);
+            publishTachLocked(freqQ10 > UINT32_MAX ? UINT32_MAX : (uint32_t)freqQ10,
+                              periodQ4 > UINT32_MAX ? UINT32_MAX : (uint32_t)periodQ4,
+                              edgeUs);
+            lastWindowPeriods = stats.count;
+            lastWindowTicks = stats.spanTicks;
+            rpmTimeoutMs = (uint32_t)timeoutMs;
+            lastRPMUpdate = lastCaptureTime;
+            latencyLastUs = latencyUs;
+            latencySumUs += latencyUs;
+            latencyCount++;
+            if (latencyUs < latencyMinUs) latencyMinUs = latencyUs;
+            if (latencyUs > latencyMaxUs) latencyMaxUs = latencyUs;
+            taskEXIT_CRITICAL(&rpmMux);
+        }
+        xSemaphoreGive(rpmConsumerLock);
+    }
+
+    // Check for signal timeout (no capture within the expected-period timeout)
+    unsigned long now = millis();
+    if ((now - lastRPMUpdate) > effectiveRPMTimeoutMs() && tachFreqQ10 != 0) {
+        taskENTER_CRITICAL(&rpmMux);
+        publishTachLocked(0, 0, 0);  // Signal lost
+        taskEXIT_CRITICAL(&rpmMux);
+    }
+}
+
+bool UART1Mux::setRPMAveraging(uint32_t edges, uint32_t windowMs) {
+    if (edges < 1 || edges > PeriodHistory::HISTORY_SIZE) {
+        Serial.printf("[UART1] Invalid averaging edges: %u (valid: 1-%u)\n",
+                     edges, PeriodHistory::HISTORY_SIZE);
+        return false;
+    }
+    if (windowMs > 10000) {
+        Serial.printf("[UART1] Invalid averaging window: %u ms (valid: 0-10000)\n", windowMs);
+        return false;
+    }
+    taskENTER_CRITICAL(&rpmMux);
+    rpmAvgEdges = edges;
+    rpmAvgWindowMs = windowMs;
+    rpmWindowMode = RPM_WINDOW_FIXED;
+    taskEXIT_CRITICAL(&rpmMux);
+    return true;
+}
+
+bool UART1Mux::setRPMAveragingAdaptive(uint32_t windowMs) {
+    if (windowMs < 1 || windowMs > 10000) {
+        Serial.printf("[UART1] Invalid adaptive window: %u ms (valid: 1-10000)\n", windowMs);
+        return false;
+    }
+    taskENTER_CRITICAL(&rpmMux);
+    rpmAvgWindowMs = windowMs;
+    rpmWindowMode = RPM_WINDOW_ADAPTIVE;
+    taskEXIT_CRITICAL(&rpmMux);
+    return true;
+}
+
+bool UART1Mux::setRPMAveragingRevolutions(uint32_t revolutions) {
+    if (revolutions < 1 || revolutions > 16 ||
+        polePairs * revolutions > PeriodHistory::HISTORY_SIZE) {
+        Serial.printf("[UART1] Invalid revolutions: %u (valid: 1-%u with %u pole pairs)\n",
+                     revolutions, PeriodHistory::HISTORY_SIZE / polePairs < 16
+                         ? PeriodHistory::HISTORY_SIZE / polePairs : 16, polePairs);
+        return false;
+    }
+    taskENTER_CRITICAL(&rpmMux);
+    rpmWindowRevs = revolutions;
+    rpmWindowMode = RPM_WINDOW_REVOLUTION;
+    taskEXIT_CRITICAL(&rpmMux);
+    return true;
+}
+
+const char* UART1Mux::getRPMWindowModeName() const {
+    switch (rpmWindowMode) {
+        case RPM_WINDOW_ADAPTIVE:   return "ADAPTIVE";
+        case RPM_WINDOW_REVOLUTION: return "REVOLUTION";
+        default:                    return "FIXED";
+    }
+}
+
+void UART1Mux::selectRPMWindow(uint32_t& maxEdges, uint64_t& windowTicks) const {
+    switch (rpmWindowMode) {
+        case RPM_WINDOW_ADAPTIVE:
+            // Edge count follows the edge rate: the whole history at speed,
+            // down to the single newest period near stall
+            maxEdges = PeriodHistory::HISTORY_SIZE;
+            windowTicks = (uint64_t)rpmAvgWindowMs * (CAPTURE_CLK_HZ / 1000);
+            break;
+
+        case RPM_WINDOW_REVOLUTION: {
+            // Whole revolutions only; pole pairs may have changed since
+            // the revolution count was validated
+            uint32_t revs = rpmWindowRevs;
+            while (revs > 1 && polePairs * revs > PeriodHistory::HISTORY_SIZE) {
+                revs--;
+            }
+            maxEdges = polePairs * revs;
+            windowTicks = 0;
+            break;
+        }
+
+        default:
+            maxEdges = rpmAvgEdges;
+            windowTicks = (uint64_t)rpmAvgWindowMs * (CAPTURE_CLK_HZ / 1000);
+            break;
+    }
+}
+
+bool UART1Mux::setRPMTimeout(uint32_t periods, uint32_t maxMs) {
+    if (periods < 2 || periods > 100) {
+        Serial.printf("[UART1] Invalid timeout periods: %u (valid: 2-100)\n", periods);
+        return false;
+    }
+    if (maxMs < RPM_TIMEOUT_MIN_MS || maxMs > RPM_TIMEOUT_MAX_MS) {
+        Serial.printf("[UART1] Invalid timeout limit: %u ms (valid: %u-%u)\n",
+                     maxMs, RPM_TIMEOUT_MIN_MS, RPM_TIMEOUT_MAX_MS);
+        return false;
+    }
+    rpmTimeoutPeriods = periods;
+    rpmTimeoutMaxMs = maxMs;
+    rpmTimeoutMs = maxMs;  // Until the next reading recomputes it
+    return true;
+}
+
+uint32_t UART1Mux::effectiveRPMTimeoutMs() const {
+    uint32_t timeoutMs = rpmTimeoutMs;
+    if (rpmMethod == RPM_METHOD_COUNTER && timeoutMs < 2 * rpmGateMs) {
+        timeoutMs = 2 * rpmGateMs;  // Counter readings arrive once per gate
+    }
+    return timeoutMs;
+}
+
+RPMWindowStats UART1Mux::getRPMWindowStats() {
+    RPMWindowStats stats;
+    stats.timeoutMs = effectiveRPMTimeoutMs();
+
+    if (rpmMethod == RPM_METHOD_COUNTER) {
+        stats.periods = 0;
+        stats.windowUs = rpmGateMs * 1000;
+    } else {
+        taskENTER_CRITICAL(&rpmMux);
+        uint32_t periods = lastWindowPeriods;
+        uint64_t ticks = lastWindowTicks;
+        taskEXIT_CRITICAL(&rpmMux);
+        stats.periods = periods;
+        uint64_t us = ticks / (CAPTURE_CLK_HZ / 1000000);
+        stats.windowUs = (us > UINT32_MAX) ? UINT32_MAX : (uint32_t)us;
+    }
+
+    // Moving average over T seconds: -3 dB at ~0.443 / T
+    if (stats.windowUs > 0) {
+        stats.bandwidthHz = 443000.0f / (float)stats.windowUs;
+    }
+    return stats;
+}
+
+bool UART1Mux::setRPMEventMode(bool enable, uint32_t edges, uint32_t intervalUs) {
+    if (edges < 1 || edges > 1000) {
+        Serial.printf("[UART1] Invalid event edge count: %u (valid: 1-1000)\n", edges);
+        return false;
+    }
+    if (intervalUs > 1000000) {
+        Serial.printf("[UART1] Invalid event interval: %u us (valid: 0-1000000)\n", intervalUs);
+        return false;
+    }
+    if (enable && rpmNotifyTask == nullptr) {
+        Serial.println("[UART1] Event mode unavailable: no measurement task registered");
+        return false;
+    }
+
+    // Update throttle first so the ISR never sees a half-applied configuration
+    rpmEventMode = false;
+    rpmEventEdges = edges;
+    rpmEventIntervalUs = intervalUs;
+    edgesSinceNotify = 0;
+    lastNotifyUs = esp_timer_get_time();
+    rpmEventMode = enable;
+    rpmEventPending = enable;
+
+    resetRPMLatencyStats();
+
+    // Wake the measurement task so it switches its wait timeout immediately
+    if (rpmNotifyTask != nullptr) {
+        xTaskNotifyGive(rpmNotifyTask);
+    }
+
+    Serial.printf("[UART1] RPM measurement: %s (edges=%u, interval=%u us)\n",
+                 enable ? "event-driven" : "polling", edges, intervalUs);
+    return true;
+}
+
+void UART1Mux::setRPMNotifyTask(TaskHandle_t task) {
+    rpmNotifyTask = task;
+    if (task == nullptr) {
+        rpmEventMode = false;
+        followActive = false;
+        return;
+    }
+    if (rpmEventPending) {
+        setRPMEventMode(true, rpmEventEdges, rpmEventIntervalUs);
+    }
+    if (followPending && !followActive) {
+        setFollowMode(true, followRatio, followOffsetHz, followEveryN);
+    }
+}
+
+RPMLatencyStats UART1Mux::getRPMLatencyStats() {
+    RPMLatencyStats stats;
+
+    taskENTER_CRITICAL(&rpmMux);
+    stats.count = latencyCount;
+    stats.lastUs = latencyLastUs;
+    stats.minUs = (latencyCount > 0) ? latencyMinUs : 0;
+    stats.maxUs = latencyMaxUs;
+    stats.avgUs = (latencyCount > 0) ? (uint32_t)(latencySumUs / latencyCount) : 0;
+    taskEXIT_CRITICAL(&rpmMux);
+
+    return stats;
+}
+
+void UART1Mux::resetRPMLatencyStats() {
+    taskENTER_CRITICAL(&rpmMux);
+    latencyCount = 0;
+    latencyLastUs = 0;
+    latencyMinUs = UINT32_MAX;
+    latencyMaxUs = 0;
+    latencySumUs = 0;
+    taskEXIT_CRITICAL(&rpmMux);
+}
+
+bool UART1Mux::startEdgeRecording(uint32_t* buffer, uint32_t capacity) {
+    if (currentMode != MODE_PWM_RPM || buffer == nullptr || capacity == 0 ||
+        edgeRecBuffer != nullptr) {
+        return false;
+    }
+
+    // Every edge must reach the ISR
+    if (rpmMethod == RPM_METHOD_COUNTER) {
+        switchRPMMethod(RPM_METHOD_CAPTURE);
+    }
+
+    taskENTER_CRITICAL(&rpmMux);
+    edgeRecCapacity = capacity;
+    edgeRecCount = 0;
+    edgeRecFirstUs = 0;
+    edgeRecBuffer = buffer;  // Armed last
+    taskEXIT_CRITICAL(&rpmMux);
+    return true;
+}
+
+uint32_t UART1Mux::stopEdgeRecording() {
+    taskENTER_CRITICAL(&rpmMux);
+    edgeRecBuffer = nullptr;
+    uint32_t count = edgeRecCount;
+    taskEXIT_CRITICAL(&rpmMux);
+    return count;
+}
+
+bool UART1Mux::setInputDutyCapture(bool enable) {
+    if (enable == dutyCaptureEnabled) {
+        return true;
+    }
+    if (enable && capturePrescale > 1) {
+        Serial.println("[UART1] Input duty capture needs capture prescale 1");
+        return false;
+    }
+
+    if (currentMode != MODE_PWM_RPM) {
+        dutyCaptureEnabled = enable;  // Applied by initRPM()
+        return true;
+    }
+
+    // Every edge must reach the ISR: leave the gated counter first
+    if (enable && rpmMethod == RPM_METHOD_COUNTER) {
+        switchRPMMethod(RPM_METHOD_CAPTURE);
+    }
+
+    // Re-arm the capture channel with the new edge selection
+    MCPWMCapture::disable(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_UART1_RPM);
+    xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+    taskENTER_CRITICAL(&rpmMux);
+    dutyCaptureEnabled = enable;
+    resetCapturePipelineLocked();
+    dutyRing.clear();
+    taskEXIT_CRITICAL(&rpmMux);
+    xSemaphoreGive(rpmConsumerLock);
+
+    esp_err_t err = enableCaptureChannel();
+    if (err != ESP_OK) {
+        Serial.printf("[UART1] ❌ Capture re-enable failed: %s\n", esp_err_to_name(err));
+        return false;
+    }
+    if (rpmMethod == RPM_METHOD_COUNTER) {
+        setCaptureInterrupt(false);  // Counter still publishing: keep per-edge interrupts off
+    }
+
+    Serial.printf("[UART1] Input duty capture %s\n", enable ? "enabled (both edges)" : "disabled");
+    return true;
+}
+
+void UART1Mux::resetCapturePipelineLocked() {
+    // Caller holds rpmConsumerLock (ring consumer side, history) and rpmMux
+    captureHasLast = false;
+    captureRing.clear();
+    periodHistory.reset();
+}
+
+void UART1Mux::drainDutyRingLocked() {
+    // At most one ring's worth per call: the ISR may keep pushing meanwhile
+    uint64_t cycles[32];
+    uint32_t count;
+    uint32_t drained = 0;
+    while (drained < CaptureRing::CAPACITY && (count = dutyRing.pop(cycles, 32)) > 0) {
+        drained += count;
+        for (uint32_t i = 0; i < count; i++) {
+            dutyHistHigh[dutyHistHead] = (uint32_t)(cycles[i] >> 32);
+            dutyHistPeriod[dutyHistHead] = (uint32_t)cycles[i];
+            dutyHistHead = (dutyHistHead + 1) % DUTY_HISTORY_SIZE;
+            if (dutyHistCount < DUTY_HISTORY_SIZE) {
+                dutyHistCount++;
+            }
+            dutyTotalCycles++;
+        }
+    }
+}
+
+InputDutyStats UART1Mux::getInputDutyStats() {
+    InputDutyStats stats;
+    uint32_t high[DUTY_HISTORY_SIZE];
+    uint32_t period[DUTY_HISTORY_SIZE];
+    uint32_t count;
+    uint32_t newest;
+
+    taskENTER_CRITICAL(&rpmMux);
+    drainDutyRingLocked();
+    count = dutyHistCount;
+    newest = (dutyHistHead + DUTY_HISTORY_SIZE - 1) % DUTY_HISTORY_SIZE;
+    memcpy(high, dutyHistHigh, sizeof(high));
+    memcpy(period, dutyHistPeriod, sizeof(period));
+    stats.totalCycles = dutyTotalCycles;
+    taskEXIT_CRITICAL(&rpmMux);
+
+    stats.cycles = count;
+    stats.overflows = dutyRing.getOverflowCount();
+    if (count == 0) {
+        return stats;
+    }
+
+    // Unordered window: slots 0..count-1 hold the newest cycles
+    uint64_t sumHigh = 0, sumPeriod = 0;
+    double mean = 0.0, m2 = 0.0;
+    uint32_t n = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (period[i] == 0) {
+            continue;
+        }
+        float duty = 100.0f * (float)high[i] / (float)period[i];
+        sumHigh += high[i];
+        sumPeriod += period[i];
+        n++;
+        double d = duty - mean;
+        mean += d / n;
+        m2 += d * (duty - mean);
+        if (n == 1 || duty < stats.dutyMin) stats.dutyMin = duty;
+        if (n == 1 || duty > stats.dutyMax) stats.dutyMax = duty;
+    }
+    if (n == 0) {
+        return stats;
+    }
+
+    const float ticksPerUs = (float)(CAPTURE_CLK_HZ / 1000000);
+    stats.dutyMean = (float)mean;
+    stats.dutyStdDev = (n > 1) ? (float)sqrt(m2 / (n - 1)) : 0.0f;
+    stats.dutyLast = (period[newest] > 0) ? 100.0f * (float)high[newest] / (float)period[newest] : 0.0f;
+    stats.highMeanUs = (float)sumHigh / n / ticksPerUs;
+    stats.periodMeanUs = (float)sumPeriod / n / ticksPerUs;
+    stats.frequency = (sumPeriod > 0) ? (float)CAPTURE_CLK_HZ * n / (float)sumPeriod : 0.0f;
+    return stats;
+}
+
+void UART1Mux::resetInputDutyStats() {
+    taskENTER_CRITICAL(&rpmMux);
+    dutyRing.clear();
+    dutyHistHead = 0;
+    dutyHistCount = 0;
+    dutyTotalCycles = 0;
+    taskEXIT_CRITICAL(&rpmMux);
+}
+
+CaptureTimeline UART1Mux::getCaptureTimeline() {
+    CaptureTimeline tl;
+    uint32_t seq;
+    do {
+        seq = captureAnchorSeq.load(std::memory_order_acquire);
+        tl.valid = captureHasLast;
+        tl.lastEdgeTicks = lastCaptureExt;
+        tl.lastEdgeUs = lastCaptureUs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != captureAnchorSeq.load(std::memory_order_relaxed));
+
+    tl.wraps = (uint32_t)(tl.lastEdgeTicks >> 32);
+    tl.multiWrapPeriods = captureMultiWraps;
+    tl.saturatedPeriods = captureSaturated;
+    return tl;
+}
+
+int64_t IRAM_ATTR UART1Mux::readLastCaptureUs() const {
+    // 64-bit ISR-written value: a plain load can tear on this 32-bit core
+    uint32_t seq;
+    int64_t us;
+    do {
+        seq = captureAnchorSeq.load(std::memory_order_acquire);
+        us = lastCaptureUs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+    } while ((seq & 1) || seq != captureAnchorSeq.load(std::memory_order_relaxed));
+    return us;
+}
+
+int64_t UART1Mux::captureTicksToUs(uint64_t ticks) {
+    CaptureTimeline tl = getCaptureTimeline();
+    if (!tl.valid) {
+        return 0;
+    }
+    // Signed distance from the anchor edge (either side of it)
+    int64_t deltaTicks = (int64_t)(ticks - tl.lastEdgeTicks);
+    return tl.lastEdgeUs + deltaTicks / (int64_t)(CAPTURE_CLK_HZ / 1000000);
+}
+
+bool UART1Mux::setTachFilter(uint32_t prescale, uint32_t minPeriodUs, uint32_t outlierPct) {
+    if (prescale < 1 || prescale > 256 || minPeriodUs > 100000 ||
+        (outlierPct != 0 && (outlierPct < 5 || outlierPct > 90))) {
+        Serial.printf("[UART1] Invalid tach filter: prescale %u (1-256), min %u us (0-100000), "
+                     "outlier %u%% (0 or 5-90)\n", prescale, minPeriodUs, outlierPct);
+        return false;
+    }
+    if (prescale > 1 && dutyCaptureEnabled) {
+        Serial.println("[UART1] Capture prescale needs input duty capture off");
+        return false;
+    }
+
+    bool prescaleChanged = (prescale != capturePrescale);
+    bool live = (currentMode == MODE_PWM_RPM);
+    if (live && prescaleChanged) {
+        MCPWMCapture::disable(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_UART1_RPM);
+    }
+
+    // Min period is compared with the spacing of capture events (prescale periods)
+    xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+    taskENTER_CRITICAL(&rpmMux);
+    capturePrescale = prescale;
+    tachMinPeriodUs = minPeriodUs;
+    glitchRejectTicks = minPeriodUs * (CAPTURE_CLK_HZ / 1000000) * prescale;
+    periodHistory.setOutlierTolerance(outlierPct);
+    if (prescaleChanged) {
+        resetCapturePipelineLocked();
+    }
+    taskEXIT_CRITICAL(&rpmMux);
+    xSemaphoreGive(rpmConsumerLock);
+
+    if (live && prescaleChanged) {
+        esp_err_t err = enableCaptureChannel();
+        if (err != ESP_OK) {
+            Serial.printf("[UART1] ❌ Capture re-enable failed: %s\n", esp_err_to_name(err));
+            return false;
+        }
+        if (rpmMethod == RPM_METHOD_COUNTER) {
+            setCaptureInterrupt(false);  // Counter still publishing
+        }
+    }
+
+    Serial.printf("[UART1] Tach filter: prescale %u, min period %u us, outlier %s%u%%\n",
+                 prescale, minPeriodUs, outlierPct ? "±" : "off ", outlierPct);
+    return true;
+}
+
+TachFilterStats UART1Mux::getTachFilterStats() {
+    TachFilterStats stats;
+    stats.prescale = capturePrescale;
+    stats.minPeriodUs = tachMinPeriodUs;
+
+    xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+    OutlierStats outliers = periodHistory.getOutlierStats();
+    stats.outlierPct = periodHistory.getOutlierTolerance();
+    xSemaphoreGive(rpmConsumerLock);
+    stats.glitchRejects = glitchRejects;
+
+    stats.shortRejects = outliers.shortRejects;
+    stats.longRejects = outliers.longRejects;
+    stats.resyncs = outliers.resyncs;
+    return stats;
+}
+
+void UART1Mux::resetTachFilterStats() {
+    xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+    periodHistory.resetOutlierStats();
+    xSemaphoreGive(rpmConsumerLock);
+    taskENTER_CRITICAL(&rpmMux);
+    glitchRejects = 0;
+    taskEXIT_CRITICAL(&rpmMux);
+}
+
+bool UART1Mux::getCaptureStats(uint32_t edges, uint32_t windowMs, CaptureStats& stats) {
+    uint64_t windowTicks = (uint64_t)windowMs * (CAPTURE_CLK_HZ / 1000);
+
+    xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+    bool ok = periodHistory.computeStats(edges, windowTicks, stats);
+    xSemaphoreGive(rpmConsumerLock);
+
+    return ok;
+}
+
+bool UART1Mux::hasRPMSignal() const {
+    if (currentMode != MODE_PWM_RPM) {
+        return false;
+    }
+
+    // Signal detected if frequency > 0 and updated within last 500ms
+    return (tachFreqQ10 > 0) && ((millis() - lastRPMUpdate) < effectiveRPMTimeoutMs());
+}
+
+void UART1Mux::publishTachLocked(uint32_t freqQ10, uint32_t periodQ4, int64_t timestampUs) {
+    // RPM = f × 60 / polePairs: Q22.10 × Q16.16 >> 20 = Q26.6
+    uint64_t rpmQ6 = ((uint64_t)freqQ10 * rpmScaleQ16) >>
+                     (TACH_FREQ_FRAC_BITS + 16 - TACH_RPM_FRAC_BITS);
+
+    tachSeq.fetch_add(1, std::memory_order_relaxed);  // Odd: write in progress
+    std::atomic_thread_fence(std::memory_order_release);
+    tachPeriodQ4 = periodQ4;
+    tachFreqQ10 = freqQ10;
+    tachRpmQ6 = (rpmQ6 > UINT32_MAX) ? UINT32_MAX : (uint32_t)rpmQ6;
+    tachTimestampUs = timestampUs;
+    tachSeq.fetch_add(1, std::memory_order_release);  // Even: reading complete
+}
+
+TachSnapshot UART1Mux::getTachSnapshot() const {
+    TachSnapshot snapshot;
+    uint32_t before, after;
+    do {
+        before = tachSeq.load(std::memory_order_acquire);
+        snapshot.periodQ4 = tachPeriodQ4;
+        snapshot.freqQ10 = tachFreqQ10;
+        snapshot.rpmQ6 = tachRpmQ6;
+        snapshot.timestampUs = tachTimestampUs;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = tachSeq.load(std::memory_order_relaxed);
+    } while ((before & 1) || before != after);
+
+    snapshot.seq = before / 2;
+    return snapshot;
+}
+
+// ============================================================================
+// Hybrid Capture / Gated Counter
+// ============================================================================
+
+bool UART1Mux::setRPMCounterConfig(bool autoSwitch, uint32_t crossoverHz, uint32_t hysteresisPct,
+                                   uint32_t gateMs) {
+    if (crossoverHz < 1000 || crossoverHz > 400000) {
+        Serial.printf("[UART1] Invalid crossover: %u Hz (valid: 1000-400000)\n", crossoverHz);
+        return false;
+    }
+    if (hysteresisPct > 50) {
+        Serial.printf("[UART1] Invalid hysteresis: %u%% (valid: 0-50)\n", hysteresisPct);
+        return false;
+    }
+    if (gateMs < 5 || gateMs > 60) {
+        Serial.printf("[UART1] Invalid gate time: %u ms (valid: 5-60)\n", gateMs);
+        return false;
+    }
+
+    bool gateChanged = (gateMs != rpmGateMs);
+    rpmAutoSwitch = autoSwitch;
+    rpmCrossoverHz = crossoverHz;
+    rpmHysteresisPct = hysteresisPct;
+    rpmGateMs = gateMs;
+
+    // Method switches happen only in gateStep(); it picks up the new thresholds
+    if (gateChanged && gateTimer != nullptr && counterReady) {
+        esp_timer_stop(gateTimer);
+        esp_timer_start_periodic(gateTimer, (uint64_t)rpmGateMs * 1000);
+    }
+
+    Serial.printf("[UART1] RPM hybrid measurement: %s (crossover=%u Hz ±%u%%, gate=%u ms)\n",
+                 autoSwitch ? "auto" : "capture only", crossoverHz, hysteresisPct, gateMs);
+    return true;
+}
+
+const char* UART1Mux::getRPMMethodName() const {
+    return (rpmMethod == RPM_METHOD_COUNTER) ? "PCNT gated counter" : "MCPWM capture";
+}
+
+bool UART1Mux::initCounter() {
+    // PCNT counts rising edges on the RX pin; the GPIO matrix feeds the same
+    // pad to the MCPWM capture input, so both run side by side.
+    pcnt_config_t cfg = {};
+    cfg.pulse_gpio_num = PIN_UART1_RX;
+    cfg.ctrl_gpio_num = PCNT_PIN_NOT_USED;
+    cfg.lctrl_mode = PCNT_MODE_KEEP;
+    cfg.hctrl_mode = PCNT_MODE_KEEP;
+    cfg.pos_mode = PCNT_COUNT_INC;             // Rising edge, same as capture
+    cfg.neg_mode = PCNT_COUNT_DIS;
+    cfg.counter_h_lim = COUNTER_H_LIM;         // Wraps to 0: read modulo H_LIM
+    cfg.counter_l_lim = -32768;                // Never reached (count up only)
+    cfg.unit = PCNT_UNIT_UART1_RPM;
+    cfg.channel = PCNT_CHANNEL_UART1_RPM;
+
+    esp_err_t err = pcnt_unit_config(&cfg);
+    if (err != ESP_OK) {
+        Serial.printf("[UART1] PCNT config failed: %s\n", esp_err_to_name(err));
+        return false;
+    }
+
+    pcnt_counter_pause(PCNT_UNIT_UART1_RPM);
+    pcnt_counter_clear(PCNT_UNIT_UART1_RPM);
+    pcnt_counter_resume(PCNT_UNIT_UART1_RPM);
+
+    if (!gateTimer) {
+        esp_timer_create_args_t args = {};
+        args.callback = gateTimerCallback;
+        args.arg = this;
+        args.dispatch_method = ESP_TIMER_TASK;
+        args.name = "uart1_gate";
+        if (esp_timer_create(&args, &gateTimer) != ESP_OK) {
+            gateTimer = nullptr;
+            Serial.println("[UART1] Gate timer create failed");
+            return false;
+        }
+    }
+
+    lastGateCount = 0;
+    lastGateUs = esp_timer_get_time();
+    counterFrequency = 0.0;
+    rpmMethod = RPM_METHOD_CAPTURE;
+
+    if (esp_timer_start_periodic(gateTimer, (uint64_t)rpmGateMs * 1000) != ESP_OK) {
+        Serial.println("[UART1] Gate timer start failed");
+        return false;
+    }
+
+    counterReady = true;
+    return true;
+}
+
+void UART1Mux::deinitCounter() {
+    // Stop switching before the capture channel goes away
+    if (gateTimer) {
+        esp_timer_stop(gateTimer);
+    }
+    if (counterReady) {
+        pcnt_counter_pause(PCNT_UNIT_UART1_RPM);
+        counterReady = false;
+    }
+    rpmMethod = RPM_METHOD_CAPTURE;
+    counterFrequency = 0.0;
+}
+
+void UART1Mux::gateTimerCallback(void* arg) {
+    static_cast<UART1Mux*>(arg)->gateStep();
+}
+
+void UART1Mux::gateStep() {
+    int16_t count = 0;
+    if (pcnt_get_counter_value(PCNT_UNIT_UART1_RPM, &count) != ESP_OK) {
+        return;
+    }
+    int64_t nowUs = esp_timer_get_time();
+
+    // Gate ≤ 60 ms keeps the count per gate below H_LIM even at 500 kHz
+    uint32_t delta = (uint32_t)((int32_t)count - (int32_t)lastGateCount + COUNTER_H_LIM) % COUNTER_H_LIM;
+    int64_t elapsedUs = nowUs - lastGateUs;
+    lastGateCount = count;
+    lastGateUs = nowUs;
+    if (elapsedUs <= 0) {
+        return;
+    }
+
+    // Fixed point like the capture path: freqQ10 = delta × 1e6 × 1024 / elapsed
+    uint64_t freqQ10 = (((uint64_t)delta * 1000000ULL) << TACH_FREQ_FRAC_BITS) / (uint64_t)elapsedUs;
+    if (freqQ10 > UINT32_MAX) freqQ10 = UINT32_MAX;
+    uint64_t periodQ4 = 0;
+    if (delta > 0) {
+        periodQ4 = (((uint64_t)CAPTURE_CLK_HZ * (uint64_t)elapsedUs) << TACH_PERIOD_FRAC_BITS) /
+                   ((uint64_t)delta * 1000000ULL);
+        if (periodQ4 > UINT32_MAX) periodQ4 = UINT32_MAX;
+    }
+    float frequency = (float)freqQ10 * (1.0f / (1u << TACH_FREQ_FRAC_BITS));
+    counterFrequency = frequency;
+
+    // Hysteresis band around the crossover
+    RPMMethod method = rpmMethod;
+    if (!rpmAutoSwitch || edgeRecBuffer != nullptr || dutyCaptureEnabled || followActive) {
+        method = RPM_METHOD_CAPTURE;  // Edge recording / input duty / follower need every edge
+    } else if (method == RPM_METHOD_CAPTURE &&
+               frequency > (float)rpmCrossoverHz * (100 + rpmHysteresisPct) / 100.0f) {
+        method = RPM_METHOD_COUNTER;
+    } else if (method == RPM_METHOD_COUNTER &&
+               frequency < (float)rpmCrossoverHz * (100 - rpmHysteresisPct) / 100.0f) {
+        method = RPM_METHOD_CAPTURE;
+    }
+    if (method != rpmMethod) {
+        switchRPMMethod(method);
+    }
+
+    if (rpmMethod == RPM_METHOD_COUNTER) {
+        // Capture interrupt is masked: speed limits are checked per gate
+        if (faultArmed && !faultLatched) {
+            checkFaultPeriod(periodQ4 ? (uint32_t)(periodQ4 >> TACH_PERIOD_FRAC_BITS) : UINT32_MAX, nowUs);
+        }
+
+        taskENTER_CRITICAL(&rpmMux);
+        publishTachLocked((uint32_t)freqQ10, (uint32_t)periodQ4, nowUs);
+        if (delta > 0) {
+            lastRPMUpdate = millis();
+        }
+        taskEXIT_CRITICAL(&rpmMux);
+
+        // Event-mode consumers still wake once per published reading
+        if (rpmEventMode && rpmNotifyTask != nullptr) {
+            xTaskNotifyGive(rpmNotifyTask);
+        }
+    }
+}
+
+void UART1Mux::switchRPMMethod(RPMMethod method) {
+    if (method == RPM_METHOD_COUNTER) {
+        // Stop the per-edge interrupts; queued edges are simply left behind
+        setCaptureInterrupt(false);
+        rpmMethod = RPM_METHOD_COUNTER;
+    } else {
+        // Restart the capture pipeline from scratch (ISR is masked here)
+        xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+        taskENTER_CRITICAL(&rpmMux);
+        resetCapturePipelineLocked();
+        taskEXIT_CRITICAL(&rpmMux);
+        xSemaphoreGive(rpmConsumerLock);
+        rpmMethod = RPM_METHOD_CAPTURE;
+        setCaptureInterrupt(true);
+    }
 
-    uartBaudRate = baudRate;
-    uartStopBits = stopBits;
-    uartParity = parity;
-    uartDataBits = dataBits;
+    rpmMethodSwitches = rpmMethodSwitches + 1;
+    UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_RPM_METHOD, method, (uint32_t)counterFrequency,
+                rpmMethodSwitches);
+}
 
-    Serial.printf("[UART1] Reconfigured: %u baud\n", baudRate);
-    return true;
+void UART1Mux::setCaptureInterrupt(bool enable) {
+    // int_ena is shared with the fan channels' captures on MCPWM0: one owner
+    MCPWMCapture::setInterrupt(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_UART1_RPM, enable);
 }
 
 // ============================================================================
-// PWM/RPM Mode Functions
+// Speed Protection
 // ============================================================================
 
-bool UART1Mux::setPWMFrequency(uint32_t frequency) {
-    if (currentMode != MODE_PWM_RPM) {
-        return false;
-    }
+bool UART1Mux::setFaultProtection(bool enable) {
+    faultArmPending = enable;
 
-    if (!validatePWMFrequency(frequency)) {
-        return false;
+    if (!enable) {
+        faultArmed = false;
+        stopFaultWatchdog();
+        return true;
     }
 
-    // Output pulse on GPIO 12 BEFORE changing frequency (to observe glitches)
-    outputPWMChangePulse();
-
-    // TRULY GLITCH-FREE UPDATE USING LL API
-    // Calculate new prescaler and period for target frequency
-    uint32_t new_prescaler, new_period;
-    calculatePWMParameters(frequency, new_prescaler, new_period);
-
-    // Check if prescaler needs to change
-    if (new_prescaler != pwmPrescaler) {
-        // Prescaler change required - must use high-level API (will stop PWM briefly)
-        Serial.printf("[UART1] ⚠️ Prescaler change required (%u → %u), brief PWM stop unavoidable\n",
-                     pwmPrescaler, new_prescaler);
+    if (currentMode != MODE_PWM_RPM) {
+        return true;  // Armed when PWM/RPM mode is entered
+    }
 
-        // Read register BEFORE API call
-        uint32_t cfg0_before = MCPWM1.timer[0].timer_cfg0.val;
-        uint32_t prescale_before = (cfg0_before & 0xFF);
-        uint32_t period_before_alt1 = ((cfg0_before >> 16) & 0xFF);
-        uint32_t period_before_alt2 = ((cfg0_before >> 8) & 0xFFFF);
-        Serial.printf("[UART1] 📖 BEFORE mcpwm_set_frequency(): cfg0=0x%08X\n", cfg0_before);
-        Serial.printf("[UART1]    prescaler=%u, period(alt1)=%u, period(alt2)=%u\n",
-                     prescale_before + 1, period_before_alt1 + 1, period_before_alt2 + 1);
-
-        esp_err_t err = mcpwm_set_frequency(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM, frequency);
+    if (!faultTimerReady) {
+        // Free-running 1 µs counter; each arm moves the alarm ahead of it.
+        // The IRAM ISR trips directly, no esp_timer task in the stall path.
+        timer_config_t config = {};
+        config.alarm_en = TIMER_ALARM_DIS;
+        config.counter_en = TIMER_PAUSE;
+        config.intr_type = TIMER_INTR_LEVEL;
+        config.counter_dir = TIMER_COUNT_UP;
+        config.auto_reload = TIMER_AUTORELOAD_DIS;
+        config.divider = 80;  // APB 80 MHz → 1 µs ticks
+
+        esp_err_t err = timer_init(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT, &config);
+        if (err == ESP_OK) {
+            err = timer_isr_callback_add(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT,
+                                         faultTimerCallback, this, ESP_INTR_FLAG_IRAM);
+        }
         if (err != ESP_OK) {
-            Serial.printf("[UART1] PWM frequency set failed: %s\n", esp_err_to_name(err));
+            Serial.printf("[UART1] ❌ Fault watchdog init failed: %s\n", esp_err_to_name(err));
             return false;
         }
+        timer_set_counter_value(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT, 0);
+        timer_start(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT);
+        faultTimerReady = true;
+    }
 
-        // Read register AFTER API call
-        uint32_t cfg0_after = MCPWM1.timer[0].timer_cfg0.val;
-        uint32_t prescale_after = (cfg0_after & 0xFF);
-        uint32_t period_after_alt1 = ((cfg0_after >> 16) & 0xFF);
-        uint32_t period_after_alt2 = ((cfg0_after >> 8) & 0xFFFF);
-        Serial.printf("[UART1] 📖 AFTER mcpwm_set_frequency(): cfg0=0x%08X\n", cfg0_after);
-        Serial.printf("[UART1]    prescaler=%u, period(alt1)=%u, period(alt2)=%u\n",
-                     prescale_after + 1, period_after_alt1 + 1, period_after_alt2 + 1);
-
-        // Update stored values with ACTUAL register values
-        pwmPrescaler = prescale_after + 1;
-        pwmPeriod = period_after_alt2 + 1;  // Using alt2 for now
-        pwmFrequency = frequency;
-
-        Serial.printf("[UART1] ✅ PWM frequency updated: %u Hz (prescaler=%u, period=%u)\n",
-                     frequency, pwmPrescaler, pwmPeriod);
-    } else {
-        // Same prescaler - update period only using LL API (no PWM stop!)
-        Serial.printf("[UART1] ✅ Keep prescaler=%u, update period only (glitch-free)\n", pwmPrescaler);
-        updatePWMRegistersDirectly(new_period, pwmDuty);
-
-        // Update stored values
-        pwmPeriod = new_period;
-        pwmFrequency = frequency;
+    updateFaultThresholds();
+    faultOverCount = 0;
+    faultUnderCount = 0;
+    faultRunning = false;
+    faultLastEdgeUs = esp_timer_get_time();
+    faultArmed = true;
 
-        Serial.printf("[UART1] ✅ PWM frequency updated (no-stop): %u Hz (period=%u)\n",
-                     frequency, pwmPeriod);
+    if (faultStallMs > 0) {
+        startFaultWatchdog((uint64_t)faultStallMs * 1000);
     }
-
     return true;
 }
 
-bool UART1Mux::setPWMDuty(float duty) {
-    if (currentMode != MODE_PWM_RPM) {
+bool UART1Mux::setFaultLimits(uint32_t maxRpm, uint32_t minRpm, uint32_t stallMs,
+                              uint32_t confirmEdges) {
+    if (maxRpm > 1000000 || (maxRpm > 0 && minRpm >= maxRpm)) {
+        Serial.printf("[UART1] Invalid speed limits: max %u, min %u RPM\n", maxRpm, minRpm);
         return false;
     }
-
-    if (duty < 0.0 || duty > 100.0) {
+    if (stallMs > 5000) {
+        Serial.printf("[UART1] Invalid stall timeout: %u ms (valid: 0-5000)\n", stallMs);
+        return false;
+    }
+    if (confirmEdges < 1 || confirmEdges > 16) {
+        Serial.printf("[UART1] Invalid confirm edges: %u (valid: 1-16)\n", confirmEdges);
         return false;
     }
 
-    // Output pulse on GPIO 12 BEFORE changing duty cycle (to observe glitches)
-    outputPWMChangePulse();
-
-    // Read register BEFORE update
-    uint32_t cfg0_before = MCPWM1.timer[0].timer_cfg0.val;
-    Serial.printf("[UART1] 📖 BEFORE duty update: cfg0=0x%08X\n", cfg0_before);
-
-    // TRULY GLITCH-FREE UPDATE USING LL API
-    // Update duty shadow register only (period unchanged)
-    updatePWMRegistersDirectly(pwmPeriod, duty);
+    faultMaxRpm = maxRpm;
+    faultMinRpm = minRpm;
+    faultStallMs = stallMs;
+    faultConfirmEdges = confirmEdges;
+    updateFaultThresholds();
 
-    // Read register AFTER update
-    uint32_t cfg0_after = MCPWM1.timer[0].timer_cfg0.val;
-    Serial.printf("[UART1] 📖 AFTER duty update: cfg0=0x%08X\n", cfg0_after);
+    if (faultArmed && !faultLatched) {
+        if (faultStallMs > 0) {
+            startFaultWatchdog((uint64_t)faultStallMs * 1000);
+        } else {
+            stopFaultWatchdog();
+        }
+    }
+    return true;
+}
 
-    pwmDuty = duty;
+void UART1Mux::updateFaultThresholds() {
+    // period = 80 MHz × 60 / (RPM × pole pairs), so the ISR only compares ticks
+    const uint64_t ticksPerMinute = (uint64_t)CAPTURE_CLK_HZ * 60;
 
-    Serial.printf("[UART1] ✅ PWM duty updated (no-stop, LL API): %.1f%%\n", duty);
+    uint64_t minPeriod = faultMaxRpm ? ticksPerMinute / ((uint64_t)faultMaxRpm * polePairs) : 0;
+    uint64_t maxPeriod = faultMinRpm ? ticksPerMinute / ((uint64_t)faultMinRpm * polePairs) : UINT32_MAX;
 
-    return true;
+    faultMinPeriodTicks = (uint32_t)minPeriod;
+    faultMaxPeriodTicks = (maxPeriod > UINT32_MAX) ? UINT32_MAX : (uint32_t)maxPeriod;
 }
 
-bool UART1Mux::setPWMFrequencyAndDuty(uint32_t frequency, float duty) {
-    Serial.printf("[UART1] 🚀 setPWMFrequencyAndDuty() ENTRY: freq=%u Hz, duty=%.1f%%\n", frequency, duty);
-    Serial.printf("[UART1] 📊 Current: prescaler=%u, period=%u, freq=%u, duty=%.1f\n",
-                     pwmPrescaler, pwmPeriod, pwmFrequency, pwmDuty);
-    Serial.flush();
-
-    if (currentMode != MODE_PWM_RPM) {
-        Serial.println("[UART1] ❌ ABORT: Not in PWM_RPM mode");
-        return false;
+void IRAM_ATTR UART1Mux::checkFaultPeriod(uint32_t periodTicks, int64_t nowUs) {
+    if (periodTicks < faultMinPeriodTicks) {
+        faultOverCount = faultOverCount + 1;
+        if (faultOverCount >= faultConfirmEdges) {
+            tripFault(FAULT_OVERSPEED, periodTicks, nowUs);
+            return;
+        }
+    } else {
+        faultOverCount = 0;
     }
 
-    // Validate parameters
-    if (!validatePWMFrequency(frequency)) {
-        Serial.println("[UART1] ❌ ABORT: Frequency validation failed");
-        return false;
+    if (periodTicks > faultMaxPeriodTicks) {
+        // Spin-up from standstill is not an underspeed
+        if (faultRunning) {
+            faultUnderCount = faultUnderCount + 1;
+            if (faultUnderCount >= faultConfirmEdges) {
+                tripFault(FAULT_UNDERSPEED, periodTicks, nowUs);
+            }
+        }
+    } else {
+        faultUnderCount = 0;
+        faultRunning = true;
     }
+}
 
-    if (duty < 0.0 || duty > 100.0) {
-        Serial.println("[UART1] ❌ ABORT: Duty validation failed");
-        return false;
+void IRAM_ATTR UART1Mux::applyFaultForce(bool force) {
+    // GEN_FORCE: continuous software force on generator A, update method 0
+    // (immediately) so the output changes within the current PWM period.
+    // A mode: 0 = off, 1 = low, 2 = high
+    uint32_t mode = force ? (faultSafeHigh ? 2u : 1u) : 0u;
+    MCPWM1.operators[MCPWM_TIMER_UART1_PWM].gen_force.val = mode << 6;
+}
+
+void IRAM_ATTR UART1Mux::tripFault(uint8_t code, uint32_t periodTicks, int64_t detectUs) {
+    portENTER_CRITICAL_SAFE(&faultMux);
+    if (faultLatched) {
+        portEXIT_CRITICAL_SAFE(&faultMux);
+        return;
     }
+    applyFaultForce(true);
+    faultLatched = true;
+    faultEvent = true;
+
+    int64_t nowUs = esp_timer_get_time();
+    uint32_t reactionUs = (nowUs > detectUs) ? (uint32_t)(nowUs - detectUs) : 0;
+    faultState.code = code;
+    faultState.periodTicks = periodTicks;
+    faultState.timestampUs = nowUs;
+    faultState.reactionUs = reactionUs;
+    faultState.tripCount = faultState.tripCount + 1;
+    portEXIT_CRITICAL_SAFE(&faultMux);
+
+    UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_FAULT, code, periodTicks, reactionUs);
+}
 
-    // Mark PWM parameter change with GPIO12 toggle (non-blocking, glitch-free)
-    outputPWMChangePulse();
+void UART1Mux::clearFault() {
+    portENTER_CRITICAL_SAFE(&faultMux);
+    applyFaultForce(false);
+    faultLatched = false;
+    faultOverCount = 0;
+    faultUnderCount = 0;
+    faultRunning = false;
+    faultLastEdgeUs = esp_timer_get_time();
+    portEXIT_CRITICAL_SAFE(&faultMux);
 
-    // Calculate required period based on current prescaler
-    uint32_t target_ticks = 80000000 / frequency;
-    uint32_t new_period = target_ticks / pwmPrescaler;
+    UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_FAULT, FAULT_NONE, 0, 0);
 
-    // Check if period is in valid range
-    if (new_period < 2 || new_period > 65535) {
-        Serial.printf("[UART1] ❌ Period out of range: %u (must be 2-65535)\n", new_period);
-        return false;
+    if (faultArmed && faultStallMs > 0) {
+        startFaultWatchdog((uint64_t)faultStallMs * 1000);
     }
+}
 
-    Serial.printf("[UART1] 🚀 Updating PWM: %u Hz (period=%u), %.1f%% duty\n", frequency, new_period, duty);
-    Serial.flush();
-
-    // Use the unified shadow register update function (glitch-free)
-    updatePWMRegistersDirectly(new_period, duty);
-
-    // Update stored frequency
-    pwmFrequency = frequency;
+FaultStatus UART1Mux::getFaultStatus() {
+    portENTER_CRITICAL_SAFE(&faultMux);
+    FaultStatus status = faultState;
+    status.latched = faultLatched;
+    portEXIT_CRITICAL_SAFE(&faultMux);
 
-    Serial.printf("[UART1] ✅ PWM updated: %u Hz, %.1f%% (prescaler=%u, period=%u)\n",
-                 frequency, duty, pwmPrescaler, pwmPeriod);
+    status.armed = faultArmed;
+    if (!status.latched) {
+        status.code = FAULT_NONE;
+    }
+    if (status.periodTicks > 0) {
+        status.rpm = (float)CAPTURE_CLK_HZ * 60.0f / ((float)status.periodTicks * polePairs);
+    }
+    return status;
+}
 
-    Serial.println("[UART1] 🏁 setPWMFrequencyAndDuty() RETURN TRUE");
-    Serial.flush();
+bool UART1Mux::takeFaultEvent() {
+    if (!faultEvent) {
+        return false;
+    }
+    faultEvent = false;
     return true;
 }
 
-void UART1Mux::setPWMEnabled(bool enable) {
-    if (currentMode != MODE_PWM_RPM) {
-        return;
+const char* UART1Mux::getFaultName(uint8_t code) {
+    switch (code) {
+        case FAULT_OVERSPEED:  return "OVERSPEED";
+        case FAULT_UNDERSPEED: return "UNDERSPEED";
+        case FAULT_STALL:      return "STALL";
+        default:               return "NONE";
     }
+}
 
-    pwmEnabled = enable;
-
-    if (enable) {
-        // Start MCPWM timer
-        mcpwm_start(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM);
-    } else {
-        // Stop MCPWM timer
-        mcpwm_stop(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM);
+void UART1Mux::startFaultWatchdog(uint64_t delayUs) {
+    if (!faultTimerReady) {
+        return;
     }
+    // Alarm on the counter's timeline: re-arming only moves the alarm. The
+    // driver holds the group lock across the ISR callback, so this lands
+    // after any reschedule the ISR computed from the state before the change.
+    uint64_t nowTicks = 0;
+    timer_get_counter_value(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT, &nowTicks);
+    timer_set_alarm_value(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT,
+                          nowTicks + (delayUs < 100 ? 100 : delayUs));
+    timer_set_alarm(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT, TIMER_ALARM_EN);
 }
 
-// ============================================================================
-// MCPWM Capture ISR Callback
-// ============================================================================
-
-bool IRAM_ATTR UART1Mux::captureCallback(mcpwm_unit_t mcpwm,
-                                          mcpwm_capture_channel_id_t cap_channel,
-                                          const cap_event_data_t *edata,
-                                          void *user_data) {
-    // This runs in ISR context - must be fast!
-    static uint32_t lastCapture = 0;
-    uint32_t currentCapture = edata->cap_value;
-
-    if (lastCapture != 0) {
-        // Calculate period between captures (in timer ticks)
-        if (currentCapture > lastCapture) {
-            capturePeriod = currentCapture - lastCapture;
-        } else {
-            // Handle timer overflow (32-bit counter)
-            capturePeriod = (UINT32_MAX - lastCapture) + currentCapture + 1;
-        }
-        newCaptureAvailable = true;
+void UART1Mux::stopFaultWatchdog() {
+    if (faultTimerReady) {
+        timer_set_alarm(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT, TIMER_ALARM_DIS);
     }
+}
 
-    lastCapture = currentCapture;
-    lastCaptureTime = millis();  // Track last valid capture time
-
-    return false;  // Don't wake higher priority task
+bool IRAM_ATTR UART1Mux::faultTimerCallback(void* arg) {
+    static_cast<UART1Mux*>(arg)->faultWatchdogStep();
+    return false;  // No task woken
 }
 
-void UART1Mux::updateRPMFrequency() {
-    if (currentMode != MODE_PWM_RPM) {
-        rpmFrequency = 0.0;
+void IRAM_ATTR UART1Mux::faultWatchdogStep() {
+    // ISR (hardware timer alarm). The driver re-enables the alarm after this
+    // returns, so every path leaves the alarm value in the future: the next
+    // deadline, or an hour out when idle until a task re-arms it.
+    uint64_t nowTicks = timer_group_get_counter_value_in_isr(TIMER_GROUP_UART1_FAULT,
+                                                             TIMER_IDX_UART1_FAULT);
+    uint64_t nextTicks = nowTicks + FAULT_TIMER_IDLE_US;
+
+    if (!faultArmed || faultLatched || faultStallMs == 0) {
+        // Re-armed by setFaultProtection() / setFaultLimits() / clearFault()
+        timer_group_set_alarm_value_in_isr(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT, nextTicks);
         return;
     }
 
-    // Check if new capture data is available
-    if (newCaptureAvailable) {
-        newCaptureAvailable = false;
+    int64_t nowUs = esp_timer_get_time();
 
-        // Calculate frequency from captured period
-        // Formula: frequency = MCPWM_CAPTURE_CLK / period
-        // MCPWM_CAPTURE_CLK = 80,000,000 Hz (80 MHz APB clock)
-        if (capturePeriod > 0) {
-            rpmFrequency = 80000000.0 / (float)capturePeriod;
-            lastRPMUpdate = lastCaptureTime;
+    // Counter mode has no per-edge interrupt: any count change is an edge
+    if (rpmMethod == RPM_METHOD_COUNTER && counterReady) {
+        // Register read: the driver getter is not IRAM-safe
+        int16_t count = 0;
+        pcnt_ll_get_counter_value(&PCNT, PCNT_UNIT_UART1_RPM, &count);
+        if (count != faultLastPcnt) {
+            faultLastPcnt = count;
+            faultLastEdgeUs = nowUs;
         }
     }
 
-    // Check for signal timeout (no capture in last 500ms)
-    unsigned long now = millis();
-    if ((now - lastRPMUpdate) > 500) {
-        rpmFrequency = 0.0;  // Signal lost
+    // Seqlock read: a torn anchor near a 2^32 us rollover would trip a false stall.
+    // Safe in this ISR: both drivers allocate at the default level 1, so it
+    // never preempts a half-written anchor on its own core.
+    int64_t lastEdgeUs = readLastCaptureUs();
+    if (faultLastEdgeUs > lastEdgeUs) {
+        lastEdgeUs = faultLastEdgeUs;
     }
-}
+    int64_t stallUs = (int64_t)faultStallMs * 1000;
+    int64_t deadlineUs = lastEdgeUs + stallUs;
 
-bool UART1Mux::hasRPMSignal() const {
-    if (currentMode != MODE_PWM_RPM) {
-        return false;
+    if (faultRunning && nowUs >= deadlineUs) {
+        tripFault(FAULT_STALL, 0, deadlineUs);
+    } else {
+        // Not due yet: sleep until the deadline of the newest edge. Before the
+        // fan first reaches speed there is nothing to time, so just poll.
+        uint64_t delayUs = faultRunning ? (uint64_t)(deadlineUs - nowUs) : (uint64_t)stallUs;
+        nextTicks = nowTicks + (delayUs < 100 ? 100 : delayUs);
     }
-
-    // Signal detected if frequency > 0 and updated within last 500ms
-    return (rpmFrequency > 0.0) && ((millis() - lastRPMUpdate) < 500);
+    timer_group_set_alarm_value_in_isr(TIMER_GROUP_UART1_FAULT, TIMER_IDX_UART1_FAULT, nextTicks);
 }
 
 // ============================================================================
@@ -482,7 +2315,7 @@ void UART1Mux::resetUARTStatistics() {
 // Private Helper Functions
 // ============================================================================
 
-bool UART1Mux::initUART() {
+uart_config_t UART1Mux::buildUARTConfig() const {
     uart_config_t uart_config = {
         .baud_rate = (int)uartBaudRate,
         .data_bits = uartDataBits,
@@ -492,31 +2325,94 @@ bool UART1Mux::initUART() {
         .rx_flow_ctrl_thresh = 122,
         .source_clk = UART_SCLK_APB,
     };
+    return uart_config;
+}
+
+bool UART1Mux::prepareDrivers() {
+    if (uartDriverReady) {
+        return true;
+    }
 
+    uart_config_t uart_config = buildUARTConfig();
     esp_err_t err = uart_param_config(uartNum, &uart_config);
     if (err != ESP_OK) {
         return false;
     }
 
-    err = uart_set_pin(uartNum, PIN_UART1_TX, PIN_UART1_RX,
-                      UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    err = uart_driver_install(uartNum, 2048, 1024, 0, NULL, 0);
     if (err != ESP_OK) {
         return false;
     }
+    uartAppliedConfig = uart_config;
+    uartDriverReady = true;
 
-    // Configure TX pin with internal pull-up (as requested)
-    gpio_set_pull_mode((gpio_num_t)PIN_UART1_TX, GPIO_PULLUP_ONLY);
-    gpio_set_pull_mode((gpio_num_t)PIN_UART1_RX, GPIO_PULLUP_ONLY);
+    // Installed but detached: RX sees a constant idle level, TX is not routed
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, U1RXD_IN_IDX, false);
+    return true;
+}
 
-    err = uart_driver_install(uartNum, 2048, 1024, 0, NULL, 0);
+bool UART1Mux::initUART() {
+    if (!prepareDrivers()) {
+        return false;
+    }
+
+    // Only write the config if it changed while parked
+    uart_config_t uart_config = buildUARTConfig();
+    if (uart_config.baud_rate != uartAppliedConfig.baud_rate ||
+        uart_config.data_bits != uartAppliedConfig.data_bits ||
+        uart_config.parity != uartAppliedConfig.parity ||
+        uart_config.stop_bits != uartAppliedConfig.stop_bits) {
+        esp_err_t err = uart_param_config(uartNum, &uart_config);
+        if (err != ESP_OK) {
+            return false;
+        }
+        uartAppliedConfig = uart_config;
+    }
+
+    // Route TX/RX through the GPIO matrix
+    esp_err_t err = uart_set_pin(uartNum, PIN_UART1_TX, PIN_UART1_RX,
+                                 UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
     if (err != ESP_OK) {
         return false;
     }
 
+    // Configure TX pin with internal pull-up (as requested)
+    gpio_set_pull_mode((gpio_num_t)PIN_UART1_TX, GPIO_PULLUP_ONLY);
+    gpio_set_pull_mode((gpio_num_t)PIN_UART1_RX, GPIO_PULLUP_ONLY);
+
+    // Nothing received while parked belongs to this session
+    uart_flush_input(uartNum);
+
+    // Settled once TX shows the UART idle level (mark = high)
+    waitPinLevel(PIN_UART1_TX, 1, MODE_SETTLE_TIMEOUT_US);
     return true;
 }
 
 bool UART1Mux::initPWM() {
+    if (pwmDriverReady) {
+        // Parked timer keeps its registers: apply what changed while parked
+        PWMSolution sol;
+        if (PWMSolver::solve(mcpwmClockFreq, pwmFrequency, pwmPrescaler, sol) &&
+            (sol.prescaler != pwmPrescaler || sol.period != pwmPeriod)) {
+            updatePWMPrescalerDirectly(sol.prescaler, sol.period);  // Timer stopped: no glitch
+        }
+        updatePWMRegistersDirectly(pwmPeriod, pwmDuty);
+
+        // Route generator A back to the pin and restart
+        mcpwm_gpio_init(MCPWM_UNIT_UART1_PWM, MCPWM0A, PIN_UART1_TX);
+        complementaryActive = false;
+        if (complementaryEnabled && !applyComplementaryOutput()) {
+            Serial.println("[UART1] ⚠️ Complementary output not applied, single output only");
+        }
+        ditherActive = false;
+        if (ditherEnabled && !startDutyDither()) {
+            Serial.println("[UART1] ⚠️ Duty dither not started, tick resolution only");
+        }
+        mcpwm_start(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM);
+        pwmEnabled = true;
+        return true;
+    }
+
     // Initialize MCPWM for PWM output (replaces LEDC)
     // Step 1: Configure GPIO for MCPWM
     mcpwm_gpio_init(MCPWM_UNIT_UART1_PWM, MCPWM0A, PIN_UART1_TX);
@@ -546,6 +2442,18 @@ bool UART1Mux::initPWM() {
     mcpwm_set_duty_type(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM,
                         MCPWM_GEN_UART1_PWM, MCPWM_DUTY_MODE_0);
 
+    // Optional complementary pair through the dead-time module
+    complementaryActive = false;
+    if (complementaryEnabled && !applyComplementaryOutput()) {
+        Serial.println("[UART1] ⚠️ Complementary output not applied, single output only");
+    }
+
+    // Duty dither (the timer survives mode changes, only the modulator pauses)
+    ditherActive = false;
+    if (ditherEnabled && !startDutyDither()) {
+        Serial.println("[UART1] ⚠️ Duty dither not started, tick resolution only");
+    }
+
     // Step 5: Read actual register values
     uint32_t cfg0_init = MCPWM1.timer[0].timer_cfg0.val;
 
@@ -567,9 +2475,10 @@ bool UART1Mux::initPWM() {
     // NOT a value computed from initial frequency (which leads to wrong calculations later)
     // ESP-IDF's mcpwm_init() uses APB_CLK (80 MHz) directly
     // Therefore: actual_frequency = 80MHz / (prescaler × period)
-    mcpwmClockFreq = 80000000;  // Use actual APB clock, not reverse-calculated value
+    mcpwmClockFreq = PWMSolver::TIMER_CLK_HZ;  // Use actual APB clock, not reverse-calculated value
 
     pwmEnabled = true;
+    pwmDriverReady = true;  // Later entries only re-attach
     Serial.printf("[UART1] ✅ MCPWM PWM initialized (GPIO %d, %u Hz, %.1f%% duty)\n",
                  PIN_UART1_TX, pwmFrequency, pwmDuty);
     Serial.printf("[UART1] 📖 Actual register: prescaler=%u, period=%u\n", pwmPrescaler, pwmPeriod);
@@ -597,6 +2506,36 @@ bool UART1Mux::initPWM() {
 }
 
 bool UART1Mux::initRPM() {
+    if (captureReady) {
+        // Parked channel: re-route the pin, restart the pipeline, unmask
+        mcpwm_gpio_init(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_1, PIN_UART1_RX);
+        gpio_set_pull_mode((gpio_num_t)PIN_UART1_RX, GPIO_PULLUP_ONLY);
+
+        xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+        taskENTER_CRITICAL(&rpmMux);
+        resetCapturePipelineLocked();
+        publishTachLocked(0, 0, 0);
+        dutyHighValid = false;
+        taskEXIT_CRITICAL(&rpmMux);
+        xSemaphoreGive(rpmConsumerLock);
+        lastCaptureTime = millis();
+        lastRPMUpdate = millis();
+
+        if (dutyCaptureEnabled != captureBothEdgesApplied || capturePrescale != capturePrescaleApplied) {
+            // Edge selection or prescaler changed while parked
+            MCPWMCapture::disable(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_UART1_RPM);
+            esp_err_t err = enableCaptureChannel();
+            if (err != ESP_OK) {
+                Serial.printf("[UART1] ❌ MCPWM Capture enable failed: %s\n", esp_err_to_name(err));
+                return false;
+            }
+        } else {
+            setCaptureInterrupt(true);
+        }
+        initCounter();  // Capture keeps working without it
+        return true;
+    }
+
     // Initialize MCPWM Capture for frequency measurement
 
     // Step 1: Route GPIO to MCPWM capture signal
@@ -614,31 +2553,37 @@ bool UART1Mux::initRPM() {
     // Step 2: Set pull-up on capture input for stable idle state
     gpio_set_pull_mode((gpio_num_t)PIN_UART1_RX, GPIO_PULLUP_ONLY);
 
-    // Step 3: Configure capture parameters
-    mcpwm_capture_config_t cap_conf;
-    cap_conf.cap_edge = MCPWM_POS_EDGE;        // Capture on rising edge
-    cap_conf.cap_prescale = 1;                  // No prescaling (80 MHz)
-    cap_conf.capture_cb = captureCallback;      // ISR callback
-    cap_conf.user_data = nullptr;               // No user data needed
+    // Step 3: Reset capture pipeline before the first edge can arrive
+    xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+    resetCapturePipelineLocked();  // ISR not installed yet: rpmMux not needed
+    xSemaphoreGive(rpmConsumerLock);
 
-    // Step 4: Enable capture channel
-    esp_err_t result = mcpwm_capture_enable_channel(MCPWM_UNIT_UART1_RPM,
-                                                     MCPWM_CAP_UART1_RPM,
-                                                     &cap_conf);
+    // Step 4: Configure and enable capture channel
+    esp_err_t result = enableCaptureChannel();
 
     if (result == ESP_OK) {
         // Initialize state variables
-        capturePeriod = 0;
-        newCaptureAvailable = false;
         lastCaptureTime = millis();
         lastRPMUpdate = millis();
-        rpmFrequency = 0.0;
+        taskENTER_CRITICAL(&rpmMux);
+        publishTachLocked(0, 0, 0);
+        taskEXIT_CRITICAL(&rpmMux);
 
         Serial.printf("[UART1] ✅ MCPWM Capture initialized:\n");
         Serial.printf("  - Unit: MCPWM_UNIT_%d\n", MCPWM_UNIT_UART1_RPM);
         Serial.printf("  - Channel: CAP%d\n", (MCPWM_CAP_UART1_RPM == MCPWM_SELECT_CAP1) ? 1 : 0);
         Serial.printf("  - GPIO: %d (RX1)\n", PIN_UART1_RX);
-        Serial.printf("  - Edge: Rising, Clock: 80 MHz\n");
+        Serial.printf("  - Edge: %s, Clock: 80 MHz\n",
+                     dutyCaptureEnabled ? "Both (input duty)" : "Rising");
+
+        // Gated counter for the high-frequency range (capture keeps working without it)
+        if (initCounter()) {
+            Serial.printf("  - PCNT: unit %d, gate %u ms, crossover %u Hz ±%u%% (%s)\n",
+                         PCNT_UNIT_UART1_RPM, rpmGateMs, rpmCrossoverHz, rpmHysteresisPct,
+                         rpmAutoSwitch ? "auto" : "off");
+        } else {
+            Serial.println("  - PCNT: unavailable, capture only");
+        }
         return true;
     }
 
@@ -647,23 +2592,120 @@ bool UART1Mux::initRPM() {
 }
 
 void UART1Mux::deinitUART() {
-    uart_driver_delete(uartNum);
+    // Keep the driver: tie the RX input idle (TX is detached by releasePins())
+    esp_rom_gpio_connect_in_signal(GPIO_MATRIX_CONST_ONE_INPUT, U1RXD_IN_IDX, false);
+}
+
+bool UART1Mux::waitPinLevel(int pin, int level, uint32_t timeoutUs) {
+    // Read back the pad (input enable does not touch the matrix routing)
+    PIN_INPUT_ENABLE(GPIO_PIN_MUX_REG[pin]);
+    int64_t deadline = esp_timer_get_time() + timeoutUs;
+    while (gpio_get_level((gpio_num_t)pin) != level) {
+        if (esp_timer_get_time() >= deadline) {
+            switchSettleTimeouts++;
+            return false;
+        }
+    }
+    return true;
+}
+
+void UART1Mux::recordModeSwitch(int64_t startUs, bool fast) {
+    int64_t elapsed = esp_timer_get_time() - startUs;
+    uint32_t us = (elapsed < 0) ? 0 : (elapsed > UINT32_MAX) ? UINT32_MAX : (uint32_t)elapsed;
+    switchCount++;
+    if (fast) {
+        switchFastCount++;
+    }
+    switchLastUs = us;
+    switchSumUs += us;
+    if (us < switchMinUs) switchMinUs = us;
+    if (us > switchMaxUs) switchMaxUs = us;
+}
+
+ModeSwitchStats UART1Mux::getModeSwitchStats() const {
+    ModeSwitchStats stats;
+    stats.count = switchCount;
+    stats.fastCount = switchFastCount;
+    stats.settleTimeouts = switchSettleTimeouts;
+    if (switchCount > 0) {
+        stats.lastUs = switchLastUs;
+        stats.minUs = switchMinUs;
+        stats.maxUs = switchMaxUs;
+        stats.avgUs = (uint32_t)(switchSumUs / switchCount);
+    }
+    return stats;
+}
+
+void UART1Mux::resetModeSwitchStats() {
+    switchCount = 0;
+    switchFastCount = 0;
+    switchLastUs = 0;
+    switchMinUs = UINT32_MAX;
+    switchMaxUs = 0;
+    switchSumUs = 0;
+    switchSettleTimeouts = 0;
 }
 
 void UART1Mux::deinitPWM() {
+    stopRamp();
+    followActive = false;  // Request (followPending) is kept for the next entry
+    if (ditherActive) {
+        timer_pause(TIMER_GROUP_UART1_DITHER, TIMER_IDX_UART1_DITHER);
+        ditherActive = false;  // Request (ditherEnabled) is kept
+    }
+
+    // Hold the low side off while the pair is not driven (setting is kept)
+    if (complementaryActive) {
+        bool requested = complementaryEnabled;
+        complementaryEnabled = false;
+        applyComplementaryOutput();
+        complementaryEnabled = requested;
+    }
+
     // Stop MCPWM timer
     mcpwm_stop(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM);
     pwmEnabled = false;
 }
 
+esp_err_t UART1Mux::enableCaptureChannel() {
+    mcpwm_capture_config_t cap_conf;
+    cap_conf.cap_edge = dutyCaptureEnabled ? MCPWM_BOTH_EDGE  // Rising + falling (input duty)
+                                           : MCPWM_POS_EDGE;  // Capture on rising edge
+    cap_conf.cap_prescale = capturePrescale;    // One capture per N rising edges
+    cap_conf.capture_cb = captureCallback;      // ISR callback
+    cap_conf.user_data = this;                  // ISR pushes into this instance's ring
+
+    dutyHighValid = false;
+    esp_err_t err = MCPWMCapture::enable(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_UART1_RPM, &cap_conf);
+    captureReady = (err == ESP_OK);
+    if (captureReady) {
+        captureBothEdgesApplied = dutyCaptureEnabled;
+        capturePrescaleApplied = capturePrescale;
+    }
+    return err;
+}
+
 void UART1Mux::deinitRPM() {
-    // Disable MCPWM Capture channel
-    mcpwm_capture_disable_channel(MCPWM_UNIT_UART1_RPM, MCPWM_CAP_UART1_RPM);
+    // Stop the gated counter first so it cannot re-enable the capture interrupt
+    deinitCounter();
+
+    // Nothing to protect without a tach input (faultArmPending is kept)
+    faultArmed = false;
+    stopFaultWatchdog();
+
+    // Park the capture channel: interrupt masked, channel and ISR stay installed
+    if (captureReady) {
+        setCaptureInterrupt(false);
+    }
 
-    // Reset state variables
-    capturePeriod = 0;
-    newCaptureAvailable = false;
-    rpmFrequency = 0.0;
+    // Reset state variables (ISR no longer running)
+    xSemaphoreTake(rpmConsumerLock, portMAX_DELAY);
+    taskENTER_CRITICAL(&rpmMux);
+    resetCapturePipelineLocked();
+    publishTachLocked(0, 0, 0);
+    edgeRecBuffer = nullptr;  // A running step recording ends here
+    taskEXIT_CRITICAL(&rpmMux);
+    xSemaphoreGive(rpmConsumerLock);
 }
 
 void UART1Mux::releasePins() {
@@ -711,7 +2753,13 @@ bool UART1Mux::setPolePairs(uint32_t poles) {
         Serial.printf("[UART1] Invalid pole pairs: %u (valid: 1-12)\n", poles);
         return false;
     }
+    taskENTER_CRITICAL(&rpmMux);
     polePairs = poles;
+    rpmScaleQ16 = (60u << 16) / poles;
+    // Rescale the current reading so RPM never mixes old and new pole pairs
+    publishTachLocked(tachFreqQ10, tachPeriodQ4, tachTimestampUs);
+    taskEXIT_CRITICAL(&rpmMux);
+    updateFaultThresholds();
     return true;
 }
 
@@ -724,13 +2772,6 @@ bool UART1Mux::setMaxFrequency(uint32_t freq) {
     return true;
 }
 
-float UART1Mux::getCalculatedRPM() const {
-    if (currentMode != MODE_PWM_RPM) {
-        return 0.0;
-    }
-    // RPM = (frequency × 60) / pole_pairs
-    return (rpmFrequency * 60.0) / (float)polePairs;
-}
 
 // ============================================================================
 // Settings Persistence
@@ -748,6 +2789,40 @@ bool UART1Mux::saveSettings() {
     prefs.putUInt("polePairs", polePairs);
     prefs.putUInt("maxFreq", maxFrequency);
     prefs.putUInt("uartBaud", uartBaudRate);
+    prefs.putUInt("rpmAvgN", rpmAvgEdges);
+    prefs.putUInt("rpmAvgWin", rpmAvgWindowMs);
+    prefs.putUInt("rpmWinMode", (uint32_t)rpmWindowMode);
+    prefs.putUInt("rpmWinRevs", rpmWindowRevs);
+    prefs.putUInt("rpmTmoN", rpmTimeoutPeriods);
+    prefs.putUInt("rpmTmoMax", rpmTimeoutMaxMs);
+    prefs.putBool("fltEn", faultArmPending);
+    prefs.putUInt("fltMaxRpm", faultMaxRpm);
+    prefs.putUInt("fltMinRpm", faultMinRpm);
+    prefs.putUInt("fltStallMs", faultStallMs);
+    prefs.putUInt("fltN", faultConfirmEdges);
+    prefs.putBool("fltSafeHi", faultSafeHigh);
+    prefs.putBool("rpmEvt", rpmEventMode);
+    prefs.putUInt("rpmEvtN", rpmEventEdges);
+    prefs.putUInt("rpmEvtUs", rpmEventIntervalUs);
+    prefs.putBool("rpmCtrAuto", rpmAutoSwitch);
+    prefs.putUInt("rpmCross", rpmCrossoverHz);
+    prefs.putUInt("rpmHyst", rpmHysteresisPct);
+    prefs.putUInt("rpmGate", rpmGateMs);
+    prefs.putBool("rpmDutyCap", dutyCaptureEnabled);
+    prefs.putUInt("tachPre", capturePrescale);
+    prefs.putUInt("tachMinUs", tachMinPeriodUs);
+    prefs.putUInt("tachOutl", periodHistory.getOutlierTolerance());
+    prefs.putBool("cmplEn", complementaryEnabled);
+    prefs.putUInt("dtRiseNs", deadTimeRisingNs);
+    prefs.putUInt("dtFallNs", deadTimeFallingNs);
+    prefs.putBool("dithEn", ditherEnabled);
+    prefs.putUInt("dithHz", ditherRateHz);
+    prefs.putBool("fllEn", followPending);
+    prefs.putFloat("fllRatio", followRatio);
+    prefs.putFloat("fllOffset", followOffsetHz);
+    prefs.putUInt("fllN", followEveryN);
+    prefs.putFloat("fllGain", followGain);
+    prefs.putUInt("fllLockPpm", followLockPpm);
 
     prefs.end();
     Serial.println("[UART1] Settings saved to NVS");
@@ -763,9 +2838,71 @@ bool UART1Mux::loadSettings() {
 
     pwmFrequency = prefs.getUInt("pwmFreq", 1000);
     pwmDuty = prefs.getFloat("pwmDuty", 50.0);
-    polePairs = prefs.getUInt("polePairs", 2);
+    if (!setPolePairs(prefs.getUInt("polePairs", 2))) {
+        setPolePairs(2);
+    }
     maxFrequency = prefs.getUInt("maxFreq", 100000);
     uartBaudRate = prefs.getUInt("uartBaud", 115200);
+    rpmAvgEdges = prefs.getUInt("rpmAvgN", 16);
+    rpmAvgWindowMs = prefs.getUInt("rpmAvgWin", 100);
+    if (rpmAvgEdges < 1 || rpmAvgEdges > PeriodHistory::HISTORY_SIZE) {
+        rpmAvgEdges = 16;
+    }
+    rpmWindowRevs = prefs.getUInt("rpmWinRevs", 1);
+    if (rpmWindowRevs < 1 || rpmWindowRevs > 16) {
+        rpmWindowRevs = 1;
+    }
+    uint32_t windowMode = prefs.getUInt("rpmWinMode", RPM_WINDOW_FIXED);
+    rpmWindowMode = (windowMode <= RPM_WINDOW_REVOLUTION) ? (RPMWindowMode)windowMode : RPM_WINDOW_FIXED;
+    if (rpmWindowMode == RPM_WINDOW_ADAPTIVE && rpmAvgWindowMs == 0) {
+        rpmWindowMode = RPM_WINDOW_FIXED;  // Adaptive needs a time window
+    }
+    if (!setRPMTimeout(prefs.getUInt("rpmTmoN", 4), prefs.getUInt("rpmTmoMax", 500))) {
+        setRPMTimeout(4, 500);
+    }
+
+    rpmEventEdges = prefs.getUInt("rpmEvtN", 1);
+    rpmEventIntervalUs = prefs.getUInt("rpmEvtUs", 10000);
+    if (rpmEventEdges < 1 || rpmEventEdges > 1000 || rpmEventIntervalUs > 1000000) {
+        rpmEventEdges = 1;
+        rpmEventIntervalUs = 10000;
+    }
+    if (!setRPMCounterConfig(prefs.getBool("rpmCtrAuto", true), prefs.getUInt("rpmCross", 20000),
+                             prefs.getUInt("rpmHyst", 10), prefs.getUInt("rpmGate", 50))) {
+        setRPMCounterConfig(true, 20000, 10, 50);
+    }
+    if (!setTachFilter(prefs.getUInt("tachPre", 1), prefs.getUInt("tachMinUs", 0),
+                       prefs.getUInt("tachOutl", 0))) {
+        setTachFilter(1, 0, 0);
+    }
+    setInputDutyCapture(prefs.getBool("rpmDutyCap", false));
+    if (!setComplementaryOutput(prefs.getBool("cmplEn", false), prefs.getUInt("dtRiseNs", 500),
+                                prefs.getUInt("dtFallNs", 500))) {
+        setComplementaryOutput(false, 500, 500);
+    }
+    if (!setDutyDither(prefs.getBool("dithEn", false), prefs.getUInt("dithHz", 10000))) {
+        setDutyDither(false, 10000);
+    }
+    if (!setFollowLoop(prefs.getFloat("fllGain", 0.5f), prefs.getUInt("fllLockPpm", 1000))) {
+        setFollowLoop(0.5f, 1000);
+    }
+    if (!setFollowMode(prefs.getBool("fllEn", false), prefs.getFloat("fllRatio", 1.0f),
+                       prefs.getFloat("fllOffset", 0.0f), prefs.getUInt("fllN", 1))) {
+        setFollowMode(false);
+    }
+
+    if (!setFaultLimits(prefs.getUInt("fltMaxRpm", 0), prefs.getUInt("fltMinRpm", 0),
+                        prefs.getUInt("fltStallMs", 0), prefs.getUInt("fltN", 2))) {
+        setFaultLimits(0, 0, 0, 2);
+    }
+    faultSafeHigh = prefs.getBool("fltSafeHi", false);
+    setFaultProtection(prefs.getBool("fltEn", false));
+
+    rpmEventPending = prefs.getBool("rpmEvt", false);
+    if (rpmNotifyTask != nullptr) {
+        // Otherwise applied once the measurement task registers
+        setRPMEventMode(rpmEventPending, rpmEventEdges, rpmEventIntervalUs);
+    }
 
     prefs.end();
     Serial.println("[UART1] Settings loaded from NVS");
@@ -775,9 +2912,28 @@ bool UART1Mux::loadSettings() {
 void UART1Mux::resetToDefaults() {
     pwmFrequency = 1000;
     pwmDuty = 50.0;
-    polePairs = 2;
+    setPolePairs(2);
     maxFrequency = 100000;
     uartBaudRate = 115200;
+    rpmAvgEdges = 16;
+    rpmAvgWindowMs = 100;
+    rpmWindowMode = RPM_WINDOW_FIXED;
+    rpmWindowRevs = 1;
+    setRPMTimeout(4, 500);
+    setRPMEventMode(false, 1, 10000);
+    setRPMCounterConfig(true, 20000, 10, 50);
+    setInputDutyCapture(false);
+    setTachFilter(1, 0, 0);
+    setComplementaryOutput(false, 500, 500);
+    setDutyDither(false, 10000);
+    setFollowMode(false);
+    followRatio = 1.0f;
+    followOffsetHz = 0.0f;
+    followEveryN = 1;
+    setFollowLoop(0.5f, 1000);
+    setFaultProtection(false);
+    setFaultLimits(0, 0, 0, 2);
+    faultSafeHigh = false;
 
     Serial.println("[UART1] Settings reset to factory defaults");
 }
@@ -824,31 +2980,51 @@ void UART1Mux::outputPWMChangePulse() {
 // PWM Low-Level Register Manipulation
 // ============================================================================
 
-void UART1Mux::calculatePWMParameters(uint32_t frequency, uint32_t& prescaler, uint32_t& period) {
-    // ESP32-S3 MCPWM uses APB clock: 80 MHz
-    // Formula: output_freq = APB_CLK / (prescaler * period)
-    // We want: prescaler * period = APB_CLK / output_freq
+void UART1Mux::updatePWMPrescalerDirectly(uint32_t prescaler, uint32_t period) {
+    // Prescaler and period go out in one store, but only the period is
+    // shadowed (PERIOD_UPMETHOD = TEZ): the prescaler switches immediately,
+    // so the rest of the running period counts the old period at the new
+    // tick rate and the new pair is complete from the next TEZ. The timer
+    // keeps running (no mcpwm_set_frequency() stop/restart).
 
-    const uint32_t APB_CLK = 80000000;  // 80 MHz
-    uint32_t target_ticks = APB_CLK / frequency;
+    // Command batch in progress on this task: releasePWMUpdates() writes the pair
+    if (pwmHoldTask != nullptr && !ditherActive && pwmHoldTask == xTaskGetCurrentTaskHandle()) {
+        pwmPrescaler = prescaler;
+        pwmPeriod = period;
+        pwmHoldPending = true;
+        return;
+    }
+
+    taskENTER_CRITICAL(&mux);
 
-    // Find optimal prescaler and period combination
-    // Goal: Maximize period for better resolution while keeping prescaler in range (1-256)
+    uint32_t cfg0_before = MCPWM1.timer[0].timer_cfg0.val;
+    uint32_t cfg0_new = (cfg0_before & 0xFF000000)            // Keep bits[31:24] (shadow mode)
+                      | (((period - 1) & 0xFFFF) << 8)        // Period bits[23:8]
+                      | ((prescaler - 1) & 0xFF);             // Prescaler bits[7:0]
 
-    // Start with prescaler = 1 for maximum resolution
-    prescaler = 1;
-    period = target_ticks;
+    MCPWM1.timer[0].timer_cfg0.val = cfg0_new;
 
-    // If period exceeds 65535 (16-bit limit), increase prescaler
-    while (period > 65535 && prescaler < 256) {
-        prescaler++;
-        period = target_ticks / prescaler;
-    }
+    UART1_TRACE(TRACE_LEVEL_REGISTER, TRACE_PWM_PRESCALER,
+                cfg0_before, MCPWM1.timer[0].timer_cfg0.val, prescaler);
 
-    // Ensure period is at least 2 (minimum valid value)
-    if (period < 2) {
-        period = 2;
-    }
+    pwmPrescaler = prescaler;
+    pwmPeriod = period;
+    ditherPeriod = period;  // Modulator scales to the new period from the next step
+
+    taskEXIT_CRITICAL(&mux);
+}
+
+float UART1Mux::getPWMActualFrequency() const {
+    uint32_t ticks = pwmPrescaler * pwmPeriod;
+    return (ticks > 0) ? (float)mcpwmClockFreq / (float)ticks : 0.0f;
+}
+
+int32_t UART1Mux::getPWMFrequencyErrorPpm() const {
+    PWMSolution sol;
+    sol.prescaler = pwmPrescaler;
+    sol.period = pwmPeriod;
+    PWMSolver::evaluate(mcpwmClockFreq, pwmFrequency, sol);
+    return sol.errorPpm;
 }
 
 void UART1Mux::updatePWMRegistersDirectly(uint32_t period, float duty) {
@@ -862,64 +3038,58 @@ void UART1Mux::updatePWMRegistersDirectly(uint32_t period, float duty) {
     //
     // Register details:
     // - timer_cfg0 [31:0]: prescaler[7:0], period[23:8], period_upmethod[24]
+    //
+    // No Serial output here: the critical section blocks interrupts (including
+    // the capture ISR). Register values go to the binary trace ring instead and
+    // are decoded later with TRACE DUMP.
+
+    // Dithered duty is a 16-bit fraction: computed here, outside the critical
+    // section, so the ISR only does integer math
+    uint32_t dutyQ16 = (uint32_t)(duty * 655.36f + 0.5f);
+
+    // Command batch in progress on this task: keep the values, releasePWMUpdates() writes them
+    if (pwmHoldTask != nullptr && !ditherActive && pwmHoldTask == xTaskGetCurrentTaskHandle()) {
+        pwmPeriod = period;
+        pwmDuty = duty;
+        pwmHoldPending = true;
+        return;
+    }
 
     // Critical section for atomic register updates
     taskENTER_CRITICAL(&mux);
 
     // ===== Update Period (if changed) =====
     if (period != pwmPeriod) {
-        // Use ESP-IDF HAL functions to safely update period
-        // This ensures proper synchronization and avoids register corruption
-
-        // For very high frequencies (period < 100), use safer update via dedicated register field
-        // For normal frequencies, use direct shadow register update
-
-        // Read register BEFORE write for debugging
-        uint32_t cfg0_before = MCPWM1.timer[0].timer_cfg0.val;
-        uint32_t prescale_before = (cfg0_before & 0xFF);
-        uint32_t period_before = ((cfg0_before >> 8) & 0xFFFF);     // bits [23:8]
-        Serial.printf("[UART1] 📖 BEFORE: cfg0=0x%08X\n", cfg0_before);
-        Serial.printf("[UART1]    prescaler=%u (bits[7:0]=0x%02X)\n",
-                     prescale_before + 1, prescale_before);
-        Serial.printf("[UART1]    period (bits[23:8])=%u (raw=0x%04X)\n",
-                     period_before + 1, period_before);
-
         // SAFER METHOD: Modify only the period bits[23:8], preserve all other bits
         // CRITICAL: Must preserve bit[24] (shadow mode flag) to avoid hardware corruption!
         // Mask: 0xFFFF00FF keeps bits[31:24] and bits[7:0], clears only bits[23:8]
+        uint32_t cfg0_before = MCPWM1.timer[0].timer_cfg0.val;
         uint32_t cfg0_new = (cfg0_before & 0xFFFF00FF)  // Keep bits[31:24] (including shadow mode) and bits[7:0]
                           | (((period - 1) & 0xFFFF) << 8);  // Write new period to bits[23:8]
 
-        Serial.printf("[UART1] 🔍 Register update:\n");
-        Serial.printf("[UART1]    before=0x%08X (bit[24]=%d)\n", cfg0_before, (cfg0_before >> 24) & 1);
-        Serial.printf("[UART1]    masked=0x%08X (preserves high bits)\n", cfg0_before & 0xFFFF00FF);
-        Serial.printf("[UART1]    new_period=%u → shifted=0x%04X\n", period-1, ((period-1) << 8) & 0xFFFF00);
-        Serial.printf("[UART1]    cfg0_new=0x%08X (bit[24]=%d)\n", cfg0_new, (cfg0_new >> 24) & 1);
-
         MCPWM1.timer[0].timer_cfg0.val = cfg0_new;
 
-        Serial.printf("[UART1] 🔧 Updated period: %u (raw=0x%04X)\n",
-                     period, period - 1);
-
-        // Read register AFTER write to verify
-        uint32_t cfg0_after = MCPWM1.timer[0].timer_cfg0.val;
-        uint32_t prescale_after = (cfg0_after & 0xFF);
-        uint32_t period_after = ((cfg0_after >> 8) & 0xFFFF);       // bits [23:8]
-        Serial.printf("[UART1] 📖 AFTER:  cfg0=0x%08X\n", cfg0_after);
-        Serial.printf("[UART1]    prescaler=%u (bits[7:0]=0x%02X)\n",
-                     prescale_after + 1, prescale_after);
-        Serial.printf("[UART1]    period (bits[23:8])=%u (raw=0x%04X)\n",
-                     period_after + 1, period_after);
-
-        // Verify calculation
-        uint32_t calculated_freq = 80000000 / (pwmPrescaler * period);
-        Serial.printf("[UART1] 🧮 Expected frequency: 80MHz / (%u × %u) = %u Hz\n",
-                     pwmPrescaler, period, calculated_freq);
+        UART1_TRACE(TRACE_LEVEL_REGISTER, TRACE_PWM_PERIOD,
+                    cfg0_before, MCPWM1.timer[0].timer_cfg0.val, period);
 
         // Update stored period value
         pwmPeriod = period;
     }
 
+    if (ditherActive) {
+        // Period and duty reach the modulator together; the coarse compare
+        // applies at the same TEZ as the period, the ISR refines from there
+        ditherPeriod = period;
+        ditherDutyQ16 = dutyQ16;
+        MCPWM1.operators[MCPWM_TIMER_UART1_PWM].timestamp[MCPWM_GEN_UART1_PWM].val =
+            (uint32_t)(((uint64_t)period * dutyQ16) >> 16);
+        taskEXIT_CRITICAL(&mux);
+
+        UART1_TRACE(TRACE_LEVEL_VERBOSE, TRACE_PWM_DUTY, (uint32_t)(duty * 100.0f + 0.5f), period, 0);
+        pwmDuty = duty;
+        return;
+    }
+
     taskEXIT_CRITICAL(&mux);
 
     // ===== Update Duty Cycle =====
@@ -928,10 +3098,12 @@ void UART1Mux::updatePWMRegistersDirectly(uint32_t period, float duty) {
     esp_err_t duty_err = mcpwm_set_duty(MCPWM_UNIT_UART1_PWM, MCPWM_TIMER_UART1_PWM,
                                         MCPWM_GEN_UART1_PWM, duty);
     if (duty_err != ESP_OK) {
-        Serial.printf("[UART1] ❌ mcpwm_set_duty() failed: %s\n", esp_err_to_name(duty_err));
+        UART1_TRACE(TRACE_LEVEL_EVENT, TRACE_PWM_ERROR, duty_err, pwmFrequency, period);
         return;
     }
 
+    UART1_TRACE(TRACE_LEVEL_VERBOSE, TRACE_PWM_DUTY, (uint32_t)(duty * 100.0f + 0.5f), period, 0);
+
     // Update stored duty value
     pwmDuty = duty;
 }
@@ -5,16 +5,170 @@
 #include "driver/uart.h"
 #include "driver/ledc.h"
 #include "driver/mcpwm.h"
+#include "driver/pcnt.h"
+#include "driver/timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_timer.h"
 #include "PeripheralPins.h"
+#include "CaptureRing.h"
+#include "PWMSolver.h"
+#include <atomic>
+
+/**
+ * @brief Edge-to-publish latency of the RPM reading (microseconds)
+ *
+ * Measured from the capture ISR timestamp of the newest edge consumed to the
+ * moment the new fixed-point tach reading is published.
+ */
+struct RPMLatencyStats {
+    uint32_t count = 0;   ///< Number of published readings
+    uint32_t lastUs = 0;  ///< Latency of the most recent reading
+    uint32_t minUs = 0;   ///< Shortest latency
+    uint32_t maxUs = 0;   ///< Longest latency
+    uint32_t avgUs = 0;   ///< Mean latency
+};
+
+/**
+ * @brief Mode switch latency (setModeUART / setModePWM_RPM, microseconds)
+ *
+ * Measured from entry to the pin-state check of the new mode. Fast switches
+ * reuse the parked drivers; full switches install or initialize them.
+ */
+struct ModeSwitchStats {
+    uint32_t count = 0;       ///< Switches measured
+    uint32_t fastCount = 0;   ///< ...of which reused parked drivers
+    uint32_t lastUs = 0;
+    uint32_t minUs = 0;
+    uint32_t maxUs = 0;
+    uint32_t avgUs = 0;
+    uint32_t settleTimeouts = 0;  ///< Pin did not reach its idle level in time
+};
+
+/**
+ * @brief Diagnostics of the RPM measurement window
+ */
+struct RPMWindowStats {
+    uint32_t periods = 0;        ///< Periods averaged in the newest reading (0 = counter mode)
+    uint32_t windowUs = 0;       ///< Time spanned by those periods (gate time in counter mode)
+    float bandwidthHz = 0.0f;    ///< Effective -3 dB bandwidth of the average (0.443 / window)
+    uint32_t timeoutMs = 0;      ///< Current signal-lost timeout
+};
+
+/**
+ * @brief Duty cycle of the PWM signal on the RX (tach) input
+ *
+ * Statistics cover the last UART1Mux::DUTY_HISTORY_SIZE complete cycles
+ * (rising edge → falling edge → rising edge).
+ */
+struct InputDutyStats {
+    uint32_t cycles = 0;          ///< Cycles in the statistics window
+    float dutyLast = 0.0f;        ///< Duty of the newest cycle (%)
+    float dutyMean = 0.0f;        ///< Mean duty (%)
+    float dutyMin = 0.0f;
+    float dutyMax = 0.0f;
+    float dutyStdDev = 0.0f;
+    float highMeanUs = 0.0f;      ///< Mean high time
+    float periodMeanUs = 0.0f;    ///< Mean period
+    float frequency = 0.0f;       ///< 1 / mean period (Hz)
+    uint32_t totalCycles = 0;     ///< Cycles measured since reset
+    uint32_t overflows = 0;       ///< Cycles dropped (ring full)
+};
+
+/**
+ * @brief Anchor of the 64-bit capture timeline
+ *
+ * The capture timer is a free-running 32-bit counter at
+ * UART1Mux::CAPTURE_CLK_HZ (wraps every 53.7 s). Edge timestamps are extended
+ * to 64 bits; the newest edge is paired with its esp_timer time so capture
+ * ticks can be placed on the same clock as trace records, PWM changes and
+ * commands.
+ */
+struct CaptureTimeline {
+    bool valid = false;              ///< At least one edge since the timeline started
+    uint64_t lastEdgeTicks = 0;      ///< Extended timestamp of the newest edge
+    int64_t lastEdgeUs = 0;          ///< esp_timer time of the same edge (ISR entry)
+    uint32_t wraps = 0;              ///< 32-bit counter wraps since the timeline started
+    uint32_t multiWrapPeriods = 0;   ///< Periods that spanned more than one wrap
+    uint32_t saturatedPeriods = 0;   ///< Periods longer than 2^32 ticks (RPM history saturates)
+};
+
+/**
+ * @brief Tach input qualification settings and reject counters
+ */
+struct TachFilterStats {
+    uint32_t prescale = 1;        ///< Input periods per capture event (MCPWM capture prescaler)
+    uint32_t minPeriodUs = 0;     ///< Edges closer than this are rejected in the ISR (0 = off)
+    uint32_t outlierPct = 0;      ///< Median outlier tolerance (0 = off)
+    uint32_t glitchRejects = 0;   ///< Edges rejected by the minimum period (ISR)
+    uint32_t shortRejects = 0;    ///< Edges dropped as glitches by the median check
+    uint32_t longRejects = 0;     ///< Periods skipped as too long by the median check
+    uint32_t resyncs = 0;         ///< Median restarts after a real speed change
+};
+
+/**
+ * @brief Tracking (follower) mode state
+ */
+struct FollowStatus {
+    bool enabled = false;         ///< Follower mode active
+    bool locked = false;          ///< Error within the lock band for UART1Mux::FOLLOW_LOCK_UPDATES updates
+    bool signal = false;          ///< Input edges arriving
+    bool clamped = false;         ///< Target outside the allowed output range
+    float ratio = 1.0f;           ///< Output = input × ratio + offset
+    float offsetHz = 0.0f;
+    uint32_t everyN = 1;          ///< Input periods per loop update
+    float gain = 0.5f;            ///< Loop gain (0.01-1, 1 = jump to target)
+    uint32_t lockPpm = 1000;      ///< Lock band
+    float inputHz = 0.0f;         ///< Input frequency over the last N periods
+    float targetHz = 0.0f;        ///< input × ratio + offset
+    float outputHz = 0.0f;        ///< Frequency currently programmed
+    float errorHz = 0.0f;         ///< outputHz - targetHz
+    int32_t errorPpm = 0;         ///< Tracking error relative to the target
+    uint32_t updates = 0;         ///< Loop updates since enabled
+    uint32_t lockLosses = 0;      ///< Locked → unlocked transitions
+    uint32_t prescalerChanges = 0;
+};
+
+/**
+ * @brief Latched speed-protection fault
+ */
+struct FaultStatus {
+    bool armed = false;          ///< Protection enabled
+    bool latched = false;        ///< Output forced to the safe state
+    uint8_t code = 0;            ///< UART1Mux::FaultCode
+    uint32_t periodTicks = 0;    ///< Offending period (capture ticks, 0 for stall)
+    float rpm = 0.0f;            ///< Offending speed (0 for stall)
+    int64_t timestampUs = 0;     ///< esp_timer time of the trip
+    uint32_t reactionUs = 0;     ///< Detection to output forced
+    uint32_t tripCount = 0;      ///< Trips since boot
+};
+
+/**
+ * @brief Fixed-point tach reading, computed once per new measurement
+ *
+ * Q-formats (unsigned 32-bit):
+ * - periodQ4: mean input period in capture ticks (12.5 ns), Q28.4
+ * - freqQ10:  input frequency in Hz, Q22.10 (1/1024 Hz resolution)
+ * - rpmQ6:    motor RPM (frequency × 60 / pole pairs), Q26.6
+ *
+ * All three are zero when there is no signal.
+ */
+struct TachSnapshot {
+    uint32_t periodQ4 = 0;    ///< Mean period (ticks × 16)
+    uint32_t freqQ10 = 0;     ///< Frequency (Hz × 1024)
+    uint32_t rpmQ6 = 0;       ///< RPM (× 64)
+    uint32_t seq = 0;         ///< Increments with every published reading
+    int64_t timestampUs = 0;  ///< esp_timer time of the newest edge / gate used
+};
 
 /**
  * @brief UART1 Multiplexing Manager
  *
  * Manages UART1 with three operating modes:
  * 1. UART Mode: Normal UART communication (TX with pull-up, RX standard)
- * 2. PWM Mode: TX outputs PWM (1Hz-500kHz), RX measures frequency via MCPWM Capture (1Hz-500kHz)
+ * 2. PWM Mode: TX outputs PWM (1Hz-500kHz), RX measures frequency via MCPWM Capture (1Hz-500kHz),
+ *    handing over to a PCNT gated counter above a configurable crossover
  * 3. Disabled: Pins released
  *
  * Mode switching sequence:
@@ -73,6 +227,13 @@ public:
      * @return true if mode switch successful
      *
      * TX pin configured with internal pull-up.
+     *
+     * Drivers are installed once and then only parked: leaving a mode detaches
+     * its signals in the GPIO matrix (UART RX input tied idle, capture
+     * interrupt masked, PCNT paused) instead of deleting the driver, so a
+     * switch back only re-routes pins and applies changed settings. Instead
+     * of a fixed delay the switch waits (bounded) for TX to show the new
+     * owner's idle level. See getModeSwitchStats().
      */
     bool setModeUART(uint32_t baudRate = 115200,
                      uart_stop_bits_t stopBits = UART_STOP_BITS_1,
@@ -89,10 +250,23 @@ public:
     bool setModePWM_RPM();
 
     /**
-     * @brief Disable UART1 and release pins
+     * @brief Disable UART1 and release pins (drivers stay installed, parked)
      */
     void disable();
 
+    /**
+     * @brief Install the UART driver at boot, parked (first UART switch is fast)
+     *
+     * The MCPWM side is set up by the first PWM/RPM entry, which happens at
+     * boot; initializing it here would briefly drive the output pin.
+     */
+    bool prepareDrivers();
+
+    ModeSwitchStats getModeSwitchStats() const;
+    void resetModeSwitchStats();
+
+    static constexpr uint32_t MODE_SETTLE_TIMEOUT_US = 200;
+
     /**
      * @brief Get current operating mode
      * @return Current mode
@@ -177,6 +351,17 @@ public:
      */
     bool setPWMDuty(float duty);
 
+    /**
+     * @brief Set PWM duty cycle from a control loop (MODE_PWM_RPM only)
+     *
+     * Same TEZ-synchronized shadow register update as setPWMDuty(), without
+     * the GPIO12 change pulse and logging, so it can be called at kHz rates.
+     *
+     * @param duty Duty cycle in percent (0.0 - 100.0)
+     * @return true if successful
+     */
+    bool setPWMDutyFast(float duty);
+
     /**
      * @brief Set PWM frequency and duty simultaneously (MODE_PWM_RPM only)
      *
@@ -199,12 +384,257 @@ public:
      */
     bool setPWMFrequencyAndDuty(uint32_t frequency, float duty);
 
+    /**
+     * @brief Defer PWM prescaler/period/duty register writes made by the calling task
+     *
+     * Used around command batches: frequency and duty changes from this task
+     * only update the driver state, and releasePWMUpdates() writes the final
+     * prescaler, period and duty back to back so they load at the same TEZ
+     * instead of one command per PWM period. Updates from other contexts
+     * (ramp, PID, follower) are written as usual; dither writes are never held.
+     */
+    void holdPWMUpdates();
+
+    /**
+     * @brief Stop holding and write the held prescaler/period/duty, if any changed
+     *
+     * A held prescaler change goes out in one cfg0 store with the period
+     * (see updatePWMPrescalerDirectly), immediately followed by the duty.
+     */
+    void releasePWMUpdates();
+
+    // ========================================================================
+    // PWM Ramp Engine (MODE_PWM_RPM only)
+    // ========================================================================
+
+    /**
+     * @brief Ramp profile
+     */
+    enum RampProfile {
+        RAMP_LINEAR,   ///< Constant rate of change
+        RAMP_SCURVE    ///< Smoothstep (zero rate at both ends)
+    };
+
+    /**
+     * @brief Start a frequency and/or duty ramp
+     *
+     * The ramp advances once per timer tick (1 ms, or one PWM period when
+     * that is longer) from an esp_timer callback. Each step is written through
+     * the TEZ-synchronized shadow registers, so no step produces a glitch and
+     * no per-step command traffic is needed. The prescaler is kept, so the
+     * target frequency must be reachable with the current prescaler.
+     *
+     * Any manual PWM set call stops a running ramp.
+     *
+     * @param targetFrequency Final frequency in Hz (0 = keep current)
+     * @param targetDuty Final duty in percent (negative = keep current)
+     * @param durationMs Ramp time (1 - 600000 ms)
+     * @param profile RAMP_LINEAR or RAMP_SCURVE
+     * @return true if the ramp was started
+     */
+    bool startRamp(uint32_t targetFrequency, float targetDuty, uint32_t durationMs,
+                   RampProfile profile = RAMP_LINEAR);
+
+    /**
+     * @brief Stop a running ramp (output stays at the last step)
+     */
+    void stopRamp();
+
+    /**
+     * @brief Check if a ramp is running
+     */
+    bool isRamping() const { return rampActive; }
+
+    /**
+     * @brief Get ramp progress (0.0 - 1.0)
+     */
+    float getRampProgress() const;
+
+    /**
+     * @brief Get number of register updates applied by the current/last ramp
+     */
+    uint32_t getRampSteps() const { return rampSteps; }
+
+    // ========================================================================
+    // Complementary Output with Dead Time (half-bridge drive)
+    // ========================================================================
+
+    static constexpr uint32_t DEADTIME_MAX_NS = 100000;
+
+    /**
+     * @brief Drive a complementary pair: GPIO 17 (high side) and GPIO 8 (low side)
+     *
+     * Both outputs come from generator A through the operator's dead-time
+     * module (active-high complementary mode): the high side turns on
+     * `risingNs` after generator A rises, the low side `fallingNs` after it
+     * falls. Frequency and duty updates are unchanged (generator A, TEZ
+     * shadow registers) and the dead-time registers also load at TEZ, so the
+     * pair stays glitch-free. The fault force acts before the dead-time
+     * module: SAFE LOW holds the low side on, SAFE HIGH the high side.
+     *
+     * Dead time resolution is one MCPWM group clock (see getDeadTimeResolutionNs()).
+     * Outside MODE_PWM_RPM the setting is stored and applied on entry.
+     *
+     * @param enable Complementary pair (true) or single output on GPIO 17 (false)
+     * @param risingNs Dead time before the high side turns on (0-DEADTIME_MAX_NS)
+     * @param fallingNs Dead time before the low side turns on (0-DEADTIME_MAX_NS)
+     * @return false if parameters are invalid or the dead-time module rejects them
+     */
+    bool setComplementaryOutput(bool enable, uint32_t risingNs, uint32_t fallingNs);
+
+    bool isComplementaryOutput() const { return complementaryEnabled; }
+    uint32_t getDeadTimeRisingNs() const { return deadTimeRisingNs; }
+    uint32_t getDeadTimeFallingNs() const { return deadTimeFallingNs; }
+
+    /**
+     * @brief Dead time actually applied after quantization to the group clock
+     */
+    uint32_t getDeadTimeRisingActualNs() const;
+    uint32_t getDeadTimeFallingActualNs() const;
+
+    /**
+     * @brief Dead-time clock period (ns), read from the group prescaler
+     */
+    float getDeadTimeResolutionNs() const;
+
+    // ========================================================================
+    // High-Resolution Duty (sigma-delta dithering)
+    // ========================================================================
+
+    static constexpr uint32_t DUTY_DITHER_BITS = 16;  // Duty resolution 100 % / 65536
+
+    /**
+     * @brief Dither the compare value to reach sub-tick duty resolution
+     *
+     * Without dithering the duty step is one timer tick (100 % / period,
+     * 1.25 % at 80 ticks). With dithering the duty is kept as a 16-bit
+     * fraction and a hardware timer ISR runs a first-order sigma-delta
+     * modulator: every update it writes floor or ceil of period × duty to
+     * the compare shadow register (loaded at TEZ, so every PWM period is
+     * still glitch-free) and carries the remainder, so the mean duty equals
+     * the requested value. The ISR is integer-only.
+     *
+     * The MCPWM driver owns the MCPWM1 interrupt for tach capture, so the
+     * modulator is stepped by a timer-group alarm instead of a TEZ interrupt;
+     * at most one compare value is used per PWM period either way.
+     *
+     * @param enable Dither on/off (off restores the nearest tick)
+     * @param rateHz Modulator updates per second (100-20000). Updates faster
+     *               than the PWM frequency add nothing.
+     * @return false if the rate is invalid or the timer cannot be set up.
+     *         Outside MODE_PWM_RPM the request is stored and applied on entry.
+     */
+    bool setDutyDither(bool enable, uint32_t rateHz = 10000);
+
+    bool isDutyDither() const { return ditherEnabled; }
+    uint32_t getDutyDitherRate() const { return ditherRateHz; }
+    uint32_t getDutyDitherUpdates() const { return ditherUpdates; }
+
+    /**
+     * @brief Smallest mean-duty step at the current period (%)
+     *
+     * 100 / period without dithering, 100 / 65536 with dithering.
+     */
+    float getDutyResolution() const;
+
+    /**
+     * @brief Averaging time for the dithered duty to reach `resolution` (%)
+     * @return Milliseconds (0 if the native step is already fine enough)
+     */
+    float getDutyDitherWindowMs(float resolution = 0.01f) const;
+
+    /**
+     * @brief Mean duty actually produced (%), after tick or 16-bit quantization
+     */
+    float getPWMDutyActual() const;
+
+    // ========================================================================
+    // Tracking / Follower Mode (MODE_PWM_RPM only)
+    // ========================================================================
+
+    static constexpr uint32_t FOLLOW_LOCK_UPDATES = 8;  // Consecutive in-band updates for lock
+
+    /**
+     * @brief Lock the PWM output frequency to the measured input frequency
+     *
+     * Software FLL: every `everyN` input periods the capture ISR publishes the
+     * exact span of those periods (integer capture ticks) and wakes the
+     * measurement task, which computes target = input × ratio + offset and
+     * moves the output period towards it by `gain` of the remaining error.
+     * The period is written through the TEZ-synchronized shadow register, so
+     * updates are glitch-free; the sub-count remainder is carried to the next
+     * update so the mean output frequency has no quantization bias. Duty (%)
+     * is kept. The prescaler is only re-solved when the target leaves the
+     * range of the current one; as with PWM FREQ the prescaler is not
+     * shadowed, so the rest of the running period is transitional (new
+     * prescaler, old period) until the next TEZ.
+     *
+     * While following, the input is measured by capture only (the gated
+     * counter is suspended). Manual frequency changes and ramps stop the
+     * follower; duty changes do not.
+     *
+     * @param enable Start or stop following (the output keeps its last frequency)
+     * @param ratio Output/input ratio (0.001-1000)
+     * @param offsetHz Added after scaling (±100000 Hz)
+     * @param everyN Input periods per update (1-1000)
+     * @return false if parameters are invalid. Outside MODE_PWM_RPM (or
+     *         before the measurement task registers) the request is stored
+     *         and applied on entry.
+     */
+    bool setFollowMode(bool enable, float ratio = 1.0f, float offsetHz = 0.0f, uint32_t everyN = 1);
+
+    /**
+     * @brief Loop gain and lock band
+     * @param gain Fraction of the period error corrected per update (0.01-1)
+     * @param lockPpm Locked when |error| stays within this (1-100000 ppm)
+     */
+    bool setFollowLoop(float gain, uint32_t lockPpm);
+
+    /**
+     * @brief Run one loop update if the ISR published a new span
+     *
+     * Called by the measurement task after each wake-up; also detects loss
+     * of the input signal (output holds its last frequency, lock is dropped).
+     */
+    void followStep();
+
+    bool isFollowing() const { return followActive; }
+    bool isFollowRequested() const { return followPending; }
+
+    /**
+     * @brief Get tracking error and lock state
+     */
+    FollowStatus getFollowStatus();
+
+    /**
+     * @brief Consume the ramp completion event
+     * @return true once after each ramp reaches its target
+     */
+    bool takeRampCompleteEvent();
+
+    uint32_t getRampTargetFrequency() const { return rampTargetFreq; }
+    float getRampTargetDuty() const { return rampTargetDuty; }
+    uint32_t getRampDurationMs() const { return rampDurationUs / 1000; }
+    RampProfile getRampProfile() const { return rampProfile; }
+
     /**
      * @brief Get current PWM frequency
      * @return Current PWM frequency in Hz
      */
     uint32_t getPWMFrequency() const { return pwmFrequency; }
 
+    /**
+     * @brief Get the frequency actually produced by the current prescaler/period
+     * @return clock / (prescaler × period) in Hz
+     */
+    float getPWMActualFrequency() const;
+
+    /**
+     * @brief Get the output frequency error against the requested frequency
+     * @return (actual - requested) / requested in ppm
+     */
+    int32_t getPWMFrequencyErrorPpm() const;
+
     /**
      * @brief Get current PWM duty cycle
      * @return Current duty cycle in percent
@@ -239,20 +669,336 @@ public:
      * @brief Update RPM frequency measurement (MODE_PWM_RPM only)
      *
      * Should be called periodically to update frequency reading from MCPWM Capture.
-     * Frequency is calculated from captured period between rising edges.
-     * Formula: frequency = 80,000,000 / capture_period
+     * Drains every edge queued by the capture ISR since the last call and
+     * averages the newest periods (see setRPMAveraging()).
+     * Formula: frequency = 80,000,000 × edges / sum(capture_periods)
      */
     void updateRPMFrequency();
 
+    /**
+     * @brief How the averaging window is chosen
+     */
+    enum RPMWindowMode {
+        RPM_WINDOW_FIXED,       // At most N periods within a time window
+        RPM_WINDOW_ADAPTIVE,    // All periods within the time window (1-128): more
+                                // periods at speed, a single period near stall
+        RPM_WINDOW_REVOLUTION   // Exactly polePairs × revolutions periods (cancels
+                                // per-pole spacing error)
+    };
+
+    /**
+     * @brief Configure multi-period averaging for the RPM reading
+     * @param edges Average over at most this many periods (1-128)
+     * @param windowMs Only use periods within this many ms of the newest edge
+     *                 (0 = no time limit, at least one period is always used)
+     * @return true if parameters are valid
+     *
+     * Selects RPM_WINDOW_FIXED.
+     */
+    bool setRPMAveraging(uint32_t edges, uint32_t windowMs);
+
+    /**
+     * @brief Average over every period inside a fixed time window
+     * @param windowMs Target window (1-10000 ms)
+     * @return true if parameters are valid
+     */
+    bool setRPMAveragingAdaptive(uint32_t windowMs);
+
+    /**
+     * @brief Average over whole revolutions (polePairs periods each)
+     * @param revolutions Revolutions per reading (1-16, polePairs × revolutions ≤ 128)
+     * @return true if parameters are valid
+     */
+    bool setRPMAveragingRevolutions(uint32_t revolutions);
+
+    /**
+     * @brief Get the averaging window mode
+     */
+    RPMWindowMode getRPMWindowMode() const { return rpmWindowMode; }
+
+    /**
+     * @brief Get window mode name ("FIXED", "ADAPTIVE", "REVOLUTION")
+     */
+    const char* getRPMWindowModeName() const;
+
+    /**
+     * @brief Get revolutions per reading (RPM_WINDOW_REVOLUTION)
+     */
+    uint32_t getRPMWindowRevolutions() const { return rpmWindowRevs; }
+
+    /**
+     * @brief Configure the signal-lost timeout
+     * @param periods Timeout in expected input periods (2-100)
+     * @param maxMs Upper bound (RPM_TIMEOUT_MIN_MS-RPM_TIMEOUT_MAX_MS); also
+     *              used before the first reading. Long limits allow sub-1 Hz
+     *              inputs (the capture timeline spans counter wraps).
+     * @return true if parameters are valid
+     *
+     * Timeout = periods × newest mean period, clamped to
+     * [RPM_TIMEOUT_MIN_MS, maxMs]. In counter mode it is never shorter than
+     * two gate intervals.
+     */
+    bool setRPMTimeout(uint32_t periods, uint32_t maxMs);
+
+    uint32_t getRPMTimeoutPeriods() const { return rpmTimeoutPeriods; }
+    uint32_t getRPMTimeoutMaxMs() const { return rpmTimeoutMaxMs; }
+
+    static constexpr uint32_t RPM_TIMEOUT_MIN_MS = 20;
+    static constexpr uint32_t RPM_TIMEOUT_MAX_MS = 120000;
+
+    /**
+     * @brief Get window length, effective bandwidth and timeout of the
+     *        newest reading
+     */
+    RPMWindowStats getRPMWindowStats();
+
+    /**
+     * @brief Get number of periods used for RPM averaging
+     */
+    uint32_t getRPMAveragingEdges() const { return rpmAvgEdges; }
+
+    /**
+     * @brief Get RPM averaging time window in ms (0 = unlimited)
+     */
+    uint32_t getRPMAveragingWindowMs() const { return rpmAvgWindowMs; }
+
+    /**
+     * @brief Get statistics over the newest captured periods
+     * @param edges Use at most this many periods (0 = all stored, max 128)
+     * @param windowMs Time window ending at the newest edge (0 = unlimited)
+     * @param stats Result (periods in capture timer ticks, 80 MHz)
+     * @return true if at least one period is available
+     */
+    bool getCaptureStats(uint32_t edges, uint32_t windowMs, CaptureStats& stats);
+
+    /**
+     * @brief Get number of edges dropped because the capture ring was full
+     */
+    uint32_t getCaptureOverflowCount() const { return captureRing.getOverflowCount(); }
+
+    /**
+     * @brief Register the task woken by the capture ISR in event mode
+     * @param task Measurement task handle (calls updateRPMFrequency() on wake-up)
+     */
+    void setRPMNotifyTask(TaskHandle_t task);
+
+    /**
+     * @brief Enable/disable event-driven RPM measurement
+     *
+     * In event mode the capture ISR sends a direct-to-task notification to the
+     * measurement task instead of waiting for the 50 ms polling loop. The ISR
+     * notifies once `edges` edges have accumulated or `intervalUs` has elapsed
+     * since the previous notification, whichever comes first.
+     *
+     * @param enable true for event mode, false for polling
+     * @param edges Notify every N edges (1-1000)
+     * @param intervalUs Notify at least this often while edges arrive
+     *                   (0 = edge count only, max 1000000)
+     * @return true if parameters are valid
+     */
+    bool setRPMEventMode(bool enable, uint32_t edges, uint32_t intervalUs);
+
+    bool isRPMEventMode() const { return rpmEventMode; }
+    uint32_t getRPMEventEdges() const { return rpmEventEdges; }
+    uint32_t getRPMEventIntervalUs() const { return rpmEventIntervalUs; }
+
+    /**
+     * @brief Get number of notifications sent by the capture ISR
+     */
+    uint32_t getRPMNotifyCount() const { return rpmNotifyCount; }
+
+    /**
+     * @brief Get edge-to-publish latency statistics
+     */
+    RPMLatencyStats getRPMLatencyStats();
+
+    /**
+     * @brief Reset edge-to-publish latency statistics
+     */
+    void resetRPMLatencyStats();
+
+    /**
+     * @brief Capture timer clock (ticks per second)
+     */
+    static constexpr uint32_t CAPTURE_CLK_HZ = 80000000;
+
+    /**
+     * @brief RPM measurement method currently publishing getRPMFrequency()
+     */
+    enum RPMMethod {
+        RPM_METHOD_CAPTURE,  ///< MCPWM capture, one interrupt per edge (reciprocal)
+        RPM_METHOD_COUNTER   ///< PCNT gated counter, no per-edge interrupt
+    };
+
+    /**
+     * @brief Configure hybrid capture / gated-counter RPM measurement
+     *
+     * The PCNT unit counts edges on the RX pin continuously and is read once
+     * per gate time from an esp_timer callback. Below the crossover the
+     * capture ISR timestamps every edge (best resolution at low frequency).
+     * Above crossover × (1 + hysteresis) the capture interrupt is masked and
+     * the gated count is published instead, so the interrupt load no longer
+     * grows with the input frequency. The capture path comes back below
+     * crossover × (1 - hysteresis).
+     *
+     * @param autoSwitch false = always use capture
+     * @param crossoverHz Switching frequency (1000-400000 Hz)
+     * @param hysteresisPct Hysteresis around the crossover (0-50 %)
+     * @param gateMs Counter gate time (5-60 ms, 16-bit counter at 500 kHz)
+     * @return true if parameters are valid
+     */
+    bool setRPMCounterConfig(bool autoSwitch, uint32_t crossoverHz, uint32_t hysteresisPct,
+                             uint32_t gateMs);
+
+    bool isRPMAutoSwitch() const { return rpmAutoSwitch; }
+    uint32_t getRPMCrossoverHz() const { return rpmCrossoverHz; }
+    uint32_t getRPMHysteresisPct() const { return rpmHysteresisPct; }
+    uint32_t getRPMGateMs() const { return rpmGateMs; }
+
+    /**
+     * @brief Get the method currently publishing the RPM frequency
+     */
+    RPMMethod getRPMMethod() const { return rpmMethod; }
+    const char* getRPMMethodName() const;
+
+    /**
+     * @brief Get number of capture/counter switches since boot
+     */
+    uint32_t getRPMMethodSwitchCount() const { return rpmMethodSwitches; }
+
+    /**
+     * @brief Get the latest gated-counter reading (valid in both methods)
+     * @return Frequency in Hz averaged over one gate time
+     */
+    float getRPMCounterFrequency() const { return counterFrequency; }
+
+    /**
+     * @brief Record every following capture edge into a caller-owned buffer
+     *
+     * The capture ISR stores each edge as capture ticks since the first
+     * recorded edge, until the buffer is full or recording stops. The
+     * gated counter is kept off while recording so no edge is missed.
+     *
+     * @param buffer Pre-allocated buffer (written from ISR context)
+     * @param capacity Number of entries
+     * @return false if not in PWM/RPM mode or a recording is active
+     */
+    bool startEdgeRecording(uint32_t* buffer, uint32_t capacity);
+
+    /**
+     * @brief Stop recording
+     * @return Number of edges recorded
+     */
+    uint32_t stopEdgeRecording();
+
+    bool isEdgeRecording() const { return edgeRecBuffer != nullptr; }
+    uint32_t getRecordedEdgeCount() const { return edgeRecCount; }
+
+    /**
+     * @brief esp_timer time of the first recorded edge (0 before it arrives)
+     */
+    int64_t getRecordedFirstEdgeUs() const { return edgeRecFirstUs; }
+
+    /**
+     * @brief Snapshot of the capture timeline anchor
+     */
+    CaptureTimeline getCaptureTimeline();
+
+    /**
+     * @brief Convert a capture timeline timestamp to esp_timer time
+     * @param ticks Extended capture timestamp (e.g. from the edge recorder base
+     *              or getCaptureTimeline())
+     * @return esp_timer µs, or 0 before the first edge
+     */
+    int64_t captureTicksToUs(uint64_t ticks);
+
+    /**
+     * @brief Tach input qualification
+     *
+     * Three stages against spurious edges on a noisy tach line:
+     * - prescale: the MCPWM capture prescaler, one capture per N rising edges
+     *   (lower interrupt rate, jitter averaged in hardware). Readings are
+     *   scaled back to single periods.
+     * - minPeriodUs: an edge closer than this to the previous good edge is
+     *   rejected in the capture ISR, before fault protection and the ring;
+     *   the next edge is then measured from the last good one. Set it below
+     *   the shortest real period (highest RPM).
+     * - outlierPct: periods outside ±outlierPct of the median of the last
+     *   PeriodHistory::OUTLIER_WINDOW periods are rejected by the consumer
+     *   (see PeriodHistory), so no single bad period reaches the reading.
+     *
+     * @param prescale 1-256 (1 = every edge; >1 not with input duty capture)
+     * @param minPeriodUs 0 (off) - 100000
+     * @param outlierPct 0 (off) or 5-90
+     * @return false if a parameter is invalid
+     */
+    bool setTachFilter(uint32_t prescale, uint32_t minPeriodUs, uint32_t outlierPct);
+
+    uint32_t getCapturePrescale() const { return capturePrescale; }
+
+    /**
+     * @brief Current settings and reject counters
+     */
+    TachFilterStats getTachFilterStats();
+
+    void resetTachFilterStats();
+
+    /**
+     * @brief Input duty measurement: capture both edges on RX
+     *
+     * The falling edge closes the high time of the current cycle, the next
+     * rising edge closes its period; RPM keeps using rising edges only.
+     * Doubles the capture interrupt rate, so the gated counter stays off
+     * while enabled.
+     *
+     * @param enable true = both edges, false = rising edges only
+     * @return true if applied (takes effect now in PWM/RPM mode, else on entry)
+     */
+    bool setInputDutyCapture(bool enable);
+    bool isInputDutyCapture() const { return dutyCaptureEnabled; }
+
+    /**
+     * @brief Get duty statistics over the last DUTY_HISTORY_SIZE cycles
+     */
+    InputDutyStats getInputDutyStats();
+
+    /**
+     * @brief Clear the duty history and counters
+     */
+    void resetInputDutyStats();
+
+    static constexpr uint32_t DUTY_HISTORY_SIZE = 64;
+
+    /**
+     * @brief Fractional bits of the TachSnapshot fields
+     */
+    static constexpr uint32_t TACH_PERIOD_FRAC_BITS = 4;
+    static constexpr uint32_t TACH_FREQ_FRAC_BITS = 10;
+    static constexpr uint32_t TACH_RPM_FRAC_BITS = 6;
+
+    /**
+     * @brief Get a consistent copy of the fixed-point tach reading
+     *
+     * Lock-free (sequence counter): never blocks the capture consumer and
+     * costs a handful of loads. Compare snapshot.seq with a previous copy to
+     * detect a new reading.
+     */
+    TachSnapshot getTachSnapshot() const;
+
     /**
      * @brief Get measured RPM frequency on RX pin (MODE_PWM_RPM only)
      * @return Frequency in Hz, 0 if no signal or not in PWM_RPM mode
      */
-    float getRPMFrequency() const { return rpmFrequency; }
+    float getRPMFrequency() const {
+        return (float)tachFreqQ10 * (1.0f / (1u << TACH_FREQ_FRAC_BITS));
+    }
 
     /**
      * @brief Check if RPM signal is present
-     * @return true if signal detected in last 500ms
+     * @return true if a reading arrived within effectiveRPMTimeoutMs(): the
+     *         configured number of input periods (setRPMTimeout()), so the
+     *         window scales with the measured period, at least two gates in
+     *         counter mode
      */
     bool hasRPMSignal() const;
 
@@ -290,9 +1036,94 @@ public:
      * @brief Get calculated motor RPM based on pole pairs
      * @return Motor RPM (rotations per minute)
      *
-     * Formula: RPM = (frequency × 60) / pole_pairs
+     * Formula: RPM = (frequency × 60) / pole_pairs, precomputed in fixed
+     * point when the reading is published (no division here).
      */
-    float getCalculatedRPM() const;
+    float getCalculatedRPM() const {
+        return (currentMode == MODE_PWM_RPM)
+            ? (float)tachRpmQ6 * (1.0f / (1u << TACH_RPM_FRAC_BITS)) : 0.0f;
+    }
+
+    // ========================================================================
+    // Speed Protection (overspeed / underspeed / stall)
+    // ========================================================================
+
+    /**
+     * @brief Fault codes (0 = none)
+     */
+    enum FaultCode : uint8_t {
+        FAULT_NONE = 0,
+        FAULT_OVERSPEED,
+        FAULT_UNDERSPEED,
+        FAULT_STALL
+    };
+
+    /**
+     * @brief Arm or disarm speed protection
+     *
+     * Overspeed and underspeed are checked on every capture edge inside the
+     * capture ISR (per gate in counter mode). Missing edges are caught by a
+     * one-shot hardware timer alarm whose IRAM ISR trips directly, so the
+     * stall reaction does not wait behind the esp_timer task. A trip forces the PWM output to the safe level
+     * through the generator's continuous software force (immediate update,
+     * i.e. within the current PWM period) and latches until clearFault().
+     *
+     * Underspeed and stall are only checked once the fan has been seen above
+     * the minimum speed, so spin-up from standstill does not trip.
+     *
+     * @return false if the watchdog timer cannot be created. Outside
+     *         MODE_PWM_RPM the request is stored and applied on entry.
+     */
+    bool setFaultProtection(bool enable);
+
+    /**
+     * @brief Check if protection is requested (armed once in PWM/RPM mode)
+     */
+    bool isFaultProtectionEnabled() const { return faultArmPending; }
+
+    /**
+     * @brief Configure protection thresholds
+     * @param maxRpm Overspeed limit (0 = off)
+     * @param minRpm Underspeed limit (0 = off, must be below maxRpm)
+     * @param stallMs Trip when no edge arrives for this long (0 = off, 1-5000)
+     * @param confirmEdges Consecutive out-of-range periods required (1-16)
+     * @return true if parameters are valid
+     */
+    bool setFaultLimits(uint32_t maxRpm, uint32_t minRpm, uint32_t stallMs, uint32_t confirmEdges);
+
+    /**
+     * @brief Select the safe output level (false = low / 0 %, true = high / 100 %)
+     */
+    void setFaultSafeHigh(bool high) { faultSafeHigh = high; }
+
+    /**
+     * @brief Release the forced output and re-arm detection
+     */
+    void clearFault();
+
+    /**
+     * @brief Get protection state and the latched fault
+     */
+    FaultStatus getFaultStatus();
+
+    bool isFaultArmed() const { return faultArmed; }
+    bool isFaultLatched() const { return faultLatched; }
+    uint32_t getFaultMaxRpm() const { return faultMaxRpm; }
+    uint32_t getFaultMinRpm() const { return faultMinRpm; }
+    uint32_t getFaultStallMs() const { return faultStallMs; }
+    uint32_t getFaultConfirmEdges() const { return faultConfirmEdges; }
+    bool isFaultSafeHigh() const { return faultSafeHigh; }
+
+    /**
+     * @brief Consume the fault trip event
+     * @return true once after each trip
+     */
+    bool takeFaultEvent();
+
+    /**
+     * @brief Fault code name ("NONE", "OVERSPEED", "UNDERSPEED", "STALL")
+     */
+    static const char* getFaultName(uint8_t code);
 
     // ========================================================================
     // Settings Persistence
@@ -353,6 +1184,21 @@ private:
     uint32_t uartTxBytes = 0;
     uint32_t uartRxBytes = 0;
     uint32_t uartErrors = 0;
+    bool uartDriverReady = false;      // Driver installed (kept across mode switches)
+    uart_config_t uartAppliedConfig = {};  // Last config written to the UART
+
+    // Parked drivers and mode switch latency
+    bool pwmDriverReady = false;       // mcpwm_init() done (timer kept, stopped when parked)
+    bool captureReady = false;         // Capture channel enabled (interrupt masked when parked)
+    bool captureBothEdgesApplied = false;
+    uint32_t capturePrescaleApplied = 1;
+    uint32_t switchCount = 0;
+    uint32_t switchFastCount = 0;
+    uint32_t switchLastUs = 0;
+    uint32_t switchMinUs = UINT32_MAX;
+    uint32_t switchMaxUs = 0;
+    uint64_t switchSumUs = 0;
+    uint32_t switchSettleTimeouts = 0;
 
     // PWM mode state (MCPWM)
     uint32_t pwmFrequency = 1000;      // Default 1kHz
@@ -360,19 +1206,179 @@ private:
     bool pwmEnabled = false;
     uint32_t pwmPrescaler = 0;         // Current prescaler value
     uint32_t pwmPeriod = 0;            // Current period value (ticks)
-    uint32_t mcpwmClockFreq = 80000000; // MCPWM clock frequency (detected at init)
+    uint32_t mcpwmClockFreq = PWMSolver::TIMER_CLK_HZ; // MCPWM timer clock (set at init)
     bool pwmChangePulseState = false;  // GPIO12 toggle state for non-blocking pulse
+    TaskHandle_t pwmHoldTask = nullptr; // holdPWMUpdates() caller (batch in progress)
+    bool pwmHoldPending = false;       // Prescaler/period/duty changed while held
+    bool complementaryEnabled = false; // Generator A + complement through the dead-time module
+    uint32_t deadTimeRisingNs = 500;
+    uint32_t deadTimeFallingNs = 500;
+    bool complementaryActive = false;  // Dead-time module and GPIO 8 currently driven
+    uint32_t deadTimeRisingTicks = 0;  // Applied values (group clock ticks)
+    uint32_t deadTimeFallingTicks = 0;
+
+    // Duty dither (timer-group ISR → compare shadow register)
+    bool ditherEnabled = false;                    // Requested state
+    volatile bool ditherActive = false;            // Timer running in PWM/RPM mode
+    bool ditherTimerReady = false;
+    uint32_t ditherRateHz = 10000;
+    volatile uint32_t ditherPeriod = 0;            // Timer period (ticks), written with the register
+    volatile uint32_t ditherDutyQ16 = 0;           // Duty × 65536 / 100
+    volatile uint32_t ditherAcc = 0;               // Modulator remainder (ISR only)
+    volatile uint32_t ditherUpdates = 0;
 
     // Motor control parameters (integrated from old MotorControl)
     uint32_t polePairs = 2;            // Motor pole pairs (default 2)
     uint32_t maxFrequency = 100000;    // Maximum frequency limit (100 kHz)
 
     // RPM measurement state (MCPWM Capture)
-    float rpmFrequency = 0.0;              // Measured frequency in Hz
+    // Published tach reading (fixed point, see TachSnapshot). Single writer
+    // at a time under rpmMux; readers use the tachSeq sequence counter.
+    std::atomic<uint32_t> tachSeq{0};      // Odd while a reading is being written
+    volatile uint32_t tachPeriodQ4 = 0;
+    volatile uint32_t tachFreqQ10 = 0;
+    volatile uint32_t tachRpmQ6 = 0;
+    volatile int64_t tachTimestampUs = 0;
+    uint32_t rpmScaleQ16 = (60u << 16) / 2; // 60 / polePairs (Q16.16)
     unsigned long lastRPMUpdate = 0;       // Last valid capture time
-    static volatile uint32_t capturePeriod;        // Period between captures (in timer ticks)
-    static volatile bool newCaptureAvailable;      // New capture data flag
-    static volatile unsigned long lastCaptureTime; // Timestamp of last capture
+    uint32_t rpmAvgEdges = 16;             // Periods averaged per reading
+    uint32_t rpmAvgWindowMs = 100;         // Averaging window (0 = unlimited)
+    RPMWindowMode rpmWindowMode = RPM_WINDOW_FIXED;
+    uint32_t rpmWindowRevs = 1;            // Revolutions per reading (REVOLUTION mode)
+    uint32_t rpmTimeoutPeriods = 4;        // Timeout in expected periods
+    uint32_t rpmTimeoutMaxMs = 500;        // Timeout upper bound
+    volatile uint32_t rpmTimeoutMs = 500;  // Current timeout (from the newest mean period)
+    uint32_t lastWindowPeriods = 0;        // Periods used by the newest reading
+    uint64_t lastWindowTicks = 0;          // Span of those periods
+
+    // Capture pipeline: ISR (producer) → captureRing → periodHistory (consumer)
+    // The ring's consumer side and periodHistory belong to whoever holds
+    // rpmConsumerLock (a mutex, so the drain and the stats run with interrupts
+    // enabled); rpmMux only guards state shared with the ISR.
+    static constexpr uint32_t RPM_DRAIN_MAX = CaptureRing::CAPACITY;  // Edges per update
+    CaptureRing captureRing;
+    PeriodHistory periodHistory;
+    StaticSemaphore_t rpmConsumerLockBuf;
+    SemaphoreHandle_t rpmConsumerLock = nullptr;
+    portMUX_TYPE rpmMux = portMUX_INITIALIZER_UNLOCKED;  // ISR-shared state
+    volatile uint64_t lastCaptureExt = 0;          // Last extended timestamp (ISR only)
+    volatile bool captureHasLast = false;          // lastCaptureExt is valid (ISR only)
+    std::atomic<uint32_t> captureAnchorSeq{0};     // Seqlock over lastCaptureExt/lastCaptureUs
+    volatile uint32_t captureMultiWraps = 0;
+    volatile uint32_t captureSaturated = 0;
+
+    // Tach input qualification (capture prescaler, ISR minimum period)
+    uint32_t capturePrescale = 1;                  // Input periods per capture event
+    uint32_t tachMinPeriodUs = 0;
+    volatile uint32_t glitchRejectTicks = 0;       // Minimum capture-event spacing (0 = off)
+    volatile uint32_t glitchRejects = 0;
+    volatile unsigned long lastCaptureTime = 0;    // millis() of last capture
+    volatile int64_t lastCaptureUs = 0;            // esp_timer time of last capture
+
+    // Event-driven measurement (capture ISR → task notification)
+    TaskHandle_t rpmNotifyTask = nullptr;
+    volatile bool rpmEventMode = false;
+    bool rpmEventPending = false;                  // Requested before task registered
+    uint32_t rpmEventEdges = 1;                    // Notify every N edges
+    uint32_t rpmEventIntervalUs = 10000;           // ...or after this much time
+    volatile uint32_t edgesSinceNotify = 0;        // ISR only
+    volatile int64_t lastNotifyUs = 0;             // ISR only
+    volatile uint32_t rpmNotifyCount = 0;
+
+    // Edge recorder (step response): ticks since the first recorded edge
+    uint32_t* volatile edgeRecBuffer = nullptr;
+    uint32_t edgeRecCapacity = 0;
+    volatile uint32_t edgeRecCount = 0;
+    uint64_t edgeRecBase = 0;                      // ISR only
+    volatile int64_t edgeRecFirstUs = 0;
+
+    // Input duty (both-edge capture): ISR → dutyRing → duty history
+    volatile bool dutyCaptureEnabled = false;
+    volatile uint32_t dutyHighTicks = 0;           // ISR only
+    volatile bool dutyHighValid = false;           // Falling edge seen this cycle (ISR only)
+    CaptureRing dutyRing;                          // (high ticks << 32) | period ticks
+    uint32_t dutyHistHigh[DUTY_HISTORY_SIZE];
+    uint32_t dutyHistPeriod[DUTY_HISTORY_SIZE];
+    uint32_t dutyHistHead = 0;
+    uint32_t dutyHistCount = 0;
+    uint32_t dutyTotalCycles = 0;
+
+    // Gated PCNT counter (high-frequency measurement, stepped from esp_timer task)
+    static constexpr int16_t COUNTER_H_LIM = 32767;  // Counter wraps to 0 here
+    esp_timer_handle_t gateTimer = nullptr;
+    bool counterReady = false;
+    volatile RPMMethod rpmMethod = RPM_METHOD_CAPTURE;
+    bool rpmAutoSwitch = true;
+    uint32_t rpmCrossoverHz = 20000;
+    uint32_t rpmHysteresisPct = 10;
+    uint32_t rpmGateMs = 50;
+    int16_t lastGateCount = 0;
+    int64_t lastGateUs = 0;
+    volatile float counterFrequency = 0.0;
+    volatile uint32_t rpmMethodSwitches = 0;
+
+    // Speed protection (thresholds in capture ticks, checked by the capture ISR)
+    bool faultTimerReady = false;                  // Missing-edge watchdog (hardware timer)
+    static constexpr uint64_t FAULT_TIMER_IDLE_US = 3600ULL * 1000000;  // Parked alarm distance
+    portMUX_TYPE faultMux = portMUX_INITIALIZER_UNLOCKED;  // Trip vs. clear (ISR and tasks)
+    bool faultArmPending = false;                  // Requested state, applied in PWM/RPM mode
+    volatile bool faultArmed = false;
+    volatile bool faultLatched = false;
+    volatile bool faultEvent = false;              // Set on trip, consumed by motorTask
+    volatile bool faultRunning = false;            // Seen above minimum speed since arming
+    bool faultSafeHigh = false;
+    uint32_t faultMaxRpm = 0;
+    uint32_t faultMinRpm = 0;
+    uint32_t faultStallMs = 0;
+    uint32_t faultConfirmEdges = 2;
+    volatile uint32_t faultMinPeriodTicks = 0;           // Overspeed below this (0 = off)
+    volatile uint32_t faultMaxPeriodTicks = UINT32_MAX;  // Underspeed above this
+    volatile uint32_t faultOverCount = 0;          // Consecutive violations (ISR only)
+    volatile uint32_t faultUnderCount = 0;
+    volatile int64_t faultLastEdgeUs = 0;          // Newest edge seen by the watchdog
+    int16_t faultLastPcnt = 0;                     // Counter mode edge detection
+    FaultStatus faultState;                        // Latched details (written once per trip)
+
+    // Ramp engine state (stepped from esp_timer task)
+    esp_timer_handle_t rampTimer = nullptr;
+    volatile bool rampActive = false;
+    volatile bool rampCompleteEvent = false;
+    volatile bool rampFinished = false;            // Last ramp reached its target
+    RampProfile rampProfile = RAMP_LINEAR;
+    uint32_t rampStartFreq = 0;
+    uint32_t rampTargetFreq = 0;
+    float rampStartDuty = 0.0;
+    float rampTargetDuty = 0.0;
+    int64_t rampStartUs = 0;
+    uint32_t rampDurationUs = 0;
+    volatile uint32_t rampSteps = 0;
+
+    // Follower FLL: ISR publishes N-period spans (seqlock), task steps the loop
+    volatile bool followActive = false;
+    bool followPending = false;                    // Requested state, applied in PWM/RPM mode
+    uint32_t followEveryN = 1;
+    volatile uint32_t followEdges = 0;             // Periods since the span start (ISR only)
+    volatile uint64_t followBaseExt = 0;           // Span start timestamp (ISR only)
+    volatile bool followHasBase = false;           // ISR only
+    std::atomic<uint32_t> followSeq{0};            // Odd while a span is being written
+    volatile uint64_t followSpanTicks = 0;
+    volatile uint32_t followSpanPeriods = 0;
+    uint32_t followSeqSeen = 0;                    // Task only
+    float followRatio = 1.0f;
+    float followOffsetHz = 0.0f;
+    float followGain = 0.5f;
+    uint32_t followLockPpm = 1000;
+    double followPeriodTicks = 0.0;                // Loop state: prescaler × period (MCPWM clocks)
+    double followResidual = 0.0;                   // Sub-count remainder carried forward
+    uint32_t followInBand = 0;
+    FollowStatus followState;
+
+    // Edge-to-publish latency (protected by rpmMux)
+    uint32_t latencyCount = 0;
+    uint32_t latencyLastUs = 0;
+    uint32_t latencyMinUs = UINT32_MAX;
+    uint32_t latencyMaxUs = 0;
+    uint64_t latencySumUs = 0;
 
     // Static callback function for MCPWM Capture ISR
     static bool IRAM_ATTR captureCallback(mcpwm_unit_t mcpwm,
@@ -387,14 +1393,58 @@ private:
     void deinitUART();
     void deinitPWM();
     void deinitRPM();
+    esp_err_t enableCaptureChannel();
+    void drainDutyRingLocked();
+    void resetCapturePipelineLocked();
+    int64_t IRAM_ATTR readLastCaptureUs() const;
     void releasePins();
+    uart_config_t buildUARTConfig() const;
+    bool waitPinLevel(int pin, int level, uint32_t timeoutUs);
+    void recordModeSwitch(int64_t startUs, bool fast);
+    bool applyComplementaryOutput();
+    bool startDutyDither();
+    void stopDutyDither();
+    static bool IRAM_ATTR ditherCallback(void* arg);
+    uint32_t deadTimeClockHz() const;
     bool validateUARTConfig(uint32_t baudRate, uart_stop_bits_t stopBits,
                            uart_parity_t parity, uart_word_length_t dataBits);
     bool validatePWMFrequency(uint32_t frequency);
 
     // PWM low-level register manipulation helpers
-    void calculatePWMParameters(uint32_t frequency, uint32_t& prescaler, uint32_t& period);
     void updatePWMRegistersDirectly(uint32_t period, float duty);
+    void updatePWMPrescalerDirectly(uint32_t prescaler, uint32_t period);
+
+    // Ramp engine
+    static void rampTimerCallback(void* arg);
+    void rampStep();
+
+    // Follower FLL
+    void stopFollow();
+
+    // Gated counter / hybrid measurement
+    bool initCounter();
+    void deinitCounter();
+    static void gateTimerCallback(void* arg);
+    void gateStep();
+    void switchRPMMethod(RPMMethod method);
+    void setCaptureInterrupt(bool enable);
+
+    // Speed protection
+    void IRAM_ATTR checkFaultPeriod(uint32_t periodTicks, int64_t nowUs);
+    void IRAM_ATTR tripFault(uint8_t code, uint32_t periodTicks, int64_t detectUs);
+    void IRAM_ATTR applyFaultForce(bool force);
+    void updateFaultThresholds();
+    void startFaultWatchdog(uint64_t delayUs);
+    void stopFaultWatchdog();
+    static bool IRAM_ATTR faultTimerCallback(void* arg);
+    void IRAM_ATTR faultWatchdogStep();
+
+    // Fixed-point tach publishing (caller holds rpmMux)
+    void publishTachLocked(uint32_t freqQ10, uint32_t periodQ4, int64_t timestampUs);
+
+    // Adaptive window / timeout
+    void selectRPMWindow(uint32_t& maxEdges, uint64_t& windowTicks) const;
+    uint32_t effectiveRPMTimeoutMs() const;
 
     // Debug/Test functions
     void initPWMChangePulse();    // Initialize GPIO 12 for pulse output
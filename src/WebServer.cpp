@@ -1,11 +1,9 @@
 #include "WebServer.h"
 #include "CommandParser.h"
+#include "CommandExecutor.h"
 #include "ArduinoJson.h"
 #include <WiFi.h>
 
-// 外部變數（從 main.cpp）
-extern CommandParser parser;
-
 WebServerManager::WebServerManager() {
     // Constructor
 }
@@ -124,15 +122,62 @@ void WebServerManager::broadcastStatus() {
         return;
     }
 
-    StaticJsonDocument<512> doc;
+    StaticJsonDocument<1024> doc;
     doc["type"] = "status";
     // Motor control now via UART1
     doc["rpm"] = pPeripheralManager->getUART1().getCalculatedRPM();
     doc["raw_freq"] = pPeripheralManager->getUART1().getRPMFrequency();  // Raw frequency instead of raw RPM
     doc["freq"] = pPeripheralManager->getUART1().getPWMFrequency();
     doc["duty"] = pPeripheralManager->getUART1().getPWMDuty();
-    // Ramping and emergency stop features removed in v3.0
+    // Closed-loop RPM control
+    RPMController& pid = pPeripheralManager->getRPMController();
+    doc["pid_enabled"] = pid.isEnabled();
+    doc["rpm_setpoint"] = pid.getSetpoint();
+    doc["pid_output"] = pid.getStatus().output;
+    // PWM ramp engine
+    doc["ramping"] = pPeripheralManager->getUART1().isRamping();
+    // Speed protection
+    doc["fault"] = UART1Mux::getFaultName(pPeripheralManager->getUART1().getFaultStatus().code);
+    doc["ramp_progress"] = pPeripheralManager->getUART1().getRampProgress();
+    // Follower (output frequency locked to the input)
+    if (pPeripheralManager->getUART1().isFollowing()) {
+        FollowStatus follow = pPeripheralManager->getUART1().getFollowStatus();
+        doc["follow_locked"] = follow.locked;
+        doc["follow_error_ppm"] = follow.errorPpm;
+    }
     doc["uptime"] = millis() / 1000;  // System uptime in seconds
+    // Additional fan channels (channel 0 is the UART1 data above)
+    FanManager& fans = pPeripheralManager->getFans();
+    if (fans.getChannelCount() > 1) {
+        JsonArray fanArray = doc.createNestedArray("fans");
+        for (uint32_t i = 0; i < fans.getChannelCount(); i++) {
+            FanStatus fan = fans.getStatus(i);
+            JsonObject obj = fanArray.createNestedObject();
+            obj["ch"] = fan.channel;
+            obj["freq"] = fan.frequency;
+            obj["duty"] = fan.duty;
+            obj["rpm"] = fan.rpm;
+            obj["en"] = fan.enabled;
+        }
+    }
+
+    String json;
+    serializeJson(doc, json);
+    ws->textAll(json);
+}
+
+void WebServerManager::broadcastEvent(const char* event) {
+    if (!ws || ws->count() == 0 || !pPeripheralManager) {
+        return;
+    }
+
+    StaticJsonDocument<256> doc;
+    doc["type"] = "event";
+    doc["event"] = event;
+    doc["fault"] = UART1Mux::getFaultName(pPeripheralManager->getUART1().getFaultStatus().code);
+    doc["freq"] = pPeripheralManager->getUART1().getPWMFrequency();
+    doc["duty"] = pPeripheralManager->getUART1().getPWMDuty();
+    doc["uptime"] = millis() / 1000;
 
     String json;
     serializeJson(doc, json);
@@ -208,36 +253,49 @@ void WebServerManager::handleWebSocketMessage(void *arg, uint8_t *data, size_t l
                 return;
             }
 
-            // Handle legacy JSON commands (motor control now via UART1)
+            // Legacy JSON commands map to text commands and run on the command
+            // executor like every other transport
+            // 不立即廣播 - 讓定期廣播處理 (避免與用戶輸入競爭)
+            char line[64];
+            line[0] = '\0';
             if (strcmp(cmd, "set_freq") == 0) {
-                uint32_t freq = doc["value"];
-                if (pPeripheralManager) {
-                    pPeripheralManager->getUART1().setPWMFrequency(freq);
-                    // 不立即廣播 - 讓定期廣播處理 (避免與用戶輸入競爭)
-                }
+                snprintf(line, sizeof(line), "SET PWM_FREQ %u", (uint32_t)(doc["value"] | 0u));
             }
             else if (strcmp(cmd, "set_duty") == 0) {
-                float duty = doc["value"];
-                if (pPeripheralManager) {
-                    pPeripheralManager->getUART1().setPWMDuty(duty);
-                    // 不立即廣播 - 讓定期廣播處理 (避免與用戶輸入競爭)
-                }
+                snprintf(line, sizeof(line), "SET PWM_DUTY %.3f", (float)(doc["value"] | 0.0f));
+            }
+            else if (strcmp(cmd, "set_rpm") == 0) {
+                // Closed-loop speed control: set target and start PID
+                snprintf(line, sizeof(line), "RPM SET %.1f", (float)(doc["value"] | 0.0f));
+            }
+            else if (strcmp(cmd, "pid_enable") == 0) {
+                snprintf(line, sizeof(line), "PID %s", (doc["value"] | false) ? "ON" : "OFF");
             }
             else if (strcmp(cmd, "stop") == 0) {
-                // Simple stop: set duty to 0% (emergency stop removed in v3.0)
+                // Urgent lane: overtakes queued commands
+                snprintf(line, sizeof(line), "MOTOR STOP");
+            }
+            else if (strcmp(cmd, "fan_pwm") == 0) {
+                // {"cmd":"fan_pwm","ch":1,"freq":25000,"duty":40}; omitted fields keep their value
                 if (pPeripheralManager) {
-                    pPeripheralManager->getUART1().setPWMDuty(0.0);
-                    // 不立即廣播 - 讓定期廣播處理
+                    uint8_t ch = doc["ch"] | 0;
+                    FanStatus fan = pPeripheralManager->getFans().getStatus(ch);
+                    snprintf(line, sizeof(line), "FAN %u PWM %u %.3f", ch,
+                             (uint32_t)(doc["freq"] | fan.frequency), (float)(doc["duty"] | fan.duty));
                 }
             }
             else if (strcmp(cmd, "clear_error") == 0) {
-                // No-op: emergency stop feature removed in v3.0
-                // 不立即廣播 - 讓定期廣播處理
+                // Release a latched speed-protection fault
+                snprintf(line, sizeof(line), "CLEAR ERROR");
             }
             else if (strcmp(cmd, "get_status") == 0) {
                 // 只有 get_status 命令才立即廣播
                 broadcastStatus();
             }
+
+            if (line[0] != '\0') {
+                runCommand(line);
+            }
         } else {
             // 作為文本命令處理（支持完整的命令解析系統）
             // 相同的命令系統用於 CDC 和 HID
@@ -267,10 +325,10 @@ void WebServerManager::handleWebSocketMessage(void *arg, uint8_t *data, size_t l
             WebSocketResponse wsResponse((void*)ws, client_id);
             USBSerial.printf("[WS] WebSocketResponse 已建立\n");
 
-            // 使用命令解析器處理命令
-            USBSerial.printf("[WS] 調用 parser.processCommand()...\n");
-            bool commandProcessed = parser.processCommand(trimmed, &wsResponse, CMD_SOURCE_WEBSOCKET);
-            USBSerial.printf("[WS] parser.processCommand() 返回: %s\n", commandProcessed ? "true" : "false");
+            // 交由命令執行器處理（與 CDC/HID/BLE 依序執行，回應寫入 wsResponse）
+            USBSerial.printf("[WS] 調用 commandExecutor.execute()...\n");
+            bool commandProcessed = commandExecutor.execute(trimmed.c_str(), &wsResponse, CMD_SOURCE_WEBSOCKET);
+            USBSerial.printf("[WS] commandExecutor.execute() 返回: %s\n", commandProcessed ? "true" : "false");
 
             // 取得響應文本
             String response = wsResponse.getResponse();
@@ -417,6 +475,17 @@ void WebServerManager::setupRoutes() {
         handleGetConfig(request);
     });
 
+    // Fan sweep results as the binary blob (SweepBlobHeader + SweepPoint[])
+    server->on("/api/sweep", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        size_t size = 0;
+        const uint8_t* blob = pPeripheralManager ? pPeripheralManager->getSweep().getBlob(size) : nullptr;
+        if (!blob) {
+            request->send(503, "application/json", "{\"success\":false}");
+            return;
+        }
+        request->send_P(200, "application/octet-stream", blob, size);
+    });
+
     server->on("/api/config", HTTP_POST,
         [this](AsyncWebServerRequest *request) {
             handlePostConfig(request);
@@ -534,6 +603,16 @@ void WebServerManager::setupRoutes() {
     });
 }
 
+bool WebServerManager::runCommand(const char* line, String* output) {
+    WebSocketResponse response((void*)ws, 0);  // Only collects the output
+    bool ok = commandExecutor.execute(line, &response, CMD_SOURCE_WEBSOCKET);
+    USBSerial.printf("[WEB] %s -> %s\n", line, ok ? "OK" : "FAILED");
+    if (output != nullptr) {
+        *output = response.getResponse();
+    }
+    return ok;
+}
+
 void WebServerManager::handleGetStatus(AsyncWebServerRequest *request) {
     request->send(200, "application/json", generateStatusJSON());
 }
@@ -556,7 +635,9 @@ void WebServerManager::handleSetPWMFreq(AsyncWebServerRequest *request) {
 
     uint32_t freq = request->getParam("value", true)->value().toInt();
 
-    if (pPeripheralManager->getUART1().setPWMFrequency(freq)) {
+    char line[32];
+    snprintf(line, sizeof(line), "SET PWM_FREQ %u", freq);
+    if (runCommand(line)) {
         request->send(200, "application/json", "{\"success\":true}");
     } else {
         request->send(500, "application/json", "{\"error\":\"Failed to set frequency\"}");
@@ -577,7 +658,9 @@ void WebServerManager::handleSetPWMDuty(AsyncWebServerRequest *request) {
 
     float duty = request->getParam("value", true)->value().toFloat();
 
-    if (pPeripheralManager->getUART1().setPWMDuty(duty)) {
+    char line[32];
+    snprintf(line, sizeof(line), "SET PWM_DUTY %.3f", duty);
+    if (runCommand(line)) {
         request->send(200, "application/json", "{\"success\":true}");
     } else {
         request->send(500, "application/json", "{\"error\":\"Failed to set duty\"}");
@@ -585,11 +668,12 @@ void WebServerManager::handleSetPWMDuty(AsyncWebServerRequest *request) {
 }
 
 void WebServerManager::handleMotorStop(AsyncWebServerRequest *request) {
-    // Simple stop: set duty to 0% (emergency stop removed in v3.0)
-    if (pPeripheralManager) {
-        pPeripheralManager->getUART1().setPWMDuty(0.0);
+    // Same as MOTOR STOP, on the executor's urgent lane
+    if (runCommand("MOTOR STOP")) {
+        request->send(200, "application/json", "{\"success\":true}");
+    } else {
+        request->send(503, "application/json", "{\"error\":\"Command queue full\"}");
     }
-    request->send(200, "application/json", "{\"success\":true}");
 }
 
 void WebServerManager::handleClearError(AsyncWebServerRequest *request) {
@@ -659,7 +743,7 @@ void WebServerManager::handleScanNetworks(AsyncWebServerRequest *request) {
 }
 
 String WebServerManager::generateStatusJSON() {
-    StaticJsonDocument<1024> doc;
+    StaticJsonDocument<1536> doc;
 
     // Motor control now via UART1 (v3.0)
     if (pPeripheralManager) {
@@ -672,6 +756,42 @@ String WebServerManager::generateStatusJSON() {
         doc["realInputFrequency"] = uart1.getRPMFrequency();
         doc["input_freq"] = uart1.getRPMFrequency();  // Alias
         // Ramping, emergency stop, and capture_init removed in v3.0
+        FaultStatus fault = uart1.getFaultStatus();
+        doc["fault"] = UART1Mux::getFaultName(fault.code);
+        doc["fault_armed"] = fault.armed;
+        doc["fault_trips"] = fault.tripCount;
+        if (uart1.isInputDutyCapture()) {
+            InputDutyStats duty = uart1.getInputDutyStats();
+            doc["input_duty"] = duty.dutyMean;
+            doc["input_duty_min"] = duty.dutyMin;
+            doc["input_duty_max"] = duty.dutyMax;
+        }
+        FollowStatus follow = uart1.getFollowStatus();
+        doc["follow"] = follow.enabled;
+        if (follow.enabled) {
+            doc["follow_ratio"] = follow.ratio;
+            doc["follow_offset"] = follow.offsetHz;
+            doc["follow_target"] = follow.targetHz;
+            doc["follow_locked"] = follow.locked;
+            doc["follow_error_hz"] = follow.errorHz;
+            doc["follow_error_ppm"] = follow.errorPpm;
+        }
+        FanManager& fans = pPeripheralManager->getFans();
+        doc["fan_count"] = fans.getChannelCount();
+        if (fans.getChannelCount() > 1) {
+            JsonArray fanArray = doc.createNestedArray("fans");
+            for (uint32_t i = 0; i < fans.getChannelCount(); i++) {
+                FanStatus fan = fans.getStatus(i);
+                JsonObject obj = fanArray.createNestedObject();
+                obj["ch"] = fan.channel;
+                obj["freq"] = fan.frequency;
+                obj["duty"] = fan.duty;
+                obj["rpm"] = fan.rpm;
+                obj["tach_hz"] = fan.inputHz;
+                obj["en"] = fan.enabled;
+                obj["active"] = fan.active;
+            }
+        }
         doc["initialized"] = true;  // Always initialized if peripheral manager exists
 
         // Format uptime as "H:MM:SS"
@@ -846,11 +966,14 @@ void WebServerManager::handlePostConfig(AsyncWebServerRequest *request) {
             // rpmUpdateRate removed in v3.0 (was UI-only setting)
 
             // Motor settings now via UART1 (v3.0)
-            if (doc.containsKey("polePairs") && pPeripheralManager) {
+            if (doc.containsKey("polePairs")) {
                 uint8_t polePairs = doc["polePairs"];
-                pPeripheralManager->getUART1().setPolePairs(polePairs);
-                Serial.printf("✅ Pole pairs set to: %d\n", polePairs);
-                updated = true;
+                char line[32];
+                snprintf(line, sizeof(line), "SET POLE_PAIRS %u", polePairs);
+                if (runCommand(line)) {
+                    Serial.printf("✅ Pole pairs set to: %d\n", polePairs);
+                    updated = true;
+                }
             }
 
             // maxFrequency, maxSafeRPM, maxSafeRPMEnabled removed in v3.0
@@ -941,18 +1064,21 @@ void WebServerManager::handlePostPWM(AsyncWebServerRequest *request) {
     String message = "";
 
     // v3.0: Motor control via UART1
-    if (hasFreq && pPeripheralManager) {
+    char line[48];
+    if (hasFreq) {
         uint32_t freq = request->getParam("frequency", true)->value().toInt();
-        if (pPeripheralManager->getUART1().setPWMFrequency(freq)) {
+        snprintf(line, sizeof(line), "SET PWM_FREQ %u", freq);
+        if (runCommand(line)) {
             message += "Frequency: " + String(freq) + "Hz ";
         } else {
             success = false;
         }
     }
 
-    if (hasDuty && pPeripheralManager) {
+    if (hasDuty) {
         float duty = request->getParam("duty", true)->value().toFloat();
-        if (pPeripheralManager->getUART1().setPWMDuty(duty)) {
+        snprintf(line, sizeof(line), "SET PWM_DUTY %.3f", duty);
+        if (runCommand(line)) {
             message += "Duty: " + String(duty, 1) + "%";
         } else {
             success = false;
@@ -979,12 +1105,13 @@ void WebServerManager::handlePostPolePairs(AsyncWebServerRequest *request) {
         return;
     }
 
-    // v3.0: Update pole pairs via UART1
-    if (pPeripheralManager) {
-        pPeripheralManager->getUART1().setPolePairs(polePairs);
+    // v3.0: Update pole pairs via UART1 (on the command executor)
+    char line[32];
+    snprintf(line, sizeof(line), "SET POLE_PAIRS %u", polePairs);
+    if (runCommand(line)) {
         request->send(200, "application/json", "{\"success\":true,\"polePairs\":" + String(polePairs) + "}");
     } else {
-        request->send(500, "application/json", "{\"success\":false,\"error\":\"Peripheral manager not initialized\"}");
+        request->send(500, "application/json", "{\"success\":false,\"error\":\"Failed to set pole pairs\"}");
     }
 }
 
@@ -92,6 +92,12 @@ public:
      */
     void broadcastStatus();
 
+    /**
+     * @brief Broadcast a one-shot event to all WebSocket clients
+     * @param event Event name (e.g. "ramp_complete")
+     */
+    void broadcastEvent(const char* event);
+
 private:
     AsyncWebServer* server = nullptr;
     AsyncWebSocket* ws = nullptr;
@@ -148,6 +154,17 @@ private:
      */
     String generateSettingsJSON();
 
+    /**
+     * @brief Run a text command on the command executor
+     *
+     * Web controls that change UART1, the PID or the fans go through the same
+     * serialized path as CDC/HID/BLE instead of touching the peripherals from
+     * the AsyncTCP task; MOTOR STOP takes the executor's urgent lane.
+     * @param output Command output (nullptr = discard)
+     * @return Command result (false: rejected, unknown or queue full)
+     */
+    bool runCommand(const char* line, String* output = nullptr);
+
     // REST API handlers
     void handleGetStatus(AsyncWebServerRequest *request);
     void handleGetSettings(AsyncWebServerRequest *request);
@@ -104,22 +104,22 @@ void WebServerManager::handlePostUART1Mode(AsyncWebServerRequest *request) {
     String mode = request->getParam("mode", true)->value();
     mode.toUpperCase();
 
-    bool success = false;
+    // Mode switches run on the command executor, never beside a UART1 command
+    char line[64];
     if (mode == "UART") {
         uint32_t baud = request->hasParam("baud", true) ?
                         request->getParam("baud", true)->value().toInt() : 115200;
-        success = pPeripheralManager->getUART1().setModeUART(baud);
+        snprintf(line, sizeof(line), "UART1 MODE UART; UART1 CONFIG %u", baud);
     } else if (mode == "PWM") {
-        success = pPeripheralManager->getUART1().setModePWM_RPM();
+        snprintf(line, sizeof(line), "UART1 MODE PWM");
     } else if (mode == "DISABLED") {
-        pPeripheralManager->getUART1().disable();
-        success = true;
+        snprintf(line, sizeof(line), "UART1 MODE OFF");
     } else {
         request->send(400, "application/json", "{\"error\":\"Invalid mode. Use UART, PWM, or DISABLED\"}");
         return;
     }
 
-    if (success) {
+    if (runCommand(line)) {
         request->send(200, "application/json", "{\"success\":true}");
     } else {
         request->send(500, "application/json", "{\"success\":false,\"error\":\"Mode change failed\"}");
@@ -137,28 +137,23 @@ void WebServerManager::handlePostUART1PWM(AsyncWebServerRequest *request) {
         return;
     }
 
-    bool success = true;
-    String message = "PWM updated";
-
+    // One batch on the command executor: validated together, applied together
+    String line;
     if (request->hasParam("frequency", true)) {
-        uint32_t freq = request->getParam("frequency", true)->value().toInt();
-        if (!pPeripheralManager->getUART1().setPWMFrequency(freq)) {
-            success = false;
-            message = "Invalid frequency";
-        }
+        line += "SET PWM_FREQ " + String((uint32_t)request->getParam("frequency", true)->value().toInt()) + ";";
     }
-
-    if (success && request->hasParam("duty", true)) {
-        float duty = request->getParam("duty", true)->value().toFloat();
-        if (!pPeripheralManager->getUART1().setPWMDuty(duty)) {
-            success = false;
-            message = "Invalid duty cycle";
-        }
+    if (request->hasParam("duty", true)) {
+        line += "SET PWM_DUTY " + String(request->getParam("duty", true)->value().toFloat(), 3) + ";";
+    }
+    if (request->hasParam("enabled", true)) {
+        line += (request->getParam("enabled", true)->value() == "true") ? "FAN 0 ON;" : "FAN 0 OFF;";
     }
 
-    if (success && request->hasParam("enabled", true)) {
-        bool enabled = request->getParam("enabled", true)->value() == "true";
-        pPeripheralManager->getUART1().setPWMEnabled(enabled);
+    bool success = true;
+    String message = "PWM updated";
+    if (line.length() > 0 && !runCommand(line.c_str())) {
+        success = false;
+        message = "Invalid frequency or duty cycle";
     }
 
     StaticJsonDocument<128> doc;
@@ -3,6 +3,7 @@
 #include "USBCDC.h"
 #include "CustomHID.h"
 #include "CommandParser.h"
+#include "CommandExecutor.h"
 #include "HIDProtocol.h"
 // Motor control is now integrated into UART1Mux
 // #include "MotorControl.h"  // DEPRECATED - merged to UART1
@@ -73,9 +74,6 @@ HIDResponse* hid_response = nullptr;
 MultiChannelResponse* multi_response = nullptr;  // 多通道回應（同時輸出到 HID 和 CDC）
 BLEResponse* ble_response = nullptr;
 
-// HID 命令緩衝區
-String hid_command_buffer = "";
-
 // Motor control instances
 // Motor control is now integrated into UART1Mux
 // MotorControl motorControl;  // DEPRECATED - merged to UART1
@@ -182,6 +180,20 @@ void hidTask(void* parameter) {
         // 等待 HID 資料
         if (xQueueReceive(hidDataQueue, &packet, portMAX_DELAY)) {
 
+            // 二進位請求（0xA0）：不經過文字解析與除錯輸出，直接回傳 0xA2 回應
+            if (packet.len >= HIDBinary::REQUEST_HEADER_SIZE && HIDProtocol::isBinaryRequest(packet.data)) {
+                uint8_t reply[64];
+                if (packet.len < 64) {
+                    memset(packet.data + packet.len, 0, 64 - packet.len);
+                }
+                commandExecutor.executeBinary(packet.data, reply);
+                if (xSemaphoreTake(hidSendMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+                    HID.send(reply, 64);
+                    xSemaphoreGive(hidSendMutex);
+                }
+                continue;
+            }
+
             // 自動偵測並解析命令（支援 0xA1 協定和純文本協定）
             if (HIDProtocol::parseCommand(packet.data, command_buffer, &command_len, &is_0xA1_protocol)) {
                 // ========== 這是命令封包 ==========
@@ -191,15 +203,13 @@ void hidTask(void* parameter) {
                     xSemaphoreGive(serialMutex);
                 }
 
-                // 執行命令（根據命令類型路由回應）
-                String cmd_str(command_buffer);
-
+                // 交由命令執行器執行（根據命令類型路由回應，直接解析 command_buffer）
                 // SCPI 命令 → 只回應到 HID
                 // 一般命令 → 只回應到 CDC
-                if (CommandParser::isSCPICommand(cmd_str)) {
-                    parser.processCommand(cmd_str, hid_response, CMD_SOURCE_HID);
+                if (CommandParser::isSCPICommand(command_buffer)) {
+                    commandExecutor.execute(command_buffer, hid_response, CMD_SOURCE_HID);
                 } else {
-                    parser.processCommand(cmd_str, cdc_response, CMD_SOURCE_HID);
+                    commandExecutor.execute(command_buffer, cdc_response, CMD_SOURCE_HID);
                 }
 
                 // 顯示提示符
@@ -250,7 +260,9 @@ void hidTask(void* parameter) {
 
 // CDC 處理 Task
 void cdcTask(void* parameter) {
-    String cdc_command_buffer = "";
+    // 固定大小的命令緩衝區（不使用 String，避免每個字元重新配置堆積）
+    char cdc_command_buffer[CommandParser::MAX_LINE_LENGTH + 1];
+    size_t cdc_command_length = 0;
 
     while (true) {
         // 檢查是否有可用資料（使用 mutex 保護）
@@ -280,12 +292,13 @@ void cdcTask(void* parameter) {
             // 處理接收到的字元（在 mutex 外部，不影響其他 task）
             if (c == '\n' || c == '\r') {
                 // 收到換行符，處理完整命令
-                if (cdc_command_buffer.length() > 0) {
+                if (cdc_command_length > 0) {
                     // 取得 mutex 保護 USBSerial 輸出
                     if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(1000))) {
                         // 處理命令（CDC 命令只輸出到 CDC）
-                        parser.processCommand(cdc_command_buffer, cdc_response, CMD_SOURCE_CDC);
-                        cdc_command_buffer = "";  // 清空緩衝區
+                        cdc_command_buffer[cdc_command_length] = '\0';
+                        commandExecutor.execute(cdc_command_buffer, cdc_response, CMD_SOURCE_CDC);
+                        cdc_command_length = 0;  // 清空緩衝區
 
                         // 顯示提示符
                         USBSerial.print("> ");
@@ -294,12 +307,14 @@ void cdcTask(void* parameter) {
                 }
             } else if (c == '\b' || c == 127) {
                 // 退格鍵
-                if (cdc_command_buffer.length() > 0) {
-                    cdc_command_buffer.remove(cdc_command_buffer.length() - 1);
+                if (cdc_command_length > 0) {
+                    cdc_command_length--;
                 }
             } else if (c >= 32 && c < 127) {
-                // 可列印字元
-                cdc_command_buffer += c;
+                // 可列印字元（超過 MAX_LINE_LENGTH 的部分捨棄）
+                if (cdc_command_length < CommandParser::MAX_LINE_LENGTH) {
+                    cdc_command_buffer[cdc_command_length++] = c;
+                }
             }
         }
 
@@ -315,12 +330,12 @@ void bleTask(void* parameter) {
     while (true) {
         // 從佇列接收命令（阻塞等待）
         if (xQueueReceive(bleCommandQueue, &packet, portMAX_DELAY) == pdTRUE) {
-            String command = String(packet.command);
-            command.trim();
+            // 直接解析佇列中的命令（前後空白由 parser 忽略）
+            const char* command = packet.command;
 
             // 調試輸出（保護 USBSerial）
             if (xSemaphoreTake(serialMutex, pdMS_TO_TICKS(100))) {
-                USBSerial.printf("\n[BLE CMD] %s\n", command.c_str());
+                USBSerial.printf("\n[BLE CMD] %s\n", command);
                 xSemaphoreGive(serialMutex);
             }
 
@@ -329,9 +344,9 @@ void bleTask(void* parameter) {
             // SCPI 命令 → 只回應到 BLE
             // 一般命令 → 只回應到 CDC
             if (CommandParser::isSCPICommand(command)) {
-                parser.processCommand(command, ble_response, CMD_SOURCE_BLE);
+                commandExecutor.execute(command, ble_response, CMD_SOURCE_BLE);
             } else {
-                parser.processCommand(command, cdc_response, CMD_SOURCE_BLE);
+                commandExecutor.execute(command, cdc_response, CMD_SOURCE_BLE);
             }
 
             // 短暫延遲確保 BLE 通知發送完成
@@ -381,6 +396,25 @@ void peripheralTask(void* parameter) {
     }
 }
 
+// RPM 量測 Task (event-driven, woken by MCPWM capture ISR)
+void rpmTask(void* parameter) {
+    auto& uart1 = peripheralManager.getUART1();
+
+    while (true) {
+        // Event/follower mode: wait for capture ISR notification, time out so
+        // signal loss is still detected. Otherwise sleep until one is enabled.
+        bool active = uart1.isRPMEventMode() || uart1.isFollowing();
+        ulTaskNotifyTake(pdTRUE, active ? pdMS_TO_TICKS(50) : portMAX_DELAY);
+
+        if (uart1.getMode() == UART1Mux::MODE_PWM_RPM) {
+            if (uart1.isRPMEventMode()) {
+                uart1.updateRPMFrequency();
+            }
+            uart1.followStep();  // FLL update when the ISR published a new span
+        }
+    }
+}
+
 // Peripheral 處理 Task (migrated from motorTask)
 void motorTask(void* parameter) {
     TickType_t lastRPMUpdate = 0;
@@ -390,17 +424,44 @@ void motorTask(void* parameter) {
         TickType_t now = xTaskGetTickCount();
 
         // Update UART1 RPM reading if in PWM/RPM mode (every 50ms)
+        // Skipped in event mode - rpmTask is woken by the capture ISR instead
         if (now - lastRPMUpdate >= pdMS_TO_TICKS(50)) {
-            peripheralManager.getUART1().updateRPMFrequency();
+            if (!peripheralManager.getUART1().isRPMEventMode()) {
+                peripheralManager.getUART1().updateRPMFrequency();
+            }
             lastRPMUpdate = now;
         }
 
+        // Ramp completion event (set by UART1 ramp engine)
+        if (peripheralManager.getUART1().takeRampCompleteEvent()) {
+            auto& uart1 = peripheralManager.getUART1();
+            USBSerial.printf("[RAMP] ✅ 漸變完成: %u Hz, %.1f%% (%u 次更新)\n",
+                             uart1.getPWMFrequency(), uart1.getPWMDuty(), uart1.getRampSteps());
+            if (webServerManager.isRunning()) {
+                webServerManager.broadcastEvent("ramp_complete");
+            }
+        }
+
+        // Speed protection trip (latched by the capture ISR / watchdog)
+        if (peripheralManager.getUART1().takeFaultEvent()) {
+            FaultStatus fault = peripheralManager.getUART1().getFaultStatus();
+            USBSerial.printf("[FAULT] ❌ %s: %.1f RPM, 輸出已強制安全狀態 (反應 %u us)\n",
+                             UART1Mux::getFaultName(fault.code), fault.rpm, fault.reactionUs);
+            if (webServerManager.isRunning()) {
+                webServerManager.broadcastEvent("fault");
+            }
+        }
+
         // Update LED based on system state every 200ms
         if (now - lastLEDUpdate >= pdMS_TO_TICKS(200)) {
             auto& uart1 = peripheralManager.getUART1();
 
+            // Priority 0: Latched speed fault - blink red
+            if (uart1.isFaultLatched()) {
+                statusLED.blinkRed(200);
+            }
             // Priority 1: Web server not ready - blink yellow as warning
-            if (!webServerManager.isRunning()) {
+            else if (!webServerManager.isRunning()) {
                 statusLED.blinkYellow(500);
             }
             // Priority 2: BLE connected - purple
@@ -723,6 +784,12 @@ void setup() {
 
     // 創建 FreeRTOS Tasks
     statusLED.update();  // Update LED before creating tasks
+
+    // 命令執行器：所有介面的命令都在此任務依序執行（需在介面 Task 之前啟動）
+    if (!commandExecutor.begin(parser)) {
+        USBSerial.println("⚠️ 命令執行器啟動失敗，命令將在各介面 Task 中直接執行");
+    }
+
     xTaskCreatePinnedToCore(
         hidTask,           // Task 函數
         "HID_Task",        // Task 名稱
@@ -753,6 +820,18 @@ void setup() {
         1                  // Core 1
     );
 
+    TaskHandle_t rpmTaskHandle = NULL;
+    xTaskCreatePinnedToCore(
+        rpmTask,           // Task 函數
+        "RPM_Task",        // Task 名稱
+        4096,              // Stack 大小
+        NULL,              // 參數
+        3,                 // 優先權（最高，量測延遲最小）
+        &rpmTaskHandle,    // Task handle（供擷取 ISR 通知）
+        1                  // Core 1
+    );
+    peripheralManager.getUART1().setRPMNotifyTask(rpmTaskHandle);
+
     xTaskCreatePinnedToCore(
         motorTask,         // Task 函數
         "Motor_Task",      // Task 名稱
@@ -784,9 +863,11 @@ void setup() {
     );
 
     USBSerial.println("[INFO] FreeRTOS Tasks 已啟動");
+    USBSerial.println("[INFO] - Command Executor (優先權 2, 緊急/一般雙佇列)");
     USBSerial.println("[INFO] - HID Task (優先權 2)");
     USBSerial.println("[INFO] - CDC Task (優先權 1)");
     USBSerial.println("[INFO] - BLE Task (優先權 1)");
+    USBSerial.println("[INFO] - RPM Task (優先權 3, 事件驅動)");
     USBSerial.println("[INFO] - Motor Task (優先權 1)");
     USBSerial.println("[INFO] - WiFi Task (優先權 1)");
     USBSerial.println("[INFO] - Peripheral Task (優先權 1)");